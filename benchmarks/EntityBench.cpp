@@ -0,0 +1,181 @@
+////////////////////////////////////////////////////////////////
+/// EntityBench.cpp
+////////////////////////////////////////////////////////////////
+
+// Iteration benchmark for the EntityStore systems at 1M entities: Create, UpdateTransforms,
+// Cull (one thread and across the job system) and BuildDrawList. Every number is the median
+// of several runs in milliseconds. Build with "make bench-entities".
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../src/EntityStore.h"
+
+const GLuint ENTITY_COUNT = 1000000;
+const int RUNS = 7;
+
+// One in CHILD_EVERY entities hangs off the root before it, so the hierarchy levels get exercised too
+const GLuint CHILD_EVERY = 4;
+
+static double Milliseconds( std::chrono::steady_clock::time_point start )
+{
+    return std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now( ) - start ).count( );
+}
+
+static double Median( std::vector<double> times )
+{
+    std::sort( times.begin( ), times.end( ) );
+
+    return times[times.size( ) / 2];
+}
+
+static void Report( const char *name, const std::vector<double> &times, const char *note = "" )
+{
+    printf( "%-28s %9.2f ms %s\n", name, Median( times ), note );
+}
+
+// Fills a store with ENTITY_COUNT entities spread over a 2km cube, with renderables spread over
+// a handful of programs and VAOs so the draw list sort has something to do
+static void Populate( EntityStore &store, std::vector<Entity> &roots, std::mt19937 &random )
+{
+    std::uniform_real_distribution<double> position( -1000.0, 1000.0 );
+    std::uniform_real_distribution<float> angle( 0.0f, 6.2831853f );
+    Entity root = NULL_ENTITY;
+
+    roots.clear( );
+
+    for ( GLuint i = 0; i < ENTITY_COUNT; ++i )
+    {
+        Entity entity;
+
+        if ( 0 != i % CHILD_EVERY || NULL_ENTITY.index == root.index )
+        {
+            entity = store.Create( glm::dvec3( position( random ), position( random ), position( random ) ) );
+            root = entity;
+            roots.push_back( entity );
+        }
+        else
+        {
+            entity = store.Create( glm::dvec3( 1.0, 0.0, 0.0 ), root );
+        }
+
+        store.SetRotation( entity, glm::angleAxis( angle( random ), glm::vec3( 0.0f, 1.0f, 0.0f ) ) );
+        store.SetBounds( entity, glm::vec3( 0.0f ), 0.87f );
+        store.SetRenderable( entity, 1 + i % 3, 1 + i % 5, 36 );
+    }
+}
+
+int main( )
+{
+    std::mt19937 random( 1 );
+    std::uniform_real_distribution<float> angle( 0.0f, 6.2831853f );
+    std::vector<Entity> roots;
+    std::vector<double> times;
+
+    printf( "EntityStore, %u entities, median of %d runs\n", ENTITY_COUNT, RUNS );
+
+    times.clear( );
+
+    for ( int run = 0; run < RUNS; ++run )
+    {
+        EntityStore store( ENTITY_COUNT );
+        auto start = std::chrono::steady_clock::now( );
+        Populate( store, roots, random );
+        times.push_back( Milliseconds( start ) );
+    }
+
+    Report( "Create", times );
+
+    EntityStore store( ENTITY_COUNT );
+    Populate( store, roots, random );
+
+    // First update sorts the hierarchy by depth and builds every world matrix
+    auto start = std::chrono::steady_clock::now( );
+    store.UpdateTransforms( );
+    printf( "%-28s %9.2f ms (depth sort, %u matrices)\n", "UpdateTransforms first", Milliseconds( start ), store.GetUpdatedCount( ) );
+
+    times.clear( );
+
+    for ( int run = 0; run < RUNS; ++run )
+    {
+        for ( size_t i = 0; i < roots.size( ); ++i )
+        {
+            store.SetRotation( roots[i], glm::angleAxis( angle( random ), glm::vec3( 0.0f, 1.0f, 0.0f ) ) );
+        }
+
+        start = std::chrono::steady_clock::now( );
+        store.UpdateTransforms( );
+        times.push_back( Milliseconds( start ) );
+    }
+
+    Report( "UpdateTransforms all moved", times );
+
+    times.clear( );
+
+    for ( int run = 0; run < RUNS; ++run )
+    {
+        start = std::chrono::steady_clock::now( );
+        store.UpdateTransforms( );
+        times.push_back( Milliseconds( start ) );
+    }
+
+    Report( "UpdateTransforms static", times );
+
+    // Camera at the centre looking down -Z, far plane at 1km
+    glm::mat4 projection = glm::perspective( glm::radians( 45.0f ), 16.0f / 9.0f, 0.1f, 1000.0f );
+    glm::mat4 view = glm::lookAt( glm::vec3( 0.0f ), glm::vec3( 0.0f, 0.0f, -1.0f ), glm::vec3( 0.0f, 1.0f, 0.0f ) );
+    Frustum frustum( projection * view );
+    glm::dvec3 origin( 0.0 );
+    std::vector<GLuint> visible;
+    std::vector<DrawItem> drawList;
+
+    times.clear( );
+
+    for ( int run = 0; run < RUNS; ++run )
+    {
+        start = std::chrono::steady_clock::now( );
+        store.Cull( frustum, origin, visible );
+        times.push_back( Milliseconds( start ) );
+    }
+
+    char note[64];
+    snprintf( note, sizeof( note ), "(%u visible)", ( GLuint )visible.size( ) );
+    Report( "Cull", times, note );
+
+    {
+        JobSystem jobs;
+
+        times.clear( );
+
+        for ( int run = 0; run < RUNS; ++run )
+        {
+            start = std::chrono::steady_clock::now( );
+            store.Cull( frustum, origin, visible, jobs );
+            times.push_back( Milliseconds( start ) );
+            FrameArena::ResetAll( );
+        }
+
+        snprintf( note, sizeof( note ), "(%u threads)", jobs.GetThreadCount( ) );
+        Report( "Cull job system", times, note );
+    }
+
+    times.clear( );
+
+    for ( int run = 0; run < RUNS; ++run )
+    {
+        start = std::chrono::steady_clock::now( );
+        store.BuildDrawList( visible, drawList );
+        times.push_back( Milliseconds( start ) );
+    }
+
+    snprintf( note, sizeof( note ), "(%u draws)", ( GLuint )drawList.size( ) );
+    Report( "BuildDrawList", times, note );
+
+    return 0;
+}
@@ -0,0 +1,261 @@
+/*
+	Quality and speed of the DXT encoder in each mode (range fit,
+	default, cluster fit), with the C code and with the AVX2 eight-block
+	encoder (SOIL_set_SIMD_enabled), which cluster fit doesn't have, so
+	it is measured once.  Images with 1 or
+	3 channels go to DXT1, 2 or 4 channels to DXT5, as SOIL does.  The
+	blocks are decoded again and PSNR is over RGB, and over alpha for
+	DXT5.  MB/s is of input pixels, one thread.
+
+	Takes image files on the command line, by default the repo's photo,
+	screenshot.png and a synthetic RGBA gradient.
+	Build with "make bench-dxt".
+*/
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../src/SOIL2/stb_image.h"
+#include "../src/SOIL2/SOIL2.h"
+#include "../src/SOIL2/image_DXT.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*	each measurement repeats the encode for at least this long	*/
+#define MIN_SECONDS 0.25
+
+static double now_seconds( void )
+{
+	struct timespec t;
+	clock_gettime( CLOCK_MONOTONIC, &t );
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void rgb_from_565( int c, int rgb[3] )
+{
+	rgb[0] = (((c >> 11) & 31) * 255 + 15) / 31;
+	rgb[1] = (((c >> 5) & 63) * 255 + 31) / 63;
+	rgb[2] = ((c & 31) * 255 + 15) / 31;
+}
+
+/*
+	Decodes the DXT1 or DXT5 blocks and sums the squared errors against
+	the source pixels, over RGB (grey for 1 and 2 channels) and alpha.
+*/
+static void DXT_error( const unsigned char *img, int width, int height, int channels,
+		const unsigned char *dxt, int dxt5, double *error_rgb, double *error_alpha )
+{
+	const int blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+	int bx, by, x, y, k;
+	*error_rgb = 0.0;
+	*error_alpha = 0.0;
+	for( by = 0; by < blocks_y; ++by )
+	{
+		for( bx = 0; bx < blocks_x; ++bx )
+		{
+			const unsigned char *block = dxt + (by * blocks_x + bx) * (dxt5 ? 16 : 8);
+			int alpha[8], palette[4][3];
+			int c0, c1;
+			unsigned int bits;
+			unsigned long alpha_bits_lo = 0, alpha_bits_hi = 0;
+			if( dxt5 )
+			{
+				alpha[0] = block[0];
+				alpha[1] = block[1];
+				for( k = 2; k < 8; ++k )
+				{
+					if( alpha[0] > alpha[1] )
+					{
+						alpha[k] = ((8 - k) * alpha[0] + (k - 1) * alpha[1]) / 7;
+					} else
+					{
+						alpha[k] = (k < 6) ? ((6 - k) * alpha[0] + (k - 1) * alpha[1]) / 5 : ((6 == k) ? 0 : 255);
+					}
+				}
+				/*	48 bits of 3 bit indices, in two halves of 24	*/
+				alpha_bits_lo = block[2] | (block[3] << 8) | ((unsigned long)block[4] << 16);
+				alpha_bits_hi = block[5] | (block[6] << 8) | ((unsigned long)block[7] << 16);
+				block += 8;
+			}
+			c0 = block[0] | (block[1] << 8);
+			c1 = block[2] | (block[3] << 8);
+			rgb_from_565( c0, palette[0] );
+			rgb_from_565( c1, palette[1] );
+			for( k = 0; k < 3; ++k )
+			{
+				/*	rounded, as the encoder scores its blocks	*/
+				if( c0 > c1 )
+				{
+					palette[2][k] = (2 * palette[0][k] + palette[1][k] + 1) / 3;
+					palette[3][k] = (palette[0][k] + 2 * palette[1][k] + 1) / 3;
+				} else
+				{
+					palette[2][k] = (palette[0][k] + palette[1][k] + 1) / 2;
+					palette[3][k] = 0;
+				}
+			}
+			bits = block[4] | (block[5] << 8) | (block[6] << 16) | ((unsigned int)block[7] << 24);
+			for( y = 0; y < 4; ++y )
+			{
+				for( x = 0; x < 4; ++x )
+				{
+					const int px = bx * 4 + x, py = by * 4 + y, i = y * 4 + x;
+					const unsigned char *pixel;
+					int index;
+					double e;
+					if( (px >= width) || (py >= height) )
+					{
+						continue;
+					}
+					pixel = img + (py * width + px) * channels;
+					index = (bits >> (2 * i)) & 3;
+					for( k = 0; k < 3; ++k )
+					{
+						e = pixel[(channels < 3) ? 0 : k] - palette[index][k];
+						*error_rgb += e * e;
+					}
+					if( dxt5 )
+					{
+						index = (i < 8) ? (int)((alpha_bits_lo >> (3 * i)) & 7) : (int)((alpha_bits_hi >> (3 * (i - 8))) & 7);
+						e = pixel[channels - 1] - alpha[index];
+						*error_alpha += e * e;
+					}
+				}
+			}
+		}
+	}
+}
+
+static double PSNR( double squared_error, double samples )
+{
+	if( squared_error <= 0.0 )
+	{
+		return 99.0;
+	}
+	return 10.0 * log10( 255.0 * 255.0 * samples / squared_error );
+}
+
+static unsigned char *encode( const unsigned char *img, int width, int height, int channels, int mode, int *size )
+{
+	if( channels & 1 )
+	{
+		return convert_image_to_DXT1( img, width, height, channels, mode, size );
+	}
+	return convert_image_to_DXT5( img, width, height, channels, mode, size );
+}
+
+/*	encodes until MIN_SECONDS have passed, returns the last output	*/
+static unsigned char *timed_encode( const unsigned char *img, int width, int height, int channels, int mode,
+		int *size, double *mb_per_second )
+{
+	double start = now_seconds(), elapsed;
+	int runs = 0;
+	unsigned char *dxt;
+	for( ;; )
+	{
+		dxt = encode( img, width, height, channels, mode, size );
+		++runs;
+		elapsed = now_seconds() - start;
+		if( elapsed >= MIN_SECONDS )
+		{
+			break;
+		}
+		free( dxt );
+	}
+	*mb_per_second = (double)width * height * channels * runs / elapsed / 1e6;
+	return dxt;
+}
+
+static void report( const char *name, const char *mode, const char *path, const unsigned char *img, int width,
+		int height, int channels, const unsigned char *dxt, double mb_per_second, const char *note )
+{
+	double error_rgb, error_alpha;
+	DXT_error( img, width, height, channels, dxt, !(channels & 1), &error_rgb, &error_alpha );
+	printf( "%-28s %-8s %-5s %8.1f MB/s   PSNR %6.2f", name, mode, path, mb_per_second,
+		PSNR( error_rgb, 3.0 * width * height ) );
+	if( !(channels & 1) )
+	{
+		printf( " / %6.2f", PSNR( error_alpha, (double)width * height ) );
+	} else
+	{
+		printf( "         " );
+	}
+	printf( "  %s\n", note );
+}
+
+static void bench_image( const char *name, const unsigned char *img, int width, int height, int channels )
+{
+	static const int modes[] = { DXT_MODE_RANGE_FIT, DXT_MODE_DEFAULT, DXT_MODE_CLUSTER_FIT };
+	static const char *const mode_names[] = { "range", "default", "cluster" };
+	int plain_size, simd_size, m;
+	double plain_speed, simd_speed;
+	unsigned char *plain, *simd;
+	char title[64];
+	snprintf( title, sizeof( title ), "%s %dx%dx%d", name, width, height, channels );
+	for( m = 0; m < (int)(sizeof( modes ) / sizeof( modes[0] )); ++m )
+	{
+		SOIL_set_SIMD_enabled( 0 );
+		plain = timed_encode( img, width, height, channels, modes[m], &plain_size, &plain_speed );
+		SOIL_set_SIMD_enabled( 1 );
+		report( (0 == m) ? title : "", mode_names[m], "C", img, width, height, channels, plain, plain_speed, "" );
+		if( DXT_MODE_CLUSTER_FIT != modes[m] )
+		{
+			simd = timed_encode( img, width, height, channels, modes[m], &simd_size, &simd_speed );
+			report( "", "", "SIMD", img, width, height, channels, simd, simd_speed,
+				((plain_size == simd_size) && (0 == memcmp( plain, simd, plain_size ))) ? "same blocks" : "DIFFERENT BLOCKS" );
+			free( simd );
+		}
+		free( plain );
+	}
+}
+
+/*	a smooth RGBA gradient with a little noise, the kind of content DXT struggles with	*/
+static unsigned char *synthetic_image( int width, int height )
+{
+	unsigned char *img = (unsigned char*)malloc( width * height * 4 );
+	int x, y;
+	srand( 1 );
+	for( y = 0; y < height; ++y )
+	{
+		for( x = 0; x < width; ++x )
+		{
+			unsigned char *pixel = img + (y * width + x) * 4;
+			pixel[0] = (unsigned char)(x * 255 / width);
+			pixel[1] = (unsigned char)(y * 255 / height);
+			pixel[2] = (unsigned char)(((x + y) * 255 / (width + height) + (rand() & 7)) & 255);
+			pixel[3] = (unsigned char)(128 + 127 * sin( x * 0.05 ) * cos( y * 0.03 ));
+		}
+	}
+	return img;
+}
+
+int main( int argc, char **argv )
+{
+	static const char *const default_files[] = { "resources/images/unsplash_image1.jpg", "screenshot.png" };
+	const char *const *files = (argc > 1) ? (const char *const *)(argv + 1) : default_files;
+	const int file_count = (argc > 1) ? argc - 1 : (int)(sizeof( default_files ) / sizeof( default_files[0] ));
+	unsigned char *img;
+	int i, width, height, channels;
+
+	printf( "DXT encoder modes, one thread, PSNR in dB rgb / alpha\n" );
+	for( i = 0; i < file_count; ++i )
+	{
+		const char *name = strrchr( files[i], '/' );
+		img = stbi_load( files[i], &width, &height, &channels, 0 );
+		if( NULL == img )
+		{
+			printf( "%s: %s\n", files[i], stbi_failure_reason() );
+			continue;
+		}
+		bench_image( (NULL != name) ? name + 1 : files[i], img, width, height, channels );
+		stbi_image_free( img );
+	}
+	if( argc <= 1 )
+	{
+		img = synthetic_image( 512, 512 );
+		bench_image( "synthetic", img, 512, 512, 4 );
+		free( img );
+	}
+	return 0;
+}
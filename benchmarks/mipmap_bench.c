@@ -0,0 +1,112 @@
+/*
+	Benchmark of the SOIL2 MIPmap chain against the per-level path
+	it replaced, on 4K and 8K textures of random pixels.
+
+	The old path built level n by averaging 2^n x 2^n blocks of the
+	base image with mipmap_image, so it read the whole image once per
+	level.  mipmap_chain builds each level from the one above it.
+	Both run on one thread (no SOIL_set_parallel_for), the chain with
+	the plain C code and with the SIMD kernels.  Times are the best
+	of RUNS runs in milliseconds.  Build with "make bench-mipmap".
+*/
+
+#include "../src/SOIL2/SOIL2.h"
+#include "../src/SOIL2/image_helper.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define RUNS 3
+
+static double now_ms( void )
+{
+	struct timespec t;
+	clock_gettime( CLOCK_MONOTONIC, &t );
+	return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+/*	what createMipmaps did before the chain, one level at a time	*/
+static void per_level_path( const unsigned char *img, int width, int height, int channels,
+		unsigned char *resampled )
+{
+	int MIPlevel = 1;
+	while( ((1<<MIPlevel) <= width) || ((1<<MIPlevel) <= height) )
+	{
+		mipmap_image(
+				img, width, height, channels,
+				resampled,
+				(1 << MIPlevel), (1 << MIPlevel) );
+		++MIPlevel;
+	}
+}
+
+static double time_per_level( const unsigned char *img, int size, int channels, unsigned char *resampled )
+{
+	double best = 1e30;
+	int run;
+	for( run = 0; run < RUNS; ++run )
+	{
+		double start = now_ms();
+		per_level_path( img, size, size, channels, resampled );
+		start = now_ms() - start;
+		best = (start < best) ? start : best;
+	}
+	return best;
+}
+
+static double time_chain( const unsigned char *img, int size, int channels, unsigned char *chain, int simd )
+{
+	double best = 1e30;
+	int run;
+	SOIL_set_SIMD_enabled( simd );
+	for( run = 0; run < RUNS; ++run )
+	{
+		double start = now_ms();
+		mipmap_chain( img, size, size, channels, chain );
+		start = now_ms() - start;
+		best = (start < best) ? start : best;
+	}
+	SOIL_set_SIMD_enabled( 1 );
+	return best;
+}
+
+int main( void )
+{
+	const int sizes[] = { 4096, 8192 };
+	int s, channels;
+
+	printf( "whole MIPmap chain, one thread, best of %d runs\n", RUNS );
+	printf( "%-12s %12s %12s %12s %9s %9s\n", "", "per level", "chain C", "chain SIMD", "C gain", "SIMD gain" );
+	for( s = 0; s < (int)(sizeof( sizes ) / sizeof( sizes[0] )); ++s )
+	{
+		const int size = sizes[s];
+		for( channels = 3; channels <= 4; ++channels )
+		{
+			size_t bytes = (size_t)size * size * channels;
+			unsigned char *img = (unsigned char*)malloc( bytes );
+			unsigned char *resampled = (unsigned char*)malloc( bytes / 4 );
+			unsigned char *chain = (unsigned char*)malloc( mipmap_chain_size( size, size, channels ) );
+			double old_ms, c_ms, simd_ms;
+			size_t i;
+			if( (NULL == img) || (NULL == resampled) || (NULL == chain) )
+			{
+				printf( "%d^2 x%d: out of memory\n", size, channels );
+				return 1;
+			}
+			srand( 1 );
+			for( i = 0; i < bytes; ++i )
+			{
+				img[i] = (unsigned char)rand();
+			}
+			old_ms = time_per_level( img, size, channels, resampled );
+			c_ms = time_chain( img, size, channels, chain, 0 );
+			simd_ms = time_chain( img, size, channels, chain, 1 );
+			printf( "%d^2 %-4s %9.1f ms %9.1f ms %9.1f ms %8.1fx %8.1fx\n", size, (3 == channels) ? "RGB" : "RGBA",
+				old_ms, c_ms, simd_ms, old_ms / c_ms, old_ms / simd_ms );
+			free( chain );
+			free( resampled );
+			free( img );
+		}
+	}
+	return 0;
+}
@@ -1,7 +0,0 @@
-#version 330 core
-out vec4 color;
-
-void main()
-{
-    color = vec4(1.0f); // Set all 4 vector values to 1.0f
-}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#version 330 core
+out vec4 color;
+
+#ifdef UBER
+// Built with every feature, the ones to apply are picked per draw
+uniform int features;
+#define FEATURE_LIT ((features & LIT_BIT) != 0)
+#elif defined(LIT)
+#define FEATURE_LIT true
+#else
+#define FEATURE_LIT false
+#endif
+
+#if defined(LIT) || defined(UBER)
+uniform vec3 objectColor;
+uniform vec3 lightColor;
+#endif
+
+void main()
+{
+#if defined(LIT) || defined(UBER)
+    if (FEATURE_LIT)
+    {
+        color = vec4(lightColor * objectColor, 1.0f);
+        return;
+    }
+#endif
+
+    color = vec4(1.0f); // Unlit, e.g. the lamp itself
+}
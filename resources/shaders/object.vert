@@ -0,0 +1,9 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+
+#include "transform.glsl"
+
+void main()
+{
+    gl_Position = transformPosition(position);
+}
@@ -0,0 +1,8 @@
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+vec4 transformPosition(vec3 position)
+{
+    return projection * view * model * vec4(position, 1.0f);
+}
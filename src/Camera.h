@@ -15,6 +15,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "Frustum.h"
+
 enum Camera_Movement
 {
     FORWARD,
@@ -28,13 +30,17 @@ const GLfloat PITCH       = 0.0f;
 const GLfloat SPEED       = 6.0f;
 const GLfloat SENSITIVITY = 0.25f;
 const GLfloat ZOOM        = 45.0f;
+const GLfloat ASPECT      = 4.0f / 3.0f;
+const GLfloat NEAR_PLANE  = 0.1f;
+const GLfloat FAR_PLANE   = 1000.0f;
 
 class Camera
 {
 public:
-    Camera( glm::vec3 position = glm::vec3( 0.0f, 0.0f, 0.0f ), glm::vec3 up = glm::vec3( 0.0f, 1.0f, 0.0f ),
+    Camera( glm::dvec3 position = glm::dvec3( 0.0, 0.0, 0.0 ), glm::vec3 up = glm::vec3( 0.0f, 1.0f, 0.0f ),
         GLfloat yaw = YAW, GLfloat pitch = PITCH )
-    : front( glm::vec3( 0.0f, 0.0f, -1.0f ) ), movementSpeed( SPEED ), mouseSensitivity( SENSITIVITY ), zoom( ZOOM )
+    : front( glm::vec3( 0.0f, 0.0f, -1.0f ) ), movementSpeed( SPEED ), mouseSensitivity( SENSITIVITY ), zoom( ZOOM ),
+      aspect( ASPECT ), nearPlane( NEAR_PLANE ), farPlane( FAR_PLANE ), viewDirty( true ), projectionDirty( true ), version( 1 )
     {
         this->position = position;
         this->worldUp = up;
@@ -43,43 +49,107 @@ public:
         this->updateCameraVectors( );
     }
 
-    Camera( GLfloat posX, GLfloat posY, GLfloat posZ, GLfloat upX, GLfloat upY, GLfloat upZ, GLfloat yaw, GLfloat pitch )
-    : front( glm::vec3( 0.0f, 0.0f, -1.0f ) ), movementSpeed( SPEED ), mouseSensitivity( SENSITIVITY ), zoom( ZOOM )
+    Camera( GLdouble posX, GLdouble posY, GLdouble posZ, GLfloat upX, GLfloat upY, GLfloat upZ, GLfloat yaw, GLfloat pitch )
+    : front( glm::vec3( 0.0f, 0.0f, -1.0f ) ), movementSpeed( SPEED ), mouseSensitivity( SENSITIVITY ), zoom( ZOOM ),
+      aspect( ASPECT ), nearPlane( NEAR_PLANE ), farPlane( FAR_PLANE ), viewDirty( true ), projectionDirty( true ), version( 1 )
     {
-        this->position = glm::vec3( posX, posY, posZ );
+        this->position = glm::dvec3( posX, posY, posZ );
         this->worldUp = glm::vec3( upX, upY, upZ );
         this->yaw = yaw;
         this->pitch = pitch;
         this->updateCameraVectors( );
     }
 
-    glm::mat4 GetViewMatrix( )
+    // The camera sits at the origin of the space it renders in (camera-relative rendering), so the
+    // view matrix only rotates. World positions are turned into small offsets from GetPosition( )
+    // in double precision on the CPU before they ever reach a float matrix.
+    const glm::mat4 &GetViewMatrix( )
+    {
+        this->rebuildMatrices( );
+
+        return this->view;
+    }
+
+    const glm::mat4 &GetProjectionMatrix( )
+    {
+        this->rebuildMatrices( );
+
+        return this->projection;
+    }
+
+    const glm::mat4 &GetViewProjectionMatrix( )
+    {
+        this->rebuildMatrices( );
+
+        return this->viewProjection;
+    }
+
+    // Planes are in the same camera-relative space as the view matrix
+    const Frustum &GetFrustum( )
+    {
+        this->rebuildMatrices( );
+
+        return this->frustum;
+    }
+
+    // Bumped whenever position, orientation, zoom, aspect or clip planes change, so culling and
+    // uniform uploads can skip their work when the number is the same as last time
+    unsigned long long GetVersion( ) const
+    {
+        return this->version;
+    }
+
+    void SetAspectRatio( GLfloat aspect )
+    {
+        if ( aspect != this->aspect )
+        {
+            this->aspect = aspect;
+            this->projectionDirty = true;
+            ++this->version;
+        }
+    }
+
+    void SetClipPlanes( GLfloat nearPlane, GLfloat farPlane )
     {
-        return glm::lookAt( this->position, this->position + this->front, this->up );
+        if ( nearPlane != this->nearPlane || farPlane != this->farPlane )
+        {
+            this->nearPlane = nearPlane;
+            this->farPlane = farPlane;
+            this->projectionDirty = true;
+            ++this->version;
+        }
     }
 
     void ProcessKeyboard( Camera_Movement direction, GLfloat deltaTime )
     {
-        GLfloat velocity = this->movementSpeed * deltaTime;
+        GLdouble velocity = this->movementSpeed * deltaTime;
+
+        if ( 0.0 == velocity )
+        {
+            return;
+        }
+
+        // Moving doesn't touch the camera-relative view, but everything drawn relative to it changes
+        ++this->version;
 
         if ( direction == FORWARD )
         {
-            this->position += this->front * velocity;
+            this->position += glm::dvec3( this->front ) * velocity;
         }
 
         if ( direction == BACKWARD )
         {
-            this->position -= this->front * velocity;
+            this->position -= glm::dvec3( this->front ) * velocity;
         }
 
         if ( direction == LEFT )
         {
-            this->position -= this->right * velocity;
+            this->position -= glm::dvec3( this->right ) * velocity;
         }
 
         if ( direction == RIGHT )
         {
-            this->position += this->right * velocity;
+            this->position += glm::dvec3( this->right ) * velocity;
         }
     }
 
@@ -109,6 +179,8 @@ public:
 
     void ProcessMouseScroll( GLfloat yOffset )
     {
+        GLfloat previousZoom = this->zoom;
+
         if ( this->zoom >= 1.0f && this->zoom <= 45.0f )
         {
             this->zoom -= yOffset;
@@ -123,6 +195,12 @@ public:
         {
             this->zoom = 45.0f;
         }
+
+        if ( previousZoom != this->zoom )
+        {
+            this->projectionDirty = true;
+            ++this->version;
+        }
     }
 
     GLfloat GetYaw( )
@@ -150,14 +228,15 @@ public:
         return this->zoom;
     };
 
-    glm::vec3 GetPosition( )
+    // World position in double precision, the origin everything is rendered relative to
+    glm::dvec3 GetPosition( )
     {
         return this->position;
     };
 
 private:
     // Camera attributes
-    glm::vec3 position;
+    glm::dvec3 position;
     glm::vec3 front;
     glm::vec3 up;
     glm::vec3 right;
@@ -172,6 +251,43 @@ private:
     GLfloat mouseSensitivity;
     GLfloat zoom;
 
+    // Projection options
+    GLfloat aspect;
+    GLfloat nearPlane;
+    GLfloat farPlane;
+
+    // Cached matrices, rebuilt on demand after something they depend on changed
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    Frustum frustum;
+    bool viewDirty;
+    bool projectionDirty;
+    unsigned long long version;
+
+    void rebuildMatrices( )
+    {
+        if ( !this->viewDirty && !this->projectionDirty )
+        {
+            return;
+        }
+
+        if ( this->viewDirty )
+        {
+            this->view = glm::lookAt( glm::vec3( 0.0f ), this->front, this->up );
+        }
+
+        if ( this->projectionDirty )
+        {
+            this->projection = glm::perspective( glm::radians( this->zoom ), this->aspect, this->nearPlane, this->farPlane );
+        }
+
+        this->viewProjection = this->projection * this->view;
+        this->frustum.Extract( this->viewProjection );
+        this->viewDirty = false;
+        this->projectionDirty = false;
+    }
+
     void updateCameraVectors( )
     {
         glm::vec3 front;
@@ -182,6 +298,9 @@ private:
 
         this->right = glm::normalize( glm::cross( this->front, this->worldUp ) );
         this->up = glm::normalize( glm::cross( this->right, this->front ) );
+
+        this->viewDirty = true;
+        ++this->version;
     }
 };
 
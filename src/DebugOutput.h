@@ -0,0 +1,419 @@
+////////////////////////////////////////////////////////////////
+/// DebugOutput.h
+////////////////////////////////////////////////////////////////
+
+#ifndef DEBUG_OUTPUT_H
+#define DEBUG_OUTPUT_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+// GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "Log.h"
+
+// On in debug builds, release builds get an empty stand-in so every call compiles to nothing
+#ifndef DEBUG_OUTPUT_ENABLED
+    #ifdef NDEBUG
+        #define DEBUG_OUTPUT_ENABLED 0
+    #else
+        #define DEBUG_OUTPUT_ENABLED 1
+    #endif
+#endif
+
+#if DEBUG_OUTPUT_ENABLED
+
+// GL error reporting through KHR_debug instead of polling glGetError, which can make the driver
+// synchronise. The driver calls back with each message, possibly from its own threads, and the
+// callback only drops it into a fixed size lock-free queue. Flush prints the queue on the render
+// thread once per frame. Messages below the minimum severity or from disabled sources are turned
+// off in the driver with glDebugMessageControl so they never reach the callback, and a message that
+// was already reported (same id, source, type, severity and text) is only counted, which keeps a
+// per-frame error from flooding the output. Flush says how many repeats it held back.
+class DebugOutput
+{
+public:
+    static const size_t QUEUE_SIZE = 256;
+    static const size_t MESSAGE_LENGTH = 256;
+    static const size_t SEEN_SIZE = 1024;
+
+    DebugOutput( ) : installed( false ), minimumSeverity( GL_DEBUG_SEVERITY_LOW ), writeIndex( 0 ), readIndex( 0 ),
+        dropped( 0 ), repeats( 0 ), reportedDropped( 0 ), reportedRepeats( 0 )
+    {
+        for ( size_t i = 0; i < QUEUE_SIZE; ++i )
+        {
+            this->queue[i].sequence.store( i, std::memory_order_relaxed );
+        }
+
+        for ( size_t i = 0; i < SEEN_SIZE; ++i )
+        {
+            this->seen[i].store( 0, std::memory_order_relaxed );
+        }
+    }
+
+    // Needs a debug context (GLFW_OPENGL_DEBUG_CONTEXT) with KHR_debug or GL 4.3, false without
+    bool Install( )
+    {
+        if ( !GLEW_VERSION_4_3 && !GLEW_KHR_debug )
+        {
+            return false;
+        }
+
+        GLint contextFlags = 0;
+        glGetIntegerv( GL_CONTEXT_FLAGS, &contextFlags );
+
+        if ( 0 == ( contextFlags & GL_CONTEXT_FLAG_DEBUG_BIT ) )
+        {
+            return false;
+        }
+
+        glDebugMessageCallback( &DebugOutput::Callback, this );
+        glEnable( GL_DEBUG_OUTPUT );
+        this->installed = true;
+        this->SetMinimumSeverity( this->minimumSeverity );
+
+        return true;
+    }
+
+    void Uninstall( )
+    {
+        if ( this->installed )
+        {
+            glDisable( GL_DEBUG_OUTPUT );
+            glDebugMessageCallback( nullptr, nullptr );
+            this->installed = false;
+        }
+    }
+
+    bool IsInstalled( ) const
+    {
+        return this->installed;
+    }
+
+    // One of GL_DEBUG_SEVERITY_HIGH/MEDIUM/LOW/NOTIFICATION, everything less severe is switched off
+    void SetMinimumSeverity( GLenum severity )
+    {
+        this->minimumSeverity = severity;
+
+        if ( !this->installed )
+        {
+            return;
+        }
+
+        const GLenum severities[] = { GL_DEBUG_SEVERITY_HIGH, GL_DEBUG_SEVERITY_MEDIUM, GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_NOTIFICATION };
+        bool enabled = true;
+
+        for ( size_t i = 0; i < sizeof( severities ) / sizeof( severities[0] ); ++i )
+        {
+            glDebugMessageControl( GL_DONT_CARE, GL_DONT_CARE, severities[i], 0, nullptr, enabled ? GL_TRUE : GL_FALSE );
+
+            if ( severity == severities[i] )
+            {
+                enabled = false;
+            }
+        }
+    }
+
+    // source is one of the GL_DEBUG_SOURCE_* values, e.g. to silence GL_DEBUG_SOURCE_SHADER_COMPILER
+    void SetSourceEnabled( GLenum source, bool enabled )
+    {
+        if ( this->installed )
+        {
+            glDebugMessageControl( source, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, enabled ? GL_TRUE : GL_FALSE );
+        }
+    }
+
+    // Synchronous output calls back on the thread that made the bad call, so a breakpoint in
+    // Callback shows the culprit, at the cost of the driver's own threading
+    void SetSynchronous( bool synchronous )
+    {
+        if ( this->installed )
+        {
+            synchronous ? glEnable( GL_DEBUG_OUTPUT_SYNCHRONOUS ) : glDisable( GL_DEBUG_OUTPUT_SYNCHRONOUS );
+        }
+    }
+
+    // Prints everything queued since the last call, returns how many messages that was. Only one
+    // thread may flush, normally the render thread at the end of the frame.
+    size_t Flush( )
+    {
+        size_t count = 0;
+
+        for ( ;; )
+        {
+            Slot &slot = this->queue[this->readIndex % QUEUE_SIZE];
+
+            if ( slot.sequence.load( std::memory_order_acquire ) != this->readIndex + 1 )
+            {
+                break;
+            }
+
+            LOG_WARNING( "GL::{}::{}::{} ({}) {}", SeverityName( slot.severity ), SourceName( slot.source ), TypeName( slot.type ),
+                slot.id, slot.text );
+
+            slot.sequence.store( this->readIndex + QUEUE_SIZE, std::memory_order_release );
+            ++this->readIndex;
+            ++count;
+        }
+
+        size_t repeated = this->repeats.load( std::memory_order_relaxed );
+        size_t lost = this->dropped.load( std::memory_order_relaxed );
+
+        if ( repeated != this->reportedRepeats )
+        {
+            LOG_WARNING( "GL::{} repeated messages not shown again", repeated - this->reportedRepeats );
+            this->reportedRepeats = repeated;
+        }
+
+        if ( lost != this->reportedDropped )
+        {
+            LOG_WARNING( "GL::{} messages lost to a full queue", lost - this->reportedDropped );
+            this->reportedDropped = lost;
+        }
+
+        return count;
+    }
+
+    // Messages lost because the queue was full
+    size_t GetDroppedCount( ) const
+    {
+        return this->dropped.load( std::memory_order_relaxed );
+    }
+
+    // Messages not printed because the same one had been printed before
+    size_t GetRepeatCount( ) const
+    {
+        return this->repeats.load( std::memory_order_relaxed );
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        GLenum source;
+        GLenum type;
+        GLenum severity;
+        GLuint id;
+        char text[MESSAGE_LENGTH];
+    };
+
+    bool installed;
+    GLenum minimumSeverity;
+
+    // Bounded multi-producer queue, a slot is free to write for ticket n when its sequence is n and
+    // readable when it is n + 1
+    Slot queue[QUEUE_SIZE];
+    std::atomic<size_t> writeIndex;
+    size_t readIndex;
+
+    // Open addressing set of message keys already reported, 0 marks an empty entry
+    std::atomic<uint64_t> seen[SEEN_SIZE];
+
+    std::atomic<size_t> dropped;
+    std::atomic<size_t> repeats;
+
+    // The counts as of the last Flush, only touched by the flushing thread
+    size_t reportedDropped;
+    size_t reportedRepeats;
+
+    static void APIENTRY Callback( GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message,
+        const void *userParam )
+    {
+        DebugOutput *output = static_cast<DebugOutput *>( const_cast<void *>( userParam ) );
+
+        if ( !output->MarkSeen( source, type, id, severity, length, message ) )
+        {
+            output->repeats.fetch_add( 1, std::memory_order_relaxed );
+            return;
+        }
+
+        output->Push( source, type, id, severity, length, message );
+    }
+
+    // Returns false if this message was seen before. The text is part of the key since drivers
+    // reuse one id for many different messages, e.g. every GL_INVALID_OPERATION. When the set is
+    // full messages are let through rather than lost.
+    bool MarkSeen( GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message )
+    {
+        // FNV-1a over the numeric fields and the text
+        uint64_t key = 0xCBF29CE484222325ULL;
+        const uint32_t fields[] = { source, type, id, severity };
+
+        for ( size_t i = 0; i < sizeof( fields ) / sizeof( fields[0] ); ++i )
+        {
+            key = ( key ^ fields[i] ) * 0x100000001B3ULL;
+        }
+
+        for ( GLsizei i = 0; ( length < 0 ) ? '\0' != message[i] : i < length; ++i )
+        {
+            key = ( key ^ ( unsigned char )message[i] ) * 0x100000001B3ULL;
+        }
+
+        key = ( 0 == key ) ? 1 : key;
+        size_t index = ( size_t )( ( key * 0x9E3779B97F4A7C15ULL ) >> 32 ) % SEEN_SIZE;
+
+        for ( size_t probe = 0; probe < 16; ++probe )
+        {
+            std::atomic<uint64_t> &entry = this->seen[( index + probe ) % SEEN_SIZE];
+            uint64_t current = entry.load( std::memory_order_relaxed );
+
+            if ( key == current )
+            {
+                return false;
+            }
+
+            if ( 0 == current )
+            {
+                if ( entry.compare_exchange_strong( current, key, std::memory_order_relaxed ) )
+                {
+                    return true;
+                }
+
+                if ( key == current )
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    void Push( GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message )
+    {
+        size_t ticket = this->writeIndex.load( std::memory_order_relaxed );
+        Slot *slot;
+
+        for ( ;; )
+        {
+            slot = &this->queue[ticket % QUEUE_SIZE];
+            size_t sequence = slot->sequence.load( std::memory_order_acquire );
+
+            if ( sequence == ticket )
+            {
+                if ( this->writeIndex.compare_exchange_weak( ticket, ticket + 1, std::memory_order_relaxed ) )
+                {
+                    break;
+                }
+            }
+            else if ( sequence < ticket )
+            {
+                // Full, the reader hasn't caught up
+                this->dropped.fetch_add( 1, std::memory_order_relaxed );
+                return;
+            }
+            else
+            {
+                ticket = this->writeIndex.load( std::memory_order_relaxed );
+            }
+        }
+
+        size_t size = ( length < 0 ) ? std::strlen( message ) : ( size_t )length;
+        size = ( size < MESSAGE_LENGTH - 1 ) ? size : MESSAGE_LENGTH - 1;
+
+        slot->source = source;
+        slot->type = type;
+        slot->severity = severity;
+        slot->id = id;
+        std::memcpy( slot->text, message, size );
+        slot->text[size] = '\0';
+
+        slot->sequence.store( ticket + 1, std::memory_order_release );
+    }
+
+    static const char *SeverityName( GLenum severity )
+    {
+        switch ( severity )
+        {
+            case GL_DEBUG_SEVERITY_HIGH: return "HIGH";
+            case GL_DEBUG_SEVERITY_MEDIUM: return "MEDIUM";
+            case GL_DEBUG_SEVERITY_LOW: return "LOW";
+            default: return "NOTIFICATION";
+        }
+    }
+
+    static const char *SourceName( GLenum source )
+    {
+        switch ( source )
+        {
+            case GL_DEBUG_SOURCE_API: return "API";
+            case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "WINDOW_SYSTEM";
+            case GL_DEBUG_SOURCE_SHADER_COMPILER: return "SHADER_COMPILER";
+            case GL_DEBUG_SOURCE_THIRD_PARTY: return "THIRD_PARTY";
+            case GL_DEBUG_SOURCE_APPLICATION: return "APPLICATION";
+            default: return "OTHER";
+        }
+    }
+
+    static const char *TypeName( GLenum type )
+    {
+        switch ( type )
+        {
+            case GL_DEBUG_TYPE_ERROR: return "ERROR";
+            case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "DEPRECATED_BEHAVIOR";
+            case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "UNDEFINED_BEHAVIOR";
+            case GL_DEBUG_TYPE_PORTABILITY: return "PORTABILITY";
+            case GL_DEBUG_TYPE_PERFORMANCE: return "PERFORMANCE";
+            case GL_DEBUG_TYPE_MARKER: return "MARKER";
+            default: return "OTHER";
+        }
+    }
+
+    DebugOutput( const DebugOutput & ) = delete;
+    DebugOutput &operator=( const DebugOutput & ) = delete;
+};
+
+#else
+
+// Release builds: same interface, nothing installed and nothing left to call
+class DebugOutput
+{
+public:
+    bool Install( )
+    {
+        return false;
+    }
+
+    void Uninstall( )
+    {
+    }
+
+    bool IsInstalled( ) const
+    {
+        return false;
+    }
+
+    void SetMinimumSeverity( GLenum )
+    {
+    }
+
+    void SetSourceEnabled( GLenum, bool )
+    {
+    }
+
+    void SetSynchronous( bool )
+    {
+    }
+
+    size_t Flush( )
+    {
+        return 0;
+    }
+
+    size_t GetDroppedCount( ) const
+    {
+        return 0;
+    }
+
+    size_t GetRepeatCount( ) const
+    {
+        return 0;
+    }
+};
+
+#endif // DEBUG_OUTPUT_ENABLED
+
+#endif // DEBUG_OUTPUT_H
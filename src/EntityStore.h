@@ -0,0 +1,806 @@
+////////////////////////////////////////////////////////////////
+/// EntityStore.h
+////////////////////////////////////////////////////////////////
+
+#ifndef ENTITY_STORE_H
+#define ENTITY_STORE_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+// GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+// OpenGL Math
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Frustum.h"
+#include "Mat4Multiply.h"
+#include "JobSystem.h"
+#include "FrameArena.h"
+
+// Stable handle to an entity, the generation catches handles that outlived their entity
+struct Entity
+{
+    GLuint index;
+    GLuint generation;
+};
+
+const Entity NULL_ENTITY = { 0xFFFFFFFFu, 0 };
+
+// One entry of the per-frame draw list, sorted by program then VAO to keep state changes down
+struct DrawItem
+{
+    GLuint program;
+    GLuint vao;
+    GLsizei vertexCount;
+    GLuint features;
+    GLuint denseIndex;
+};
+
+enum Transform_Flags
+{
+    TRANSFORM_LOCAL_DIRTY   = 1,
+    TRANSFORM_WORLD_CHANGED = 2
+};
+
+const GLuint NO_PARENT = 0xFFFFFFFFu;
+
+// Every component lives in its own contiguous array indexed by the same dense index, so each
+// per-frame system only streams through the columns it actually touches. Removing an entity
+// swaps the last one into its place, the slot table keeps handles valid across the move.
+//
+// Entities can be parented to each other. The dense order is kept sorted by hierarchy depth,
+// so every parent sits before its children and each depth level is one contiguous range.
+// UpdateTransforms only revisits entities whose local transform changed and their descendants,
+// level by level, and does nothing at all when the scene is static.
+//
+// Positions are kept in double precision and world matrices only hold rotation and scale, with
+// the world translation in a separate double column. Matrices handed to the GPU and the culling
+// tests are built relative to a camera origin, so floats only ever see small offsets and large
+// worlds don't jitter.
+class EntityStore
+{
+public:
+    EntityStore( GLuint capacity = 0 )
+    : orderDirty( false ), version( 1 )
+    {
+        this->Reserve( capacity );
+    }
+
+    void Reserve( GLuint capacity )
+    {
+        this->VisitColumns( [&]( auto &column ) { column.reserve( capacity ); } );
+        this->slots.reserve( capacity );
+    }
+
+    // position is relative to the parent, or the world position for roots
+    Entity Create( const glm::dvec3 &position = glm::dvec3( 0.0 ), Entity parent = NULL_ENTITY )
+    {
+        GLuint slot;
+
+        if ( !this->freeSlots.empty( ) )
+        {
+            slot = this->freeSlots.back( );
+            this->freeSlots.pop_back( );
+        }
+        else
+        {
+            slot = ( GLuint )this->slots.size( );
+            Slot fresh = { 0, 0 };
+            this->slots.push_back( fresh );
+        }
+
+        GLuint dense = ( GLuint )this->positions.size( );
+        this->slots[slot].dense = dense;
+
+        GLuint parentDense = NO_PARENT;
+        GLuint depth = 0;
+
+        if ( this->IsAlive( parent ) )
+        {
+            parentDense = this->IndexOf( parent );
+            depth = this->depths[parentDense] + 1;
+        }
+        else
+        {
+            parent = NULL_ENTITY;
+        }
+
+        // Appending keeps the depth order as long as we don't go back up a level
+        if ( dense > 0 && depth < this->depths.back( ) )
+        {
+            this->orderDirty = true;
+        }
+        else if ( !this->orderDirty )
+        {
+            if ( depth == this->levelEnds.size( ) )
+            {
+                this->levelEnds.push_back( dense + 1 );
+            }
+            else
+            {
+                this->levelEnds[depth] = dense + 1;
+            }
+        }
+
+        this->positions.push_back( position );
+        this->rotations.push_back( glm::quat( 1.0f, 0.0f, 0.0f, 0.0f ) );
+        this->scales.push_back( glm::vec3( 1.0f ) );
+        this->locals.push_back( glm::mat4( 1.0f ) );
+        this->worlds.push_back( glm::mat4( 1.0f ) );
+        this->worldPositions.push_back( position );
+        this->boundsCenters.push_back( glm::vec3( 0.0f ) );
+        this->boundsRadii.push_back( 0.0f );
+        this->worldCenters.push_back( position );
+        this->worldRadii.push_back( 0.0f );
+        this->vaos.push_back( 0 );
+        this->programs.push_back( 0 );
+        this->vertexCounts.push_back( 0 );
+        this->features.push_back( 0 );
+        this->owners.push_back( slot );
+        this->parentHandles.push_back( parent );
+        this->parents.push_back( parentDense );
+        this->depths.push_back( depth );
+        this->flags.push_back( 0 );
+
+        this->MarkDirty( dense );
+        ++this->version;
+
+        Entity entity = { slot, this->slots[slot].generation };
+
+        return entity;
+    }
+
+    // Children of a destroyed entity become roots on the next update
+    void Destroy( Entity entity )
+    {
+        if ( !this->IsAlive( entity ) )
+        {
+            return;
+        }
+
+        GLuint dense = this->slots[entity.index].dense;
+        GLuint last = ( GLuint )this->positions.size( ) - 1;
+
+        this->VisitColumns( [&]( auto &column )
+        {
+            column[dense] = column[last];
+            column.pop_back( );
+        } );
+
+        if ( dense != last )
+        {
+            this->slots[this->owners[dense]].dense = dense;
+        }
+
+        ++this->slots[entity.index].generation;
+        this->freeSlots.push_back( entity.index );
+
+        // The swap broke both the depth order and the dense parent links
+        this->orderDirty = true;
+        ++this->version;
+    }
+
+    bool IsAlive( Entity entity ) const
+    {
+        return entity.index < this->slots.size( ) && this->slots[entity.index].generation == entity.generation;
+    }
+
+    GLuint Size( ) const
+    {
+        return ( GLuint )this->positions.size( );
+    }
+
+    // Dense index of a live entity, only valid until the next Destroy or UpdateTransforms
+    GLuint IndexOf( Entity entity ) const
+    {
+        return this->slots[entity.index].dense;
+    }
+
+    // Returns false if the parent is dead or is the entity itself or one of its descendants
+    bool SetParent( Entity entity, Entity parent )
+    {
+        if ( !this->IsAlive( entity ) )
+        {
+            return false;
+        }
+
+        if ( this->IsAlive( parent ) )
+        {
+            for ( Entity up = parent; this->IsAlive( up ); up = this->parentHandles[this->IndexOf( up )] )
+            {
+                if ( up.index == entity.index )
+                {
+                    return false;
+                }
+            }
+        }
+        else if ( parent.index != NULL_ENTITY.index )
+        {
+            return false;
+        }
+
+        GLuint dense = this->IndexOf( entity );
+        this->parentHandles[dense] = parent;
+        this->MarkDirty( dense );
+        this->orderDirty = true;
+
+        return true;
+    }
+
+    Entity GetParent( Entity entity ) const
+    {
+        return this->parentHandles[this->IndexOf( entity )];
+    }
+
+    void SetPosition( Entity entity, const glm::dvec3 &position )
+    {
+        GLuint dense = this->IndexOf( entity );
+        this->positions[dense] = position;
+        this->MarkDirty( dense );
+    }
+
+    void SetRotation( Entity entity, const glm::quat &rotation )
+    {
+        GLuint dense = this->IndexOf( entity );
+        this->rotations[dense] = rotation;
+        this->MarkDirty( dense );
+    }
+
+    void SetScale( Entity entity, const glm::vec3 &scale )
+    {
+        GLuint dense = this->IndexOf( entity );
+        this->scales[dense] = scale;
+        this->MarkDirty( dense );
+    }
+
+    void SetBounds( Entity entity, const glm::vec3 &center, GLfloat radius )
+    {
+        GLuint dense = this->IndexOf( entity );
+        this->boundsCenters[dense] = center;
+        this->boundsRadii[dense] = radius;
+        this->MarkDirty( dense );
+    }
+
+    // features are the shader permutation bits the entity wants, passed along for programs (like an
+    // uber shader) that pick features per draw
+    void SetRenderable( Entity entity, GLuint program, GLuint vao, GLsizei vertexCount, GLuint features = 0 )
+    {
+        GLuint dense = this->IndexOf( entity );
+        this->programs[dense] = program;
+        this->vaos[dense] = vao;
+        this->vertexCounts[dense] = vertexCount;
+        this->features[dense] = features;
+        ++this->version;
+    }
+
+    // Points every entity drawn with one program at another, e.g. after a shader was rebuilt
+    void ReplaceProgram( GLuint oldProgram, GLuint newProgram )
+    {
+        for ( size_t i = 0; i < this->programs.size( ); ++i )
+        {
+            if ( oldProgram == this->programs[i] )
+            {
+                this->programs[i] = newProgram;
+            }
+        }
+
+        ++this->version;
+    }
+
+    // Same, limited to the entities that want exactly these features, e.g. to move them off the uber
+    // shader once their specialised variant is built
+    void ReplaceProgram( GLuint oldProgram, GLuint newProgram, GLuint features )
+    {
+        for ( size_t i = 0; i < this->programs.size( ); ++i )
+        {
+            if ( oldProgram == this->programs[i] && features == this->features[i] )
+            {
+                this->programs[i] = newProgram;
+            }
+        }
+
+        ++this->version;
+    }
+
+    glm::dvec3 GetPosition( Entity entity ) const
+    {
+        return this->positions[this->IndexOf( entity )];
+    }
+
+    glm::dvec3 GetWorldPosition( Entity entity ) const
+    {
+        return this->worldPositions[this->IndexOf( entity )];
+    }
+
+    // Model matrix with the translation taken relative to origin (the camera position)
+    glm::mat4 GetRelativeMatrix( Entity entity, const glm::dvec3 &origin ) const
+    {
+        return this->GetRelativeMatrixAt( this->IndexOf( entity ), origin );
+    }
+
+    glm::mat4 GetRelativeMatrixAt( GLuint dense, const glm::dvec3 &origin ) const
+    {
+        glm::mat4 model = this->worlds[dense];
+        model[3] = glm::vec4( glm::vec3( this->worldPositions[dense] - origin ), 1.0f );
+
+        return model;
+    }
+
+    // Bumped by anything that can change what culling or the draw list produce: entities coming
+    // and going, render handles, and UpdateTransforms moving something
+    unsigned long long GetVersion( ) const
+    {
+        return this->version;
+    }
+
+    // Number of world matrices recomputed by the last UpdateTransforms
+    GLuint GetUpdatedCount( ) const
+    {
+        return ( GLuint )this->changed.size( );
+    }
+
+    // Transform system: walks the depth levels from the shallowest dirty one, rebuilding
+    // local = R * S for dirty entities and world = parent world * local for them and
+    // everything below them, one level at a time with the SSE multiply. World positions follow in double.
+    void UpdateTransforms( )
+    {
+        if ( this->orderDirty )
+        {
+            this->RebuildOrder( );
+        }
+
+        this->changed.clear( );
+
+        if ( this->dirtyList.empty( ) )
+        {
+            return;
+        }
+
+        // Dense order is depth order, so sorting the dirty list groups it by level
+        std::sort( this->dirtyList.begin( ), this->dirtyList.end( ) );
+
+        GLuint levelCount = ( GLuint )this->levelEnds.size( );
+        size_t next = 0;
+        bool parentsChanged = false;
+
+        for ( GLuint depth = this->depths[this->dirtyList[0]]; depth < levelCount && ( next < this->dirtyList.size( ) || parentsChanged ); ++depth )
+        {
+            GLuint begin = ( 0 == depth ) ? 0 : this->levelEnds[depth - 1];
+            GLuint end = this->levelEnds[depth];
+
+            this->batch.clear( );
+
+            if ( parentsChanged )
+            {
+                // Something above moved, so any entity on this level may need its world matrix
+                for ( GLuint i = begin; i < end; ++i )
+                {
+                    GLubyte f = this->flags[i];
+                    GLuint p = this->parents[i];
+
+                    if ( f & TRANSFORM_LOCAL_DIRTY )
+                    {
+                        this->ComputeLocal( i );
+                    }
+
+                    if ( ( f & TRANSFORM_LOCAL_DIRTY ) || ( NO_PARENT != p && ( this->flags[p] & TRANSFORM_WORLD_CHANGED ) ) )
+                    {
+                        this->flags[i] = TRANSFORM_WORLD_CHANGED;
+                        this->batch.push_back( i );
+                    }
+                }
+
+                while ( next < this->dirtyList.size( ) && this->dirtyList[next] < end )
+                {
+                    ++next;
+                }
+            }
+            else
+            {
+                // Nothing above moved, only the entities that were touched directly
+                for ( ; next < this->dirtyList.size( ) && this->dirtyList[next] < end; ++next )
+                {
+                    GLuint i = this->dirtyList[next];
+
+                    this->ComputeLocal( i );
+                    this->flags[i] = TRANSFORM_WORLD_CHANGED;
+                    this->batch.push_back( i );
+                }
+            }
+
+            parentsChanged = !this->batch.empty( );
+
+            if ( !parentsChanged )
+            {
+                continue;
+            }
+
+            if ( 0 == depth )
+            {
+                for ( size_t n = 0; n < this->batch.size( ); ++n )
+                {
+                    GLuint i = this->batch[n];
+                    this->worlds[i] = this->locals[i];
+                    this->worldPositions[i] = this->positions[i];
+                }
+            }
+            else
+            {
+                Mat4MultiplyParents( this->worlds.data( ), this->locals.data( ), this->parents.data( ), this->batch.data( ), this->batch.size( ) );
+                this->UpdateWorldPositions( this->batch );
+            }
+
+            this->UpdateBounds( this->batch );
+            this->changed.insert( this->changed.end( ), this->batch.begin( ), this->batch.end( ) );
+        }
+
+        for ( size_t n = 0; n < this->changed.size( ); ++n )
+        {
+            this->flags[this->changed[n]] = 0;
+        }
+
+        if ( !this->changed.empty( ) )
+        {
+            ++this->version;
+        }
+
+        this->dirtyList.clear( );
+    }
+
+    // Culling system: collects the dense index of every entity whose world sphere touches the frustum.
+    // Any vector-like list works, frame-scoped ones can use a FrameAllocator.
+    // The frustum is in camera-relative space, origin is the camera's world position.
+    template<typename VisibleList>
+    void Cull( const Frustum &frustum, const glm::dvec3 &origin, VisibleList &visible ) const
+    {
+        visible.resize( this->Size( ) );
+        visible.resize( this->CullRange( frustum, origin, 0, this->Size( ), visible.data( ) ) );
+    }
+
+    // Same result as Cull, with the entities split into chunks across the job system. Each chunk
+    // writes into its own slice of a scratch buffer taken from the calling thread's frame arena.
+    template<typename VisibleList>
+    void Cull( const Frustum &frustum, const glm::dvec3 &origin, VisibleList &visible, JobSystem &jobs ) const
+    {
+        const GLuint grain = 16384;
+        GLuint count = this->Size( );
+        GLuint chunks = ( count + grain - 1 ) / grain;
+
+        if ( chunks < 2 )
+        {
+            this->Cull( frustum, origin, visible );
+            return;
+        }
+
+        FrameArena &arena = FrameArena::ForThisThread( );
+        GLuint *scratch = arena.AllocateArray<GLuint>( count );
+        GLuint *found = arena.AllocateArray<GLuint>( chunks );
+
+        jobs.ParallelFor( chunks, 1, [&]( GLuint begin, GLuint end )
+        {
+            for ( GLuint chunk = begin; chunk < end; ++chunk )
+            {
+                GLuint first = chunk * grain;
+                found[chunk] = this->CullRange( frustum, origin, first, std::min( count, first + grain ), scratch + first );
+            }
+        } );
+
+        visible.clear( );
+
+        for ( GLuint chunk = 0; chunk < chunks; ++chunk )
+        {
+            visible.insert( visible.end( ), scratch + chunk * grain, scratch + chunk * grain + found[chunk] );
+        }
+    }
+
+    // Writes the visible dense indices in [begin, end) to out and returns how many there were
+    GLuint CullRange( const Frustum &frustum, const glm::dvec3 &origin, GLuint begin, GLuint end, GLuint *out ) const
+    {
+        const glm::vec4 *planes = frustum.planes;
+        GLuint written = 0;
+
+        for ( GLuint i = begin; i < end; ++i )
+        {
+            // Subtract in double first, the offset is what fits in a float
+            glm::vec3 c( this->worldCenters[i] - origin );
+            GLfloat negRadius = -this->worldRadii[i];
+            bool inside = true;
+
+            for ( int p = 0; p < FRUSTUM_PLANE_COUNT && inside; ++p )
+            {
+                inside = planes[p].x * c.x + planes[p].y * c.y + planes[p].z * c.z + planes[p].w >= negRadius;
+            }
+
+            out[written] = i;
+            written += inside ? 1 : 0;
+        }
+
+        return written;
+    }
+
+    // Draw-list system: gathers render handles for the visible set and sorts them by state
+    template<typename VisibleList, typename DrawList>
+    void BuildDrawList( const VisibleList &visible, DrawList &drawList ) const
+    {
+        drawList.clear( );
+        drawList.reserve( visible.size( ) );
+
+        for ( size_t i = 0; i < visible.size( ); ++i )
+        {
+            GLuint dense = visible[i];
+
+            if ( 0 == this->vertexCounts[dense] )
+            {
+                continue;
+            }
+
+            DrawItem item = { this->programs[dense], this->vaos[dense], this->vertexCounts[dense], this->features[dense], dense };
+            drawList.push_back( item );
+        }
+
+        std::sort( drawList.begin( ), drawList.end( ), []( const DrawItem &a, const DrawItem &b )
+        {
+            if ( a.program != b.program )
+            {
+                return a.program < b.program;
+            }
+
+            if ( a.vao != b.vao )
+            {
+                return a.vao < b.vao;
+            }
+
+            return a.denseIndex < b.denseIndex;
+        } );
+    }
+
+private:
+    struct Slot
+    {
+        GLuint dense;
+        GLuint generation;
+    };
+
+    // Transform components
+    std::vector<glm::dvec3> positions;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<glm::dvec3> worldPositions;
+
+    // Bounding spheres, local and world space
+    std::vector<glm::vec3> boundsCenters;
+    std::vector<GLfloat> boundsRadii;
+    std::vector<glm::dvec3> worldCenters;
+    std::vector<GLfloat> worldRadii;
+
+    // Render handles
+    std::vector<GLuint> vaos;
+    std::vector<GLuint> programs;
+    std::vector<GLsizei> vertexCounts;
+    std::vector<GLuint> features;
+
+    // Hierarchy, parents and depths are derived from the handles when the order is rebuilt
+    std::vector<Entity> parentHandles;
+    std::vector<GLuint> parents;
+    std::vector<GLuint> depths;
+    std::vector<GLubyte> flags;
+
+    // Dense index -> slot, slot -> dense index
+    std::vector<GLuint> owners;
+    std::vector<Slot> slots;
+    std::vector<GLuint> freeSlots;
+
+    // One past the last dense index of each depth level
+    std::vector<GLuint> levelEnds;
+    bool orderDirty;
+    unsigned long long version;
+
+    // Entities whose local transform changed since the last update
+    std::vector<GLuint> dirtyList;
+
+    // Scratch for UpdateTransforms, kept to avoid allocating every frame
+    std::vector<GLuint> batch;
+    std::vector<GLuint> changed;
+
+    template<typename Op>
+    void VisitColumns( Op op )
+    {
+        op( this->positions );
+        op( this->rotations );
+        op( this->scales );
+        op( this->locals );
+        op( this->worlds );
+        op( this->worldPositions );
+        op( this->boundsCenters );
+        op( this->boundsRadii );
+        op( this->worldCenters );
+        op( this->worldRadii );
+        op( this->vaos );
+        op( this->programs );
+        op( this->vertexCounts );
+        op( this->features );
+        op( this->parentHandles );
+        op( this->parents );
+        op( this->depths );
+        op( this->flags );
+        op( this->owners );
+    }
+
+    void MarkDirty( GLuint dense )
+    {
+        if ( !( this->flags[dense] & TRANSFORM_LOCAL_DIRTY ) )
+        {
+            this->flags[dense] |= TRANSFORM_LOCAL_DIRTY;
+            this->dirtyList.push_back( dense );
+        }
+    }
+
+    void ComputeLocal( GLuint i )
+    {
+        glm::mat3 r = glm::mat3_cast( this->rotations[i] );
+        const glm::vec3 &s = this->scales[i];
+        glm::mat4 &local = this->locals[i];
+
+        // Translation stays out of the float matrices, see UpdateWorldPositions
+        local[0] = glm::vec4( r[0] * s.x, 0.0f );
+        local[1] = glm::vec4( r[1] * s.y, 0.0f );
+        local[2] = glm::vec4( r[2] * s.z, 0.0f );
+        local[3] = glm::vec4( 0.0f, 0.0f, 0.0f, 1.0f );
+    }
+
+    // world position = parent world position + parent rotation/scale * local position, in double
+    void UpdateWorldPositions( const std::vector<GLuint> &indices )
+    {
+        for ( size_t n = 0; n < indices.size( ); ++n )
+        {
+            GLuint i = indices[n];
+            const glm::mat4 &parent = this->worlds[this->parents[i]];
+            const glm::dvec3 &t = this->positions[i];
+
+            this->worldPositions[i] = this->worldPositions[this->parents[i]]
+                + glm::dvec3( parent[0] ) * t.x + glm::dvec3( parent[1] ) * t.y + glm::dvec3( parent[2] ) * t.z;
+        }
+    }
+
+    void UpdateBounds( const std::vector<GLuint> &indices )
+    {
+        for ( size_t n = 0; n < indices.size( ); ++n )
+        {
+            GLuint i = indices[n];
+            const glm::mat4 &world = this->worlds[i];
+
+            this->worldCenters[i] = this->worldPositions[i] + glm::dvec3( world * glm::vec4( this->boundsCenters[i], 0.0f ) );
+
+            // Inherited scale can be non-uniform, so take the longest basis vector
+            GLfloat sx = glm::dot( glm::vec3( world[0] ), glm::vec3( world[0] ) );
+            GLfloat sy = glm::dot( glm::vec3( world[1] ), glm::vec3( world[1] ) );
+            GLfloat sz = glm::dot( glm::vec3( world[2] ), glm::vec3( world[2] ) );
+            this->worldRadii[i] = this->boundsRadii[i] * std::sqrt( std::max( sx, std::max( sy, sz ) ) );
+        }
+    }
+
+    // Re-resolves parent links and depths, then counting-sorts every column by depth
+    void RebuildOrder( )
+    {
+        GLuint count = this->Size( );
+
+        for ( GLuint i = 0; i < count; ++i )
+        {
+            Entity parent = this->parentHandles[i];
+
+            if ( this->IsAlive( parent ) )
+            {
+                this->parents[i] = this->IndexOf( parent );
+            }
+            else
+            {
+                if ( parent.index != NULL_ENTITY.index )
+                {
+                    this->parentHandles[i] = NULL_ENTITY;
+                    this->flags[i] |= TRANSFORM_LOCAL_DIRTY;
+                }
+
+                this->parents[i] = NO_PARENT;
+            }
+
+            this->depths[i] = NO_PARENT;
+        }
+
+        // Parents may sit after their children here, so resolve each chain bottom up
+        std::vector<GLuint> chain;
+        GLuint levelCount = 0;
+
+        for ( GLuint i = 0; i < count; ++i )
+        {
+            GLuint node = i;
+
+            while ( NO_PARENT != node && NO_PARENT == this->depths[node] )
+            {
+                chain.push_back( node );
+                node = this->parents[node];
+            }
+
+            GLuint depth = ( NO_PARENT == node ) ? 0 : this->depths[node] + 1;
+
+            while ( !chain.empty( ) )
+            {
+                this->depths[chain.back( )] = depth++;
+                chain.pop_back( );
+            }
+
+            levelCount = std::max( levelCount, this->depths[i] + 1 );
+        }
+
+        this->levelEnds.assign( levelCount, 0 );
+
+        for ( GLuint i = 0; i < count; ++i )
+        {
+            ++this->levelEnds[this->depths[i]];
+        }
+
+        std::vector<GLuint> offsets( levelCount, 0 );
+
+        for ( GLuint depth = 1; depth < levelCount; ++depth )
+        {
+            offsets[depth] = offsets[depth - 1] + this->levelEnds[depth - 1];
+        }
+
+        for ( GLuint depth = 0; depth < levelCount; ++depth )
+        {
+            this->levelEnds[depth] += offsets[depth];
+        }
+
+        std::vector<GLuint> order( count );
+        std::vector<GLuint> inverse( count );
+
+        for ( GLuint i = 0; i < count; ++i )
+        {
+            GLuint to = offsets[this->depths[i]]++;
+            order[to] = i;
+            inverse[i] = to;
+        }
+
+        this->VisitColumns( [&]( auto &column )
+        {
+            typename std::decay<decltype( column )>::type sorted;
+            sorted.reserve( column.capacity( ) );
+
+            for ( GLuint to = 0; to < count; ++to )
+            {
+                sorted.push_back( column[order[to]] );
+            }
+
+            column.swap( sorted );
+        } );
+
+        this->dirtyList.clear( );
+
+        for ( GLuint i = 0; i < count; ++i )
+        {
+            this->slots[this->owners[i]].dense = i;
+
+            if ( NO_PARENT != this->parents[i] )
+            {
+                this->parents[i] = inverse[this->parents[i]];
+            }
+
+            if ( this->flags[i] & TRANSFORM_LOCAL_DIRTY )
+            {
+                this->dirtyList.push_back( i );
+            }
+        }
+
+        this->orderDirty = false;
+    }
+};
+
+#endif // ENTITY_STORE_H
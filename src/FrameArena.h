@@ -0,0 +1,272 @@
+////////////////////////////////////////////////////////////////
+/// FrameArena.h
+////////////////////////////////////////////////////////////////
+
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for data that only lives until the end of the frame (draw lists, visible sets,
+// uniform staging). Allocating is a pointer bump and there is no per-allocation free. When the
+// current block runs out another one is chained on, and Reset folds the chain back into a single
+// block sized for the high-water mark, so a steady workload stops calling malloc after a frame or two.
+class FrameArena
+{
+public:
+    static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+    FrameArena( size_t blockSize = DEFAULT_BLOCK_SIZE )
+    : blockSize( blockSize ), used( 0 ), highWater( 0 ), overflowCount( 0 )
+    {
+        this->AddBlock( blockSize );
+    }
+
+    ~FrameArena( )
+    {
+        this->FreeBlocks( );
+    }
+
+    void *Allocate( size_t size, size_t alignment = alignof( std::max_align_t ) )
+    {
+        Block *block = &this->blocks.back( );
+        uintptr_t base = reinterpret_cast<uintptr_t>( block->memory );
+        uintptr_t aligned = ( base + block->offset + alignment - 1 ) & ~( uintptr_t )( alignment - 1 );
+
+        if ( aligned + size > base + block->size )
+        {
+            // Overflow, chain on a block big enough for this request
+            ++this->overflowCount;
+            this->AddBlock( std::max( this->blockSize, size + alignment ) );
+
+            block = &this->blocks.back( );
+            base = reinterpret_cast<uintptr_t>( block->memory );
+            aligned = ( base + alignment - 1 ) & ~( uintptr_t )( alignment - 1 );
+        }
+
+        size_t consumed = ( aligned + size ) - ( base + block->offset );
+        block->offset += consumed;
+        this->used += consumed;
+
+        return reinterpret_cast<void *>( aligned );
+    }
+
+    // Uninitialized storage, only for types that need no destructor since nothing runs one
+    template<typename T>
+    T *AllocateArray( size_t count )
+    {
+        static_assert( std::is_trivially_destructible<T>::value, "FrameArena never runs destructors" );
+
+        return static_cast<T *>( this->Allocate( sizeof( T ) * count, alignof( T ) ) );
+    }
+
+    // Frame end: everything handed out since the last Reset becomes invalid
+    void Reset( )
+    {
+        this->highWater = std::max( this->highWater, this->used );
+
+        if ( this->blocks.size( ) > 1 )
+        {
+            // Grow the single block so next frame fits without chaining, with some headroom for alignment
+            this->FreeBlocks( );
+            this->blockSize = std::max( this->blockSize, this->highWater + this->highWater / 8 );
+            this->AddBlock( this->blockSize );
+        }
+        else
+        {
+            this->blocks.back( ).offset = 0;
+        }
+
+        this->used = 0;
+    }
+
+    size_t GetUsed( ) const
+    {
+        return this->used;
+    }
+
+    size_t GetHighWater( ) const
+    {
+        return std::max( this->highWater, this->used );
+    }
+
+    size_t GetCapacity( ) const
+    {
+        size_t capacity = 0;
+
+        for ( size_t i = 0; i < this->blocks.size( ); ++i )
+        {
+            capacity += this->blocks[i].size;
+        }
+
+        return capacity;
+    }
+
+    // Number of times a block had to be chained on since the arena was created
+    size_t GetOverflowCount( ) const
+    {
+        return this->overflowCount;
+    }
+
+    // The calling thread's arena, created on first use
+    static FrameArena &ForThisThread( );
+
+    // Resets every thread's arena, only call this when no other thread is allocating (frame end)
+    static void ResetAll( )
+    {
+        std::lock_guard<std::mutex> guard( Registry( ).lock );
+
+        for ( size_t i = 0; i < Registry( ).arenas.size( ); ++i )
+        {
+            Registry( ).arenas[i]->Reset( );
+        }
+    }
+
+    // Sums of every thread's statistics, for the debug overlay and logs
+    static size_t GetTotalHighWater( )
+    {
+        std::lock_guard<std::mutex> guard( Registry( ).lock );
+        size_t total = 0;
+
+        for ( size_t i = 0; i < Registry( ).arenas.size( ); ++i )
+        {
+            total += Registry( ).arenas[i]->GetHighWater( );
+        }
+
+        return total;
+    }
+
+private:
+    struct Block
+    {
+        unsigned char *memory;
+        size_t size;
+        size_t offset;
+    };
+
+    struct ArenaRegistry
+    {
+        std::mutex lock;
+        std::vector<FrameArena *> arenas;
+    };
+
+    std::vector<Block> blocks;
+    size_t blockSize;
+    size_t used;
+    size_t highWater;
+    size_t overflowCount;
+
+    static ArenaRegistry &Registry( )
+    {
+        static ArenaRegistry registry;
+        return registry;
+    }
+
+    void AddBlock( size_t size )
+    {
+        Block block;
+        block.memory = static_cast<unsigned char *>( std::malloc( size ) );
+
+        if ( nullptr == block.memory )
+        {
+            throw std::bad_alloc( );
+        }
+
+        block.size = size;
+        block.offset = 0;
+        this->blocks.push_back( block );
+    }
+
+    void FreeBlocks( )
+    {
+        for ( size_t i = 0; i < this->blocks.size( ); ++i )
+        {
+            std::free( this->blocks[i].memory );
+        }
+
+        this->blocks.clear( );
+    }
+
+    friend struct FrameArenaThreadSlot;
+
+    FrameArena( const FrameArena & ) = delete;
+    FrameArena &operator=( const FrameArena & ) = delete;
+};
+
+// Owns one thread's arena and registers it so ResetAll can reach arenas that belong to worker threads
+struct FrameArenaThreadSlot
+{
+    FrameArena arena;
+
+    FrameArenaThreadSlot( )
+    {
+        std::lock_guard<std::mutex> guard( FrameArena::Registry( ).lock );
+        FrameArena::Registry( ).arenas.push_back( &this->arena );
+    }
+
+    ~FrameArenaThreadSlot( )
+    {
+        std::lock_guard<std::mutex> guard( FrameArena::Registry( ).lock );
+        std::vector<FrameArena *> &arenas = FrameArena::Registry( ).arenas;
+        arenas.erase( std::remove( arenas.begin( ), arenas.end( ), &this->arena ), arenas.end( ) );
+    }
+};
+
+inline FrameArena &FrameArena::ForThisThread( )
+{
+    static thread_local FrameArenaThreadSlot slot;
+    return slot.arena;
+}
+
+// Lets standard containers draw from a frame arena, deallocate is a no-op
+template<typename T>
+class FrameAllocator
+{
+public:
+    typedef T value_type;
+
+    FrameAllocator( FrameArena &arena = FrameArena::ForThisThread( ) ) : arena( &arena )
+    {
+    }
+
+    template<typename U>
+    FrameAllocator( const FrameAllocator<U> &other ) : arena( other.arena )
+    {
+    }
+
+    T *allocate( size_t count )
+    {
+        return static_cast<T *>( this->arena->Allocate( sizeof( T ) * count, alignof( T ) ) );
+    }
+
+    void deallocate( T *, size_t )
+    {
+    }
+
+    template<typename U>
+    bool operator==( const FrameAllocator<U> &other ) const
+    {
+        return this->arena == other.arena;
+    }
+
+    template<typename U>
+    bool operator!=( const FrameAllocator<U> &other ) const
+    {
+        return this->arena != other.arena;
+    }
+
+private:
+    template<typename U>
+    friend class FrameAllocator;
+
+    FrameArena *arena;
+};
+
+#endif // FRAME_ARENA_H
@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////
+/// Frustum.h
+////////////////////////////////////////////////////////////////
+
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+// GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+// OpenGL Math
+#include <glm/glm.hpp>
+
+enum Frustum_Plane
+{
+    FRUSTUM_LEFT,
+    FRUSTUM_RIGHT,
+    FRUSTUM_BOTTOM,
+    FRUSTUM_TOP,
+    FRUSTUM_NEAR,
+    FRUSTUM_FAR,
+    FRUSTUM_PLANE_COUNT
+};
+
+// Six normalized planes (xyz = inward normal, w = distance) pulled out of a view-projection matrix
+struct Frustum
+{
+    glm::vec4 planes[FRUSTUM_PLANE_COUNT];
+
+    Frustum( )
+    {
+        for ( int i = 0; i < FRUSTUM_PLANE_COUNT; ++i )
+        {
+            this->planes[i] = glm::vec4( 0.0f, 0.0f, 0.0f, 1.0f );
+        }
+    }
+
+    explicit Frustum( const glm::mat4 &viewProjection )
+    {
+        this->Extract( viewProjection );
+    }
+
+    // Gribb/Hartmann extraction, glm matrices are column major so row i is ( m[0][i], m[1][i], m[2][i], m[3][i] )
+    void Extract( const glm::mat4 &m )
+    {
+        glm::vec4 row0( m[0][0], m[1][0], m[2][0], m[3][0] );
+        glm::vec4 row1( m[0][1], m[1][1], m[2][1], m[3][1] );
+        glm::vec4 row2( m[0][2], m[1][2], m[2][2], m[3][2] );
+        glm::vec4 row3( m[0][3], m[1][3], m[2][3], m[3][3] );
+
+        this->planes[FRUSTUM_LEFT]   = row3 + row0;
+        this->planes[FRUSTUM_RIGHT]  = row3 - row0;
+        this->planes[FRUSTUM_BOTTOM] = row3 + row1;
+        this->planes[FRUSTUM_TOP]    = row3 - row1;
+        this->planes[FRUSTUM_NEAR]   = row3 + row2;
+        this->planes[FRUSTUM_FAR]    = row3 - row2;
+
+        for ( int i = 0; i < FRUSTUM_PLANE_COUNT; ++i )
+        {
+            GLfloat length = glm::length( glm::vec3( this->planes[i].x, this->planes[i].y, this->planes[i].z ) );
+            this->planes[i] = this->planes[i] / length;
+        }
+    }
+
+    bool IntersectsSphere( const glm::vec3 &center, GLfloat radius ) const
+    {
+        for ( int i = 0; i < FRUSTUM_PLANE_COUNT; ++i )
+        {
+            const glm::vec4 &p = this->planes[i];
+
+            if ( p.x * center.x + p.y * center.y + p.z * center.z + p.w < -radius )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+#endif // FRUSTUM_H
@@ -0,0 +1,146 @@
+////////////////////////////////////////////////////////////////
+/// InputBuffer.h
+////////////////////////////////////////////////////////////////
+
+#ifndef INPUT_BUFFER_H
+#define INPUT_BUFFER_H
+
+#include <algorithm>
+
+// GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+struct MouseEvent
+{
+    GLdouble x;
+    GLdouble y;
+    GLdouble timestamp;
+};
+
+// Collects the cursor events that arrive during glfwPollEvents. High-rate mice deliver many of
+// them per frame, so instead of moving the camera for each one the offsets are summed and handed
+// out once per frame. Event timestamps are kept so the input-to-present latency can be measured.
+class InputBuffer
+{
+public:
+    static const int MAX_EVENTS = 512;
+
+    InputBuffer( )
+    : eventCount( 0 ), droppedEvents( 0 ), firstMouse( true ), lastX( 0.0 ), lastY( 0.0 ), deltaX( 0.0 ), deltaY( 0.0 ),
+      pendingLatencyFrom( -1.0 ), latencySamples( 0 ), latencySum( 0.0 ), latencyMax( 0.0 )
+    {
+    }
+
+    // Called from the cursor callback
+    void PushMouseMove( GLdouble x, GLdouble y, GLdouble timestamp )
+    {
+        if ( this->firstMouse )
+        {
+            this->lastX = x;
+            this->lastY = y;
+            this->firstMouse = false;
+        }
+
+        this->deltaX += x - this->lastX;
+        this->deltaY += this->lastY - y; // Reversed since y-coords start from bottom left
+
+        this->lastX = x;
+        this->lastY = y;
+
+        // The deltas are already accumulated, a full buffer only loses the timing record
+        if ( this->eventCount < MAX_EVENTS )
+        {
+            MouseEvent event = { x, y, timestamp };
+            this->events[this->eventCount++] = event;
+        }
+        else
+        {
+            ++this->droppedEvents;
+        }
+    }
+
+    // Hands out everything gathered since the last call, returns false if the mouse didn't move
+    bool ConsumeMouseDelta( GLfloat &xOffset, GLfloat &yOffset )
+    {
+        if ( 0 == this->eventCount )
+        {
+            return false;
+        }
+
+        xOffset = ( GLfloat )this->deltaX;
+        yOffset = ( GLfloat )this->deltaY;
+
+        // The oldest event is the one that has waited longest for this frame to show it
+        if ( this->pendingLatencyFrom < 0.0 )
+        {
+            this->pendingLatencyFrom = this->events[0].timestamp;
+        }
+
+        this->deltaX = 0.0;
+        this->deltaY = 0.0;
+        this->eventCount = 0;
+
+        return 0.0f != xOffset || 0.0f != yOffset;
+    }
+
+    // Call right after the frame that used the input was presented
+    void FramePresented( GLdouble timestamp )
+    {
+        if ( this->pendingLatencyFrom < 0.0 )
+        {
+            return;
+        }
+
+        GLdouble latency = timestamp - this->pendingLatencyFrom;
+
+        ++this->latencySamples;
+        this->latencySum += latency;
+        this->latencyMax = std::max( this->latencyMax, latency );
+        this->pendingLatencyFrom = -1.0;
+    }
+
+    int GetEventCount( ) const
+    {
+        return this->eventCount;
+    }
+
+    const MouseEvent *GetEvents( ) const
+    {
+        return this->events;
+    }
+
+    int GetDroppedEvents( ) const
+    {
+        return this->droppedEvents;
+    }
+
+    // Seconds from the oldest mouse event in a frame to that frame being presented
+    GLdouble GetAverageLatency( ) const
+    {
+        return ( 0 == this->latencySamples ) ? 0.0 : this->latencySum / this->latencySamples;
+    }
+
+    GLdouble GetMaxLatency( ) const
+    {
+        return this->latencyMax;
+    }
+
+private:
+    MouseEvent events[MAX_EVENTS];
+    int eventCount;
+    int droppedEvents;
+
+    bool firstMouse;
+    GLdouble lastX;
+    GLdouble lastY;
+    GLdouble deltaX;
+    GLdouble deltaY;
+
+    GLdouble pendingLatencyFrom;
+    int latencySamples;
+    GLdouble latencySum;
+    GLdouble latencyMax;
+};
+
+#endif // INPUT_BUFFER_H
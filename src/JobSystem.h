@@ -0,0 +1,372 @@
+////////////////////////////////////////////////////////////////
+/// JobSystem.h
+////////////////////////////////////////////////////////////////
+
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "Profiler.h"
+
+class JobSystem;
+
+// Counts outstanding jobs. Jobs submitted with a dependency on a counter are parked on it
+// and only get queued once it drops to zero.
+class JobCounter
+{
+public:
+    JobCounter( int value = 0 ) : value( value ), finishing( 0 )
+    {
+    }
+
+    int GetValue( ) const
+    {
+        return this->value.load( );
+    }
+
+    // Also waits out any Finish still touching the counter, so it is safe to destroy once this is true
+    bool IsDone( ) const
+    {
+        return 0 == this->value.load( ) && 0 == this->finishing.load( );
+    }
+
+private:
+    friend class JobSystem;
+
+    struct Parked
+    {
+        std::function<void( )> function;
+        JobCounter *signal;
+    };
+
+    std::atomic<int> value;
+    std::atomic<int> finishing;
+    std::mutex lock;
+    std::vector<Parked> parked;
+
+    JobCounter( const JobCounter & ) = delete;
+    JobCounter &operator=( const JobCounter & ) = delete;
+};
+
+// Work-stealing scheduler. Every worker owns a deque, pushes and pops at the back and steals
+// from the front of the others when it runs dry. Queue 0 belongs to the thread that created
+// the system (normally the main thread), which only runs jobs while it is inside Wait.
+class JobSystem
+{
+public:
+    // workerCount threads are started on top of the calling thread, 0 picks one per spare core
+    JobSystem( unsigned workerCount = 0 ) : pending( 0 ), stopping( false )
+    {
+        if ( 0 == workerCount )
+        {
+            unsigned cores = std::thread::hardware_concurrency( );
+            workerCount = ( cores > 1 ) ? cores - 1 : 0;
+        }
+
+        for ( unsigned i = 0; i <= workerCount; ++i )
+        {
+            this->queues.push_back( std::unique_ptr<WorkerQueue>( new WorkerQueue( ) ) );
+        }
+
+        CurrentWorker( ).system = this;
+        CurrentWorker( ).index = 0;
+
+        for ( unsigned i = 1; i <= workerCount; ++i )
+        {
+            this->threads.push_back( std::thread( &JobSystem::WorkerLoop, this, i ) );
+        }
+    }
+
+    ~JobSystem( )
+    {
+        {
+            std::lock_guard<std::mutex> guard( this->sleepLock );
+            this->stopping = true;
+        }
+
+        this->wake.notify_all( );
+
+        for ( size_t i = 0; i < this->threads.size( ); ++i )
+        {
+            this->threads[i].join( );
+        }
+
+        if ( this == CurrentWorker( ).system )
+        {
+            CurrentWorker( ).system = nullptr;
+        }
+    }
+
+    // Number of threads that can run jobs, including the one that waits
+    unsigned GetThreadCount( ) const
+    {
+        return ( unsigned )this->queues.size( );
+    }
+
+    // Queues a job. signal (if any) is incremented now and decremented when the job finishes,
+    // dependency (if any) must reach zero before the job is allowed to start.
+    void Run( std::function<void( )> function, JobCounter *signal = nullptr, JobCounter *dependency = nullptr )
+    {
+        if ( nullptr != signal )
+        {
+            signal->value.fetch_add( 1 );
+        }
+
+        if ( nullptr != dependency )
+        {
+            std::lock_guard<std::mutex> guard( dependency->lock );
+
+            if ( dependency->value.load( ) > 0 )
+            {
+                JobCounter::Parked parked = { std::move( function ), signal };
+                dependency->parked.push_back( std::move( parked ) );
+
+                return;
+            }
+        }
+
+        this->Push( Job( std::move( function ), signal ) );
+    }
+
+    // Splits [0, count) into ranges of at most grain items and queues one job per range
+    void ParallelFor( GLuint count, GLuint grain, std::function<void( GLuint, GLuint )> function,
+        JobCounter *signal, JobCounter *dependency = nullptr )
+    {
+        if ( 0 == grain )
+        {
+            grain = 1;
+        }
+
+        std::shared_ptr<std::function<void( GLuint, GLuint )>> shared =
+            std::make_shared<std::function<void( GLuint, GLuint )>>( std::move( function ) );
+
+        for ( GLuint begin = 0; begin < count; begin += grain )
+        {
+            GLuint end = ( count - begin > grain ) ? begin + grain : count;
+
+            this->Run( [shared, begin, end]( ) { ( *shared )( begin, end ); }, signal, dependency );
+        }
+    }
+
+    // Blocking form, the calling thread works through the ranges too
+    void ParallelFor( GLuint count, GLuint grain, std::function<void( GLuint, GLuint )> function )
+    {
+        if ( count <= grain || this->queues.size( ) < 2 )
+        {
+            if ( count > 0 )
+            {
+                function( 0, count );
+            }
+
+            return;
+        }
+
+        JobCounter done;
+        this->ParallelFor( count, grain, std::move( function ), &done );
+        this->Wait( done );
+    }
+
+    // Runs other jobs on this thread until the counter reaches zero instead of blocking
+    void Wait( const JobCounter &counter )
+    {
+        unsigned index = this->CurrentIndex( );
+
+        while ( !counter.IsDone( ) )
+        {
+            if ( !this->TryRunOne( index ) )
+            {
+                std::this_thread::yield( );
+            }
+        }
+    }
+
+private:
+    struct Job
+    {
+        Job( ) : signal( nullptr )
+        {
+        }
+
+        Job( std::function<void( )> function, JobCounter *signal ) : function( std::move( function ) ), signal( signal )
+        {
+        }
+
+        std::function<void( )> function;
+        JobCounter *signal;
+    };
+
+    struct WorkerQueue
+    {
+        std::mutex lock;
+        std::deque<Job> jobs;
+    };
+
+    struct WorkerIdentity
+    {
+        JobSystem *system;
+        unsigned index;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::atomic<int> pending;
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    bool stopping;
+
+    static WorkerIdentity &CurrentWorker( )
+    {
+        static thread_local WorkerIdentity identity = { nullptr, 0 };
+        return identity;
+    }
+
+    // Threads that don't belong to this system share queue 0 with its owner
+    unsigned CurrentIndex( )
+    {
+        WorkerIdentity &identity = CurrentWorker( );
+        return ( this == identity.system ) ? identity.index : 0;
+    }
+
+    void Push( Job job )
+    {
+        WorkerQueue &queue = *this->queues[this->CurrentIndex( )];
+
+        {
+            std::lock_guard<std::mutex> guard( queue.lock );
+            queue.jobs.push_back( std::move( job ) );
+        }
+
+        this->pending.fetch_add( 1, std::memory_order_release );
+
+        {
+            std::lock_guard<std::mutex> guard( this->sleepLock );
+        }
+
+        this->wake.notify_one( );
+    }
+
+    bool TryPop( unsigned index, Job &job )
+    {
+        WorkerQueue &own = *this->queues[index];
+
+        {
+            std::lock_guard<std::mutex> guard( own.lock );
+
+            if ( !own.jobs.empty( ) )
+            {
+                job = std::move( own.jobs.back( ) );
+                own.jobs.pop_back( );
+
+                return true;
+            }
+        }
+
+        // Steal the oldest (and so usually biggest) job from someone else
+        size_t count = this->queues.size( );
+
+        for ( size_t n = 1; n < count; ++n )
+        {
+            WorkerQueue &victim = *this->queues[( index + n ) % count];
+            std::lock_guard<std::mutex> guard( victim.lock );
+
+            if ( !victim.jobs.empty( ) )
+            {
+                job = std::move( victim.jobs.front( ) );
+                victim.jobs.pop_front( );
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool TryRunOne( unsigned index )
+    {
+        Job job;
+
+        if ( !this->TryPop( index, job ) )
+        {
+            return false;
+        }
+
+        this->pending.fetch_sub( 1, std::memory_order_relaxed );
+
+        {
+            PROFILE_ZONE( "Job" );
+            job.function( );
+        }
+
+        if ( nullptr != job.signal )
+        {
+            this->Finish( *job.signal );
+        }
+
+        return true;
+    }
+
+    void Finish( JobCounter &counter )
+    {
+        std::vector<JobCounter::Parked> released;
+
+        counter.finishing.fetch_add( 1 );
+
+        // Run checks the value under the lock, so anything it parked before we hit zero is
+        // picked up here and anything after sees zero and queues itself
+        if ( 1 == counter.value.fetch_sub( 1 ) )
+        {
+            std::lock_guard<std::mutex> guard( counter.lock );
+            released.swap( counter.parked );
+        }
+
+        // Last touch, a waiter may destroy the counter straight after this
+        counter.finishing.fetch_sub( 1 );
+
+        for ( size_t i = 0; i < released.size( ); ++i )
+        {
+            this->Push( Job( std::move( released[i].function ), released[i].signal ) );
+        }
+    }
+
+    void WorkerLoop( unsigned index )
+    {
+        CurrentWorker( ).system = this;
+        CurrentWorker( ).index = index;
+        Profiler::Get( ).SetThreadName( "Worker " + std::to_string( index ) );
+
+        for ( ;; )
+        {
+            if ( this->TryRunOne( index ) )
+            {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> guard( this->sleepLock );
+            this->wake.wait( guard, [this]( ) { return this->stopping || this->pending.load( std::memory_order_acquire ) > 0; } );
+
+            if ( this->stopping )
+            {
+                return;
+            }
+        }
+    }
+
+    JobSystem( const JobSystem & ) = delete;
+    JobSystem &operator=( const JobSystem & ) = delete;
+};
+
+#endif // JOB_SYSTEM_H
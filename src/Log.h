@@ -0,0 +1,576 @@
+////////////////////////////////////////////////////////////////
+/// Log.h
+////////////////////////////////////////////////////////////////
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+enum Log_Level
+{
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARNING,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_NONE
+};
+
+// Anything below this is compiled out, override with -DLOG_MIN_LEVEL=...
+#ifndef LOG_MIN_LEVEL
+    #ifdef NDEBUG
+        #define LOG_MIN_LEVEL LOG_LEVEL_INFO
+    #else
+        #define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+    #endif
+#endif
+
+// format must be a string literal, only its address is kept. Each {} in it is replaced by the
+// next argument when the line is written out on the logging thread. The level test is in the
+// macro so a compiled out line never evaluates its arguments either.
+#define LOG_AT( LEVEL, ... ) \
+    do \
+    { \
+        if ( ( LEVEL ) >= LOG_MIN_LEVEL ) \
+        { \
+            Logger::Write<LEVEL>( __VA_ARGS__ ); \
+        } \
+    } while ( 0 )
+
+#define LOG_DEBUG( ... ) LOG_AT( LOG_LEVEL_DEBUG, __VA_ARGS__ )
+#define LOG_INFO( ... ) LOG_AT( LOG_LEVEL_INFO, __VA_ARGS__ )
+#define LOG_WARNING( ... ) LOG_AT( LOG_LEVEL_WARNING, __VA_ARGS__ )
+#define LOG_ERROR( ... ) LOG_AT( LOG_LEVEL_ERROR, __VA_ARGS__ )
+
+// Logging that never makes the caller wait on I/O. Each thread writes its records into its own
+// single-producer ring, so logging is a few copies and two atomic operations with no lock, and the
+// arguments are stored raw: turning them into text happens later on a background thread that
+// drains every ring to stderr or a file. Should a ring fill up faster than it is drained the
+// record is dropped and counted rather than blocking the frame.
+class Logger
+{
+public:
+    static const size_t RING_SIZE = 1 << 16;
+    static const size_t MAX_RECORD_SIZE = 2048;
+
+    template<int Level, typename... Args>
+    static void Write( const char *format, const Args &... args )
+    {
+        // The LOG_ macros already skip the call, this covers calling Write directly
+        if ( Level < LOG_MIN_LEVEL )
+        {
+            return;
+        }
+
+        Get( ).Push( Level, format, args... );
+    }
+
+    static Logger &Get( )
+    {
+        static Logger logger;
+        return logger;
+    }
+
+    // Takes ownership of file, pass nullptr to go back to stderr
+    void SetOutput( FILE *file )
+    {
+        std::lock_guard<std::mutex> guard( this->drainLock );
+
+        this->DrainRings( );
+
+        if ( nullptr != this->file )
+        {
+            std::fclose( this->file );
+        }
+
+        this->file = file;
+    }
+
+    bool OpenFile( const char *path )
+    {
+        FILE *file = std::fopen( path, "w" );
+
+        if ( nullptr == file )
+        {
+            return false;
+        }
+
+        this->SetOutput( file );
+
+        return true;
+    }
+
+    // Writes out everything logged so far before returning, e.g. before the program exits
+    void Flush( )
+    {
+        std::lock_guard<std::mutex> guard( this->drainLock );
+        this->DrainRings( );
+    }
+
+    size_t GetDroppedCount( ) const
+    {
+        return this->dropped.load( std::memory_order_relaxed );
+    }
+
+private:
+    enum Argument_Type
+    {
+        ARGUMENT_INT,
+        ARGUMENT_UINT,
+        ARGUMENT_DOUBLE,
+        ARGUMENT_BOOL,
+        ARGUMENT_STRING,
+        ARGUMENT_POINTER
+    };
+
+    struct RecordHeader
+    {
+        size_t size;
+        int level;
+        int argumentCount;
+        const char *format;
+        long long time;
+    };
+
+    // One per thread that ever logged. head is only written by that thread, tail only by whoever
+    // holds drainLock.
+    struct Ring
+    {
+        Ring( ) : head( 0 ), tail( 0 ), retired( false )
+        {
+        }
+
+        unsigned char data[RING_SIZE];
+        std::atomic<size_t> head;
+        std::atomic<size_t> tail;
+        std::atomic<bool> retired;
+    };
+
+    // Registers the thread's ring on first use and retires it when the thread exits, the drain
+    // thread frees it once it's empty
+    struct ThreadRing
+    {
+        std::shared_ptr<Ring> ring;
+
+        ThreadRing( ) : ring( std::make_shared<Ring>( ) )
+        {
+            Logger &logger = Logger::Get( );
+            std::lock_guard<std::mutex> guard( logger.ringsLock );
+            logger.rings.push_back( this->ring );
+        }
+
+        ~ThreadRing( )
+        {
+            this->ring->retired.store( true, std::memory_order_release );
+        }
+    };
+
+    std::mutex ringsLock;
+    std::vector<std::shared_ptr<Ring>> rings;
+
+    std::mutex drainLock;
+    std::vector<unsigned char> record;
+
+    struct Line
+    {
+        long long time;
+        std::string text;
+    };
+
+    std::vector<Line> lines;
+
+    FILE *file;
+    std::chrono::steady_clock::time_point start;
+    std::atomic<size_t> dropped;
+
+    std::mutex wakeLock;
+    std::condition_variable wake;
+    bool stopping;
+    std::thread thread;
+
+    Logger( ) : file( nullptr ), start( std::chrono::steady_clock::now( ) ), dropped( 0 ), stopping( false )
+    {
+        this->thread = std::thread( &Logger::Run, this );
+    }
+
+    ~Logger( )
+    {
+        {
+            std::lock_guard<std::mutex> guard( this->wakeLock );
+            this->stopping = true;
+        }
+
+        this->wake.notify_one( );
+        this->thread.join( );
+        this->Flush( );
+
+        if ( nullptr != this->file )
+        {
+            std::fclose( this->file );
+        }
+    }
+
+    static Ring &ThisThreadRing( )
+    {
+        static thread_local ThreadRing ring;
+        return *ring.ring;
+    }
+
+    void Run( )
+    {
+        std::unique_lock<std::mutex> guard( this->wakeLock );
+
+        while ( !this->stopping )
+        {
+            // Polled, so logging never has to wake anyone
+            this->wake.wait_for( guard, std::chrono::milliseconds( 5 ) );
+            guard.unlock( );
+            this->Flush( );
+            guard.lock( );
+        }
+    }
+
+    // Encoding, every argument is a type byte followed by its raw value
+
+    template<typename T>
+    static typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, size_t>::type
+        Encode( unsigned char *out, size_t room, const T &value )
+    {
+        return EncodeValue( out, room, ARGUMENT_INT, ( long long )value );
+    }
+
+    template<typename T>
+    static typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value && !std::is_same<T, bool>::value, size_t>::type
+        Encode( unsigned char *out, size_t room, const T &value )
+    {
+        return EncodeValue( out, room, ARGUMENT_UINT, ( unsigned long long )value );
+    }
+
+    template<typename T>
+    static typename std::enable_if<std::is_enum<T>::value, size_t>::type
+        Encode( unsigned char *out, size_t room, const T &value )
+    {
+        return EncodeValue( out, room, ARGUMENT_INT, ( long long )value );
+    }
+
+    template<typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value, size_t>::type
+        Encode( unsigned char *out, size_t room, const T &value )
+    {
+        return EncodeValue( out, room, ARGUMENT_DOUBLE, ( double )value );
+    }
+
+    static size_t Encode( unsigned char *out, size_t room, const bool &value )
+    {
+        return EncodeValue( out, room, ARGUMENT_BOOL, ( long long )value );
+    }
+
+    static size_t Encode( unsigned char *out, size_t room, const void *value )
+    {
+        return EncodeValue( out, room, ARGUMENT_POINTER, ( unsigned long long )( uintptr_t )value );
+    }
+
+    // Strings are copied since the caller's buffer is long gone by the time the line is written
+    static size_t Encode( unsigned char *out, size_t room, const char *value )
+    {
+        return EncodeString( out, room, ( nullptr == value ) ? "(null)" : value, ( nullptr == value ) ? 6 : std::strlen( value ) );
+    }
+
+    static size_t Encode( unsigned char *out, size_t room, char *value )
+    {
+        return Encode( out, room, ( const char * )value );
+    }
+
+    // glGetString and friends
+    static size_t Encode( unsigned char *out, size_t room, const unsigned char *value )
+    {
+        return Encode( out, room, ( const char * )value );
+    }
+
+    static size_t Encode( unsigned char *out, size_t room, const std::string &value )
+    {
+        return EncodeString( out, room, value.data( ), value.size( ) );
+    }
+
+    template<size_t N>
+    static size_t Encode( unsigned char *out, size_t room, const char ( &value )[N] )
+    {
+        return Encode( out, room, ( const char * )value );
+    }
+
+    template<size_t N>
+    static size_t Encode( unsigned char *out, size_t room, char ( &value )[N] )
+    {
+        return Encode( out, room, ( const char * )value );
+    }
+
+    template<typename T>
+    static size_t EncodeValue( unsigned char *out, size_t room, Argument_Type type, const T &value )
+    {
+        if ( room < 1 + sizeof( T ) )
+        {
+            return 0;
+        }
+
+        out[0] = ( unsigned char )type;
+        std::memcpy( out + 1, &value, sizeof( T ) );
+
+        return 1 + sizeof( T );
+    }
+
+    static size_t EncodeString( unsigned char *out, size_t room, const char *value, size_t length )
+    {
+        if ( room < 1 + sizeof( uint32_t ) )
+        {
+            return 0;
+        }
+
+        // Cut long strings to whatever still fits in the record
+        length = std::min( length, room - 1 - sizeof( uint32_t ) );
+        uint32_t stored = ( uint32_t )length;
+
+        out[0] = ( unsigned char )ARGUMENT_STRING;
+        std::memcpy( out + 1, &stored, sizeof( stored ) );
+        std::memcpy( out + 1 + sizeof( stored ), value, length );
+
+        return 1 + sizeof( stored ) + length;
+    }
+
+    static size_t EncodeAll( unsigned char *, size_t, int & )
+    {
+        return 0;
+    }
+
+    template<typename First, typename... Rest>
+    static size_t EncodeAll( unsigned char *out, size_t room, int &count, const First &first, const Rest &... rest )
+    {
+        size_t used = Encode( out, room, first );
+
+        if ( 0 == used )
+        {
+            return 0;
+        }
+
+        ++count;
+
+        return used + EncodeAll( out + used, room - used, count, rest... );
+    }
+
+    template<typename... Args>
+    void Push( int level, const char *format, const Args &... args )
+    {
+        unsigned char buffer[MAX_RECORD_SIZE];
+        RecordHeader header;
+        header.level = level;
+        header.format = format;
+        header.argumentCount = 0;
+        header.time = ( long long )std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now( ) - this->start ).count( );
+
+        size_t size = sizeof( header ) + EncodeAll( buffer + sizeof( header ), sizeof( buffer ) - sizeof( header ), header.argumentCount, args... );
+        header.size = size;
+        std::memcpy( buffer, &header, sizeof( header ) );
+
+        Ring &ring = ThisThreadRing( );
+        size_t head = ring.head.load( std::memory_order_relaxed );
+        size_t tail = ring.tail.load( std::memory_order_acquire );
+
+        if ( RING_SIZE - ( head - tail ) < size )
+        {
+            this->dropped.fetch_add( 1, std::memory_order_relaxed );
+            return;
+        }
+
+        CopyIn( ring, head, buffer, size );
+        ring.head.store( head + size, std::memory_order_release );
+    }
+
+    static void CopyIn( Ring &ring, size_t position, const unsigned char *source, size_t size )
+    {
+        size_t offset = position % RING_SIZE;
+        size_t first = std::min( size, RING_SIZE - offset );
+
+        std::memcpy( ring.data + offset, source, first );
+        std::memcpy( ring.data, source + first, size - first );
+    }
+
+    static void CopyOut( const Ring &ring, size_t position, unsigned char *destination, size_t size )
+    {
+        size_t offset = position % RING_SIZE;
+        size_t first = std::min( size, RING_SIZE - offset );
+
+        std::memcpy( destination, ring.data + offset, first );
+        std::memcpy( destination + first, ring.data, size - first );
+    }
+
+    // Decoding and formatting, only ever on the draining side
+
+    void Format( const unsigned char *record, std::string &out )
+    {
+        RecordHeader header;
+        std::memcpy( &header, record, sizeof( header ) );
+
+        static const char *LEVEL_NAMES[] = { "DEBUG", "INFO", "WARNING", "ERROR" };
+        char prefix[48];
+        std::snprintf( prefix, sizeof( prefix ), "[%12.6f] %-7s ", header.time / 1e9, LEVEL_NAMES[header.level] );
+        out = prefix;
+
+        const unsigned char *argument = record + sizeof( header );
+        int remaining = header.argumentCount;
+
+        for ( const char *c = header.format; '\0' != *c; ++c )
+        {
+            if ( '{' == c[0] && '}' == c[1] && remaining > 0 )
+            {
+                argument = AppendArgument( argument, out );
+                --remaining;
+                ++c;
+                continue;
+            }
+
+            out += *c;
+        }
+
+        out += '\n';
+    }
+
+    static const unsigned char *AppendArgument( const unsigned char *argument, std::string &out )
+    {
+        char text[64];
+        long long integer;
+        unsigned long long unsignedInteger;
+        double real;
+        uint32_t length;
+
+        switch ( argument[0] )
+        {
+            case ARGUMENT_INT:
+                std::memcpy( &integer, argument + 1, sizeof( integer ) );
+                std::snprintf( text, sizeof( text ), "%lld", integer );
+                out += text;
+                return argument + 1 + sizeof( integer );
+
+            case ARGUMENT_BOOL:
+                std::memcpy( &integer, argument + 1, sizeof( integer ) );
+                out += integer ? "true" : "false";
+                return argument + 1 + sizeof( integer );
+
+            case ARGUMENT_UINT:
+                std::memcpy( &unsignedInteger, argument + 1, sizeof( unsignedInteger ) );
+                std::snprintf( text, sizeof( text ), "%llu", unsignedInteger );
+                out += text;
+                return argument + 1 + sizeof( unsignedInteger );
+
+            case ARGUMENT_POINTER:
+                std::memcpy( &unsignedInteger, argument + 1, sizeof( unsignedInteger ) );
+                std::snprintf( text, sizeof( text ), "0x%llx", unsignedInteger );
+                out += text;
+                return argument + 1 + sizeof( unsignedInteger );
+
+            case ARGUMENT_DOUBLE:
+                std::memcpy( &real, argument + 1, sizeof( real ) );
+                std::snprintf( text, sizeof( text ), "%g", real );
+                out += text;
+                return argument + 1 + sizeof( real );
+
+            default:
+                std::memcpy( &length, argument + 1, sizeof( length ) );
+                out.append( ( const char * )argument + 1 + sizeof( length ), length );
+                return argument + 1 + sizeof( length ) + length;
+        }
+    }
+
+    // Caller holds drainLock. Lines from different threads are put back in time order before writing.
+    void DrainRings( )
+    {
+        std::vector<std::shared_ptr<Ring>> snapshot;
+
+        {
+            std::lock_guard<std::mutex> guard( this->ringsLock );
+            snapshot = this->rings;
+        }
+
+        size_t count = 0;
+
+        for ( size_t i = 0; i < snapshot.size( ); ++i )
+        {
+            Ring &ring = *snapshot[i];
+            size_t tail = ring.tail.load( std::memory_order_relaxed );
+            size_t head = ring.head.load( std::memory_order_acquire );
+
+            while ( tail != head )
+            {
+                RecordHeader header;
+                CopyOut( ring, tail, ( unsigned char * )&header, sizeof( header ) );
+
+                this->record.resize( header.size );
+                CopyOut( ring, tail, &this->record[0], header.size );
+                tail += header.size;
+
+                if ( count == this->lines.size( ) )
+                {
+                    this->lines.push_back( Line( ) );
+                }
+
+                this->lines[count].time = header.time;
+                this->Format( &this->record[0], this->lines[count].text );
+                ++count;
+            }
+
+            ring.tail.store( tail, std::memory_order_release );
+        }
+
+        std::stable_sort( this->lines.begin( ), this->lines.begin( ) + count, []( const Line &a, const Line &b ) { return a.time < b.time; } );
+
+        FILE *output = ( nullptr != this->file ) ? this->file : stderr;
+
+        for ( size_t i = 0; i < count; ++i )
+        {
+            std::fwrite( this->lines[i].text.data( ), 1, this->lines[i].text.size( ), output );
+        }
+
+        if ( count > 0 )
+        {
+            std::fflush( output );
+        }
+
+        this->ForgetRetiredRings( );
+    }
+
+    // Threads that exited and whose last lines are written out
+    void ForgetRetiredRings( )
+    {
+        std::lock_guard<std::mutex> guard( this->ringsLock );
+
+        for ( size_t i = 0; i < this->rings.size( ); )
+        {
+            Ring &ring = *this->rings[i];
+
+            if ( ring.retired.load( std::memory_order_acquire ) &&
+                ring.head.load( std::memory_order_acquire ) == ring.tail.load( std::memory_order_relaxed ) )
+            {
+                this->rings[i] = this->rings.back( );
+                this->rings.pop_back( );
+                continue;
+            }
+
+            ++i;
+        }
+    }
+
+    Logger( const Logger & ) = delete;
+    Logger &operator=( const Logger & ) = delete;
+};
+
+#endif // LOG_H
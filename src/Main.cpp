@@ -2,9 +2,10 @@
 /// Main.cpp
 ////////////////////////////////////////////////////////////////
 
-#include <iostream>
 #include <ctime>
 #include <string>
+#include <vector>
+#include <unordered_map>
 
 // GLEW
 #define GLEW_STATIC
@@ -14,8 +15,18 @@
 #include <GLFW/glfw3.h>
 
 // Other includes
+#include "Log.h"
 #include "Shader.h"
+#include "ShaderCompileThread.h"
+#include "ShaderVariants.h"
+#include "ShaderWatcher.h"
 #include "Camera.h"
+#include "EntityStore.h"
+#include "JobSystem.h"
+#include "FrameArena.h"
+#include "InputBuffer.h"
+#include "DebugOutput.h"
+#include "Profiler.h"
 
 // OpenGL Math
 #include <glm/glm.hpp>
@@ -25,6 +36,9 @@
 // Other libraries
 #include "SOIL2/SOIL2.h"
 
+// Where F9 writes profile captures
+const char *PROFILE_PATH = "profile.json";
+
 // Window Dimensions
 const GLuint WIDTH = 800, HEIGHT = 600;
 int SCREEN_WIDTH, SCREEN_HEIGHT;
@@ -34,16 +48,25 @@ void KeyCallback( GLFWwindow *window, int key, int scancode, int action, int mod
 void ScrollCallback( GLFWwindow *window, double xOffset, double yOffset );
 void MouseCallback( GLFWwindow *window, double xPos, double yPos );
 void DoMovement( );
+void SetLightingColours( Shader &shader );
+void ToggleProfileCapture( );
+void SOILParallelFor( SOIL_parallel_task task, void *context, int count, int grain, void *userData );
+void SOILLog( int level, const char *message, void *userData );
+void SOILZoneBegin( const char *name, void *userData );
+void SOILZoneEnd( void *userData );
+
+Camera camera( glm::dvec3( 0.0, 0.0, 3.0 ) );
 
-Camera camera( glm::vec3( 0.0f, 0.0f, 3.0f ) );
-GLfloat lastX = WIDTH / 2.0;
-GLfloat lastY = HEIGHT / 2.0;
+// Mouse events are gathered here during glfwPollEvents and applied to the camera once per frame
+InputBuffer input;
 
 bool keys[1024];
-bool firstMouse = true;
 
 // Light attributes
-glm::vec3 lightPos( 1.2f, 1.0f, 2.0f );
+glm::dvec3 lightPos( 1.2, 1.0, 2.0 );
+
+// Scene entities
+EntityStore scene;
 
 GLfloat deltaTime = 0.0f;   // Time between current frame and last frame
 GLfloat lastFrame = 0.0f;   // Time of last frame
@@ -55,6 +78,15 @@ int main( )
 
     glfwInit( );
 
+    // Worker threads shared by the engine and SOIL2's image processing
+    JobSystem jobs;
+    SOIL_set_parallel_for( SOILParallelFor, &jobs );
+    SOIL_set_log_func( SOILLog, nullptr );
+
+    // F9 starts and stops a profile capture, written to PROFILE_PATH for chrome://tracing or Perfetto
+    Profiler::Get( ).SetThreadName( "Main" );
+    SOIL_set_profiler( SOILZoneBegin, SOILZoneEnd, nullptr );
+
     // set all the required options for GLFW
     glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 3 );
     glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 3 );
@@ -62,12 +94,18 @@ int main( )
     glfwWindowHint( GLFW_RESIZABLE, GL_FALSE );
     glfwWindowHint( GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE );
 
+#ifndef NDEBUG
+    // GL errors are reported through debug output, which needs a debug context
+    glfwWindowHint( GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE );
+#endif
+
     // create a GLFWwindow object that we can use for GLFW's functions
     GLFWwindow* window = glfwCreateWindow( WIDTH, HEIGHT, "LearnOpenGL", nullptr, nullptr );
 
     if ( nullptr == window )
     {
-        std::cout << "Failed to create GLFW window" << std::endl;
+        LOG_ERROR( "Failed to create GLFW window" );
+        Logger::Get( ).Flush( );
         glfwTerminate( );
 
         return EXIT_FAILURE;
@@ -83,16 +121,33 @@ int main( )
 
     glfwSetInputMode( window, GLFW_CURSOR, GLFW_CURSOR_DISABLED );
 
+#ifdef GLFW_RAW_MOUSE_MOTION
+    // Unaccelerated, unscaled motion straight from the device when the platform has it
+    if ( glfwRawMouseMotionSupported( ) )
+    {
+        glfwSetInputMode( window, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE );
+    }
+#endif
+
     // Set this to true so FLEW knows to use a modern approach to retrieving function points and extensions
     glewExperimental = GL_TRUE;
 
     // Initialize GLEW to setup the OpenGL Function pointers
     if ( GLEW_OK != glewInit( ) )
     {
-        std::cout << "Failed to initialize GLEW" << std::endl;
+        LOG_ERROR( "Failed to initialize GLEW" );
+        Logger::Get( ).Flush( );
         return EXIT_FAILURE;
     }
 
+    // Driver messages get queued by a callback and printed once per frame, in place of glGetError
+    DebugOutput debugOutput;
+
+    if ( debugOutput.Install( ) )
+    {
+        SOIL_set_GL_debug_output( 1 );
+    }
+
     // Define the viewport dimensions
     glViewport( 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT );
     glEnable( GL_DEPTH_TEST );
@@ -101,9 +156,20 @@ int main( )
     glEnable( GL_BLEND );
     glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
 
-    // Build and compile our shader program
-    Shader lightingShader( "resources/shaders/lighting.vert", "resources/shaders/lighting.frag" );
-    Shader lampShader( "resources/shaders/lamp.vert", "resources/shaders/lamp.frag" );
+    // Edited shader sources get rebuilt and swapped in while the program runs
+    ShaderWatcher shaderWatcher;
+
+    // Specialised shader variants are built on a thread with a context of its own, anything whose
+    // variant isn't ready yet is drawn with the object uber shader so a new permutation never
+    // stalls a frame. The lamp is the object shader without lighting.
+    ShaderCompileThread shaderCompiler( window );
+    ShaderVariants objectShaders( "resources/shaders/object.vert", "resources/shaders/object.frag", std::vector<std::string>( 1, "LIT" ) );
+    const GLuint OBJECT_LIT = objectShaders.GetFeatureBit( "LIT" );
+    objectShaders.SetWatcher( &shaderWatcher );
+    objectShaders.SetCompileThread( &shaderCompiler );
+    shaderWatcher.SetCompileThread( &shaderCompiler );
+    Shader &uberShader = objectShaders.EnableUberShader( );
+    objectShaders.Prewarm( "resources/shaders/object.variants" );
 
     GLfloat vertices[] = {
         // Positions
@@ -180,7 +246,32 @@ int main( )
     glEnableVertexAttribArray( 0 );
     glBindVertexArray( 0 );
 
-    glm::mat4 projection = glm::perspective( camera.GetZoom( ), ( GLfloat )SCREEN_WIDTH / ( GLfloat )SCREEN_HEIGHT, 0.1f, 1000.0f);
+    // The camera owns its projection now, so zooming reaches it
+    camera.SetAspectRatio( ( GLfloat )SCREEN_WIDTH / ( GLfloat )SCREEN_HEIGHT );
+    camera.SetClipPlanes( 0.1f, 1000.0f );
+
+    // The colours never change, so set them once rather than every frame
+    SetLightingColours( uberShader );
+
+    // Scene entities, a unit cube has a bounding sphere radius of sqrt( 0.75 )
+    const GLfloat cubeRadius = 0.8660254f;
+
+    Entity container = scene.Create( glm::dvec3( 0.0 ) );
+    scene.SetBounds( container, glm::vec3( 0.0f ), cubeRadius );
+    scene.SetRenderable( container, objectShaders.Select( OBJECT_LIT ).Program, boxVAO, 36, OBJECT_LIT );
+
+    Entity lamp = scene.Create( lightPos );
+    scene.SetScale( lamp, glm::vec3( 0.2f ) ); // Make it a smaller cube
+    scene.SetBounds( lamp, glm::vec3( 0.0f ), cubeRadius );
+    scene.SetRenderable( lamp, objectShaders.Select( 0 ).Program, lightVAO, 36, 0 );
+
+    // Kept across frames so they can be reused untouched while nothing moves
+    std::vector<GLuint> visible;
+    std::vector<DrawItem> drawList;
+    unsigned long long culledCameraVersion = 0, culledSceneVersion = 0;
+
+    // Camera version whose view/projection each program last received
+    std::unordered_map<GLuint, unsigned long long> uploadedCameraVersion;
 
     // Game loop
     while ( !glfwWindowShouldClose( window ) )
@@ -189,73 +280,181 @@ int main( )
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
-        // check if any events have been activated (key press, mouse, etc)
-        glfwPollEvents( );
-        DoMovement( );
-
-        // Render
-        // Clear the colorbuffer
-        glClearColor( 0.2f, 0.3f, 0.3f, 1.0f );
-        glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
-
-        lightingShader.Use( );
-        GLint objectColorLoc = glGetUniformLocation( lightingShader.Program, "objectColor" );
-        GLint lightColorLoc  = glGetUniformLocation( lightingShader.Program, "lightColor" );
-        glUniform3f( objectColorLoc, 1.0f, 0.5f, 0.31f );
-        glUniform3f( lightColorLoc,  1.0f, 0.5f, 1.0f );
-
-        // Create camera transformation
-        glm::mat4 view;
-        view = camera.GetViewMatrix( );
-
-        GLint modelLoc = glGetUniformLocation( lightingShader.Program, "model" );
-        GLint viewLoc = glGetUniformLocation( lightingShader.Program, "view" );
-        GLint projLoc = glGetUniformLocation( lightingShader.Program, "projection" );
-
-        // Pass the matricies to the shader        
-        glUniformMatrix4fv( viewLoc, 1, GL_FALSE, glm::value_ptr( view ) );
-        glUniformMatrix4fv( projLoc, 1, GL_FALSE, glm::value_ptr( projection ) );
-
-        // Draw container
-        glBindVertexArray( boxVAO );
-        glm::mat4 model;
-        glUniformMatrix4fv( modelLoc, 1, GL_FALSE, glm::value_ptr( model ) );
-        glDrawArrays( GL_TRIANGLES, 0, 36 );
-        glBindVertexArray( 0 );
-
-        // Also draw the lamp object, again binding the appropriate shader
-        lampShader.Use( );
-
-        // Get location objects for the matricies on the lamp shader (these could be different on a different shader)
-        modelLoc = glGetUniformLocation( lampShader.Program, "model" );
-        viewLoc = glGetUniformLocation( lampShader.Program, "view" );
-        projLoc = glGetUniformLocation( lampShader.Program, "projection" );
-
-        // Set matrices
-        glUniformMatrix4fv( viewLoc, 1, GL_FALSE, glm::value_ptr( view ) );
-        glUniformMatrix4fv( projLoc, 1, GL_FALSE, glm::value_ptr( projection ) );
-        model = glm::mat4(  );
-        model = glm::translate( model, lightPos );
-        model = glm::scale( model, glm::vec3( 0.2f ) ); // Make it a smaller cube
-        glUniformMatrix4fv( modelLoc, 1, GL_FALSE, glm::value_ptr( model ) );
-
-        // Draw the light object (using light's vertex attributes)
-        glBindVertexArray( lightVAO );
-        glDrawArrays( GL_TRIANGLES, 0, 36 );
-        glBindVertexArray( 0 );
-
-        // swap the screen buffers
-        glfwSwapBuffers( window );
+        {
+            PROFILE_ZONE( "Frame::Input" );
+
+            // check if any events have been activated (key press, mouse, etc)
+            glfwPollEvents( );
+            DoMovement( );
+
+            // However many cursor events arrived, the camera vectors get rebuilt once
+            GLfloat xOffset, yOffset;
+
+            if ( input.ConsumeMouseDelta( xOffset, yOffset ) )
+            {
+                camera.ProcessMouseMovement( xOffset, yOffset );
+            }
+        }
+
+        {
+            PROFILE_ZONE( "Frame::Shaders" );
+
+            // Swap in rebuilt shaders before anything is drawn with them this frame
+            const std::vector<ShaderSwap> &swaps = shaderWatcher.Update( );
+
+            for ( size_t i = 0; i < swaps.size( ); ++i )
+            {
+                GLuint permutation;
+
+                scene.ReplaceProgram( swaps[i].oldProgram, swaps[i].shader->Program );
+                uploadedCameraVersion.erase( swaps[i].oldProgram );
+                SetLightingColours( *swaps[i].shader );
+
+                // A variant that failed before and compiles now takes over from the uber shader
+                if ( objectShaders.FindPermutation( swaps[i].shader, permutation ) )
+                {
+                    scene.ReplaceProgram( uberShader.Program, swaps[i].shader->Program, permutation );
+                }
+            }
+
+            // Move what was drawn with the uber shader onto the variants that finished building
+            const std::vector<GLuint> &readyVariants = objectShaders.Update( );
+
+            for ( size_t i = 0; i < readyVariants.size( ); ++i )
+            {
+                Shader &variant = objectShaders.Select( readyVariants[i] );
+
+                SetLightingColours( variant );
+                scene.ReplaceProgram( uberShader.Program, variant.Program, readyVariants[i] );
+            }
+        }
+
+        // Camera transformation, everything is drawn relative to the camera position
+        glm::dvec3 origin = camera.GetPosition( );
+        unsigned long long cameraVersion = camera.GetVersion( );
+
+        {
+            PROFILE_ZONE( "Frame::Update" );
+
+            // Per-frame systems: transforms, then culling and the sorted draw list only if something moved
+            scene.UpdateTransforms( );
+
+            if ( cameraVersion != culledCameraVersion || scene.GetVersion( ) != culledSceneVersion )
+            {
+                scene.Cull( camera.GetFrustum( ), origin, visible, jobs );
+                scene.BuildDrawList( visible, drawList );
+                culledCameraVersion = cameraVersion;
+                culledSceneVersion = scene.GetVersion( );
+            }
+        }
+
+        {
+            PROFILE_ZONE( "Frame::Draw" );
+
+            // Render
+            // Clear the colorbuffer
+            glClearColor( 0.2f, 0.3f, 0.3f, 1.0f );
+            glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+
+            GLuint currentProgram = 0;
+            GLuint currentVAO = 0;
+            GLint modelLoc = -1;
+            GLint featuresLoc = -1;
+
+            for ( size_t i = 0; i < drawList.size( ); ++i )
+            {
+                const DrawItem &item = drawList[i];
+
+                // The draw list is sorted by program, so the matricies only get set once per shader
+                if ( item.program != currentProgram )
+                {
+                    currentProgram = item.program;
+                    glUseProgram( currentProgram );
+
+                    modelLoc = glGetUniformLocation( currentProgram, "model" );
+                    featuresLoc = glGetUniformLocation( currentProgram, "features" );
+
+                    // Uniforms stay set in the program, so only pass the matricies when the camera changed
+                    unsigned long long &uploaded = uploadedCameraVersion[currentProgram];
+
+                    if ( uploaded != cameraVersion )
+                    {
+                        GLint viewLoc = glGetUniformLocation( currentProgram, "view" );
+                        GLint projLoc = glGetUniformLocation( currentProgram, "projection" );
+
+                        glUniformMatrix4fv( viewLoc, 1, GL_FALSE, glm::value_ptr( camera.GetViewMatrix( ) ) );
+                        glUniformMatrix4fv( projLoc, 1, GL_FALSE, glm::value_ptr( camera.GetProjectionMatrix( ) ) );
+                        uploaded = cameraVersion;
+                    }
+                }
+
+                if ( item.vao != currentVAO )
+                {
+                    currentVAO = item.vao;
+                    glBindVertexArray( currentVAO );
+                }
+
+                // Only the uber shader has this, specialised variants have their features compiled in
+                if ( -1 != featuresLoc )
+                {
+                    glUniform1i( featuresLoc, ( GLint )item.features );
+                }
+
+                glUniformMatrix4fv( modelLoc, 1, GL_FALSE, glm::value_ptr( scene.GetRelativeMatrixAt( item.denseIndex, origin ) ) );
+                glDrawArrays( GL_TRIANGLES, 0, item.vertexCount );
+            }
+
+            glBindVertexArray( 0 );
+        }
+
+        {
+            PROFILE_ZONE( "Frame::Present" );
+
+            // swap the screen buffers
+            glfwSwapBuffers( window );
+            input.FramePresented( glfwGetTime( ) );
+        }
+
+        debugOutput.Flush( );
+
+        // Nothing from this frame's arenas is used past this point
+        FrameArena::ResetAll( );
+
+        PROFILE_COUNTER( "Draw calls", drawList.size( ) );
+        PROFILE_FRAME( );
+    }
+
+    // A capture still running when the window closes is written out too
+    if ( Profiler::Get( ).IsCapturing( ) )
+    {
+        ToggleProfileCapture( );
     }
 
+    LOG_INFO( "Mouse input to present latency: {} ms average, {} ms worst", input.GetAverageLatency( ) * 1000.0,
+        input.GetMaxLatency( ) * 1000.0 );
+
     // Properly de-allocate all resources once they've outlived their purpose
     glDeleteVertexArrays( 1, &boxVAO );
     glDeleteVertexArrays( 1, &lightVAO );
     glDeleteBuffers( 1, &VBO );
 
+    // Its hidden window has to go before GLFW does
+    shaderCompiler.Stop( );
+
+    debugOutput.Flush( );
+    debugOutput.Uninstall( );
+    SOIL_set_GL_debug_output( 0 );
+
     // Terminate GLFW, clearing any resources allocated by GLFW.
     glfwTerminate( );
 
+    SOIL_set_parallel_for( nullptr, nullptr );
+    SOIL_set_log_func( nullptr, nullptr );
+    SOIL_set_profiler( nullptr, nullptr, nullptr );
+
+    // Everything logged is on its way out before main returns
+    Logger::Get( ).Flush( );
+
     return EXIT_SUCCESS;
 }
 
@@ -279,6 +478,15 @@ void DoMovement( )
     }
 }
 
+// Uniforms live in the program object, so every new program needs them. Programs without lighting
+// don't have them, setting a uniform at location -1 does nothing.
+void SetLightingColours( Shader &shader )
+{
+    shader.Use( );
+    glUniform3f( glGetUniformLocation( shader.Program, "objectColor" ), 1.0f, 0.5f, 0.31f );
+    glUniform3f( glGetUniformLocation( shader.Program, "lightColor" ),  1.0f, 0.5f, 1.0f );
+}
+
 void KeyCallback( GLFWwindow *window, int key, int scancode, int action, int mode )
 {
     if ( key == GLFW_KEY_ESCAPE && action == GLFW_PRESS )
@@ -286,6 +494,11 @@ void KeyCallback( GLFWwindow *window, int key, int scancode, int action, int mod
         glfwSetWindowShouldClose( window, GL_TRUE );
     }
 
+    if ( key == GLFW_KEY_F9 && action == GLFW_PRESS )
+    {
+        ToggleProfileCapture( );
+    }
+
     if ( key >= 0 && key < 1024 )
     {
         if ( action == GLFW_PRESS )
@@ -301,23 +514,73 @@ void KeyCallback( GLFWwindow *window, int key, int scancode, int action, int mod
 
 void MouseCallback( GLFWwindow *window, double xPos, double yPos )
 {
-    if ( firstMouse )
+    input.PushMouseMove( xPos, yPos, glfwGetTime( ) );
+}
+
+void ScrollCallback( GLFWwindow *window, double xOffset, double yOffset )
+{
+    camera.ProcessMouseScroll( yOffset );
+}
+
+void SOILParallelFor( SOIL_parallel_task task, void *context, int count, int grain, void *userData )
+{
+    JobSystem *jobs = static_cast<JobSystem *>( userData );
+
+    jobs->ParallelFor( count, grain, [task, context]( GLuint begin, GLuint end )
     {
-        lastX = xPos;
-        lastY = yPos;
-        firstMouse = false;
+        task( context, ( int )begin, ( int )end );
+    } );
+}
+
+// SOIL2's diagnostics go through the same logger as everything else
+void SOILLog( int level, const char *message, void * )
+{
+    switch ( level )
+    {
+        case SOIL_LOG_DEBUG:
+            LOG_DEBUG( "SOIL2::{}", message );
+            break;
+
+        case SOIL_LOG_INFO:
+            LOG_INFO( "SOIL2::{}", message );
+            break;
+
+        case SOIL_LOG_WARNING:
+            LOG_WARNING( "SOIL2::{}", message );
+            break;
+
+        default:
+            LOG_ERROR( "SOIL2::{}", message );
+            break;
     }
+}
 
-    GLfloat xOffset = xPos - lastX;
-    GLfloat yOffset = lastY - yPos; // Reversed since y-coords start from bottom left
+void ToggleProfileCapture( )
+{
+    Profiler &profiler = Profiler::Get( );
 
-    lastX = xPos;
-    lastY = yPos;
+    if ( !profiler.IsCapturing( ) )
+    {
+        profiler.StartCapture( );
+        LOG_INFO( "PROFILER::CAPTURE_STARTED" );
+    }
+    else if ( profiler.StopCapture( PROFILE_PATH ) )
+    {
+        LOG_INFO( "PROFILER::CAPTURE_WRITTEN {} ({} events dropped)", PROFILE_PATH, profiler.GetDroppedCount( ) );
+    }
+    else
+    {
+        LOG_ERROR( "ERROR::PROFILER::CAPTURE_NOT_WRITTEN {}", PROFILE_PATH );
+    }
+}
 
-    camera.ProcessMouseMovement( xOffset, yOffset );
+// SOIL2's loading stages show up as zones on whichever thread ran them
+void SOILZoneBegin( const char *name, void * )
+{
+    Profiler::Get( ).BeginZone( name );
 }
 
-void ScrollCallback( GLFWwindow *window, double xOffset, double yOffset )
+void SOILZoneEnd( void * )
 {
-    camera.ProcessMouseScroll( yOffset );
+    Profiler::Get( ).EndZone( );
 }
@@ -0,0 +1,77 @@
+////////////////////////////////////////////////////////////////
+/// Mat4Multiply.h
+////////////////////////////////////////////////////////////////
+
+#ifndef MAT4_MULTIPLY_H
+#define MAT4_MULTIPLY_H
+
+#include <cstddef>
+
+// GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+// OpenGL Math
+#include <glm/glm.hpp>
+
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+    #define MAT4_MULTIPLY_SSE
+    #include <xmmintrin.h>
+#endif
+
+// out = a * b for column major 4x4 matrices, out may not alias a or b
+inline void Mat4Multiply( const glm::mat4 &a, const glm::mat4 &b, glm::mat4 &out )
+{
+#ifdef MAT4_MULTIPLY_SSE
+    const GLfloat *pa = &a[0][0];
+    const GLfloat *pb = &b[0][0];
+    GLfloat *po = &out[0][0];
+
+    __m128 a0 = _mm_loadu_ps( pa );
+    __m128 a1 = _mm_loadu_ps( pa + 4 );
+    __m128 a2 = _mm_loadu_ps( pa + 8 );
+    __m128 a3 = _mm_loadu_ps( pa + 12 );
+
+    for ( int column = 0; column < 4; ++column )
+    {
+        const GLfloat *bc = pb + column * 4;
+        __m128 r = _mm_mul_ps( a0, _mm_set1_ps( bc[0] ) );
+        r = _mm_add_ps( r, _mm_mul_ps( a1, _mm_set1_ps( bc[1] ) ) );
+        r = _mm_add_ps( r, _mm_mul_ps( a2, _mm_set1_ps( bc[2] ) ) );
+        r = _mm_add_ps( r, _mm_mul_ps( a3, _mm_set1_ps( bc[3] ) ) );
+        _mm_storeu_ps( po + column * 4, r );
+    }
+#else
+    for ( int column = 0; column < 4; ++column )
+    {
+        out[column] = a[0] * b[column][0] + a[1] * b[column][1] + a[2] * b[column][2] + a[3] * b[column][3];
+    }
+#endif
+}
+
+// worlds[i] = worlds[parents[i]] * locals[i] for every i in indices, one matrix at a time with
+// Mat4Multiply, prefetching the next pair while the current one is multiplied. All parents must
+// already be up to date, which holds when the indices are one depth level of a depth-sorted
+// hierarchy. Working on four matrices per iteration in structure-of-arrays lanes was tried and was
+// about twice as slow with SSE, the transposes in and out cost more than the broadcasts they save.
+inline void Mat4MultiplyParents( glm::mat4 *worlds, const glm::mat4 *locals, const GLuint *parents,
+    const GLuint *indices, size_t count )
+{
+    for ( size_t n = 0; n < count; ++n )
+    {
+        GLuint i = indices[n];
+
+#ifdef MAT4_MULTIPLY_SSE
+        if ( n + 1 < count )
+        {
+            GLuint next = indices[n + 1];
+            _mm_prefetch( ( const char * )&locals[next], _MM_HINT_T0 );
+            _mm_prefetch( ( const char * )&worlds[parents[next]], _MM_HINT_T0 );
+        }
+#endif
+
+        Mat4Multiply( worlds[parents[i]], locals[i], worlds[i] );
+    }
+}
+
+#endif // MAT4_MULTIPLY_H
@@ -0,0 +1,458 @@
+////////////////////////////////////////////////////////////////
+/// Profiler.h
+////////////////////////////////////////////////////////////////
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+    #include <x86intrin.h>
+    #define PROFILER_USE_TSC 1
+#elif defined( _M_X64 ) || defined( _M_IX86 )
+    #include <intrin.h>
+    #define PROFILER_USE_TSC 1
+#else
+    #define PROFILER_USE_TSC 0
+#endif
+
+// Zones cost a relaxed load and a branch while nothing is being captured, build with
+// -DPROFILER_ENABLED=0 to remove them entirely
+#ifndef PROFILER_ENABLED
+    #define PROFILER_ENABLED 1
+#endif
+
+#define PROFILE_CONCAT_( a, b ) a##b
+#define PROFILE_CONCAT( a, b ) PROFILE_CONCAT_( a, b )
+
+#if PROFILER_ENABLED
+    // name must be a string literal (or otherwise outlive the capture), only its address is recorded
+    #define PROFILE_ZONE( name ) ProfileZone PROFILE_CONCAT( profileZone, __LINE__ )( name )
+    #define PROFILE_FRAME( ) Profiler::Get( ).MarkFrame( )
+    #define PROFILE_COUNTER( name, value ) Profiler::Get( ).Count( name, ( double )( value ) )
+#else
+    #define PROFILE_ZONE( name ) ( ( void )0 )
+    #define PROFILE_FRAME( ) ( ( void )0 )
+    #define PROFILE_COUNTER( name, value ) ( ( void )0 )
+#endif
+
+// Instrumentation profiler. Zones, frame marks and counters are appended to a fixed buffer owned
+// by the thread that records them, so recording takes no lock and touches no shared cache line:
+// a timestamp (the TSC where there is one), a store, and publishing the new count. Nothing is
+// recorded outside a capture. StopCapture writes what was captured as Chrome trace event JSON,
+// which chrome://tracing and ui.perfetto.dev open, with one track per thread and one per counter.
+class Profiler
+{
+public:
+    // Per thread and capture, events past this are dropped and counted
+    static const size_t EVENTS_PER_THREAD = 1 << 16;
+
+    static Profiler &Get( )
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    void StartCapture( )
+    {
+        std::lock_guard<std::mutex> guard( this->captureLock );
+
+        if ( this->capturing.load( std::memory_order_relaxed ) )
+        {
+            return;
+        }
+
+        this->ForgetExitedThreads( );
+        this->dropped.store( 0, std::memory_order_relaxed );
+        this->startTicks = Now( );
+        this->startClock = std::chrono::steady_clock::now( );
+
+        // Buffers still holding the last capture's events reset themselves on their next event
+        this->generation.fetch_add( 1, std::memory_order_relaxed );
+        this->capturing.store( true, std::memory_order_release );
+    }
+
+    // Ends the capture and writes it to path, false if the file couldn't be written
+    bool StopCapture( const char *path )
+    {
+        std::lock_guard<std::mutex> guard( this->captureLock );
+
+        if ( !this->capturing.load( std::memory_order_relaxed ) )
+        {
+            return false;
+        }
+
+        this->capturing.store( false, std::memory_order_release );
+        this->stopTicks = Now( );
+
+        // The TSC rate isn't known up front, measure it over the capture
+        double elapsed = std::chrono::duration<double, std::micro>( std::chrono::steady_clock::now( ) - this->startClock ).count( );
+        this->microsecondsPerTick = ( this->stopTicks > this->startTicks ) ? elapsed / ( double )( this->stopTicks - this->startTicks ) : 0.0;
+
+        return this->Export( path );
+    }
+
+    bool IsCapturing( ) const
+    {
+        return this->capturing.load( std::memory_order_relaxed );
+    }
+
+    // Shown as the track name, threads that never name themselves get "Thread n"
+    void SetThreadName( const std::string &name )
+    {
+        ThreadBuffer &buffer = ThisThreadBuffer( );
+        std::lock_guard<std::mutex> guard( this->threadsLock );
+        buffer.name = name;
+    }
+
+    void BeginZone( const char *name )
+    {
+        this->Record( EVENT_BEGIN, name, 0.0 );
+    }
+
+    void EndZone( )
+    {
+        this->Record( EVENT_END, nullptr, 0.0 );
+    }
+
+    void MarkFrame( )
+    {
+        this->Record( EVENT_FRAME, nullptr, 0.0 );
+    }
+
+    void Count( const char *name, double value )
+    {
+        this->Record( EVENT_COUNTER, name, value );
+    }
+
+    // Events lost in the last capture because a thread's buffer was full
+    size_t GetDroppedCount( ) const
+    {
+        return this->dropped.load( std::memory_order_relaxed );
+    }
+
+private:
+    enum Event_Type
+    {
+        EVENT_BEGIN,
+        EVENT_END,
+        EVENT_FRAME,
+        EVENT_COUNTER
+    };
+
+    struct Event
+    {
+        uint64_t ticks;
+        const char *name;
+        double value;
+        int type;
+    };
+
+    // Written only by its thread. count is published with release so the exporter sees every
+    // event below it complete. The events are only allocated once the thread records something.
+    struct ThreadBuffer
+    {
+        ThreadBuffer( unsigned id ) : count( 0 ), generation( 0 ), id( id ), exited( false )
+        {
+        }
+
+        std::unique_ptr<Event[]> events;
+        std::atomic<size_t> count;
+        std::atomic<unsigned> generation;
+        unsigned id;
+        std::string name;
+        std::atomic<bool> exited;
+    };
+
+    // Registers the thread's buffer the first time it records and marks it exited with the thread,
+    // the buffer itself lives on until a later capture no longer needs it
+    struct ThreadHolder
+    {
+        std::shared_ptr<ThreadBuffer> buffer;
+
+        ThreadHolder( )
+        {
+            Profiler &profiler = Profiler::Get( );
+            std::lock_guard<std::mutex> guard( profiler.threadsLock );
+            this->buffer = std::make_shared<ThreadBuffer>( ++profiler.nextThreadId );
+            profiler.threads.push_back( this->buffer );
+        }
+
+        ~ThreadHolder( )
+        {
+            this->buffer->exited.store( true, std::memory_order_release );
+        }
+    };
+
+    std::atomic<bool> capturing;
+    std::atomic<unsigned> generation;
+    std::atomic<size_t> dropped;
+
+    std::mutex captureLock;
+    uint64_t startTicks;
+    uint64_t stopTicks;
+    std::chrono::steady_clock::time_point startClock;
+    double microsecondsPerTick;
+
+    std::mutex threadsLock;
+    std::vector<std::shared_ptr<ThreadBuffer>> threads;
+    unsigned nextThreadId;
+
+    Profiler( ) : capturing( false ), generation( 0 ), dropped( 0 ), startTicks( 0 ), stopTicks( 0 ), microsecondsPerTick( 0.0 ),
+        nextThreadId( 0 )
+    {
+    }
+
+    static uint64_t Now( )
+    {
+#if PROFILER_USE_TSC
+        return __rdtsc( );
+#else
+        return ( uint64_t )std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now( ).time_since_epoch( ) ).count( );
+#endif
+    }
+
+    static ThreadBuffer &ThisThreadBuffer( )
+    {
+        static thread_local ThreadHolder holder;
+        return *holder.buffer;
+    }
+
+    void Record( int type, const char *name, double value )
+    {
+        // Acquire, so a capture that has started is seen with its generation
+        if ( !this->capturing.load( std::memory_order_acquire ) )
+        {
+            return;
+        }
+
+        ThreadBuffer &buffer = ThisThreadBuffer( );
+        unsigned current = this->generation.load( std::memory_order_relaxed );
+
+        if ( current != buffer.generation.load( std::memory_order_relaxed ) )
+        {
+            if ( !buffer.events )
+            {
+                buffer.events.reset( new Event[EVENTS_PER_THREAD] );
+            }
+
+            buffer.count.store( 0, std::memory_order_relaxed );
+            buffer.generation.store( current, std::memory_order_release );
+        }
+
+        size_t index = buffer.count.load( std::memory_order_relaxed );
+
+        if ( EVENTS_PER_THREAD == index )
+        {
+            this->dropped.fetch_add( 1, std::memory_order_relaxed );
+            return;
+        }
+
+        Event &event = buffer.events[index];
+        event.ticks = Now( );
+        event.name = name;
+        event.value = value;
+        event.type = type;
+
+        buffer.count.store( index + 1, std::memory_order_release );
+    }
+
+    // Caller holds captureLock
+    void ForgetExitedThreads( )
+    {
+        std::lock_guard<std::mutex> guard( this->threadsLock );
+
+        for ( size_t i = 0; i < this->threads.size( ); )
+        {
+            if ( this->threads[i]->exited.load( std::memory_order_acquire ) )
+            {
+                this->threads[i] = this->threads.back( );
+                this->threads.pop_back( );
+                continue;
+            }
+
+            ++i;
+        }
+    }
+
+    double ToMicroseconds( uint64_t ticks ) const
+    {
+        return ( ticks > this->startTicks ) ? ( double )( ticks - this->startTicks ) * this->microsecondsPerTick : 0.0;
+    }
+
+    static void WriteString( FILE *file, const char *text )
+    {
+        std::fputc( '"', file );
+
+        for ( const char *c = text; '\0' != *c; ++c )
+        {
+            if ( '"' == *c || '\\' == *c )
+            {
+                std::fputc( '\\', file );
+                std::fputc( *c, file );
+            }
+            else if ( ( unsigned char )*c < 0x20 )
+            {
+                std::fprintf( file, "\\u%04x", ( unsigned )( unsigned char )*c );
+            }
+            else
+            {
+                std::fputc( *c, file );
+            }
+        }
+
+        std::fputc( '"', file );
+    }
+
+    // Caller holds captureLock
+    bool Export( const char *path )
+    {
+        FILE *file = std::fopen( path, "w" );
+
+        if ( nullptr == file )
+        {
+            return false;
+        }
+
+        std::vector<std::shared_ptr<ThreadBuffer>> snapshot;
+        std::vector<std::string> names;
+
+        {
+            std::lock_guard<std::mutex> guard( this->threadsLock );
+            snapshot = this->threads;
+
+            for ( size_t i = 0; i < snapshot.size( ); ++i )
+            {
+                names.push_back( snapshot[i]->name );
+            }
+        }
+
+        unsigned current = this->generation.load( std::memory_order_relaxed );
+        double end = this->ToMicroseconds( this->stopTicks );
+        const char *separator = "\n";
+
+        std::fprintf( file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" );
+
+        for ( size_t t = 0; t < snapshot.size( ); ++t )
+        {
+            ThreadBuffer &buffer = *snapshot[t];
+
+            if ( current != buffer.generation.load( std::memory_order_acquire ) )
+            {
+                continue;
+            }
+
+            size_t count = buffer.count.load( std::memory_order_acquire );
+            std::string name = names[t].empty( ) ? "Thread " + std::to_string( buffer.id ) : names[t];
+
+            std::fprintf( file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", separator, buffer.id );
+            WriteString( file, name.c_str( ) );
+            std::fprintf( file, "}}" );
+            separator = ",\n";
+
+            // Zones open when the capture started have no begin and are skipped, zones still open at
+            // the end are closed there
+            int depth = 0;
+            double lastFrame = -1.0;
+            unsigned frameNumber = 0;
+
+            for ( size_t i = 0; i < count; ++i )
+            {
+                const Event &event = buffer.events[i];
+                double time = this->ToMicroseconds( event.ticks );
+
+                switch ( event.type )
+                {
+                    case EVENT_BEGIN:
+                        std::fprintf( file, "%s{\"ph\":\"B\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"name\":", separator, buffer.id, time );
+                        WriteString( file, event.name );
+                        std::fputc( '}', file );
+                        ++depth;
+                        break;
+
+                    case EVENT_END:
+                        if ( depth > 0 )
+                        {
+                            std::fprintf( file, "%s{\"ph\":\"E\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", separator, buffer.id, time );
+                            --depth;
+                        }
+                        break;
+
+                    case EVENT_FRAME:
+                        // Each frame becomes a slice on a track of its own, from one mark to the next
+                        if ( lastFrame >= 0.0 )
+                        {
+                            std::fprintf( file, "%s{\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f,\"name\":\"Frame %u\"}",
+                                separator, lastFrame, time - lastFrame, frameNumber++ );
+                        }
+
+                        lastFrame = time;
+                        break;
+
+                    default:
+                        std::fprintf( file, "%s{\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"name\":", separator, buffer.id, time );
+                        WriteString( file, event.name );
+                        std::fprintf( file, ",\"args\":{\"value\":%.17g}}", event.value );
+                        break;
+                }
+            }
+
+            for ( ; depth > 0; --depth )
+            {
+                std::fprintf( file, "%s{\"ph\":\"E\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", separator, buffer.id, end );
+            }
+
+            if ( frameNumber > 0 )
+            {
+                std::fprintf( file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Frames\"}}", separator );
+            }
+        }
+
+        std::fprintf( file, "\n]}\n" );
+
+        bool written = !std::ferror( file );
+
+        return ( 0 == std::fclose( file ) ) && written;
+    }
+
+    Profiler( const Profiler & ) = delete;
+    Profiler &operator=( const Profiler & ) = delete;
+};
+
+// Records a zone from construction to the end of the scope, use through PROFILE_ZONE. A zone that
+// began outside a capture doesn't record its end either.
+class ProfileZone
+{
+public:
+    ProfileZone( const char *name ) : active( Profiler::Get( ).IsCapturing( ) )
+    {
+        if ( this->active )
+        {
+            Profiler::Get( ).BeginZone( name );
+        }
+    }
+
+    ~ProfileZone( )
+    {
+        if ( this->active )
+        {
+            Profiler::Get( ).EndZone( );
+        }
+    }
+
+private:
+    bool active;
+
+    ProfileZone( const ProfileZone & ) = delete;
+    ProfileZone &operator=( const ProfileZone & ) = delete;
+};
+
+#endif // PROFILER_H
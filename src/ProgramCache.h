@@ -0,0 +1,208 @@
+////////////////////////////////////////////////////////////////
+/// ProgramCache.h
+////////////////////////////////////////////////////////////////
+
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#ifdef _WIN32
+    #include <direct.h>
+#endif
+
+// GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+// Keeps linked program binaries on disk so later launches can skip compiling and linking.
+// Entries are keyed by a hash of everything that affects the binary: the shader sources, the
+// defines they were built with and the renderer/driver that produced it, so a driver update or
+// a different GPU simply misses instead of loading a binary the driver would reject.
+class ProgramCache
+{
+public:
+    typedef unsigned long long Key;
+
+    static const char *GetDirectory( )
+    {
+        return "shadercache";
+    }
+
+    // Binary caching needs GL 4.1 or ARB_get_program_binary and at least one binary format
+    static bool IsSupported( )
+    {
+        if ( !GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary )
+        {
+            return false;
+        }
+
+        GLint formats = 0;
+        glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &formats );
+
+        return formats > 0;
+    }
+
+    static Key MakeKey( const std::vector<std::string> &sources, const std::string &defines )
+    {
+        Key hash = HashBytes( FNV_OFFSET, defines.data( ), defines.size( ) );
+
+        for ( size_t i = 0; i < sources.size( ); ++i )
+        {
+            // Mix in the length so moving text from one stage to the next changes the key
+            Key length = sources[i].size( );
+            hash = HashBytes( hash, &length, sizeof( length ) );
+            hash = HashBytes( hash, sources[i].data( ), sources[i].size( ) );
+        }
+
+        const GLubyte *strings[] = { glGetString( GL_VENDOR ), glGetString( GL_RENDERER ), glGetString( GL_VERSION ) };
+
+        for ( size_t i = 0; i < sizeof( strings ) / sizeof( strings[0] ); ++i )
+        {
+            if ( nullptr != strings[i] )
+            {
+                std::string value( ( const char * )strings[i] );
+                hash = HashBytes( hash, value.data( ), value.size( ) + 1 );
+            }
+        }
+
+        return hash;
+    }
+
+    // Returns true if program was linked from a cached binary. A stale or corrupt entry is deleted
+    // so the caller's fresh link can replace it.
+    static bool Load( Key key, GLuint program )
+    {
+        std::string path = PathFor( key );
+        FILE *file = std::fopen( path.c_str( ), "rb" );
+
+        if ( nullptr == file )
+        {
+            return false;
+        }
+
+        Header header;
+        std::vector<unsigned char> binary;
+        bool valid = 1 == std::fread( &header, sizeof( header ), 1, file ) && MAGIC == header.magic && key == header.key &&
+            header.length > 0;
+
+        if ( valid )
+        {
+            binary.resize( header.length );
+            valid = 1 == std::fread( &binary[0], binary.size( ), 1, file );
+        }
+
+        std::fclose( file );
+
+        if ( valid )
+        {
+            glProgramBinary( program, header.format, &binary[0], ( GLsizei )binary.size( ) );
+
+            GLint success = GL_FALSE;
+            glGetProgramiv( program, GL_LINK_STATUS, &success );
+            valid = GL_TRUE == success;
+        }
+
+        if ( !valid )
+        {
+            std::remove( path.c_str( ) );
+        }
+
+        return valid;
+    }
+
+    // Call with a program that linked successfully with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+    static void Store( Key key, GLuint program )
+    {
+        GLint length = 0;
+        glGetProgramiv( program, GL_PROGRAM_BINARY_LENGTH, &length );
+
+        if ( length <= 0 )
+        {
+            return;
+        }
+
+        std::vector<unsigned char> binary( length );
+        Header header;
+        header.magic = MAGIC;
+        header.key = key;
+        header.format = 0;
+        header.reserved = 0;
+        glGetProgramBinary( program, length, &length, &header.format, &binary[0] );
+        header.length = ( GLuint )length;
+
+        MakeDirectory( GetDirectory( ) );
+
+        // Write to a temporary name first so a crash mid write never leaves a truncated entry behind
+        std::string path = PathFor( key );
+        std::string temporary = path + ".tmp";
+        FILE *file = std::fopen( temporary.c_str( ), "wb" );
+
+        if ( nullptr == file )
+        {
+            return;
+        }
+
+        bool written = 1 == std::fwrite( &header, sizeof( header ), 1, file ) &&
+            1 == std::fwrite( &binary[0], header.length, 1, file );
+
+        if ( 0 != std::fclose( file ) || !written )
+        {
+            std::remove( temporary.c_str( ) );
+            return;
+        }
+
+        std::remove( path.c_str( ) );
+        std::rename( temporary.c_str( ), path.c_str( ) );
+    }
+
+private:
+    static const GLuint MAGIC = 0x42504C47; // "GLPB"
+    static const Key FNV_OFFSET = 14695981039346656037ULL;
+    static const Key FNV_PRIME = 1099511628211ULL;
+
+    struct Header
+    {
+        GLuint magic;
+        GLenum format;
+        GLuint length;
+        GLuint reserved;
+        Key key;
+    };
+
+    // FNV-1a, plenty for telling a handful of shader builds apart
+    static Key HashBytes( Key hash, const void *data, size_t size )
+    {
+        const unsigned char *bytes = static_cast<const unsigned char *>( data );
+
+        for ( size_t i = 0; i < size; ++i )
+        {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+
+        return hash;
+    }
+
+    static std::string PathFor( Key key )
+    {
+        char name[32];
+        std::snprintf( name, sizeof( name ), "%016llx.bin", key );
+
+        return std::string( GetDirectory( ) ) + "/" + name;
+    }
+
+    static void MakeDirectory( const char *path )
+    {
+#ifdef _WIN32
+        _mkdir( path );
+#else
+        mkdir( path, 0755 );
+#endif
+    }
+};
+
+#endif // PROGRAM_CACHE_H
@@ -16,7 +16,12 @@
 	* everybody at gamedev.net
 */
 
-#define SOIL_CHECK_FOR_GL_ERRORS 0
+/*	GL errors are left to the application's debug output (KHR_debug).
+	Build with SOIL_CHECK_FOR_GL_ERRORS defined to 1 to poll glGetError
+	after each upload instead, which can make the driver synchronise	*/
+#ifndef SOIL_CHECK_FOR_GL_ERRORS
+	#define SOIL_CHECK_FOR_GL_ERRORS 0
+#endif
 
 #if defined( __APPLE_CC__ ) || defined ( __APPLE__ )
 	#include <TargetConditionals.h>
@@ -113,14 +118,59 @@
 #include "image_DXT.h"
 #include "pvr_helper.h"
 #include "pkm_helper.h"
+#include "ktx_helper.h"
+#include "etc1_utils.h"
+#include "etc2_utils.h"
 #include "jo_jpeg.h"
+#include "profile_helper.h"
 
+#include <stdarg.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+/*	KTX2 files may be Zstandard supercompressed, define SOIL_KTX2_ZSTD
+	and link libzstd to load them	*/
+#ifdef SOIL_KTX2_ZSTD
+	#include <zstd.h>
+#endif
+
 /*	error reporting	*/
 const char *result_string_pointer = "SOIL initialized";
 
+/*	where diagnostics go, stdout when nothing is set	*/
+static SOIL_log_func soil_log_func = NULL;
+static void *soil_log_user_data = NULL;
+
+void
+	SOIL_set_log_func
+	(
+		SOIL_log_func func,
+		void *user_data
+	)
+{
+	soil_log_func = func;
+	soil_log_user_data = user_data;
+}
+
+void soil_log( int level, const char *format, ... )
+{
+	char message[256];
+	va_list args;
+
+	va_start( args, format );
+	vsnprintf( message, sizeof( message ), format, args );
+	va_end( args );
+
+	if( NULL != soil_log_func )
+	{
+		soil_log_func( level, message, soil_log_user_data );
+	} else
+	{
+		printf( "%s\n", message );
+	}
+}
+
 /*	for loading cube maps	*/
 enum{
 	SOIL_CAPABILITY_UNKNOWN = -1,
@@ -180,6 +230,24 @@ static int has_BGRA8888_capability = SOIL_CAPABILITY_UNKNOWN;
 int query_BGRA8888_capability( void );
 static int has_ETC1_capability = SOIL_CAPABILITY_UNKNOWN;
 int query_ETC1_capability( void );
+/*	ETC2 and EAC, part of OpenGL ES 3	*/
+static int has_ETC2_capability = SOIL_CAPABILITY_UNKNOWN;
+int query_ETC2_capability( void );
+/*	for BC4/BC5 and BC6H/BC7	*/
+static int has_RGTC_capability = SOIL_CAPABILITY_UNKNOWN;
+int query_RGTC_capability( void );
+static int has_BPTC_capability = SOIL_CAPABILITY_UNKNOWN;
+int query_BPTC_capability( void );
+#define SOIL_COMPRESSED_RED_RGTC1					0x8DBB
+#define SOIL_COMPRESSED_SIGNED_RED_RGTC1			0x8DBC
+#define SOIL_COMPRESSED_RG_RGTC2					0x8DBD
+#define SOIL_COMPRESSED_SIGNED_RG_RGTC2				0x8DBE
+#define SOIL_COMPRESSED_RGBA_BPTC_UNORM				0x8E8C
+#define SOIL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM		0x8E8D
+#define SOIL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT		0x8E8E
+#define SOIL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT		0x8E8F
+#define SOIL_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT	0x8C4D
+#define SOIL_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT	0x8C4E
 
 /* GL_IMG_texture_compression_pvrtc */
 #define SOIL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG                      0x8C00
@@ -188,6 +256,56 @@ int query_ETC1_capability( void );
 #define SOIL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG                     0x8C03
 #define SOIL_GL_ETC1_RGB8_OES                                     0x8D64
 
+/*	for KTX files: ASTC, array textures and the sized formats	*/
+static int has_ASTC_capability = SOIL_CAPABILITY_UNKNOWN;
+int query_ASTC_capability( void );
+#define SOIL_COMPRESSED_RGBA_ASTC_4x4				0x93B0
+#define SOIL_COMPRESSED_RGBA_ASTC_12x12				0x93BD
+#define SOIL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4		0x93D0
+#define SOIL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x12		0x93DD
+#define SOIL_TEXTURE_2D_ARRAY						0x8C1A
+#define SOIL_TEXTURE_CUBE_MAP_ARRAY					0x9009
+#define SOIL_TEXTURE_MAX_LEVEL						0x813D
+#define SOIL_GL_RED									0x1903
+#define SOIL_GL_RG									0x8227
+#define SOIL_GL_R8									0x8229
+#define SOIL_GL_RG8									0x822B
+#define SOIL_GL_RGB8								0x8051
+#define SOIL_GL_RGBA8								0x8058
+#define SOIL_GL_SRGB8								0x8C41
+#define SOIL_GL_SRGB8_ALPHA8						0x8C43
+#define SOIL_GL_R8_SNORM							0x8F94
+#define SOIL_GL_RG8_SNORM							0x8F95
+#define SOIL_GL_R16F								0x822D
+#define SOIL_GL_RG16F								0x822F
+#define SOIL_GL_RGB16F								0x881B
+#define SOIL_GL_RGBA16F								0x881A
+#define SOIL_GL_R32F								0x822E
+#define SOIL_GL_RG32F								0x8230
+#define SOIL_GL_RGB32F								0x8815
+#define SOIL_GL_RGBA32F								0x8814
+#define SOIL_GL_HALF_FLOAT							0x140B
+#define SOIL_GL_BGR									0x80E0
+#define SOIL_GL_RED_INTEGER							0x8D94
+#define SOIL_GL_RG_INTEGER							0x8228
+#define SOIL_GL_RGB_INTEGER							0x8D98
+#define SOIL_GL_RGBA_INTEGER						0x8D99
+#define SOIL_GL_UNSIGNED_SHORT_4_4_4_4				0x8033
+#define SOIL_GL_UNSIGNED_SHORT_5_5_5_1				0x8034
+#define SOIL_GL_UNSIGNED_SHORT_5_6_5				0x8363
+#define SOIL_GL_UNSIGNED_SHORT_5_6_5_REV			0x8364
+#define SOIL_GL_UNSIGNED_SHORT_4_4_4_4_REV			0x8365
+#define SOIL_GL_UNSIGNED_SHORT_1_5_5_5_REV			0x8366
+#define SOIL_GL_UNSIGNED_INT_8_8_8_8				0x8035
+#define SOIL_GL_UNSIGNED_INT_8_8_8_8_REV			0x8367
+#define SOIL_GL_UNSIGNED_INT_2_10_10_10_REV			0x8368
+#define SOIL_GL_UNSIGNED_INT_10F_11F_11F_REV		0x8C3B
+#define SOIL_GL_UNSIGNED_INT_5_9_9_9_REV			0x8C3E
+typedef void (APIENTRY * P_SOIL_GLCOMPRESSEDTEXIMAGE3DPROC) (GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLsizei imageSize, const GLvoid * data);
+static P_SOIL_GLCOMPRESSEDTEXIMAGE3DPROC soilGlCompressedTexImage3D = NULL;
+typedef void (APIENTRY * P_SOIL_GLTEXIMAGE3DPROC) (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const GLvoid * data);
+static P_SOIL_GLTEXIMAGE3DPROC soilGlTexImage3D = NULL;
+
 #if defined( SOIL_X11_PLATFORM ) || defined( SOIL_PLATFORM_WIN32 ) || defined( SOIL_PLATFORM_OSX )
 typedef const GLubyte *(APIENTRY * P_SOIL_glGetStringiFunc) (GLenum, GLuint);
 static P_SOIL_glGetStringiFunc soilGlGetStringiFunc = NULL;
@@ -369,6 +487,14 @@ unsigned int
 		unsigned int opengl_texture_target,
 		unsigned int texture_check_size_enum
 	);
+static unsigned int
+	SOIL_internal_create_OGL_BC6H_texture
+	(
+		float *data,
+		int width, int height,
+		unsigned int reuse_texture_ID,
+		unsigned int flags
+	);
 
 /*	and the code magic begins here [8^)	*/
 unsigned int
@@ -419,6 +545,16 @@ unsigned int
 		}
 	}
 
+	if( flags & SOIL_FLAG_KTX_LOAD_DIRECT )
+	{
+		tex_id = SOIL_direct_load_KTX( filename, reuse_texture_ID, flags, 0 );
+		if( tex_id )
+		{
+			/*	hey, it worked!!	*/
+			return tex_id;
+		}
+	}
+
 	/*	try to load the image	*/
 	img = SOIL_load_image( filename, &width, &height, &channels, force_channels );
 	/*	channels holds the original number of channels, which may have been forced	*/
@@ -468,6 +604,25 @@ unsigned int
 		return 0;
 	}
 
+	/*	keep the real HDR values if the card can take them as BC6H	*/
+	if( (flags & SOIL_FLAG_COMPRESS_TO_BC6H) &&
+		(query_BPTC_capability() == SOIL_CAPABILITY_PRESENT) &&
+		stbi_is_hdr( filename ) )
+	{
+		float *HDR_img = stbi_loadf( filename, &width, &height, &channels, 3 );
+		if( NULL != HDR_img )
+		{
+			tex_id = SOIL_internal_create_OGL_BC6H_texture(
+					HDR_img, width, height,
+					reuse_texture_ID, flags );
+			free( HDR_img );
+			if( 0 != tex_id )
+			{
+				return tex_id;
+			}
+		}
+	}
+
 	/* check if the image is HDR */
 	if ( stbi_is_hdr( filename ) )
 	{
@@ -557,6 +712,18 @@ unsigned int
 		}
 	}
 
+	if( flags & SOIL_FLAG_KTX_LOAD_DIRECT )
+	{
+		tex_id = SOIL_direct_load_KTX_from_memory(
+				buffer, buffer_length,
+				reuse_texture_ID, flags, 0 );
+		if( tex_id )
+		{
+			/*	hey, it worked!!	*/
+			return tex_id;
+		}
+	}
+
 	/*	try to load the image	*/
 	img = SOIL_load_image_from_memory(
 					buffer, buffer_length,
@@ -1018,6 +1185,16 @@ unsigned int
 		}
 	}
 
+	if ( flags & SOIL_FLAG_KTX_LOAD_DIRECT )
+	{
+		tex_id = SOIL_direct_load_KTX( filename, reuse_texture_ID, flags, 1 );
+		if( tex_id )
+		{
+			/*	hey, it worked!!	*/
+			return tex_id;
+		}
+	}
+
 	if ( flags & SOIL_FLAG_ETC1_LOAD_DIRECT )
 	{
 		return 0;
@@ -1124,6 +1301,18 @@ unsigned int
 		}
 	}
 
+	if ( flags & SOIL_FLAG_KTX_LOAD_DIRECT )
+	{
+		tex_id = SOIL_direct_load_KTX_from_memory(
+				buffer, buffer_length,
+				reuse_texture_ID, flags, 1 );
+		if ( tex_id )
+		{
+			/*	hey, it worked!!	*/
+			return tex_id;
+		}
+	}
+
 	if ( flags & SOIL_FLAG_ETC1_LOAD_DIRECT )
 	{
 		return 0;
@@ -1312,24 +1501,146 @@ unsigned int
 }
 
 #if SOIL_CHECK_FOR_GL_ERRORS
+static int soil_GL_debug_output = 0;
+
+void
+	SOIL_set_GL_debug_output
+	(
+		int enabled
+	)
+{
+	soil_GL_debug_output = enabled;
+}
+
 void check_for_GL_errors( const char *calling_location )
 {
+	GLenum err_code;
+
+	/*	the debug output callback already reports these, and
+		glGetError can make the driver synchronise	*/
+	if( soil_GL_debug_output )
+	{
+		return;
+	}
+
 	/*	check for errors	*/
-	GLenum err_code = glGetError();
+	err_code = glGetError();
 	while( GL_NO_ERROR != err_code )
 	{
-		printf( "OpenGL Error @ %s: %i", calling_location, err_code );
+		soil_log( SOIL_LOG_ERROR, "OpenGL Error @ %s: %i", calling_location, err_code );
 		err_code = glGetError();
 	}
 }
 #else
-void check_for_GL_errors( const char *calling_location )
+void
+	SOIL_set_GL_debug_output
+	(
+		int enabled
+	)
 {
-	/*	no check for errors	*/
+	/*	nothing is polled in this build	*/
 }
+
+/*	no check for errors, not even a call	*/
+#define check_for_GL_errors( calling_location )
 #endif
 
-static void createMipmaps(const unsigned char *const img,
+/*	which DXT encoder the flags ask for	*/
+static int DXT_mode_from_flags( unsigned int flags )
+{
+	if( flags & SOIL_FLAG_DXT_HIGH_QUALITY )
+	{
+		return DXT_MODE_CLUSTER_FIT;
+	}
+	if( flags & SOIL_FLAG_DXT_FAST )
+	{
+		return DXT_MODE_RANGE_FIT;
+	}
+	return DXT_MODE_DEFAULT;
+}
+
+/*	the block compressed format the flags ask for and the card can
+	display, or 0 to upload the image as it is	*/
+static unsigned int compressed_format_from_flags( unsigned int flags, int channels, int sRGB_texture )
+{
+	if( (flags & SOIL_FLAG_COMPRESS_TO_BC7) &&
+		(query_BPTC_capability() == SOIL_CAPABILITY_PRESENT) )
+	{
+		return sRGB_texture ? SOIL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : SOIL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+	if( (flags & SOIL_FLAG_COMPRESS_TO_RGTC) &&
+		(query_RGTC_capability() == SOIL_CAPABILITY_PRESENT) )
+	{
+		/*	1 channel = BC4, the rest = BC5 of the first 2 channels	*/
+		return (1 == channels) ? SOIL_COMPRESSED_RED_RGTC1 : SOIL_COMPRESSED_RG_RGTC2;
+	}
+	if( (flags & SOIL_FLAG_COMPRESS_TO_RGTC) &&
+		(query_ETC2_capability() == SOIL_CAPABILITY_PRESENT) )
+	{
+		/*	the same split with EAC, for OpenGL ES	*/
+		return (1 == channels) ? ETC2_COMPRESSED_R11_EAC : ETC2_COMPRESSED_RG11_EAC;
+	}
+	if( (flags & SOIL_FLAG_COMPRESS_TO_DXT) &&
+		(query_DXT_capability() == SOIL_CAPABILITY_PRESENT) )
+	{
+		if( (channels & 1) == 1 )
+		{
+			/*	1 or 3 channels = DXT1	*/
+			return sRGB_texture ? SOIL_GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : SOIL_RGB_S3TC_DXT1;
+		}
+		/*	2 or 4 channels = DXT5	*/
+		return sRGB_texture ? SOIL_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : SOIL_RGBA_S3TC_DXT5;
+	}
+	if( (flags & SOIL_FLAG_COMPRESS_TO_ETC2) &&
+		(query_ETC2_capability() == SOIL_CAPABILITY_PRESENT) )
+	{
+		if( (channels & 1) == 1 )
+		{
+			/*	1 or 3 channels = ETC2 RGB8	*/
+			return sRGB_texture ? ETC2_COMPRESSED_SRGB8_ETC2 : ETC2_COMPRESSED_RGB8_ETC2;
+		}
+		/*	2 or 4 channels = ETC2 RGBA8 with EAC alpha	*/
+		return sRGB_texture ? ETC2_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC : ETC2_COMPRESSED_RGBA8_ETC2_EAC;
+	}
+	return 0;
+}
+
+/*	compresses one level of the texture into its compressed format	*/
+static unsigned char* compress_image_to_format( unsigned int format,
+		const unsigned char *const img,
+		int width, int height, int channels,
+		unsigned int flags,
+		int *out_size )
+{
+	switch( format )
+	{
+	case SOIL_COMPRESSED_RED_RGTC1:
+		return convert_image_to_BC4( img, width, height, channels, DXT_mode_from_flags( flags ), out_size );
+	case SOIL_COMPRESSED_RG_RGTC2:
+		return convert_image_to_BC5( img, width, height, channels, DXT_mode_from_flags( flags ), out_size );
+	case SOIL_COMPRESSED_RGBA_BPTC_UNORM:
+	case SOIL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+		return convert_image_to_BC7( img, width, height, channels, DXT_mode_from_flags( flags ), out_size );
+	case ETC2_COMPRESSED_R11_EAC:
+	case ETC2_COMPRESSED_RG11_EAC:
+	case ETC2_COMPRESSED_RGB8_ETC2:
+	case ETC2_COMPRESSED_SRGB8_ETC2:
+	case ETC2_COMPRESSED_RGBA8_ETC2_EAC:
+	case ETC2_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+		return convert_image_to_ETC2( img, width, height, channels, format,
+				(flags & SOIL_FLAG_DXT_FAST) ? ETC1_QUALITY_FAST : ETC1_QUALITY_THOROUGH, out_size );
+	}
+	if( (channels & 1) == 1 )
+	{
+		/*	RGB, use DXT1	*/
+		return convert_image_to_DXT1( img, width, height, channels, DXT_mode_from_flags( flags ), out_size );
+	}
+	/*	RGBA, use DXT5	*/
+	return convert_image_to_DXT5( img, width, height, channels, DXT_mode_from_flags( flags ), out_size );
+}
+
+/*	returns 0 when there was no RAM for the MIPmaps, so level 0 is all there is	*/
+static int createMipmaps(const unsigned char *const img,
 		int width, int height, int channels,
 		unsigned int flags,
 		unsigned int opengl_texture_target,
@@ -1337,42 +1648,43 @@ static void createMipmaps(const unsigned char *const img,
 		unsigned int original_texture_format,
 		int DXT_mode)
 {
+	int created = 1;
+	soil_zone_begin( "SOIL2::Mipmaps" );
 	if ( ( flags & SOIL_FLAG_GL_MIPMAPS ) && query_gen_mipmap_capability() == SOIL_CAPABILITY_PRESENT )
 	{
 		soilGlGenerateMipmap(opengl_texture_target);
 	}
 	else
 	{
-		int MIPlevel = 1;
-		int MIPwidth = (width+1) / 2;
-		int MIPheight = (height+1) / 2;
-		unsigned char *resampled = (unsigned char*)malloc( channels*MIPwidth*MIPheight );
+		/*	every level at once, each one filtered from the one above	*/
+		int MIPlevel;
+		int MIPlevels = 0;
+		int MIPwidth = width;
+		int MIPheight = height;
+		int chain_size = mipmap_chain_size( width, height, channels );
+		unsigned char *chain = (chain_size > 0) ? (unsigned char*)malloc( chain_size ) : NULL;
+		unsigned char *resampled = chain;
+
+		if( NULL != chain )
+		{
+			MIPlevels = 1 + mipmap_chain( img, width, height, channels, chain );
+		} else
+		{
+			created = 0;
+		}
 
-		while( ((1<<MIPlevel) <= width) || ((1<<MIPlevel) <= height) )
+		for( MIPlevel = 1; MIPlevel < MIPlevels; ++MIPlevel )
 		{
-			/*	do this MIPmap level	*/
-			mipmap_image(
-					img, width, height, channels,
-					resampled,
-					(1 << MIPlevel), (1 << MIPlevel) );
+			MIPwidth = (MIPwidth > 1) ? MIPwidth / 2 : 1;
+			MIPheight = (MIPheight > 1) ? MIPheight / 2 : 1;
 
 			/*  upload the MIPmaps	*/
 			if( DXT_mode == SOIL_CAPABILITY_PRESENT )
 			{
 				/*	user wants me to do the DXT conversion!	*/
 				int DDS_size;
-				unsigned char *DDS_data = NULL;
-				if( (channels & 1) == 1 )
-				{
-					/*	RGB, use DXT1	*/
-					DDS_data = convert_image_to_DXT1(
-							resampled, MIPwidth, MIPheight, channels, &DDS_size );
-				} else
-				{
-					/*	RGBA, use DXT5	*/
-					DDS_data = convert_image_to_DXT5(
-							resampled, MIPwidth, MIPheight, channels, &DDS_size );
-				}
+				unsigned char *DDS_data = compress_image_to_format( internal_texture_format,
+						resampled, MIPwidth, MIPheight, channels, flags, &DDS_size );
 				if( DDS_data )
 				{
 					soilGlCompressedTexImage2D(
@@ -1399,14 +1711,14 @@ static void createMipmaps(const unsigned char *const img,
 					original_texture_format, GL_UNSIGNED_BYTE, resampled );
 				check_for_GL_errors( "glTexImage2D" );
 			}
-			/*	prep for the next level	*/
-			++MIPlevel;
-			MIPwidth = (MIPwidth + 1) / 2;
-			MIPheight = (MIPheight + 1) / 2;
+			/*	the next level follows this one	*/
+			resampled += channels*MIPwidth*MIPheight;
 		}
 
-		SOIL_free_image_data( resampled );
+		SOIL_free_image_data( chain );
 	}
+	soil_zone_end();
+	return created;
 }
 
 unsigned int
@@ -1426,6 +1738,7 @@ unsigned int
 	unsigned int tex_id;
 	unsigned int internal_texture_format = 0, original_texture_format = 0;
 	int DXT_mode = SOIL_CAPABILITY_UNKNOWN;
+	unsigned int compressed_format;
 	int sRGB_texture = query_sRGB_capability() == SOIL_CAPABILITY_PRESENT && ( flags & SOIL_FLAG_SRGB_COLOR_SPACE );;
 	int max_supported_size;
 	int iwidth = *width;
@@ -1433,6 +1746,8 @@ unsigned int
 	int needCopy;
 	GLint unpack_aligment;
 
+	soil_zone_begin( "SOIL2::CreateTexture" );
+
 	/*	how large of a texture can this OpenGL implementation handle?	*/
 	/*	texture_check_size_enum will be GL_MAX_TEXTURE_SIZE or SOIL_MAX_CUBE_MAP_TEXTURE_SIZE	*/
 	glGetIntegerv( texture_check_size_enum, &max_supported_size );
@@ -1464,6 +1779,7 @@ unsigned int
 		{
 			/*	can't do it, and that is a breakable offense (uv coords use pixels instead of [0,1]!)	*/
 			result_string_pointer = "Texture Rectangle extension unsupported";
+			soil_zone_end();
 			return 0;
 		}
 	}
@@ -1640,23 +1956,13 @@ unsigned int
 			break;
 		}
 		internal_texture_format = original_texture_format;
-		/*	does the user want me to, and can I, save as DXT?	*/
-		if( flags & SOIL_FLAG_COMPRESS_TO_DXT )
+		/*	does the user want me to, and can I, save as DXT, BC4/5 or BC7?	*/
+		compressed_format = compressed_format_from_flags( flags, channels, sRGB_texture );
+		if( 0 != compressed_format )
 		{
-			DXT_mode = query_DXT_capability();
-			if( DXT_mode == SOIL_CAPABILITY_PRESENT )
-			{
-				/*	I can use DXT, whether I compress it or OpenGL does	*/
-				if( (channels & 1) == 1 )
-				{
-					/*	1 or 3 channels = DXT1	*/
-					internal_texture_format = sRGB_texture ? SOIL_GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : SOIL_RGB_S3TC_DXT1;
-				} else
-				{
-					/*	2 or 4 channels = DXT5	*/
-					internal_texture_format = sRGB_texture ? SOIL_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : SOIL_RGBA_S3TC_DXT5;
-				}
-			}
+			/*	I can use it, whether I compress it or OpenGL does	*/
+			DXT_mode = SOIL_CAPABILITY_PRESENT;
+			internal_texture_format = compressed_format;
 		}
 		else if ( sRGB_texture )
 		{
@@ -1683,20 +1989,13 @@ unsigned int
 		}
 
 		/*  upload the main image	*/
+		soil_zone_begin( "SOIL2::Upload" );
 		if( DXT_mode == SOIL_CAPABILITY_PRESENT )
 		{
 			/*	user wants me to do the DXT conversion!	*/
 			int DDS_size;
-			unsigned char *DDS_data = NULL;
-			if( (channels & 1) == 1 )
-			{
-				/*	RGB, use DXT1	*/
-				DDS_data = convert_image_to_DXT1( NULL != img ? img : data, iwidth, iheight, channels, &DDS_size );
-			} else
-			{
-				/*	RGBA, use DXT5	*/
-				DDS_data = convert_image_to_DXT5( NULL != img ? img : data, iwidth, iheight, channels, &DDS_size );
-			}
+			unsigned char *DDS_data = compress_image_to_format( internal_texture_format,
+					NULL != img ? img : data, iwidth, iheight, channels, flags, &DDS_size );
 			if( DDS_data )
 			{
 				soilGlCompressedTexImage2D(
@@ -1727,15 +2026,16 @@ unsigned int
 			check_for_GL_errors( "glTexImage2D" );
 			/*printf( "OpenGL DXT compressor\n" );	*/
 		}
+		soil_zone_end();
 
 		/*	are any MIPmaps desired?	*/
 		if( flags & SOIL_FLAG_MIPMAPS || flags & SOIL_FLAG_GL_MIPMAPS )
 		{
-			createMipmaps( NULL != img ? img : data, iwidth, iheight, channels, flags, opengl_texture_target, internal_texture_format, original_texture_format, DXT_mode );
+			int have_mipmaps = createMipmaps( NULL != img ? img : data, iwidth, iheight, channels, flags, opengl_texture_target, internal_texture_format, original_texture_format, DXT_mode );
 
-			/*	instruct OpenGL to use the MIPmaps	*/
+			/*	instruct OpenGL to use the MIPmaps, if it got them	*/
 			glTexParameteri( opengl_texture_type, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-			glTexParameteri( opengl_texture_type, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+			glTexParameteri( opengl_texture_type, GL_TEXTURE_MIN_FILTER, have_mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR );
 			check_for_GL_errors( "GL_TEXTURE_MIN/MAG_FILTER" );
 		} else
 		{
@@ -1785,6 +2085,140 @@ unsigned int
 
 	SOIL_free_image_data( img );
 
+	soil_zone_end();
+	return tex_id;
+}
+
+/*	uploads an RGB float image as BC6H, with its MIPmaps, or returns 0
+	before touching OpenGL if the card can't take it at this size	*/
+static unsigned int
+	SOIL_internal_create_OGL_BC6H_texture
+	(
+		float *data,
+		int width, int height,
+		unsigned int reuse_texture_ID,
+		unsigned int flags
+	)
+{
+	unsigned int tex_id;
+	int max_supported_size;
+	int DDS_size;
+	unsigned char *DDS_data;
+	int MIPlevels = 1;
+	int is_POT = SOIL_IS_POW2( width ) && SOIL_IS_POW2( height );
+
+	/*	there is no float resampler, the fake HDR path resizes	*/
+	glGetIntegerv( GL_MAX_TEXTURE_SIZE, &max_supported_size );
+	if( (width > max_supported_size) || (height > max_supported_size) ||
+		(flags & SOIL_FLAG_TEXTURE_RECTANGLE) ||
+		(!is_POT && ((flags & SOIL_FLAG_POWER_OF_TWO) ||
+			(query_NPOT_capability() == SOIL_CAPABILITY_NONE))) )
+	{
+		return 0;
+	}
+	soil_zone_begin( "SOIL2::CreateBC6HTexture" );
+	/*	does the user want me to invert the image?	*/
+	if( flags & SOIL_FLAG_INVERT_Y )
+	{
+		int i, j;
+		for( j = 0; j*2 < height; ++j )
+		{
+			float *row1 = data + j*width*3;
+			float *row2 = data + (height - 1 - j)*width*3;
+			for( i = 0; i < width*3; ++i )
+			{
+				float temp = row1[i];
+				row1[i] = row2[i];
+				row2[i] = temp;
+			}
+		}
+	}
+	DDS_data = convert_image_to_BC6H( data, width, height, 3, 0,
+			DXT_mode_from_flags( flags ), &DDS_size );
+	if( NULL == DDS_data )
+	{
+		soil_zone_end();
+		return 0;
+	}
+	tex_id = reuse_texture_ID;
+	if( tex_id == 0 )
+	{
+		glGenTextures( 1, &tex_id );
+	}
+	check_for_GL_errors( "glGenTextures" );
+	if( 0 == tex_id )
+	{
+		SOIL_free_image_data( DDS_data );
+		soil_zone_end();
+		return 0;
+	}
+	glBindTexture( GL_TEXTURE_2D, tex_id );
+	check_for_GL_errors( "glBindTexture" );
+	soilGlCompressedTexImage2D(
+		GL_TEXTURE_2D, 0,
+		SOIL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, width, height, 0,
+		DDS_size, DDS_data );
+	check_for_GL_errors( "glCompressedTexImage2D" );
+	SOIL_free_image_data( DDS_data );
+
+	/*	the driver can't build MIPmaps of a compressed texture, so
+		filter the floats and compress every level	*/
+	if( flags & (SOIL_FLAG_MIPMAPS | SOIL_FLAG_GL_MIPMAPS) )
+	{
+		int chain_size = mipmap_chain_size( width, height, 3 );
+		float *chain = (chain_size > 0) ? (float*)malloc( chain_size*sizeof( float ) ) : NULL;
+		const float *resampled = chain;
+		int MIPlevel;
+		int MIPwidth = width;
+		int MIPheight = height;
+		if( NULL != chain )
+		{
+			MIPlevels = 1 + mipmap_chain_float( data, width, height, 3, chain );
+		}
+		for( MIPlevel = 1; MIPlevel < MIPlevels; ++MIPlevel )
+		{
+			MIPwidth = (MIPwidth > 1) ? MIPwidth / 2 : 1;
+			MIPheight = (MIPheight > 1) ? MIPheight / 2 : 1;
+			DDS_data = convert_image_to_BC6H( resampled, MIPwidth, MIPheight, 3, 0,
+					DXT_mode_from_flags( flags ), &DDS_size );
+			if( NULL == DDS_data )
+			{
+				/*	an incomplete chain, so don't sample it	*/
+				MIPlevels = 1;
+				break;
+			}
+			soilGlCompressedTexImage2D(
+				GL_TEXTURE_2D, MIPlevel,
+				SOIL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, MIPwidth, MIPheight, 0,
+				DDS_size, DDS_data );
+			check_for_GL_errors( "glCompressedTexImage2D" );
+			SOIL_free_image_data( DDS_data );
+			resampled += 3*MIPwidth*MIPheight;
+		}
+		free( chain );
+	}
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	if( MIPlevels > 1 )
+	{
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+	} else
+	{
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	}
+	check_for_GL_errors( "GL_TEXTURE_MIN/MAG_FILTER" );
+	/*	does the user want clamping, or wrapping?	*/
+	if( flags & SOIL_FLAG_TEXTURE_REPEATS )
+	{
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
+	} else
+	{
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, SOIL_CLAMP_TO_EDGE );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, SOIL_CLAMP_TO_EDGE );
+	}
+	check_for_GL_errors( "GL_TEXTURE_WRAP_*" );
+	result_string_pointer = "Image loaded as an OpenGL texture";
+	soil_zone_end();
 	return tex_id;
 }
 
@@ -1865,8 +2299,11 @@ unsigned char*
 		int force_channels
 	)
 {
-	unsigned char *result = stbi_load( filename,
+	unsigned char *result;
+	soil_zone_begin( "SOIL2::Decode" );
+	result = stbi_load( filename,
 			width, height, channels, force_channels );
+	soil_zone_end();
 	if( result == NULL )
 	{
 		result_string_pointer = stbi_failure_reason();
@@ -1886,10 +2323,13 @@ unsigned char*
 		int force_channels
 	)
 {
-	unsigned char *result = stbi_load_from_memory(
+	unsigned char *result;
+	soil_zone_begin( "SOIL2::Decode" );
+	result = stbi_load_from_memory(
 				buffer, buffer_length,
 				width, height, channels,
 				force_channels );
+	soil_zone_end();
 	if( result == NULL )
 	{
 		result_string_pointer = stbi_failure_reason();
@@ -1922,6 +2362,20 @@ int
 		const unsigned char *const data,
 		int quality
 	)
+{
+	return SOIL_save_image_flags( filename, image_type, width, height, channels, data, quality, 0 );
+}
+
+int
+	SOIL_save_image_flags
+	(
+		const char *filename,
+		int image_type,
+		int width, int height, int channels,
+		const unsigned char *const data,
+		int quality,
+		unsigned int flags
+	)
 {
 	int save_result;
 
@@ -1945,8 +2399,33 @@ int
 	} else
 	if( image_type == SOIL_SAVE_TYPE_DDS )
 	{
+		int format = DDS_FORMAT_DXT;
+		if( flags & SOIL_FLAG_COMPRESS_TO_BC7 )
+		{
+			format = DDS_FORMAT_BC7;
+		} else
+		if( flags & SOIL_FLAG_COMPRESS_TO_RGTC )
+		{
+			format = (1 == channels) ? DDS_FORMAT_BC4 : DDS_FORMAT_BC5;
+		}
 		save_result = save_image_as_DDS( filename,
-				width, height, channels, (const unsigned char *const)data );
+				width, height, channels, (const unsigned char *const)data,
+				format, DXT_mode_from_flags( flags ) );
+	} else
+	if( image_type == SOIL_SAVE_TYPE_PKM )
+	{
+		unsigned int format = ETC1_RGB8_OES;
+		if( flags & SOIL_FLAG_COMPRESS_TO_ETC2 )
+		{
+			format = ((channels & 1) == 1) ? ETC2_COMPRESSED_RGB8_ETC2 : ETC2_COMPRESSED_RGBA8_ETC2_EAC;
+		} else
+		if( flags & SOIL_FLAG_COMPRESS_TO_RGTC )
+		{
+			format = (1 == channels) ? ETC2_COMPRESSED_R11_EAC : ETC2_COMPRESSED_RG11_EAC;
+		}
+		save_result = save_image_as_PKM( filename,
+				width, height, channels, (const unsigned char *const)data,
+				format, (flags & SOIL_FLAG_DXT_FAST) ? ETC1_QUALITY_FAST : ETC1_QUALITY_THOROUGH );
 	} else
 	if( image_type == SOIL_SAVE_TYPE_PNG )
 	{
@@ -1972,6 +2451,46 @@ int
 	return save_result;
 }
 
+int
+	SOIL_save_HDR_image
+	(
+		const char *filename,
+		int image_type,
+		int width, int height, int channels,
+		const float *const data,
+		unsigned int flags
+	)
+{
+	int save_result;
+
+	/*	error check	*/
+	if( (width < 1) || (height < 1) ||
+		(channels < 1) || (channels > 4) ||
+		(data == NULL) ||
+		(filename == NULL) )
+	{
+		return 0;
+	}
+	if( image_type == SOIL_SAVE_TYPE_DDS )
+	{
+		save_result = save_image_as_DDS_BC6H( filename,
+				width, height, channels, data,
+				DXT_mode_from_flags( flags ) );
+	} else
+	{
+		save_result = 0;
+	}
+
+	if( save_result == 0 )
+	{
+		result_string_pointer = "Saving the image failed";
+	} else
+	{
+		result_string_pointer = "Image saved";
+	}
+	return save_result;
+}
+
 void
 	SOIL_free_image_data
 	(
@@ -1991,15 +2510,219 @@ const char*
 	return result_string_pointer;
 }
 
-unsigned int SOIL_direct_load_DDS_from_memory(
-		const unsigned char *const buffer,
-		int buffer_length,
-		unsigned int reuse_texture_ID,
-		int flags,
-		int loading_as_cubemap )
+#define SOIL_DDS_FOURCC( a, b, c, d ) ( ((a)<<0) | ((b)<<8) | ((c)<<16) | ((unsigned int)(d)<<24) )
+
+/*
+	The OpenGL format and block size of a compressed DDS, from its
+	FourCC or, for 'DX10', the DXGI format of the extended header.
+	Returns 0 for the formats I can't upload.
+*/
+static unsigned int DDS_compressed_format(
+		const DDS_header *header,
+		const DDS_header_DXT10 *header10,
+		int *block_size )
 {
-	/*	variables	*/
+	const unsigned int fourCC = header->sPixelFormat.dwFourCC;
+	unsigned int dxgi_format = 0;
+	*block_size = 16;
+	if( fourCC == SOIL_DDS_FOURCC( 'D', 'X', '1', '0' ) )
+	{
+		dxgi_format = header10->dxgiFormat;
+	}
+	if( (fourCC == SOIL_DDS_FOURCC( 'D', 'X', 'T', '1' )) || (dxgi_format == DXGI_FORMAT_BC1_UNORM) )
+	{
+		*block_size = 8;
+		return SOIL_RGBA_S3TC_DXT1;
+	}
+	if( dxgi_format == DXGI_FORMAT_BC1_UNORM_SRGB )
+	{
+		*block_size = 8;
+		return SOIL_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+	}
+	if( (fourCC == SOIL_DDS_FOURCC( 'D', 'X', 'T', '3' )) || (dxgi_format == DXGI_FORMAT_BC2_UNORM) )
+	{
+		return SOIL_RGBA_S3TC_DXT3;
+	}
+	if( dxgi_format == DXGI_FORMAT_BC2_UNORM_SRGB )
+	{
+		return SOIL_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;
+	}
+	if( (fourCC == SOIL_DDS_FOURCC( 'D', 'X', 'T', '5' )) || (dxgi_format == DXGI_FORMAT_BC3_UNORM) )
+	{
+		return SOIL_RGBA_S3TC_DXT5;
+	}
+	if( dxgi_format == DXGI_FORMAT_BC3_UNORM_SRGB )
+	{
+		return SOIL_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+	}
+	/*	the older writers name BC4 and BC5 ATI1 and ATI2	*/
+	if( (fourCC == SOIL_DDS_FOURCC( 'A', 'T', 'I', '1' )) ||
+		(fourCC == SOIL_DDS_FOURCC( 'B', 'C', '4', 'U' )) ||
+		(dxgi_format == DXGI_FORMAT_BC4_UNORM) )
+	{
+		*block_size = 8;
+		return SOIL_COMPRESSED_RED_RGTC1;
+	}
+	if( (fourCC == SOIL_DDS_FOURCC( 'B', 'C', '4', 'S' )) || (dxgi_format == DXGI_FORMAT_BC4_SNORM) )
+	{
+		*block_size = 8;
+		return SOIL_COMPRESSED_SIGNED_RED_RGTC1;
+	}
+	if( (fourCC == SOIL_DDS_FOURCC( 'A', 'T', 'I', '2' )) ||
+		(fourCC == SOIL_DDS_FOURCC( 'B', 'C', '5', 'U' )) ||
+		(dxgi_format == DXGI_FORMAT_BC5_UNORM) )
+	{
+		return SOIL_COMPRESSED_RG_RGTC2;
+	}
+	if( (fourCC == SOIL_DDS_FOURCC( 'B', 'C', '5', 'S' )) || (dxgi_format == DXGI_FORMAT_BC5_SNORM) )
+	{
+		return SOIL_COMPRESSED_SIGNED_RG_RGTC2;
+	}
+	if( dxgi_format == DXGI_FORMAT_BC7_UNORM )
+	{
+		return SOIL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+	if( dxgi_format == DXGI_FORMAT_BC7_UNORM_SRGB )
+	{
+		return SOIL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+	}
+	if( dxgi_format == DXGI_FORMAT_BC6H_UF16 )
+	{
+		return SOIL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+	}
+	if( dxgi_format == DXGI_FORMAT_BC6H_SF16 )
+	{
+		return SOIL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;
+	}
+	return 0;
+}
+
+/*	whether the card can display the compressed format	*/
+static int query_compressed_format_capability( unsigned int format )
+{
+	switch( format )
+	{
+	case SOIL_COMPRESSED_RED_RGTC1:
+	case SOIL_COMPRESSED_SIGNED_RED_RGTC1:
+	case SOIL_COMPRESSED_RG_RGTC2:
+	case SOIL_COMPRESSED_SIGNED_RG_RGTC2:
+		return query_RGTC_capability();
+	case SOIL_COMPRESSED_RGBA_BPTC_UNORM:
+	case SOIL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+	case SOIL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+	case SOIL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+		return query_BPTC_capability();
+	case SOIL_RGB_S3TC_DXT1:
+	case SOIL_RGBA_S3TC_DXT1:
+	case SOIL_RGBA_S3TC_DXT3:
+	case SOIL_RGBA_S3TC_DXT5:
+	case SOIL_GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+	case SOIL_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+	case SOIL_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+	case SOIL_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+		return query_DXT_capability();
+	case SOIL_GL_ETC1_RGB8_OES:
+		return query_ETC1_capability();
+	case SOIL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG:
+	case SOIL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG:
+	case SOIL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG:
+	case SOIL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG:
+		return query_PVR_capability();
+	}
+	if( 0 != etc2_block_size( format ) )
+	{
+		return query_ETC2_capability();
+	}
+	if( ((format >= SOIL_COMPRESSED_RGBA_ASTC_4x4) && (format <= SOIL_COMPRESSED_RGBA_ASTC_12x12)) ||
+		((format >= SOIL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4) && (format <= SOIL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x12)) )
+	{
+		return query_ASTC_capability();
+	}
+	return SOIL_CAPABILITY_NONE;
+}
+
+/*	the OpenGL internal format, format and type of a KTX2 vkFormat,
+	format and type are 0 for the compressed ones.
+	\return 0 if SOIL can't upload the format	*/
+static int KTX2_GL_format( unsigned int vk_format,
+		unsigned int *internal_format, unsigned int *format, unsigned int *type )
+{
+	/*	vkFormat, internal format, format, type	*/
+	static const unsigned int table[][4] =
+	{
+		{ KTX2_VK_FORMAT_R8_UNORM, SOIL_GL_R8, SOIL_GL_RED, GL_UNSIGNED_BYTE },
+		{ KTX2_VK_FORMAT_R8G8_UNORM, SOIL_GL_RG8, SOIL_GL_RG, GL_UNSIGNED_BYTE },
+		{ KTX2_VK_FORMAT_R8G8B8_UNORM, SOIL_GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE },
+		{ KTX2_VK_FORMAT_R8G8B8_SRGB, SOIL_GL_SRGB8, GL_RGB, GL_UNSIGNED_BYTE },
+		{ KTX2_VK_FORMAT_R8G8B8A8_UNORM, SOIL_GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE },
+		{ KTX2_VK_FORMAT_R8G8B8A8_SRGB, SOIL_GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE },
+		{ KTX2_VK_FORMAT_R16_SFLOAT, SOIL_GL_R16F, SOIL_GL_RED, SOIL_GL_HALF_FLOAT },
+		{ KTX2_VK_FORMAT_R16G16_SFLOAT, SOIL_GL_RG16F, SOIL_GL_RG, SOIL_GL_HALF_FLOAT },
+		{ KTX2_VK_FORMAT_R16G16B16_SFLOAT, SOIL_GL_RGB16F, GL_RGB, SOIL_GL_HALF_FLOAT },
+		{ KTX2_VK_FORMAT_R16G16B16A16_SFLOAT, SOIL_GL_RGBA16F, GL_RGBA, SOIL_GL_HALF_FLOAT },
+		{ KTX2_VK_FORMAT_R32_SFLOAT, SOIL_GL_R32F, SOIL_GL_RED, GL_FLOAT },
+		{ KTX2_VK_FORMAT_R32G32_SFLOAT, SOIL_GL_RG32F, SOIL_GL_RG, GL_FLOAT },
+		{ KTX2_VK_FORMAT_R32G32B32_SFLOAT, SOIL_GL_RGB32F, GL_RGB, GL_FLOAT },
+		{ KTX2_VK_FORMAT_R32G32B32A32_SFLOAT, SOIL_GL_RGBA32F, GL_RGBA, GL_FLOAT },
+		{ KTX2_VK_FORMAT_BC1_RGB_UNORM_BLOCK, SOIL_RGB_S3TC_DXT1, 0, 0 },
+		{ KTX2_VK_FORMAT_BC1_RGB_SRGB_BLOCK, SOIL_GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, 0, 0 },
+		{ KTX2_VK_FORMAT_BC1_RGBA_UNORM_BLOCK, SOIL_RGBA_S3TC_DXT1, 0, 0 },
+		{ KTX2_VK_FORMAT_BC1_RGBA_SRGB_BLOCK, SOIL_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, 0, 0 },
+		{ KTX2_VK_FORMAT_BC2_UNORM_BLOCK, SOIL_RGBA_S3TC_DXT3, 0, 0 },
+		{ KTX2_VK_FORMAT_BC2_SRGB_BLOCK, SOIL_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT, 0, 0 },
+		{ KTX2_VK_FORMAT_BC3_UNORM_BLOCK, SOIL_RGBA_S3TC_DXT5, 0, 0 },
+		{ KTX2_VK_FORMAT_BC3_SRGB_BLOCK, SOIL_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 0, 0 },
+		{ KTX2_VK_FORMAT_BC4_UNORM_BLOCK, SOIL_COMPRESSED_RED_RGTC1, 0, 0 },
+		{ KTX2_VK_FORMAT_BC4_SNORM_BLOCK, SOIL_COMPRESSED_SIGNED_RED_RGTC1, 0, 0 },
+		{ KTX2_VK_FORMAT_BC5_UNORM_BLOCK, SOIL_COMPRESSED_RG_RGTC2, 0, 0 },
+		{ KTX2_VK_FORMAT_BC5_SNORM_BLOCK, SOIL_COMPRESSED_SIGNED_RG_RGTC2, 0, 0 },
+		{ KTX2_VK_FORMAT_BC6H_UFLOAT_BLOCK, SOIL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, 0, 0 },
+		{ KTX2_VK_FORMAT_BC6H_SFLOAT_BLOCK, SOIL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT, 0, 0 },
+		{ KTX2_VK_FORMAT_BC7_UNORM_BLOCK, SOIL_COMPRESSED_RGBA_BPTC_UNORM, 0, 0 },
+		{ KTX2_VK_FORMAT_BC7_SRGB_BLOCK, SOIL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, 0, 0 },
+		{ KTX2_VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, ETC2_COMPRESSED_RGB8_ETC2, 0, 0 },
+		{ KTX2_VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK, ETC2_COMPRESSED_SRGB8_ETC2, 0, 0 },
+		{ KTX2_VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, ETC2_COMPRESSED_RGBA8_ETC2_EAC, 0, 0 },
+		{ KTX2_VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK, ETC2_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC, 0, 0 },
+		{ KTX2_VK_FORMAT_EAC_R11_UNORM_BLOCK, ETC2_COMPRESSED_R11_EAC, 0, 0 },
+		{ KTX2_VK_FORMAT_EAC_R11_SNORM_BLOCK, ETC2_COMPRESSED_SIGNED_R11_EAC, 0, 0 },
+		{ KTX2_VK_FORMAT_EAC_R11G11_UNORM_BLOCK, ETC2_COMPRESSED_RG11_EAC, 0, 0 },
+		{ KTX2_VK_FORMAT_EAC_R11G11_SNORM_BLOCK, ETC2_COMPRESSED_SIGNED_RG11_EAC, 0, 0 }
+	};
+	unsigned int i;
+	*format = 0;
+	*type = 0;
+	if( (vk_format >= KTX2_VK_FORMAT_ASTC_4x4_UNORM_BLOCK) && (vk_format <= KTX2_VK_FORMAT_ASTC_12x12_SRGB_BLOCK) )
+	{
+		/*	the block sizes are in the same order in Vulkan and OpenGL,
+			and Vulkan alternates UNORM and SRGB	*/
+		unsigned int k = vk_format - KTX2_VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
+		*internal_format = ((k & 1) ? SOIL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4 : SOIL_COMPRESSED_RGBA_ASTC_4x4) + (k >> 1);
+		return 1;
+	}
+	for( i = 0; i < sizeof( table ) / sizeof( table[0] ); ++i )
+	{
+		if( table[i][0] == vk_format )
+		{
+			*internal_format = table[i][1];
+			*format = table[i][2];
+			*type = table[i][3];
+			return 1;
+		}
+	}
+	return 0;
+}
+
+unsigned int SOIL_direct_load_DDS_from_memory(
+		const unsigned char *const buffer,
+		int buffer_length,
+		unsigned int reuse_texture_ID,
+		int flags,
+		int loading_as_cubemap )
+{
+	/*	variables	*/
 	DDS_header header;
+	DDS_header_DXT10 header10;
 	unsigned int buffer_index = 0;
 	unsigned int tex_ID = 0;
 	/*	file reading variables	*/
@@ -2028,6 +2751,7 @@ unsigned int SOIL_direct_load_DDS_from_memory(
 	}
 	/*	try reading in the header	*/
 	memcpy ( (void*)(&header), (const void *)buffer, sizeof( DDS_header ) );
+	memset( (void*)(&header10), 0, sizeof( DDS_header_DXT10 ) );
 	buffer_index = sizeof( DDS_header );
 	/*	guilty until proven innocent	*/
 	result_string_pointer = "Failed to read a known DDS header";
@@ -2048,14 +2772,23 @@ unsigned int SOIL_direct_load_DDS_from_memory(
 	if( header.sPixelFormat.dwSize != 32 ) {goto quick_exit;}
 	if( (header.sCaps.dwCaps1 & DDSCAPS_TEXTURE) == 0 ) {goto quick_exit;}
 	/*	make sure it is a type we can upload	*/
-	if( (header.sPixelFormat.dwFlags & DDPF_FOURCC) &&
-		!(
-		(header.sPixelFormat.dwFourCC == (('D'<<0)|('X'<<8)|('T'<<16)|('1'<<24))) ||
-		(header.sPixelFormat.dwFourCC == (('D'<<0)|('X'<<8)|('T'<<16)|('3'<<24))) ||
-		(header.sPixelFormat.dwFourCC == (('D'<<0)|('X'<<8)|('T'<<16)|('5'<<24)))
-		) )
+	if( header.sPixelFormat.dwFlags & DDPF_FOURCC )
 	{
-		goto quick_exit;
+		if( header.sPixelFormat.dwFourCC == SOIL_DDS_FOURCC( 'D', 'X', '1', '0' ) )
+		{
+			/*	the extended header follows, for a single 2D texture or cubemap	*/
+			if( buffer_length < (int)(sizeof( DDS_header ) + sizeof( DDS_header_DXT10 )) ) {goto quick_exit;}
+			memcpy( (void*)(&header10), (const void *)(&buffer[buffer_index]), sizeof( DDS_header_DXT10 ) );
+			buffer_index += sizeof( DDS_header_DXT10 );
+			if( header10.resourceDimension != DDS_DIMENSION_TEXTURE2D ) {goto quick_exit;}
+			if( header10.arraySize > 1 ) {goto quick_exit;}
+			if( header10.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE )
+			{
+				header.sCaps.dwCaps2 |= DDSCAPS2_CUBEMAP;
+			}
+		}
+		S3TC_type = DDS_compressed_format( &header, &header10, &block_size );
+		if( 0 == S3TC_type ) {goto quick_exit;}
 	}
 	/*	OK, validated the header, let's load the image data	*/
 	result_string_pointer = "DDS header loaded and validated";
@@ -2075,29 +2808,14 @@ unsigned int SOIL_direct_load_DDS_from_memory(
 		DDS_main_size = width * height * block_size;
 	} else
 	{
-		/*	can we even handle direct uploading to OpenGL DXT compressed images?	*/
-		if( query_DXT_capability() != SOIL_CAPABILITY_PRESENT )
+		/*	can we even handle direct uploading of this compressed format to OpenGL?
+			(the format and block size were found when checking the header)	*/
+		if( query_compressed_format_capability( S3TC_type ) != SOIL_CAPABILITY_PRESENT )
 		{
 			/*	we can't do it!	*/
-			result_string_pointer = "Direct upload of S3TC images not supported by the OpenGL driver";
+			result_string_pointer = "Direct upload of the DDS compressed format not supported by the OpenGL driver";
 			return 0;
 		}
-		/*	well, we know it is DXT1/3/5, because we checked above	*/
-		switch( (header.sPixelFormat.dwFourCC >> 24) - '0' )
-		{
-		case 1:
-			S3TC_type = SOIL_RGBA_S3TC_DXT1;
-			block_size = 8;
-			break;
-		case 3:
-			S3TC_type = SOIL_RGBA_S3TC_DXT3;
-			block_size = 16;
-			break;
-		case 5:
-			S3TC_type = SOIL_RGBA_S3TC_DXT5;
-			block_size = 16;
-			break;
-		}
 		DDS_main_size = ((width+3)>>2)*((height+3)>>2)*block_size;
 	}
 	if( cubemap )
@@ -2134,7 +2852,13 @@ unsigned int SOIL_direct_load_DDS_from_memory(
 	}
 	if( (header.sCaps.dwCaps1 & DDSCAPS_MIPMAP) && (header.dwMipMapCount > 1) )
 	{
-		mipmaps = header.dwMipMapCount - 1;
+		/*	no more levels than it takes to get down to 1x1	*/
+		unsigned int full_chain = 1;
+		while( ((width | height) >> full_chain) > 0 )
+		{
+			++full_chain;
+		}
+		mipmaps = ((header.dwMipMapCount < full_chain) ? header.dwMipMapCount : full_chain) - 1;
 		DDS_full_size = DDS_main_size;
 		for( i = 1; i <= mipmaps; ++ i )
 		{
@@ -2658,23 +3382,45 @@ unsigned int SOIL_direct_load_ETC1_from_memory(
 	unsigned int opengl_texture_type = GL_TEXTURE_2D;
 	unsigned int width;
 	unsigned int height;
-	unsigned long compressed_image_size = buffer_length - PKM_HEADER_SIZE;
+	unsigned long compressed_image_size;
 	char *texture_ptr = (char*)buffer + PKM_HEADER_SIZE;
+	unsigned int format;
 	GLint unpack_aligment;
 
-	if ( query_ETC1_capability() != SOIL_CAPABILITY_PRESENT ) {
-		result_string_pointer = "error: ETC1 not supported. Decompress the texture first.";
+	if ( ( NULL == buffer ) || ( buffer_length < PKM_HEADER_SIZE ) ) {
+		result_string_pointer = "error: PKM header not found.";
 		return 0;
 	}
 
-	if ( 0 != strcmp( header->aName, "PKM 10" ) ) {
-		result_string_pointer = "error: PKM 10 header not found.";
+	/*	PKM 10 is ETC1, PKM 20 any of ETC2 and EAC	*/
+	format = etc2_pkm_get_format( buffer );
+	if ( 0 == format ) {
+		result_string_pointer = "error: PKM 10 or PKM 20 header not found.";
+		return 0;
+	}
+
+	if ( format == SOIL_GL_ETC1_RGB8_OES ) {
+		/*	ETC1 blocks are valid ETC2 RGB8 ones	*/
+		if ( query_ETC1_capability() != SOIL_CAPABILITY_PRESENT ) {
+			if ( query_ETC2_capability() != SOIL_CAPABILITY_PRESENT ) {
+				result_string_pointer = "error: ETC1 not supported. Decompress the texture first.";
+				return 0;
+			}
+			format = ETC2_COMPRESSED_RGB8_ETC2;
+		}
+	} else if ( query_ETC2_capability() != SOIL_CAPABILITY_PRESENT ) {
+		result_string_pointer = "error: ETC2 not supported. Decompress the texture first.";
 		return 0;
 	}
 
 	width = (header->iWidthMSB << 8) | header->iWidthLSB;
 	height = (header->iHeightMSB << 8) | header->iHeightLSB;
-	compressed_image_size = (((width + 3) & ~3) * ((height + 3) & ~3)) >> 1;
+	compressed_image_size = etc2_get_encoded_data_size( format, width, height );
+
+	if ( compressed_image_size > (unsigned long)( buffer_length - PKM_HEADER_SIZE ) ) {
+		result_string_pointer = "error: PKM file is truncated.";
+		return 0;
+	}
 
 	// load the texture up
 	tex_ID = reuse_texture_ID;
@@ -2696,7 +3442,7 @@ unsigned int SOIL_direct_load_ETC1_from_memory(
 		glPixelStorei(GL_UNPACK_ALIGNMENT,1);				// Never have row-aligned in headers
 	}
 
-	soilGlCompressedTexImage2D( opengl_texture_type, 0, SOIL_GL_ETC1_RGB8_OES, width, height, 0, compressed_image_size, texture_ptr );
+	soilGlCompressedTexImage2D( opengl_texture_type, 0, format, width, height, 0, compressed_image_size, texture_ptr );
 
 	if( glGetError() ) {
 		result_string_pointer = "failed: glCompressedTexImage2D() failed.";
@@ -2715,7 +3461,7 @@ unsigned int SOIL_direct_load_ETC1_from_memory(
 
 	if( tex_ID )
 	{
-		/* No MIPmaps for ETC1 */
+		/* No MIPmaps in PKM files */
 		glTexParameteri( opengl_texture_type, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
 		glTexParameteri( opengl_texture_type, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
 
@@ -2784,6 +3530,654 @@ unsigned int SOIL_direct_load_ETC1(const char *filename,
 	return tex_ID;
 }
 
+/*	bytes per pixel of uncompressed KTX data, 0 for a format or type
+	this loader doesn't know and so can't check the level sizes of	*/
+static unsigned int KTX_pixel_size( unsigned int format, unsigned int type )
+{
+	unsigned int components;
+	/*	the packed types hold a whole pixel	*/
+	switch( type )
+	{
+	case SOIL_GL_UNSIGNED_SHORT_4_4_4_4:
+	case SOIL_GL_UNSIGNED_SHORT_5_5_5_1:
+	case SOIL_GL_UNSIGNED_SHORT_5_6_5:
+	case SOIL_GL_UNSIGNED_SHORT_5_6_5_REV:
+	case SOIL_GL_UNSIGNED_SHORT_4_4_4_4_REV:
+	case SOIL_GL_UNSIGNED_SHORT_1_5_5_5_REV:
+		return 2;
+	case SOIL_GL_UNSIGNED_INT_8_8_8_8:
+	case SOIL_GL_UNSIGNED_INT_8_8_8_8_REV:
+	case SOIL_GL_UNSIGNED_INT_2_10_10_10_REV:
+	case SOIL_GL_UNSIGNED_INT_10F_11F_11F_REV:
+	case SOIL_GL_UNSIGNED_INT_5_9_9_9_REV:
+		return 4;
+	}
+	switch( format )
+	{
+	case SOIL_GL_RED:
+	case SOIL_GL_RED_INTEGER:
+	case GL_ALPHA:
+	case GL_LUMINANCE:
+		components = 1;
+		break;
+	case SOIL_GL_RG:
+	case SOIL_GL_RG_INTEGER:
+	case GL_LUMINANCE_ALPHA:
+		components = 2;
+		break;
+	case GL_RGB:
+	case SOIL_GL_BGR:
+	case SOIL_GL_RGB_INTEGER:
+		components = 3;
+		break;
+	case GL_RGBA:
+	case GL_BGRA:
+	case SOIL_GL_RGBA_INTEGER:
+		components = 4;
+		break;
+	default:
+		return 0;
+	}
+	switch( type )
+	{
+	case GL_UNSIGNED_BYTE:
+	case GL_BYTE:
+		return components;
+	case GL_UNSIGNED_SHORT:
+	case GL_SHORT:
+	case SOIL_GL_HALF_FLOAT:
+		return components * 2;
+	case GL_UNSIGNED_INT:
+	case GL_INT:
+	case GL_FLOAT:
+		return components * 4;
+	}
+	return 0;
+}
+
+/*	the 8 bit format an ETC2 or EAC image is uploaded as when it is
+	decoded on the CPU, sRGB stays sRGB and signed EAC stays signed	*/
+static void KTX_ETC2_decoded_format( unsigned int etc2_format,
+		unsigned int *internal_format, unsigned int *format, unsigned int *pixel_type )
+{
+	const int is_signed = (ETC2_COMPRESSED_SIGNED_R11_EAC == etc2_format) ||
+			(ETC2_COMPRESSED_SIGNED_RG11_EAC == etc2_format);
+	*pixel_type = is_signed ? GL_BYTE : GL_UNSIGNED_BYTE;
+	switch( etc2_decoded_channels( etc2_format ) )
+	{
+	case 1:
+		*internal_format = is_signed ? SOIL_GL_R8_SNORM : SOIL_GL_R8;
+		*format = SOIL_GL_RED;
+		break;
+	case 2:
+		*internal_format = is_signed ? SOIL_GL_RG8_SNORM : SOIL_GL_RG8;
+		*format = SOIL_GL_RG;
+		break;
+	case 3:
+		*internal_format = (ETC2_COMPRESSED_SRGB8_ETC2 == etc2_format) ? SOIL_GL_SRGB8 : SOIL_GL_RGB8;
+		*format = GL_RGB;
+		break;
+	default:
+		*internal_format = (ETC2_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC == etc2_format) ? SOIL_GL_SRGB8_ALPHA8 : SOIL_GL_RGBA8;
+		*format = GL_RGBA;
+		break;
+	}
+}
+
+/*	whether KTX2 level data with this supercompression can be loaded	*/
+static int KTX2_supercompression_supported( unsigned int scheme )
+{
+	switch( scheme )
+	{
+	case KTX2_SUPERCOMPRESSION_NONE:
+#ifdef SOIL_KTX2_ZSTD
+	case KTX2_SUPERCOMPRESSION_ZSTD:
+#endif
+#ifndef STBI_NO_ZLIB
+	case KTX2_SUPERCOMPRESSION_ZLIB:
+#endif
+		return 1;
+	}
+	return 0;
+}
+
+/*	decompresses a supercompressed KTX2 mip level, all of it or nothing	*/
+static int KTX2_inflate_level( unsigned int scheme,
+		const unsigned char *in, unsigned int in_size,
+		unsigned char *out, unsigned int out_size )
+{
+	switch( scheme )
+	{
+#ifdef SOIL_KTX2_ZSTD
+	case KTX2_SUPERCOMPRESSION_ZSTD:
+		{
+			size_t result = ZSTD_decompress( out, out_size, in, in_size );
+			return !ZSTD_isError( result ) && (result == out_size);
+		}
+#endif
+#ifndef STBI_NO_ZLIB
+	case KTX2_SUPERCOMPRESSION_ZLIB:
+		return stbi_zlib_decode_buffer( (char*)out, (int)out_size, (const char*)in, (int)in_size ) == (int)out_size;
+#endif
+	}
+	return 0;
+}
+
+unsigned int SOIL_direct_load_KTX_from_memory(
+		const unsigned char *const buffer,
+		int buffer_length,
+		unsigned int reuse_texture_ID,
+		int flags,
+		int loading_as_cubemap )
+{
+	/*	variables	*/
+	KTX_Header header;
+	KTX2_Header header2;
+	KTX2_Level_Index level_index;
+	int is_KTX2, swap_bytes = 0;
+	unsigned int internal_format, format, pixel_type, pixel_size = 0;
+	unsigned int width, height, depth, layers, faces, levels;
+	int generate_mipmaps = 0;
+	unsigned int supercompression = KTX2_SUPERCOMPRESSION_NONE;
+	unsigned int buffer_index, level, face, i;
+	unsigned int opengl_texture_type;
+	unsigned char *inflated = NULL;
+	unsigned int inflated_size = 0;
+	unsigned int etc2_format = 0;
+	unsigned char *decoded = NULL;
+	size_t decoded_size = 0;
+	int decode_failed = 0;
+	unsigned int uploaded_levels;
+	GLuint tex_ID = 0;
+	GLint unpack_aligment = 1, file_alignment;
+	/*	1st off, does the buffer even exist?	*/
+	if( NULL == buffer )
+	{
+		result_string_pointer = "NULL buffer";
+		return 0;
+	}
+	if( buffer_length < (int)sizeof( KTX_Header ) )
+	{
+		result_string_pointer = "KTX file was too small to contain the KTX header";
+		return 0;
+	}
+	if( 0 == memcmp( buffer, KTX1_identifier, KTX_IDENTIFIER_SIZE ) )
+	{
+		/*	KTX 1.1: OpenGL formats, rows padded to 4 bytes	*/
+		unsigned int *field = &header.endianness;
+		is_KTX2 = 0;
+		memcpy( (void*)(&header), (const void*)buffer, sizeof( KTX_Header ) );
+		if( header.endianness == KTX_ENDIAN_REF_REV )
+		{
+			/*	written on a machine of the other endianness	*/
+			swap_bytes = 1;
+			for( i = 0; i < (sizeof( KTX_Header ) - KTX_IDENTIFIER_SIZE) / 4; ++i )
+			{
+				field[i] = (field[i] >> 24) | ((field[i] >> 8) & 0xFF00) |
+						((field[i] & 0xFF00) << 8) | (field[i] << 24);
+			}
+			if( (0 != header.glType) && (header.glTypeSize > 1) )
+			{
+				result_string_pointer = "KTX file pixels need their bytes swapped";
+				return 0;
+			}
+		} else if( header.endianness != KTX_ENDIAN_REF )
+		{
+			result_string_pointer = "Failed to read a known KTX header";
+			return 0;
+		}
+		internal_format = header.glInternalFormat;
+		format = header.glFormat;
+		pixel_type = header.glType;
+		if( (0 == format) != (0 == pixel_type) )
+		{
+			result_string_pointer = "Failed to read a known KTX header";
+			return 0;
+		}
+		width = header.pixelWidth;
+		height = header.pixelHeight;
+		depth = header.pixelDepth;
+		layers = header.numberOfArrayElements;
+		faces = header.numberOfFaces;
+		levels = header.numberOfMipmapLevels;
+		if( header.bytesOfKeyValueData > (unsigned int)buffer_length - sizeof( KTX_Header ) )
+		{
+			result_string_pointer = "KTX file was too small for expected image data";
+			return 0;
+		}
+		/*	the mip levels follow the key/value data	*/
+		buffer_index = sizeof( KTX_Header ) + header.bytesOfKeyValueData;
+		file_alignment = 4;
+	} else if( 0 == memcmp( buffer, KTX2_identifier, KTX_IDENTIFIER_SIZE ) )
+	{
+		/*	KTX 2.0: Vulkan formats, tightly packed	*/
+		is_KTX2 = 1;
+		if( buffer_length < (int)sizeof( KTX2_Header ) )
+		{
+			result_string_pointer = "KTX file was too small to contain the KTX header";
+			return 0;
+		}
+		memcpy( (void*)(&header2), (const void*)buffer, sizeof( KTX2_Header ) );
+		if( !KTX2_GL_format( header2.vkFormat, &internal_format, &format, &pixel_type ) )
+		{
+			/*	Basis Universal files have no vkFormat, they must be transcoded	*/
+			result_string_pointer = "KTX2 format not supported";
+			return 0;
+		}
+		supercompression = header2.supercompressionScheme;
+		if( !KTX2_supercompression_supported( supercompression ) )
+		{
+			result_string_pointer = "KTX2 supercompression scheme not supported";
+			return 0;
+		}
+		width = header2.pixelWidth;
+		height = header2.pixelHeight;
+		depth = header2.pixelDepth;
+		layers = header2.layerCount;
+		faces = header2.faceCount;
+		levels = header2.levelCount;
+		/*	the level index follows the header	*/
+		buffer_index = sizeof( KTX2_Header );
+		if( (levels > 32) ||
+			((levels > 0 ? levels : 1) * sizeof( KTX2_Level_Index ) > (unsigned int)buffer_length - buffer_index) )
+		{
+			result_string_pointer = "KTX file was too small to contain the level index";
+			return 0;
+		}
+		file_alignment = 1;
+	} else
+	{
+		result_string_pointer = "Failed to read a known KTX header";
+		return 0;
+	}
+	/*	2D textures, cubemaps and arrays of either	*/
+	if( (0 == width) || (0 == height) || (0 != depth) )
+	{
+		result_string_pointer = "KTX 1D and 3D textures are not supported";
+		return 0;
+	}
+	if( ((1 != faces) && (6 != faces)) || (levels > 32) )
+	{
+		result_string_pointer = "Failed to read a known KTX header";
+		return 0;
+	}
+	if( 0 == levels )
+	{
+		/*	the file asks for the MIPmaps to be generated	*/
+		levels = 1;
+		generate_mipmaps = 1;
+	}
+	/*	uncompressed levels are checked against their size before they are uploaded	*/
+	if( 0 != format )
+	{
+		pixel_size = KTX_pixel_size( format, pixel_type );
+		if( 0 == pixel_size )
+		{
+			result_string_pointer = "KTX uncompressed format not supported";
+			return 0;
+		}
+	}
+	/*	can we even handle direct uploading of this compressed format to OpenGL?	*/
+	if( (0 == format) && (query_compressed_format_capability( internal_format ) != SOIL_CAPABILITY_PRESENT) )
+	{
+		if( 0 == etc2_block_size( internal_format ) )
+		{
+			result_string_pointer = "Direct upload of the KTX compressed format not supported by the OpenGL driver";
+			return 0;
+		}
+		/*	ETC2 and EAC are decoded on the CPU instead, into tightly packed 8 bit pixels	*/
+		etc2_format = internal_format;
+		KTX_ETC2_decoded_format( etc2_format, &internal_format, &format, &pixel_type );
+		file_alignment = 1;
+	}
+	if( 6 == faces )
+	{
+		/* does the user want a cubemap?	*/
+		if( !loading_as_cubemap )
+		{
+			result_string_pointer = "KTX image was a cubemap";
+			return 0;
+		}
+		/*	can we even handle cubemaps with the OpenGL driver?	*/
+		if( query_cubemap_capability() != SOIL_CAPABILITY_PRESENT )
+		{
+			result_string_pointer = "Direct upload of cubemap images not supported by the OpenGL driver";
+			return 0;
+		}
+		opengl_texture_type = (layers > 0) ? SOIL_TEXTURE_CUBE_MAP_ARRAY : SOIL_TEXTURE_CUBE_MAP;
+	} else
+	{
+		/* does the user want a non-cubemap?	*/
+		if( loading_as_cubemap )
+		{
+			result_string_pointer = "KTX image was not a cubemap";
+			return 0;
+		}
+		opengl_texture_type = (layers > 0) ? SOIL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+	}
+	if( layers > 0 )
+	{
+		/*	arrays upload every layer of a level at once	*/
+		if( NULL == soilGlCompressedTexImage3D )
+		{
+			soilGlCompressedTexImage3D = (P_SOIL_GLCOMPRESSEDTEXIMAGE3DPROC)SOIL_GL_GetProcAddress( "glCompressedTexImage3D" );
+		}
+		if( NULL == soilGlTexImage3D )
+		{
+			soilGlTexImage3D = (P_SOIL_GLTEXIMAGE3DPROC)SOIL_GL_GetProcAddress( "glTexImage3D" );
+		}
+		if( (NULL == soilGlCompressedTexImage3D) || (NULL == soilGlTexImage3D) )
+		{
+			result_string_pointer = "Direct upload of array textures not supported by the OpenGL driver";
+			return 0;
+		}
+	}
+	/*	OK, validated the header, create or use an existing OpenGL texture handle	*/
+	tex_ID = reuse_texture_ID;
+	if( tex_ID == 0 )
+	{
+		glGenTextures( 1, &tex_ID );
+	}
+	glBindTexture( opengl_texture_type, tex_ID );
+	glGetIntegerv( GL_UNPACK_ALIGNMENT, &unpack_aligment );
+	if( file_alignment != unpack_aligment )
+	{
+		glPixelStorei( GL_UNPACK_ALIGNMENT, file_alignment );
+	}
+	result_string_pointer = "KTX file loaded";
+	soil_zone_begin( "SOIL2::KTXUpload" );
+	for( level = 0; level < levels; ++level )
+	{
+		const unsigned char *level_data;
+		unsigned int level_size, face_size, face_stride, image_bytes;
+		unsigned int w = (width >> level) > 0 ? (width >> level) : 1;
+		unsigned int h = (height >> level) > 0 ? (height >> level) : 1;
+		if( is_KTX2 )
+		{
+			memcpy( (void*)(&level_index),
+					(const void*)(&buffer[sizeof( KTX2_Header ) + level * sizeof( KTX2_Level_Index )]),
+					sizeof( KTX2_Level_Index ) );
+			if( (0 != level_index.byteOffset[1]) || (0 != level_index.byteLength[1]) ||
+				(0 != level_index.uncompressedByteLength[1]) ||
+				(level_index.byteOffset[0] > (unsigned int)buffer_length) ||
+				(level_index.byteLength[0] > (unsigned int)buffer_length - level_index.byteOffset[0]) )
+			{
+				result_string_pointer = "KTX file was too small for expected image data";
+				break;
+			}
+			level_data = &buffer[level_index.byteOffset[0]];
+			level_size = level_index.byteLength[0];
+			if( supercompression != KTX2_SUPERCOMPRESSION_NONE )
+			{
+				/*	one buffer for every level, the first is the biggest	*/
+				level_size = level_index.uncompressedByteLength[0];
+				if( inflated_size < level_size )
+				{
+					SOIL_free_image_data( inflated );
+					inflated = (unsigned char*)malloc( level_size );
+					inflated_size = (NULL != inflated) ? level_size : 0;
+				}
+				if( (NULL == inflated) ||
+					!KTX2_inflate_level( supercompression,
+						level_data, level_index.byteLength[0], inflated, level_size ) )
+				{
+					result_string_pointer = "KTX2 level failed to decompress";
+					break;
+				}
+				level_data = inflated;
+			}
+			if( 0 != level_size % faces )
+			{
+				result_string_pointer = "KTX file was too small for expected image data";
+				break;
+			}
+			face_size = face_stride = level_size / faces;
+		} else
+		{
+			/*	each level starts with its size, of one face for cubemaps	*/
+			unsigned int image_size;
+			if( (unsigned int)buffer_length - buffer_index < 4 )
+			{
+				result_string_pointer = "KTX file was too small for expected image data";
+				break;
+			}
+			memcpy( (void*)(&image_size), (const void*)(&buffer[buffer_index]), 4 );
+			if( swap_bytes )
+			{
+				image_size = (image_size >> 24) | ((image_size >> 8) & 0xFF00) |
+						((image_size & 0xFF00) << 8) | (image_size << 24);
+			}
+			buffer_index += 4;
+			if( image_size > (unsigned int)buffer_length )
+			{
+				result_string_pointer = "KTX file was too small for expected image data";
+				break;
+			}
+			face_size = face_stride = level_size = image_size;
+			if( (0 == layers) && (6 == faces) )
+			{
+				face_stride = (image_size + 3) & ~3u;
+				level_size = face_stride * 6;
+			}
+			if( level_size > (unsigned int)buffer_length - buffer_index )
+			{
+				result_string_pointer = "KTX file was too small for expected image data";
+				break;
+			}
+			level_data = &buffer[buffer_index];
+			buffer_index += (level_size + 3) & ~3u;
+		}
+		/*	the bytes there are for each layer-face, arrays have them back to back	*/
+		image_bytes = (layers > 0) ? level_size / faces / layers : face_size;
+		if( 0 != pixel_size )
+		{
+			/*	w * h pixels, KTX1 rows padded to 4 bytes	*/
+			const unsigned int pitch = (w * pixel_size + file_alignment - 1) & ~(unsigned int)(file_alignment - 1);
+			if( (image_bytes / h / pixel_size < w) || (image_bytes / h < pitch) )
+			{
+				result_string_pointer = "KTX file was too small for expected image data";
+				break;
+			}
+		}
+		if( 0 != etc2_format )
+		{
+			const unsigned int images = ((layers > 0) ? layers : 1) * faces;
+			const unsigned int encoded_size = etc2_get_encoded_data_size( etc2_format, w, h );
+			const size_t image_size = (size_t)w * h * etc2_decoded_channels( etc2_format );
+			const unsigned int source_stride = (layers > 0) ? encoded_size : face_stride;
+			if( encoded_size > image_bytes )
+			{
+				result_string_pointer = "KTX file was too small for expected image data";
+				break;
+			}
+			/*	one buffer for every level, the first is the biggest	*/
+			if( decoded_size < image_size * images )
+			{
+				SOIL_free_image_data( decoded );
+				decoded = (unsigned char*)malloc( image_size * images );
+				decoded_size = (NULL != decoded) ? image_size * images : 0;
+			}
+			if( NULL == decoded )
+			{
+				result_string_pointer = "malloc failed";
+				decode_failed = 1;
+				break;
+			}
+			for( i = 0; i < images; ++i )
+			{
+				if( !etc2_decode_image_signed( &level_data[i * source_stride], etc2_format, w, h, &decoded[i * image_size] ) )
+				{
+					break;
+				}
+			}
+			if( i < images )
+			{
+				result_string_pointer = "KTX ETC2 level failed to decode";
+				decode_failed = 1;
+				break;
+			}
+			level_data = decoded;
+			face_size = face_stride = (unsigned int)image_size;
+		}
+		/*	upload the level as it is	*/
+		if( layers > 0 )
+		{
+			/*	layer-faces in the order OpenGL wants them	*/
+			if( 0 == format )
+			{
+				soilGlCompressedTexImage3D(
+					opengl_texture_type, level,
+					internal_format, w, h, layers * faces, 0,
+					level_size, level_data );
+			} else
+			{
+				soilGlTexImage3D(
+					opengl_texture_type, level,
+					internal_format, w, h, layers * faces, 0,
+					format, pixel_type, level_data );
+			}
+		} else
+		{
+			for( face = 0; face < faces; ++face )
+			{
+				unsigned int target = (6 == faces) ? SOIL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+				if( 0 == format )
+				{
+					soilGlCompressedTexImage2D(
+						target, level,
+						internal_format, w, h, 0,
+						face_size, &level_data[face * face_stride] );
+				} else
+				{
+					glTexImage2D(
+						target, level,
+						internal_format, w, h, 0,
+						format, pixel_type, &level_data[face * face_stride] );
+				}
+			}
+		}
+		if( glGetError() )
+		{
+			result_string_pointer = "failed: uploading a KTX level failed.";
+			break;
+		}
+	}
+	soil_zone_end();
+	SOIL_free_image_data( inflated );
+	SOIL_free_image_data( decoded );
+	if( file_alignment != unpack_aligment )
+	{
+		glPixelStorei( GL_UNPACK_ALIGNMENT, unpack_aligment );
+	}
+	/*	a level that fails to decode on the CPU ends the MIPmaps there,
+		anything else wrong with the file fails it	*/
+	uploaded_levels = level;
+	if( (uploaded_levels < levels) && ((0 == uploaded_levels) || !decode_failed) )
+	{
+		/*	one of the levels failed	*/
+		if( tex_ID != reuse_texture_ID )
+		{
+			glDeleteTextures( 1, &tex_ID );
+		}
+		return 0;
+	}
+	if( uploaded_levels < levels )
+	{
+		result_string_pointer = "KTX file loaded without the levels that failed to decode";
+	}
+	/*	the compressed formats can't be generated	*/
+	if( generate_mipmaps && (0 != format) &&
+		(flags & (SOIL_FLAG_MIPMAPS | SOIL_FLAG_GL_MIPMAPS)) &&
+		(query_gen_mipmap_capability() == SOIL_CAPABILITY_PRESENT) )
+	{
+		soilGlGenerateMipmap( opengl_texture_type );
+		uploaded_levels = 0;
+	}
+	/*	did I have MIPmaps?	*/
+	if( uploaded_levels != 1 )
+	{
+		unsigned int full_chain = 1;
+		while( ((width | height) >> full_chain) > 0 )
+		{
+			++full_chain;
+		}
+		/*	instruct OpenGL to use the MIPmaps, only the ones there are	*/
+		glTexParameteri( opengl_texture_type, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+		glTexParameteri( opengl_texture_type, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+		if( (uploaded_levels > 1) && (uploaded_levels < full_chain) )
+		{
+			glTexParameteri( opengl_texture_type, SOIL_TEXTURE_MAX_LEVEL, uploaded_levels - 1 );
+		}
+	} else
+	{
+		/*	instruct OpenGL _NOT_ to use the MIPmaps	*/
+		glTexParameteri( opengl_texture_type, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+		glTexParameteri( opengl_texture_type, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	}
+	/*	does the user want clamping, or wrapping?	*/
+	if( flags & SOIL_FLAG_TEXTURE_REPEATS )
+	{
+		glTexParameteri( opengl_texture_type, GL_TEXTURE_WRAP_S, GL_REPEAT );
+		glTexParameteri( opengl_texture_type, GL_TEXTURE_WRAP_T, GL_REPEAT );
+		glTexParameteri( opengl_texture_type, SOIL_TEXTURE_WRAP_R, GL_REPEAT );
+	} else
+	{
+		unsigned int clamp_mode = SOIL_CLAMP_TO_EDGE;
+		glTexParameteri( opengl_texture_type, GL_TEXTURE_WRAP_S, clamp_mode );
+		glTexParameteri( opengl_texture_type, GL_TEXTURE_WRAP_T, clamp_mode );
+		glTexParameteri( opengl_texture_type, SOIL_TEXTURE_WRAP_R, clamp_mode );
+	}
+	return tex_ID;
+}
+
+unsigned int SOIL_direct_load_KTX(
+		const char *filename,
+		unsigned int reuse_texture_ID,
+		int flags,
+		int loading_as_cubemap )
+{
+	FILE *f;
+	unsigned char *buffer;
+	size_t buffer_length, bytes_read;
+	unsigned int tex_ID = 0;
+	/*	error checks	*/
+	if( NULL == filename )
+	{
+		result_string_pointer = "NULL filename";
+		return 0;
+	}
+	f = fopen( filename, "rb" );
+	if( NULL == f )
+	{
+		/*	the file doesn't seem to exist (or be open-able)	*/
+		result_string_pointer = "Can not find KTX file";
+		return 0;
+	}
+	fseek( f, 0, SEEK_END );
+	buffer_length = ftell( f );
+	fseek( f, 0, SEEK_SET );
+	buffer = (unsigned char *) malloc( buffer_length );
+	if( NULL == buffer )
+	{
+		result_string_pointer = "malloc failed";
+		fclose( f );
+		return 0;
+	}
+	bytes_read = fread( (void*)buffer, 1, buffer_length, f );
+	fclose( f );
+	if( bytes_read < buffer_length )
+	{
+		/*	huh?	*/
+		buffer_length = bytes_read;
+	}
+	/*	now try to do the loading	*/
+	tex_ID = SOIL_direct_load_KTX_from_memory(
+		(const unsigned char *const)buffer, (int)buffer_length,
+		reuse_texture_ID, flags, loading_as_cubemap );
+	SOIL_free_image_data( buffer );
+	return tex_ID;
+}
+
 int query_NPOT_capability( void )
 {
 	/*	check for the capability	*/
@@ -3022,6 +4416,126 @@ int query_ETC1_capability( void )
 	return has_ETC1_capability;
 }
 
+int query_ETC2_capability( void )
+{
+	/*	check for the capability	*/
+	if( has_ETC2_capability == SOIL_CAPABILITY_UNKNOWN )
+	{
+		/*	we haven't yet checked for the capability, do so	*/
+		const char *verstr = (const char *) glGetString( GL_VERSION );
+		int is_ES3 = ( NULL != verstr ) &&
+				( 0 == strncmp( verstr, "OpenGL ES ", 10 ) ) &&
+				( atoi( verstr + 10 ) >= 3 );
+
+		if (	!is_ES3 &&
+				0 == SOIL_GL_ExtensionSupported(
+					"GL_ARB_ES3_compatibility" )
+			)
+		{
+			/*	not there, flag the failure	*/
+			has_ETC2_capability = SOIL_CAPABILITY_NONE;
+		} else
+		{
+			if ( NULL == soilGlCompressedTexImage2D ) {
+				soilGlCompressedTexImage2D = get_glCompressedTexImage2D_addr();
+			}
+
+			/*	it's there, if I can upload it	*/
+			has_ETC2_capability = ( NULL != soilGlCompressedTexImage2D ) ?
+					SOIL_CAPABILITY_PRESENT : SOIL_CAPABILITY_NONE;
+		}
+	}
+	/*	let the user know if we can do ETC2 and EAC or not	*/
+	return has_ETC2_capability;
+}
+
+int query_RGTC_capability( void )
+{
+	/*	check for the capability	*/
+	if( has_RGTC_capability == SOIL_CAPABILITY_UNKNOWN )
+	{
+		/*	we haven't yet checked for the capability, do so	*/
+		if (	0 == SOIL_GL_ExtensionSupported(
+					"GL_ARB_texture_compression_rgtc" ) &&
+				0 == SOIL_GL_ExtensionSupported(
+					"GL_EXT_texture_compression_rgtc" )
+			)
+		{
+			/*	not there, flag the failure	*/
+			has_RGTC_capability = SOIL_CAPABILITY_NONE;
+		} else
+		{
+			if ( NULL == soilGlCompressedTexImage2D ) {
+				soilGlCompressedTexImage2D = get_glCompressedTexImage2D_addr();
+			}
+
+			/*	it's there, if I can upload it	*/
+			has_RGTC_capability = ( NULL != soilGlCompressedTexImage2D ) ?
+					SOIL_CAPABILITY_PRESENT : SOIL_CAPABILITY_NONE;
+		}
+	}
+	/*	let the user know if we can do BC4/BC5 or not	*/
+	return has_RGTC_capability;
+}
+
+int query_BPTC_capability( void )
+{
+	/*	check for the capability	*/
+	if( has_BPTC_capability == SOIL_CAPABILITY_UNKNOWN )
+	{
+		/*	we haven't yet checked for the capability, do so	*/
+		if (	0 == SOIL_GL_ExtensionSupported(
+					"GL_ARB_texture_compression_bptc" ) &&
+				0 == SOIL_GL_ExtensionSupported(
+					"GL_EXT_texture_compression_bptc" )
+			)
+		{
+			/*	not there, flag the failure	*/
+			has_BPTC_capability = SOIL_CAPABILITY_NONE;
+		} else
+		{
+			if ( NULL == soilGlCompressedTexImage2D ) {
+				soilGlCompressedTexImage2D = get_glCompressedTexImage2D_addr();
+			}
+
+			/*	it's there, if I can upload it	*/
+			has_BPTC_capability = ( NULL != soilGlCompressedTexImage2D ) ?
+					SOIL_CAPABILITY_PRESENT : SOIL_CAPABILITY_NONE;
+		}
+	}
+	/*	let the user know if we can do BC7 or not	*/
+	return has_BPTC_capability;
+}
+
+int query_ASTC_capability( void )
+{
+	/*	check for the capability	*/
+	if( has_ASTC_capability == SOIL_CAPABILITY_UNKNOWN )
+	{
+		/*	we haven't yet checked for the capability, do so	*/
+		if (	0 == SOIL_GL_ExtensionSupported(
+					"GL_KHR_texture_compression_astc_ldr" ) &&
+				0 == SOIL_GL_ExtensionSupported(
+					"GL_OES_texture_compression_astc" )
+			)
+		{
+			/*	not there, flag the failure	*/
+			has_ASTC_capability = SOIL_CAPABILITY_NONE;
+		} else
+		{
+			if ( NULL == soilGlCompressedTexImage2D ) {
+				soilGlCompressedTexImage2D = get_glCompressedTexImage2D_addr();
+			}
+
+			/*	it's there, if I can upload it	*/
+			has_ASTC_capability = ( NULL != soilGlCompressedTexImage2D ) ?
+					SOIL_CAPABILITY_PRESENT : SOIL_CAPABILITY_NONE;
+		}
+	}
+	/*	let the user know if we can do ASTC or not	*/
+	return has_ASTC_capability;
+}
+
 int query_gen_mipmap_capability( void )
 {
 	/* check for the capability   */
@@ -97,6 +97,24 @@ enum
 	SOIL_FLAG_CoCg_Y: Google YCoCg; RGB=>CoYCg, RGBA=>CoCgAY
 	SOIL_FLAG_TEXTURE_RECTANGE: uses ARB_texture_rectangle ; pixel indexed & no repeat or MIPmaps or cubemaps
 	SOIL_FLAG_PVR_LOAD_DIRECT: will load PVR files directly without _ANY_ additional processing ( if supported )
+	SOIL_FLAG_ETC1_LOAD_DIRECT: will load PKM files (ETC1, ETC2 and EAC) directly without _ANY_ additional processing ( if supported )
+	SOIL_FLAG_DXT_FAST: with SOIL_FLAG_COMPRESS_TO_DXT, a quick bounding box encoder for streaming at runtime
+	SOIL_FLAG_DXT_HIGH_QUALITY: with SOIL_FLAG_COMPRESS_TO_DXT, a slow cluster fit encoder for cooking offline
+	SOIL_FLAG_COMPRESS_TO_RGTC: if the card can display them, will convert 1 channel to BC4, and the first 2 channels of the rest to BC5 (normal maps)
+	SOIL_FLAG_COMPRESS_TO_BC7: if the card can display them, will convert RGB and RGBA to BC7
+	SOIL_FLAG_COMPRESS_TO_BC6H: for SOIL_load_OGL_HDR_texture, if the card can display them, will upload the HDR image as BC6H floats
+	SOIL_FLAG_COMPRESS_TO_ETC2: if the card can display them (OpenGL ES 3 or ARB_ES3_compatibility), will convert RGB to ETC2 RGB8, RGBA to ETC2 RGBA8
+	SOIL_FLAG_KTX_LOAD_DIRECT: will load KTX and KTX2 files directly without _ANY_ additional processing ( if supported ),
+	every MIPmap, face and array layer in the file (arrays become GL_TEXTURE_2D_ARRAY or GL_TEXTURE_CUBE_MAP_ARRAY);
+	zlib supercompressed KTX2 always loads, Zstandard when SOIL2 is built with SOIL_KTX2_ZSTD and linked to libzstd;
+	ETC2 and EAC files the card can't display are decoded on the CPU and uploaded as R8, RG8, RGB8 or RGBA8,
+	signed EAC as R8_SNORM or RG8_SNORM
+	(the DXT_FAST and DXT_HIGH_QUALITY flags pick the BC7 and BC6H encoders too,
+	DXT_FAST the quick ETC2 one, COMPRESS_TO_DXT is the fallback for cards without
+	RGTC or BC7, and COMPRESS_TO_RGTC falls back to EAC R11/RG11 on ETC2 cards)
+	(with more than one COMPRESS_TO_ flag the first one the card can display wins,
+	in the order BC7, RGTC, EAC (RGTC on ETC2 cards), DXT, ETC2; so DXT | ETC2
+	gives DXT on desktop cards and ETC2 on OpenGL ES)
 **/
 enum
 {
@@ -113,15 +131,23 @@ enum
 	SOIL_FLAG_PVR_LOAD_DIRECT = 1024,
 	SOIL_FLAG_ETC1_LOAD_DIRECT = 2048,
 	SOIL_FLAG_GL_MIPMAPS = 4096,
-	SOIL_FLAG_SRGB_COLOR_SPACE = 8192
+	SOIL_FLAG_SRGB_COLOR_SPACE = 8192,
+	SOIL_FLAG_DXT_FAST = 16384,
+	SOIL_FLAG_DXT_HIGH_QUALITY = 32768,
+	SOIL_FLAG_COMPRESS_TO_RGTC = 65536,
+	SOIL_FLAG_COMPRESS_TO_BC7 = 131072,
+	SOIL_FLAG_COMPRESS_TO_BC6H = 262144,
+	SOIL_FLAG_COMPRESS_TO_ETC2 = 524288,
+	SOIL_FLAG_KTX_LOAD_DIRECT = 1048576
 };
 
 /**
 	The types of images that may be saved.
 	(TGA supports uncompressed RGB / RGBA)
 	(BMP supports uncompressed RGB)
-	(DDS supports DXT1 and DXT5)
+	(DDS supports DXT1 and DXT5, or BC4/BC5/BC7 with SOIL_save_image_flags)
 	(PNG supports RGB / RGBA)
+	(PKM supports ETC1, or ETC2 / EAC with SOIL_save_image_flags)
 **/
 enum
 {
@@ -129,7 +155,8 @@ enum
 	SOIL_SAVE_TYPE_BMP = 1,
 	SOIL_SAVE_TYPE_PNG = 2,
 	SOIL_SAVE_TYPE_DDS = 3,
-	SOIL_SAVE_TYPE_JPG = 4
+	SOIL_SAVE_TYPE_JPG = 4,
+	SOIL_SAVE_TYPE_PKM = 5
 };
 
 /**
@@ -220,9 +247,12 @@ unsigned int
 /**
 	Loads an HDR image from disk into an OpenGL texture.
 	\param filename the name of the file to upload as a texture
+	With SOIL_FLAG_COMPRESS_TO_BC6H and a card that can display BPTC the
+	image is kept in floating point and uploaded as BC6H (fake_HDR_format is
+	then unused), otherwise it is uploaded as the fake HDR format.
 	\param fake_HDR_format SOIL_HDR_RGBE, SOIL_HDR_RGBdivA, SOIL_HDR_RGBdivA2
 	\param reuse_texture_ID 0-generate a new texture ID, otherwise reuse the texture ID (overwriting the old texture)
-	\param flags can be any of SOIL_FLAG_POWER_OF_TWO | SOIL_FLAG_MIPMAPS | SOIL_FLAG_TEXTURE_REPEATS | SOIL_FLAG_MULTIPLY_ALPHA | SOIL_FLAG_INVERT_Y | SOIL_FLAG_COMPRESS_TO_DXT
+	\param flags can be any of SOIL_FLAG_POWER_OF_TWO | SOIL_FLAG_MIPMAPS | SOIL_FLAG_TEXTURE_REPEATS | SOIL_FLAG_MULTIPLY_ALPHA | SOIL_FLAG_INVERT_Y | SOIL_FLAG_COMPRESS_TO_DXT | SOIL_FLAG_COMPRESS_TO_BC6H
 	\return 0-failed, otherwise returns the OpenGL texture handle
 **/
 unsigned int
@@ -427,6 +457,43 @@ int
 		const unsigned char *const data
 	);
 
+/**
+	Saves an image like SOIL_save_image_quality, with flags for the DDS
+	encoder: SOIL_FLAG_DXT_FAST, SOIL_FLAG_DXT_HIGH_QUALITY or 0 for the
+	default one, and SOIL_FLAG_COMPRESS_TO_RGTC or SOIL_FLAG_COMPRESS_TO_BC7
+	to save BC4/BC5 or BC7 instead of DXT1/DXT5.  PKM files are ETC1,
+	or ETC2 RGB8/RGBA8 with SOIL_FLAG_COMPRESS_TO_ETC2, or EAC R11/RG11
+	with SOIL_FLAG_COMPRESS_TO_RGTC.  Other flags are ignored.
+	\return 0 if failed, otherwise returns 1
+**/
+int
+	SOIL_save_image_flags
+	(
+		const char *filename,
+		int image_type,
+		int width, int height, int channels,
+		const unsigned char *const data,
+		int quality,
+		unsigned int flags
+	);
+
+/**
+	Saves an HDR image from an array of floats (RGB or RGBA, alpha is
+	dropped) to disk.  Only SOIL_SAVE_TYPE_DDS is supported, as BC6H
+	(signed if any value is negative); SOIL_FLAG_DXT_FAST and
+	SOIL_FLAG_DXT_HIGH_QUALITY pick the encoder, other flags are ignored.
+	\return 0 if failed, otherwise returns 1
+**/
+int
+	SOIL_save_HDR_image
+	(
+		const char *filename,
+		int image_type,
+		int width, int height, int channels,
+		const float *const data,
+		unsigned int flags
+	);
+
 /**
 	Frees the image data (note, this is just C's "free()"...this function is
 	present mostly so C++ programmers don't forget to use "free()" and call
@@ -463,6 +530,103 @@ int
 		const char *extension
 	);
 
+/**
+	A range of work handed out by SOIL_parallel_for_func,
+	process items [begin,end) of whatever context points at.
+**/
+typedef void (*SOIL_parallel_task)( void *context, int begin, int end );
+
+/**
+	A parallel-for provided by the application.  It must run
+	task( context, begin, end ) over [0,count) in ranges of at most
+	grain items, on any threads, and only return when all are done.
+**/
+typedef void (*SOIL_parallel_for_func)( SOIL_parallel_task task, void *context, int count, int grain, void *user_data );
+
+/**
+	Lets SOIL split its image processing (resampling, MIPmaps, DXT
+	compression) over the application's thread pool.  Pass NULL to go
+	back to a single thread.
+**/
+void
+	SOIL_set_parallel_for
+	(
+		SOIL_parallel_for_func func,
+		void *user_data
+	);
+
+/**
+	Tells SOIL the application gets GL errors through a debug output
+	callback (KHR_debug), so it stops polling glGetError after every
+	upload.  Polling is off unless SOIL2 is built with
+	SOIL_CHECK_FOR_GL_ERRORS defined to 1.
+**/
+void
+	SOIL_set_GL_debug_output
+	(
+		int enabled
+	);
+
+/**
+	The image processing uses SSE2, AVX2 or NEON code where the CPU
+	has it, chosen at runtime, and gives the same bytes as without.
+	The resampling has all three, DXT compression only AVX2, other
+	CPUs compress with the C encoder.
+	Pass 0 to force the plain C code, e.g. to compare against it.
+**/
+void
+	SOIL_set_SIMD_enabled
+	(
+		int enabled
+	);
+
+/**
+	Called around each stage of loading and processing an image
+	(decoding, resampling, MIPmaps, compression, upload), on
+	whatever thread runs it.  name is a string literal.  Zones
+	nest and a thread always ends its most recent zone first.
+**/
+typedef void (*SOIL_zone_begin_func)( const char *name, void *user_data );
+typedef void (*SOIL_zone_end_func)( void *user_data );
+
+/**
+	Reports SOIL's stages to the application's profiler.  Pass NULL
+	for both to stop.  Set it before loading, not during.
+**/
+void
+	SOIL_set_profiler
+	(
+		SOIL_zone_begin_func begin,
+		SOIL_zone_end_func end,
+		void *user_data
+	);
+
+/**	severities passed to SOIL_log_func	**/
+enum
+{
+	SOIL_LOG_DEBUG = 0,
+	SOIL_LOG_INFO = 1,
+	SOIL_LOG_WARNING = 2,
+	SOIL_LOG_ERROR = 3
+};
+
+/**
+	Receives SOIL's diagnostics as one finished line each (no
+	trailing newline).  May be called from any thread SOIL runs on.
+**/
+typedef void (*SOIL_log_func)( int level, const char *message, void *user_data );
+
+/**
+	Sends SOIL's diagnostics to the application's logger instead of
+	stdout.  Pass NULL to go back to printing them.
+**/
+void
+	SOIL_set_log_func
+	(
+		SOIL_log_func func,
+		void *user_data
+	);
+
 /** Loads the DDS texture directly to the GPU memory ( if supported ) */
 unsigned int SOIL_direct_load_DDS(
 		const char *filename,
@@ -493,17 +657,32 @@ unsigned int SOIL_direct_load_PVR_from_memory(
 		int flags,
 		int loading_as_cubemap );
 
-/** Loads the PVR texture directly to the GPU memory ( if supported ) */
+/** Loads the PKM texture (ETC1, ETC2 or EAC) directly to the GPU memory ( if supported ) */
 unsigned int SOIL_direct_load_ETC1(const char *filename,
 		unsigned int reuse_texture_ID,
 		int flags );
 
-/** Loads the PVR texture directly to the GPU memory ( if supported ) */
+/** Loads the PKM texture (ETC1, ETC2 or EAC) directly to the GPU memory ( if supported ) */
 unsigned int SOIL_direct_load_ETC1_from_memory(const unsigned char *const buffer,
 		int buffer_length,
 		unsigned int reuse_texture_ID,
 		int flags );
 
+/** Loads the KTX or KTX2 texture directly to the GPU memory ( if supported ) */
+unsigned int SOIL_direct_load_KTX(
+		const char *filename,
+		unsigned int reuse_texture_ID,
+		int flags,
+		int loading_as_cubemap );
+
+/** Loads the KTX or KTX2 texture directly to the GPU memory ( if supported ) */
+unsigned int SOIL_direct_load_KTX_from_memory(
+		const unsigned char *const buffer,
+		int buffer_length,
+		unsigned int reuse_texture_ID,
+		int flags,
+		int loading_as_cubemap );
+
 #ifdef __cplusplus
 }
 #endif
@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include "etc1_utils.h"
+#include "parallel_helper.h"
+#include "simd_helper.h"
 
 #include <string.h>
 
@@ -483,56 +485,245 @@ static void writeBigEndian(etc1_byte* pOut, etc1_uint32 d) {
     pOut[3] = (etc1_byte) d;
 }
 
-// Input is a 4 x 4 square of 3-byte pixels in form R, G, B
-// inmask is a 16-bit mask where bit (1 << (x + y * 4)) tells whether the corresponding (x,y)
-// pixel is valid or not. Invalid pixel color values are ignored when compressing.
-// Output is an ETC1 compressed version of the data.
+// The pixels of one sub-block in the order etc_encode_subblock_helper visits
+// them, with the bit each one's index goes to.
 
-void etc1_encode_block(const etc1_byte* pIn, etc1_uint32 inMask,
-        etc1_byte* pOut) {
+static
+int etc_gather_subblock(const etc1_byte* pIn, etc1_uint32 inMask,
+        etc1_bool flipped, etc1_bool second, const etc1_byte* pPixels[8],
+        int bitIndex[8], etc1_bool valid[8]) {
+    int n, x, y;
+    int count = 0;
+    for (n = 0; n < 8; n++) {
+        int i;
+        if (flipped) {
+            x = n & 3;
+            y = (second ? 2 : 0) + (n >> 2);
+        } else {
+            x = (second ? 2 : 0) + (n & 1);
+            y = n >> 1;
+        }
+        i = x + 4 * y;
+        pPixels[n] = pIn + i * 3;
+        bitIndex[n] = y + x * 4;
+        valid[n] = (inMask & (1 << i)) != 0;
+        count += valid[n];
+    }
+    return count;
+}
+
+#ifdef SOIL_SIMD_X86
+
+// etc_encode_block_helper's search over the modifier tables of one sub-block,
+// eight pixels at a time.  A pixel's score for each modifier is shifted up two
+// bits with the modifier index in the bottom, so the minimum picks the first
+// of equal scores just like chooseModifier.  Returns the best score, the first
+// table that reaches it, and its pixel indices or'ed into *pLow.
+
+static
+etc1_uint32 etc_choose_table_sse2(const etc1_byte* pIn, etc1_uint32 inMask,
+        etc1_bool flipped, etc1_bool second, const etc1_byte* pBaseColors,
+        int* pTable, etc1_uint32* pLow) {
+    const etc1_byte* pPixels[8];
+    int bitIndex[8];
+    etc1_bool valid[8];
+    short channels[3][8];
+    int keys[8];
+    int n, t, i;
+    etc1_uint32 bestScore = ~0;
+    __m128i bestLo = _mm_setzero_si128(), bestHi = _mm_setzero_si128();
+    __m128i pixelR, pixelG, pixelB, validLo, validHi;
+    const __m128i weightsGR = _mm_set_epi16(3, 6, 3, 6, 3, 6, 3, 6);
+    const __m128i zero = _mm_setzero_si128();
+
+    etc_gather_subblock(pIn, inMask, flipped, second, pPixels, bitIndex, valid);
+    for (n = 0; n < 8; n++) {
+        channels[0][n] = pPixels[n][0];
+        channels[1][n] = pPixels[n][1];
+        channels[2][n] = pPixels[n][2];
+        keys[n] = valid[n] ? -1 : 0;
+    }
+    pixelR = _mm_loadu_si128((const __m128i*) channels[0]);
+    pixelG = _mm_loadu_si128((const __m128i*) channels[1]);
+    pixelB = _mm_loadu_si128((const __m128i*) channels[2]);
+    validLo = _mm_loadu_si128((const __m128i*) keys);
+    validHi = _mm_loadu_si128((const __m128i*) (keys + 4));
+
+    for (t = 0; t < 8; t++) {
+        const int* pModifierTable = kModifierTable + t * 4;
+        __m128i minLo = _mm_set1_epi32(0x7fffffff);
+        __m128i minHi = minLo;
+        __m128i sum;
+        etc1_uint32 score;
+        for (i = 0; i < 4; i++) {
+            int modifier = pModifierTable[i];
+            __m128i dR = _mm_sub_epi16(_mm_set1_epi16(clamp(pBaseColors[0] + modifier)), pixelR);
+            __m128i dG = _mm_sub_epi16(_mm_set1_epi16(clamp(pBaseColors[1] + modifier)), pixelG);
+            __m128i dB = _mm_sub_epi16(_mm_set1_epi16(clamp(pBaseColors[2] + modifier)), pixelB);
+            // 6 dG^2 + 3 dR^2 + dB^2, in 32 bits
+            __m128i gr = _mm_unpacklo_epi16(dG, dR);
+            __m128i b = _mm_unpacklo_epi16(dB, zero);
+            __m128i keyLo = _mm_add_epi32(_mm_madd_epi16(gr, _mm_mullo_epi16(gr, weightsGR)),
+                    _mm_madd_epi16(b, b));
+            __m128i keyHi, less;
+            gr = _mm_unpackhi_epi16(dG, dR);
+            b = _mm_unpackhi_epi16(dB, zero);
+            keyHi = _mm_add_epi32(_mm_madd_epi16(gr, _mm_mullo_epi16(gr, weightsGR)),
+                    _mm_madd_epi16(b, b));
+            keyLo = _mm_or_si128(_mm_slli_epi32(keyLo, 2), _mm_set1_epi32(i));
+            keyHi = _mm_or_si128(_mm_slli_epi32(keyHi, 2), _mm_set1_epi32(i));
+            less = _mm_cmplt_epi32(keyLo, minLo);
+            minLo = _mm_or_si128(_mm_and_si128(less, keyLo), _mm_andnot_si128(less, minLo));
+            less = _mm_cmplt_epi32(keyHi, minHi);
+            minHi = _mm_or_si128(_mm_and_si128(less, keyHi), _mm_andnot_si128(less, minHi));
+        }
+        minLo = _mm_and_si128(minLo, validLo);
+        minHi = _mm_and_si128(minHi, validHi);
+        sum = _mm_add_epi32(_mm_srli_epi32(minLo, 2), _mm_srli_epi32(minHi, 2));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        score = (etc1_uint32) _mm_cvtsi128_si32(sum);
+        if (score < bestScore) {
+            bestScore = score;
+            bestLo = minLo;
+            bestHi = minHi;
+            *pTable = t;
+        }
+    }
+
+    _mm_storeu_si128((__m128i*) keys, bestLo);
+    _mm_storeu_si128((__m128i*) (keys + 4), bestHi);
+    for (n = 0; n < 8; n++) {
+        if (valid[n]) {
+            int bestIndex = keys[n] & 3;
+            *pLow |= (etc1_uint32) (((bestIndex >> 1) << 16) | (bestIndex & 1)) << bitIndex[n];
+        }
+    }
+    return bestScore;
+}
+
+static
+void etc_encode_block_helper_sse2(const etc1_byte* pIn, etc1_uint32 inMask,
+        const etc1_byte* pColors, etc_compressed* pCompressed, etc1_bool flipped) {
+    etc1_byte pBaseColors[6];
+    int tableA = 0, tableB = 0;
+
+    pCompressed->high = (flipped ? 1 : 0);
+    pCompressed->low = 0;
+    etc_encodeBaseColors(pBaseColors, pColors, pCompressed);
+    pCompressed->score = etc_choose_table_sse2(pIn, inMask, flipped, 0,
+            pBaseColors, &tableA, &pCompressed->low);
+    pCompressed->score += etc_choose_table_sse2(pIn, inMask, flipped, 1,
+            pBaseColors + 3, &tableB, &pCompressed->low);
+    pCompressed->high |= (tableA << 5) | (tableB << 2);
+}
+
+#endif
+
+// How far the pixels of the two sub-blocks stray from their averages, to guess
+// the better orientation without encoding both.
+
+static
+etc1_uint32 etc_subblock_spread(const etc1_byte* pIn, etc1_uint32 inMask,
+        const etc1_byte* pColors, etc1_bool flipped) {
+    const etc1_byte* pPixels[8];
+    int bitIndex[8];
+    etc1_bool valid[8];
+    etc1_uint32 spread = 0;
+    int second, n;
+    for (second = 0; second < 2; second++) {
+        const etc1_byte* pAverage = pColors + 3 * second;
+        etc_gather_subblock(pIn, inMask, flipped, second, pPixels, bitIndex, valid);
+        for (n = 0; n < 8; n++) {
+            if (valid[n]) {
+                spread += 3 * square(pPixels[n][0] - pAverage[0])
+                        + 6 * square(pPixels[n][1] - pAverage[1])
+                        + square(pPixels[n][2] - pAverage[2]);
+            }
+        }
+    }
+    return spread;
+}
+
+static
+void etc_encode_block(const etc1_byte* pIn, etc1_uint32 inMask,
+        etc1_byte* pOut, int quality, int simd) {
     etc1_byte colors[6];
     etc1_byte flippedColors[6];
+    etc_compressed a, b;
+    void (*encode)(const etc1_byte*, etc1_uint32, const etc1_byte*,
+            etc_compressed*, etc1_bool) = etc_encode_block_helper;
+#ifdef SOIL_SIMD_X86
+    if (simd != SOIL_SIMD_NONE) {
+        encode = etc_encode_block_helper_sse2;
+    }
+#else
+    (void) simd;
+#endif
 	etc_average_colors_subblock(pIn, inMask, colors, 0, 0);
 	etc_average_colors_subblock(pIn, inMask, colors + 3, 0, 1);
 	etc_average_colors_subblock(pIn, inMask, flippedColors, 1, 0);
 	etc_average_colors_subblock(pIn, inMask, flippedColors + 3, 1, 1);
 
-    etc_compressed a, b;
-	etc_encode_block_helper(pIn, inMask, colors, &a, 0);
-	etc_encode_block_helper(pIn, inMask, flippedColors, &b, 1);
-    take_best(&a, &b);
+    if (quality == ETC1_QUALITY_FAST) {
+        if (etc_subblock_spread(pIn, inMask, flippedColors, 1)
+                < etc_subblock_spread(pIn, inMask, colors, 0)) {
+            encode(pIn, inMask, flippedColors, &a, 1);
+        } else {
+            encode(pIn, inMask, colors, &a, 0);
+        }
+    } else {
+        encode(pIn, inMask, colors, &a, 0);
+        encode(pIn, inMask, flippedColors, &b, 1);
+        take_best(&a, &b);
+    }
     writeBigEndian(pOut, a.high);
     writeBigEndian(pOut + 4, a.low);
 }
 
+// Input is a 4 x 4 square of 3-byte pixels in form R, G, B
+// inmask is a 16-bit mask where bit (1 << (x + y * 4)) tells whether the corresponding (x,y)
+// pixel is valid or not. Invalid pixel color values are ignored when compressing.
+// Output is an ETC1 compressed version of the data.
+
+void etc1_encode_block(const etc1_byte* pIn, etc1_uint32 inMask,
+        etc1_byte* pOut) {
+    etc_encode_block(pIn, inMask, pOut, ETC1_QUALITY_THOROUGH, soil_simd_level());
+}
+
 // Return the size of the encoded image data (does not include size of PKM header).
 
 etc1_uint32 etc1_get_encoded_data_size(etc1_uint32 width, etc1_uint32 height) {
     return (((width + 3) & ~3) * ((height + 3) & ~3)) >> 1;
 }
 
-// Encode an entire image.
-// pIn - pointer to the image data. Formatted such that the Red component of
-//       pixel (x,y) is at pIn + pixelSize * x + stride * y + redOffset;
-// pOut - pointer to encoded data. Must be large enough to store entire encoded image.
+// Rows of blocks per parallel job.
 
-int etc1_encode_image(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 height,
-        etc1_uint32 pixelSize, etc1_uint32 stride, etc1_byte* pOut) {
-    if (pixelSize < 2 || pixelSize > 3) {
-        return -1;
-    }
+#define ETC1_ENCODE_GRAIN 4
+
+typedef struct {
+    const etc1_byte* pIn;
+    etc1_uint32 width, height, pixelSize, stride;
+    etc1_byte* pOut;
+    int quality;
+    int simd;
+} etc_encode_job;
+
+static
+void etc_encode_block_rows(void* context, int rowBegin, int rowEnd) {
     static const unsigned short kYMask[] = { 0x0, 0xf, 0xff, 0xfff, 0xffff };
     static const unsigned short kXMask[] = { 0x0, 0x1111, 0x3333, 0x7777,
             0xffff };
+    const etc_encode_job* job = (const etc_encode_job*) context;
+    const etc1_uint32 width = job->width;
+    const etc1_uint32 pixelSize = job->pixelSize;
     etc1_byte block[ETC1_DECODED_BLOCK_SIZE];
-    etc1_byte encoded[ETC1_ENCODED_BLOCK_SIZE];
-	etc1_uint32 y, x, cy, cx;
-
     etc1_uint32 encodedWidth = (width + 3) & ~3;
-    etc1_uint32 encodedHeight = (height + 3) & ~3;
+    etc1_byte* pOut = job->pOut + (etc1_uint32) rowBegin * (encodedWidth >> 2) * ETC1_ENCODED_BLOCK_SIZE;
+	etc1_uint32 y, x, cy, cx;
 
-	for ( y = 0; y < encodedHeight; y += 4) {
-        etc1_uint32 yEnd = height - y;
+	for ( y = (etc1_uint32) rowBegin * 4; y < (etc1_uint32) rowEnd * 4; y += 4) {
+        etc1_uint32 yEnd = job->height - y;
         if (yEnd > 4) {
             yEnd = 4;
         }
@@ -545,7 +736,7 @@ int etc1_encode_image(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 heigh
             int mask = ymask & kXMask[xEnd];
 			for ( cy = 0; cy < yEnd; cy++) {
                 etc1_byte* q = block + (cy * 4) * 3;
-                const etc1_byte* p = pIn + pixelSize * x + stride * (y + cy);
+                const etc1_byte* p = job->pIn + pixelSize * x + job->stride * (y + cy);
                 if (pixelSize == 3) {
                     memcpy(q, p, xEnd * 3);
                 } else {
@@ -558,11 +749,40 @@ int etc1_encode_image(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 heigh
                     }
                 }
             }
-            etc1_encode_block(block, mask, encoded);
-            memcpy(pOut, encoded, sizeof(encoded));
-            pOut += sizeof(encoded);
+            etc_encode_block(block, mask, pOut, job->quality, job->simd);
+            pOut += ETC1_ENCODED_BLOCK_SIZE;
         }
     }
+}
+
+// Encode an entire image.
+// pIn - pointer to the image data. Formatted such that the Red component of
+//       pixel (x,y) is at pIn + pixelSize * x + stride * y + redOffset;
+// pOut - pointer to encoded data. Must be large enough to store entire encoded image.
+
+int etc1_encode_image(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 height,
+        etc1_uint32 pixelSize, etc1_uint32 stride, etc1_byte* pOut) {
+    return etc1_encode_image_quality(pIn, width, height, pixelSize, stride, pOut,
+            ETC1_QUALITY_THOROUGH);
+}
+
+int etc1_encode_image_quality(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 height,
+        etc1_uint32 pixelSize, etc1_uint32 stride, etc1_byte* pOut, int quality) {
+    etc_encode_job job;
+    if (pixelSize < 2 || pixelSize > 3) {
+        return -1;
+    }
+    job.pIn = pIn;
+    job.width = width;
+    job.height = height;
+    job.pixelSize = pixelSize;
+    job.stride = stride;
+    job.pOut = pOut;
+    job.quality = quality;
+    job.simd = soil_simd_level();
+    // the rows of blocks are independent, and each knows where its output goes
+    soil_parallel_for(etc_encode_block_rows, &job, (int) ((height + 3) >> 2),
+            ETC1_ENCODE_GRAIN);
     return 0;
 }
 
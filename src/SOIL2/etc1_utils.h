@@ -67,6 +67,20 @@ etc1_uint32 etc1_get_encoded_data_size(etc1_uint32 width, etc1_uint32 height);
 int etc1_encode_image(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 height,
         etc1_uint32 pixelSize, etc1_uint32 stride, etc1_byte* pOut);
 
+// How hard etc1_encode_image_quality tries.
+// ETC1_QUALITY_THOROUGH encodes both sub-block orientations and keeps the
+// better one, the output etc1_encode_image has always given.
+// ETC1_QUALITY_FAST only encodes the orientation whose sub-blocks stray the
+// least from their average colors, for about half the time.
+
+#define ETC1_QUALITY_THOROUGH 0
+#define ETC1_QUALITY_FAST 1
+
+// Encode an entire image like etc1_encode_image, at the given quality.
+
+int etc1_encode_image_quality(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 height,
+        etc1_uint32 pixelSize, etc1_uint32 stride, etc1_byte* pOut, int quality);
+
 // Decode an entire image.
 // pIn - pointer to encoded data.
 // pOut - pointer to the image data. Will be written such that
@@ -0,0 +1,1290 @@
+/*
+	ETC2 and EAC compression / decompression code
+
+	Public Domain
+*/
+
+#include "etc2_utils.h"
+#include "etc1_utils.h"
+#include "pkm_helper.h"
+#include "parallel_helper.h"
+#include "profile_helper.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/*	rows of 4x4 blocks per parallel job	*/
+#define ETC2_GRAIN 4
+
+/*	the block modes an ETC2 RGB block can be in	*/
+enum
+{
+	ETC2_MODE_ETC1 = 0,
+	ETC2_MODE_T = 1,
+	ETC2_MODE_H = 2,
+	ETC2_MODE_PLANAR = 3
+};
+
+/*	the T and H mode distances	*/
+static const int ETC2_distance_table[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+/*	the EAC modifiers, the negative ones first	*/
+static const int EAC_modifier_table[16][8] =
+{
+	{ -3, -6,  -9, -15, 2, 5, 8, 14 },
+	{ -3, -7, -10, -13, 2, 6, 9, 12 },
+	{ -2, -5,  -8, -13, 1, 4, 7, 12 },
+	{ -2, -4,  -6, -13, 1, 3, 5, 12 },
+	{ -3, -6,  -8, -12, 2, 5, 7, 11 },
+	{ -3, -7,  -9, -11, 2, 6, 8, 10 },
+	{ -4, -7,  -8, -11, 3, 6, 7, 10 },
+	{ -3, -5,  -8, -11, 2, 4, 7, 10 },
+	{ -2, -6,  -8, -10, 1, 5, 7,  9 },
+	{ -2, -5,  -8, -10, 1, 4, 7,  9 },
+	{ -2, -4,  -8, -10, 1, 3, 7,  9 },
+	{ -2, -5,  -7, -10, 1, 4, 6,  9 },
+	{ -3, -4,  -7, -10, 2, 3, 6,  9 },
+	{ -1, -2,  -3, -10, 0, 1, 2,  9 },
+	{ -4, -6,  -8,  -9, 3, 5, 7,  8 },
+	{ -3, -5,  -7,  -9, 2, 4, 6,  8 }
+};
+
+/********* Helper Functions *********/
+static int clamp_int( int v, int lo, int hi )
+{
+	return (v < lo) ? lo : ((v > hi) ? hi : v);
+}
+
+static unsigned int read_big_endian( const unsigned char *p )
+{
+	return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) |
+			((unsigned int)p[2] << 8) | (unsigned int)p[3];
+}
+
+static void write_big_endian( unsigned char *p, unsigned int v )
+{
+	p[0] = (unsigned char)(v >> 24);
+	p[1] = (unsigned char)(v >> 16);
+	p[2] = (unsigned char)(v >> 8);
+	p[3] = (unsigned char)v;
+}
+
+static int extend_4_to_8( int c )
+{
+	return (c << 4) | c;
+}
+
+static int quantize_8_to_4( int c )
+{
+	return (c * 15 + 128) / 255;
+}
+
+/*	the 3 bit two's complement delta of a differential block	*/
+static int signed_3_bits( unsigned int v )
+{
+	return (int)((v & 7) ^ 4) - 4;
+}
+
+/*	which of the modes the high word of an ETC2 RGB block is in	*/
+static int ETC2_block_mode( unsigned int high )
+{
+	int c;
+	if( 0 == (high & 2) )
+	{
+		return ETC2_MODE_ETC1;
+	}
+	c = (int)((high >> 27) & 31) + signed_3_bits( high >> 24 );
+	if( (c < 0) || (c > 31) )
+	{
+		return ETC2_MODE_T;
+	}
+	c = (int)((high >> 19) & 31) + signed_3_bits( high >> 16 );
+	if( (c < 0) || (c > 31) )
+	{
+		return ETC2_MODE_H;
+	}
+	c = (int)((high >> 11) & 31) + signed_3_bits( high >> 8 );
+	if( (c < 0) || (c > 31) )
+	{
+		return ETC2_MODE_PLANAR;
+	}
+	return ETC2_MODE_ETC1;
+}
+
+/*	the 2 bit index of pixel (x,y) in a T, H (or ETC1) block	*/
+static int ETC2_pixel_index( unsigned int low, int x, int y )
+{
+	int k = x*4 + y;
+	return (int)(((low >> k) & 1) | ((low >> (k + 15)) & 2));
+}
+
+static void ETC2_paint_pixels(
+		const int paint[4][3], unsigned int low,
+		unsigned char out[16*3] )
+{
+	int x, y, c;
+	for( y = 0; y < 4; ++y )
+	{
+		for( x = 0; x < 4; ++x )
+		{
+			const int *color = paint[ETC2_pixel_index( low, x, y )];
+			for( c = 0; c < 3; ++c )
+			{
+				out[(y*4 + x)*3 + c] = (unsigned char)color[c];
+			}
+		}
+	}
+}
+
+/*	decodes an 8 byte ETC2 RGB block to 16 RGB pixels in rows	*/
+static void decode_ETC2_RGB_block( const unsigned char block[8], unsigned char out[16*3] )
+{
+	const unsigned int high = read_big_endian( block );
+	const unsigned int low = read_big_endian( block + 4 );
+	int paint[4][3];
+	int c1[3], c2[3], d, c, x, y;
+	switch( ETC2_block_mode( high ) )
+	{
+	case ETC2_MODE_T:
+		c1[0] = extend_4_to_8( (int)(((high >> 27) & 3) << 2 | ((high >> 24) & 3)) );
+		c1[1] = extend_4_to_8( (int)((high >> 20) & 15) );
+		c1[2] = extend_4_to_8( (int)((high >> 16) & 15) );
+		c2[0] = extend_4_to_8( (int)((high >> 12) & 15) );
+		c2[1] = extend_4_to_8( (int)((high >> 8) & 15) );
+		c2[2] = extend_4_to_8( (int)((high >> 4) & 15) );
+		d = ETC2_distance_table[((high >> 1) & 6) | (high & 1)];
+		for( c = 0; c < 3; ++c )
+		{
+			paint[0][c] = c1[c];
+			paint[1][c] = clamp_int( c2[c] + d, 0, 255 );
+			paint[2][c] = c2[c];
+			paint[3][c] = clamp_int( c2[c] - d, 0, 255 );
+		}
+		ETC2_paint_pixels( (const int (*)[3])paint, low, out );
+		break;
+	case ETC2_MODE_H:
+		c1[0] = (int)((high >> 27) & 15);
+		c1[1] = (int)(((high >> 24) & 7) << 1 | ((high >> 20) & 1));
+		c1[2] = (int)(((high >> 19) & 1) << 3 | ((high >> 15) & 7));
+		c2[0] = (int)((high >> 11) & 15);
+		c2[1] = (int)((high >> 7) & 15);
+		c2[2] = (int)((high >> 3) & 15);
+		/*	the last bit of the distance is the order of the colors	*/
+		d = (int)((high & 4) | ((high & 1) << 1));
+		if( ((c1[0] << 8) | (c1[1] << 4) | c1[2]) >= ((c2[0] << 8) | (c2[1] << 4) | c2[2]) )
+		{
+			d |= 1;
+		}
+		d = ETC2_distance_table[d];
+		for( c = 0; c < 3; ++c )
+		{
+			paint[0][c] = clamp_int( extend_4_to_8( c1[c] ) + d, 0, 255 );
+			paint[1][c] = clamp_int( extend_4_to_8( c1[c] ) - d, 0, 255 );
+			paint[2][c] = clamp_int( extend_4_to_8( c2[c] ) + d, 0, 255 );
+			paint[3][c] = clamp_int( extend_4_to_8( c2[c] ) - d, 0, 255 );
+		}
+		ETC2_paint_pixels( (const int (*)[3])paint, low, out );
+		break;
+	case ETC2_MODE_PLANAR:
+		{
+			int o[3], h[3], v[3];
+			o[0] = (int)((high >> 25) & 63);
+			o[1] = (int)(((high >> 24) & 1) << 6 | ((high >> 17) & 63));
+			o[2] = (int)(((high >> 16) & 1) << 5 | ((high >> 11) & 3) << 3 | ((high >> 7) & 7));
+			h[0] = (int)(((high >> 2) & 31) << 1 | (high & 1));
+			h[1] = (int)((low >> 25) & 127);
+			h[2] = (int)((low >> 19) & 63);
+			v[0] = (int)((low >> 13) & 63);
+			v[1] = (int)((low >> 6) & 127);
+			v[2] = (int)(low & 63);
+			/*	6 bit red and blue, 7 bit green	*/
+			for( c = 0; c < 3; c += 2 )
+			{
+				o[c] = (o[c] << 2) | (o[c] >> 4);
+				h[c] = (h[c] << 2) | (h[c] >> 4);
+				v[c] = (v[c] << 2) | (v[c] >> 4);
+			}
+			o[1] = (o[1] << 1) | (o[1] >> 6);
+			h[1] = (h[1] << 1) | (h[1] >> 6);
+			v[1] = (v[1] << 1) | (v[1] >> 6);
+			for( y = 0; y < 4; ++y )
+			{
+				for( x = 0; x < 4; ++x )
+				{
+					for( c = 0; c < 3; ++c )
+					{
+						out[(y*4 + x)*3 + c] = (unsigned char)clamp_int(
+								(x*(h[c] - o[c]) + y*(v[c] - o[c]) + 4*o[c] + 2) >> 2, 0, 255 );
+					}
+				}
+			}
+		}
+		break;
+	default:
+		etc1_decode_block( block, out );
+		break;
+	}
+}
+
+/*	the value an EAC block gives index idx, 8 bit or 11 bit unsigned	*/
+static int EAC_value( int base, int multiplier, int modifier, int is_11_bit )
+{
+	if( is_11_bit )
+	{
+		/*	a multiplier of 0 steps by single 11 bit values	*/
+		int step = (multiplier > 0) ? modifier * multiplier * 8 : modifier;
+		return clamp_int( base*8 + 4 + step, 0, 2047 );
+	}
+	return clamp_int( base + modifier * multiplier, 0, 255 );
+}
+
+/*	decodes an 8 byte EAC block to 16 values (8 bit, or 11 bit
+	unsigned, or signed 11 bit offset by 1023) in rows	*/
+static void decode_EAC_block( const unsigned char block[8], int bits, int is_signed, int out[16] )
+{
+	const int multiplier = block[1] >> 4;
+	const int *modifiers = EAC_modifier_table[block[1] & 15];
+	/*	3 bit indices, in 2 halves of 24 bits, by columns	*/
+	const unsigned int first = ((unsigned int)block[2] << 16) | ((unsigned int)block[3] << 8) | block[4];
+	const unsigned int second = ((unsigned int)block[5] << 16) | ((unsigned int)block[6] << 8) | block[7];
+	int i;
+	for( i = 0; i < 16; ++i )
+	{
+		const int idx = (int)(((i < 8) ? (first >> (21 - 3*i)) : (second >> (45 - 3*i))) & 7);
+		int value;
+		if( is_signed )
+		{
+			int base = (signed char)block[0];
+			int step = (multiplier > 0) ? modifiers[idx] * multiplier * 8 : modifiers[idx];
+			if( base == -128 )
+			{
+				base = -127;
+			}
+			value = clamp_int( base*8 + step, -1023, 1023 ) + 1023;
+		} else
+		{
+			value = EAC_value( block[0], multiplier, modifiers[idx], bits == 11 );
+		}
+		out[(i & 3)*4 + (i >> 2)] = value;
+	}
+}
+
+/*	rounds an 11 bit EAC value (signed ones offset to 0..2046) to 8 bits	*/
+static unsigned char EAC_to_8_bits( int value, int is_signed )
+{
+	const int range = is_signed ? 2046 : 2047;
+	return (unsigned char)((value * 255 + (range >> 1)) / range);
+}
+
+/*	rounds a signed 11 bit EAC value (offset to 0..2046) to a signed
+	8 bit one, -127..127 as the SNORM formats read it	*/
+static unsigned char EAC_to_signed_8_bits( int value )
+{
+	const int v = value - 1023;
+	return (unsigned char)(signed char)((v * 127 + ((v < 0) ? -511 : 511)) / 1023);
+}
+
+/********* Encoding *********/
+/*	3 dR^2 + 6 dG^2 + dB^2, the error the ETC1 encoder minimizes	*/
+static unsigned int ETC2_pixel_error( const unsigned char *a, const int *b )
+{
+	const int dr = a[0] - b[0];
+	const int dg = a[1] - b[1];
+	const int db = a[2] - b[2];
+	return (unsigned int)(3*dr*dr + 6*dg*dg + db*db);
+}
+
+static unsigned int ETC2_block_error( const unsigned char block[8], const unsigned char pixels[16*3] )
+{
+	unsigned char decoded[16*3];
+	unsigned int error = 0;
+	int i, c[3];
+	decode_ETC2_RGB_block( block, decoded );
+	for( i = 0; i < 16; ++i )
+	{
+		c[0] = decoded[i*3+0];
+		c[1] = decoded[i*3+1];
+		c[2] = decoded[i*3+2];
+		error += ETC2_pixel_error( pixels + i*3, c );
+	}
+	return error;
+}
+
+/*	sets the filler bits (those in mask) so the block reads as the mode	*/
+static int ETC2_set_filler_bits( unsigned int *high, unsigned int mask, int mode )
+{
+	unsigned int fill = 0;
+	do
+	{
+		if( ETC2_block_mode( *high | fill ) == mode )
+		{
+			*high |= fill;
+			return 1;
+		}
+		/*	the next subset of the mask	*/
+		fill = (fill - mask) & mask;
+	} while( fill != 0 );
+	return 0;
+}
+
+/*	picks the best of 4 paint colors for every pixel, and the
+	error, giving up once it reaches best_error	*/
+static unsigned int ETC2_paint_indices(
+		const unsigned char pixels[16*3], const int paint[4][3],
+		unsigned int best_error, unsigned int *low )
+{
+	unsigned int error = 0;
+	int x, y, i;
+	*low = 0;
+	for( y = 0; y < 4; ++y )
+	{
+		for( x = 0; x < 4; ++x )
+		{
+			const unsigned char *p = pixels + (y*4 + x)*3;
+			unsigned int best = ETC2_pixel_error( p, paint[0] );
+			int best_i = 0, k = x*4 + y;
+			for( i = 1; i < 4; ++i )
+			{
+				unsigned int e = ETC2_pixel_error( p, paint[i] );
+				if( e < best )
+				{
+					best = e;
+					best_i = i;
+				}
+			}
+			*low |= ((unsigned int)(best_i & 1) << k) | ((unsigned int)(best_i >> 1) << (k + 16));
+			error += best;
+			if( error >= best_error )
+			{
+				return error;
+			}
+		}
+	}
+	return error;
+}
+
+/*	splits the pixels in two along their principal axis, then
+	moves them to the nearer of the two means a couple of times	*/
+static void ETC2_split_pixels( const unsigned char pixels[16*3], int means[2][3], int *count_first )
+{
+	float mean[3], cov[6], axis[3];
+	int group[16];
+	int i, c, iter;
+	for( c = 0; c < 3; ++c )
+	{
+		mean[c] = 0.0f;
+		for( i = 0; i < 16; ++i )
+		{
+			mean[c] += pixels[i*3+c];
+		}
+		mean[c] *= 1.0f / 16.0f;
+	}
+	for( c = 0; c < 6; ++c )
+	{
+		cov[c] = 0.0f;
+	}
+	for( i = 0; i < 16; ++i )
+	{
+		float r = pixels[i*3+0] - mean[0];
+		float g = pixels[i*3+1] - mean[1];
+		float b = pixels[i*3+2] - mean[2];
+		cov[0] += r*r; cov[1] += r*g; cov[2] += r*b;
+		cov[3] += g*g; cov[4] += g*b; cov[5] += b*b;
+	}
+	/*	start from the row of the channel that varies most, a fixed
+		start can be square to the axis and never leave it	*/
+	if( (cov[0] >= cov[3]) && (cov[0] >= cov[5]) )
+	{
+		axis[0] = cov[0]; axis[1] = cov[1]; axis[2] = cov[2];
+	} else if( cov[3] >= cov[5] )
+	{
+		axis[0] = cov[1]; axis[1] = cov[3]; axis[2] = cov[4];
+	} else
+	{
+		axis[0] = cov[2]; axis[1] = cov[4]; axis[2] = cov[5];
+	}
+	for( iter = 0; iter < 4; ++iter )
+	{
+		float r = cov[0]*axis[0] + cov[1]*axis[1] + cov[2]*axis[2];
+		float g = cov[1]*axis[0] + cov[3]*axis[1] + cov[4]*axis[2];
+		float b = cov[2]*axis[0] + cov[4]*axis[1] + cov[5]*axis[2];
+		/*	scaled by the largest component, whatever its sign	*/
+		float m = (r < 0.0f) ? -r : r;
+		m = (g > m) ? g : ((-g > m) ? -g : m);
+		m = (b > m) ? b : ((-b > m) ? -b : m);
+		if( m <= 0.0f )
+		{
+			break;
+		}
+		axis[0] = r / m; axis[1] = g / m; axis[2] = b / m;
+	}
+	for( i = 0; i < 16; ++i )
+	{
+		group[i] = ((pixels[i*3+0] - mean[0])*axis[0] + (pixels[i*3+1] - mean[1])*axis[1]
+				+ (pixels[i*3+2] - mean[2])*axis[2]) > 0.0f;
+	}
+	for( iter = 0; iter < 3; ++iter )
+	{
+		int sum[2][3] = { { 0, 0, 0 }, { 0, 0, 0 } };
+		int count[2] = { 0, 0 };
+		for( i = 0; i < 16; ++i )
+		{
+			++count[group[i]];
+			for( c = 0; c < 3; ++c )
+			{
+				sum[group[i]][c] += pixels[i*3+c];
+			}
+		}
+		for( c = 0; c < 3; ++c )
+		{
+			means[0][c] = count[0] ? (sum[0][c] + count[0]/2) / count[0] : (int)(mean[c] + 0.5f);
+			means[1][c] = count[1] ? (sum[1][c] + count[1]/2) / count[1] : (int)(mean[c] + 0.5f);
+		}
+		*count_first = count[0];
+		for( i = 0; i < 16; ++i )
+		{
+			group[i] = ETC2_pixel_error( pixels + i*3, means[1] ) < ETC2_pixel_error( pixels + i*3, means[0] );
+		}
+	}
+}
+
+/*	T mode: one color alone, the other with +-distance	*/
+static unsigned int ETC2_try_T_mode(
+		const unsigned char pixels[16*3], const int means[2][3],
+		unsigned int best_error, unsigned char block[8] )
+{
+	int order, d, c;
+	for( order = 0; order < 2; ++order )
+	{
+		int c1[3], c2[3], paint[4][3];
+		for( c = 0; c < 3; ++c )
+		{
+			c1[c] = quantize_8_to_4( means[order][c] );
+			c2[c] = quantize_8_to_4( means[1-order][c] );
+		}
+		for( d = 0; d < 8; ++d )
+		{
+			unsigned int high, low, error;
+			for( c = 0; c < 3; ++c )
+			{
+				paint[0][c] = extend_4_to_8( c1[c] );
+				paint[1][c] = clamp_int( extend_4_to_8( c2[c] ) + ETC2_distance_table[d], 0, 255 );
+				paint[2][c] = extend_4_to_8( c2[c] );
+				paint[3][c] = clamp_int( extend_4_to_8( c2[c] ) - ETC2_distance_table[d], 0, 255 );
+			}
+			error = ETC2_paint_indices( pixels, (const int (*)[3])paint, best_error, &low );
+			if( error >= best_error )
+			{
+				continue;
+			}
+			high = ((unsigned int)(c1[0] >> 2) << 27) | ((unsigned int)(c1[0] & 3) << 24) |
+					((unsigned int)c1[1] << 20) | ((unsigned int)c1[2] << 16) |
+					((unsigned int)c2[0] << 12) | ((unsigned int)c2[1] << 8) | ((unsigned int)c2[2] << 4) |
+					((unsigned int)(d >> 1) << 2) | 2 | (unsigned int)(d & 1);
+			if( ETC2_set_filler_bits( &high, 0xE4000000u, ETC2_MODE_T ) )
+			{
+				write_big_endian( block, high );
+				write_big_endian( block + 4, low );
+				best_error = error;
+			}
+		}
+	}
+	return best_error;
+}
+
+/*	H mode: both colors with +-distance	*/
+static unsigned int ETC2_try_H_mode(
+		const unsigned char pixels[16*3], const int means[2][3],
+		unsigned int best_error, unsigned char block[8] )
+{
+	int c1[3], c2[3], d, c;
+	for( c = 0; c < 3; ++c )
+	{
+		c1[c] = quantize_8_to_4( means[0][c] );
+		c2[c] = quantize_8_to_4( means[1][c] );
+	}
+	for( d = 0; d < 8; ++d )
+	{
+		int paint[4][3], *a = c1, *b = c2;
+		int order = ((c1[0] << 8) | (c1[1] << 4) | c1[2]) >= ((c2[0] << 8) | (c2[1] << 4) | c2[2]);
+		unsigned int high, low, error;
+		/*	the order of the colors is the last bit of the distance	*/
+		if( order != (d & 1) )
+		{
+			if( (c1[0] == c2[0]) && (c1[1] == c2[1]) && (c1[2] == c2[2]) )
+			{
+				continue;
+			}
+			a = c2;
+			b = c1;
+		}
+		for( c = 0; c < 3; ++c )
+		{
+			paint[0][c] = clamp_int( extend_4_to_8( a[c] ) + ETC2_distance_table[d], 0, 255 );
+			paint[1][c] = clamp_int( extend_4_to_8( a[c] ) - ETC2_distance_table[d], 0, 255 );
+			paint[2][c] = clamp_int( extend_4_to_8( b[c] ) + ETC2_distance_table[d], 0, 255 );
+			paint[3][c] = clamp_int( extend_4_to_8( b[c] ) - ETC2_distance_table[d], 0, 255 );
+		}
+		error = ETC2_paint_indices( pixels, (const int (*)[3])paint, best_error, &low );
+		if( error >= best_error )
+		{
+			continue;
+		}
+		high = ((unsigned int)a[0] << 27) | ((unsigned int)(a[1] >> 1) << 24) | ((unsigned int)(a[1] & 1) << 20) |
+				((unsigned int)(a[2] >> 3) << 19) | ((unsigned int)(a[2] & 7) << 15) |
+				((unsigned int)b[0] << 11) | ((unsigned int)b[1] << 7) | ((unsigned int)b[2] << 3) |
+				((unsigned int)(d >> 2) << 2) | 2 | (unsigned int)((d >> 1) & 1);
+		if( ETC2_set_filler_bits( &high, 0x80E40000u, ETC2_MODE_H ) )
+		{
+			write_big_endian( block, high );
+			write_big_endian( block + 4, low );
+			best_error = error;
+		}
+	}
+	return best_error;
+}
+
+/*	the error of one channel of a planar block	*/
+static unsigned int ETC2_planar_channel_error(
+		const unsigned char pixels[16*3], int c, int o, int h, int v, int bits )
+{
+	unsigned int error = 0;
+	int x, y;
+	if( bits == 6 )
+	{
+		o = (o << 2) | (o >> 4);
+		h = (h << 2) | (h >> 4);
+		v = (v << 2) | (v >> 4);
+	} else
+	{
+		o = (o << 1) | (o >> 6);
+		h = (h << 1) | (h >> 6);
+		v = (v << 1) | (v >> 6);
+	}
+	for( y = 0; y < 4; ++y )
+	{
+		for( x = 0; x < 4; ++x )
+		{
+			int d = clamp_int( (x*(h - o) + y*(v - o) + 4*o + 2) >> 2, 0, 255 ) - pixels[(y*4 + x)*3 + c];
+			error += (unsigned int)(d*d);
+		}
+	}
+	return error;
+}
+
+/*	planar mode: a least squares plane through the pixels,
+	each channel tried one step around the rounded fit when thorough	*/
+static unsigned int ETC2_try_planar_mode(
+		const unsigned char pixels[16*3], int thorough,
+		unsigned int best_error, unsigned char block[8] )
+{
+	static const int weights[3] = { 3, 6, 1 };
+	int q[3][3];	/*	O, H, V per channel	*/
+	unsigned int error = 0, high, low;
+	int c, x, y;
+	for( c = 0; c < 3; ++c )
+	{
+		const int bits = (c == 1) ? 7 : 6;
+		const int top = (1 << bits) - 1;
+		int sum = 0, sum_x = 0, sum_y = 0;
+		float a, b, d;
+		unsigned int best = 0xFFFFFFFFu;
+		int fit[3], i, j, k;
+		for( y = 0; y < 4; ++y )
+		{
+			for( x = 0; x < 4; ++x )
+			{
+				int p = pixels[(y*4 + x)*3 + c];
+				sum += p;
+				sum_x += (2*x - 3) * p;
+				sum_y += (2*y - 3) * p;
+			}
+		}
+		/*	p = a + b (x - 1.5) + d (y - 1.5)	*/
+		a = sum / 16.0f;
+		b = sum_x / 40.0f;
+		d = sum_y / 40.0f;
+		fit[0] = clamp_int( (int)((a - 1.5f*b - 1.5f*d) * top / 255.0f + 0.5f), 0, top );
+		fit[1] = clamp_int( (int)((a + 2.5f*b - 1.5f*d) * top / 255.0f + 0.5f), 0, top );
+		fit[2] = clamp_int( (int)((a - 1.5f*b + 2.5f*d) * top / 255.0f + 0.5f), 0, top );
+		q[c][0] = fit[0];
+		q[c][1] = fit[1];
+		q[c][2] = fit[2];
+		if( thorough )
+		{
+			for( i = -1; i <= 1; ++i )
+			for( j = -1; j <= 1; ++j )
+			for( k = -1; k <= 1; ++k )
+			{
+				int o = fit[0] + i, h = fit[1] + j, v = fit[2] + k;
+				unsigned int e;
+				if( (o < 0) || (o > top) || (h < 0) || (h > top) || (v < 0) || (v > top) )
+				{
+					continue;
+				}
+				e = ETC2_planar_channel_error( pixels, c, o, h, v, bits );
+				if( e < best )
+				{
+					best = e;
+					q[c][0] = o;
+					q[c][1] = h;
+					q[c][2] = v;
+				}
+			}
+		} else
+		{
+			best = ETC2_planar_channel_error( pixels, c, fit[0], fit[1], fit[2], bits );
+		}
+		error += best * weights[c];
+		if( error >= best_error )
+		{
+			return best_error;
+		}
+	}
+	high = ((unsigned int)q[0][0] << 25) | ((unsigned int)(q[1][0] >> 6) << 24) |
+			((unsigned int)(q[1][0] & 63) << 17) | ((unsigned int)(q[2][0] >> 5) << 16) |
+			((unsigned int)((q[2][0] >> 3) & 3) << 11) | ((unsigned int)(q[2][0] & 7) << 7) |
+			((unsigned int)(q[0][1] >> 1) << 2) | 2 | (unsigned int)(q[0][1] & 1);
+	low = ((unsigned int)q[1][1] << 25) | ((unsigned int)q[2][1] << 19) |
+			((unsigned int)q[0][2] << 13) | ((unsigned int)q[1][2] << 6) | (unsigned int)q[2][2];
+	if( !ETC2_set_filler_bits( &high, 0x8080E400u, ETC2_MODE_PLANAR ) )
+	{
+		return best_error;
+	}
+	write_big_endian( block, high );
+	write_big_endian( block + 4, low );
+	return error;
+}
+
+/*	the ETC1 encoding, then any of the ETC2 modes that does better	*/
+static void compress_ETC2_RGB_block( const unsigned char pixels[16*3], int quality, unsigned char block[8] )
+{
+	unsigned char candidate[8];
+	unsigned int best_error, error;
+	etc1_encode_block( pixels, 0xFFFF, block );
+	best_error = ETC2_block_error( block, pixels );
+	if( 0 == best_error )
+	{
+		return;
+	}
+	error = ETC2_try_planar_mode( pixels, quality != ETC1_QUALITY_FAST, best_error, candidate );
+	if( error < best_error )
+	{
+		best_error = error;
+		memcpy( block, candidate, 8 );
+	}
+	if( quality != ETC1_QUALITY_FAST )
+	{
+		int means[2][3], count_first;
+		ETC2_split_pixels( pixels, means, &count_first );
+		error = ETC2_try_T_mode( pixels, (const int (*)[3])means, best_error, candidate );
+		if( error < best_error )
+		{
+			best_error = error;
+			memcpy( block, candidate, 8 );
+		}
+		error = ETC2_try_H_mode( pixels, (const int (*)[3])means, best_error, candidate );
+		if( error < best_error )
+		{
+			memcpy( block, candidate, 8 );
+		}
+	}
+}
+
+/*	EAC: a base, a multiplier and a table of 8 modifiers per block.
+	values are 8 bit (alpha) or 11 bit, in rows	*/
+static void compress_EAC_block( const int values[16], int is_11_bit, int quality, unsigned char block[8] )
+{
+	const int unit = is_11_bit ? 8 : 1;
+	unsigned int best_error = 0xFFFFFFFFu;
+	int best_base = 0, best_multiplier = 1, best_table = 0;
+	int lo = values[0], hi = values[0];
+	int indices[16];
+	int t, m, b, i, k;
+	unsigned int first = 0, second = 0;
+	for( i = 1; i < 16; ++i )
+	{
+		lo = (values[i] < lo) ? values[i] : lo;
+		hi = (values[i] > hi) ? values[i] : hi;
+	}
+	for( t = 0; (t < 16) && (best_error > 0); ++t )
+	{
+		const int *modifiers = EAC_modifier_table[t];
+		const int span = modifiers[7] - modifiers[3];
+		/*	the smallest multiplier that covers the range	*/
+		int m0 = clamp_int( (hi - lo + span*unit - 1) / (span*unit), is_11_bit ? 0 : 1, 15 );
+		int m_lo = m0, m_hi = m0;
+		if( quality != ETC1_QUALITY_FAST )
+		{
+			m_lo = m0 - 1;
+			m_hi = m0 + 1;
+		}
+		for( m = m_lo; m <= m_hi; ++m )
+		{
+			int step, b0, b_lo, b_hi;
+			/*	alpha can't use a multiplier of 0	*/
+			if( (m < (is_11_bit ? 0 : 1)) || (m > 15) )
+			{
+				continue;
+			}
+			/*	center the modifiers on the range	*/
+			step = (m > 0) ? m * unit : 1;
+			if( is_11_bit )
+			{
+				b0 = ((lo + hi) - (modifiers[3] + modifiers[7]) * step) / 16;
+			} else
+			{
+				b0 = ((lo + hi) - (modifiers[3] + modifiers[7]) * step + 1) / 2;
+			}
+			b0 = clamp_int( b0, 0, 255 );
+			b_lo = b0;
+			b_hi = b0;
+			if( quality != ETC1_QUALITY_FAST )
+			{
+				b_lo = b0 - 1;
+				b_hi = b0 + 1;
+			}
+			for( b = b_lo; b <= b_hi; ++b )
+			{
+				int decoded[8];
+				unsigned int error = 0;
+				if( (b < 0) || (b > 255) )
+				{
+					continue;
+				}
+				for( k = 0; k < 8; ++k )
+				{
+					decoded[k] = EAC_value( b, m, modifiers[k], is_11_bit );
+				}
+				for( i = 0; (i < 16) && (error < best_error); ++i )
+				{
+					unsigned int best = 0xFFFFFFFFu;
+					for( k = 0; k < 8; ++k )
+					{
+						int d = decoded[k] - values[i];
+						if( (unsigned int)(d*d) < best )
+						{
+							best = (unsigned int)(d*d);
+						}
+					}
+					error += best;
+				}
+				if( error < best_error )
+				{
+					best_error = error;
+					best_base = b;
+					best_multiplier = m;
+					best_table = t;
+				}
+			}
+		}
+	}
+	/*	the indices of the winner	*/
+	for( i = 0; i < 16; ++i )
+	{
+		unsigned int best = 0xFFFFFFFFu;
+		indices[i] = 0;
+		for( k = 0; k < 8; ++k )
+		{
+			int d = EAC_value( best_base, best_multiplier, EAC_modifier_table[best_table][k], is_11_bit ) - values[i];
+			if( (unsigned int)(d*d) < best )
+			{
+				best = (unsigned int)(d*d);
+				indices[i] = k;
+			}
+		}
+	}
+	/*	3 bits per pixel, by columns	*/
+	for( i = 0; i < 8; ++i )
+	{
+		first |= (unsigned int)indices[(i & 3)*4 + (i >> 2)] << (21 - 3*i);
+		second |= (unsigned int)indices[(i & 3)*4 + (i >> 2) + 2] << (21 - 3*i);
+	}
+	block[0] = (unsigned char)best_base;
+	block[1] = (unsigned char)((best_multiplier << 4) | best_table);
+	block[2] = (unsigned char)(first >> 16);
+	block[3] = (unsigned char)(first >> 8);
+	block[4] = (unsigned char)first;
+	block[5] = (unsigned char)(second >> 16);
+	block[6] = (unsigned char)(second >> 8);
+	block[7] = (unsigned char)second;
+}
+
+/********* Whole Images *********/
+typedef struct
+{
+	const unsigned char *uncompressed;
+	unsigned char *compressed;
+	int width, height, channels;
+	unsigned int format;
+	int quality;
+	int keep_sign;
+} ETC2_job;
+
+/*	the 4x4 block at (i,j) as RGBA, repeating the first pixel where
+	the block hangs over the image	*/
+static void gather_ETC2_block( const ETC2_job *job, int i, int j, unsigned char rgba[16*4] )
+{
+	const int channels = job->channels;
+	int x, y, mx = 4, my = 4;
+	if( j+4 >= job->height )
+	{
+		my = job->height - j;
+	}
+	if( i+4 >= job->width )
+	{
+		mx = job->width - i;
+	}
+	for( y = 0; y < 4; ++y )
+	{
+		for( x = 0; x < 4; ++x )
+		{
+			const unsigned char *p = job->uncompressed +
+					((size_t)(j + ((y < my) && (x < mx) ? y : 0)) * job->width +
+					i + ((y < my) && (x < mx) ? x : 0)) * channels;
+			unsigned char *q = rgba + (y*4 + x)*4;
+			switch( channels )
+			{
+			case 1:
+				q[0] = q[1] = q[2] = p[0];
+				q[3] = 255;
+				break;
+			case 2:
+				q[0] = q[1] = q[2] = p[0];
+				q[3] = p[1];
+				break;
+			case 3:
+				q[0] = p[0]; q[1] = p[1]; q[2] = p[2];
+				q[3] = 255;
+				break;
+			default:
+				q[0] = p[0]; q[1] = p[1]; q[2] = p[2];
+				q[3] = p[3];
+				break;
+			}
+		}
+	}
+}
+
+static void ETC2_block_rows( void *context, int row_begin, int row_end )
+{
+	const ETC2_job *job = (const ETC2_job*)context;
+	const int blocks_x = (job->width+3) >> 2;
+	const int block_size = etc2_block_size( job->format );
+	unsigned char rgba[16*4], rgb[16*3];
+	int values[16];
+	int i, j, k;
+	for( j = row_begin; j < row_end; ++j )
+	{
+		unsigned char *out = job->compressed + (size_t)j * blocks_x * block_size;
+		for( i = 0; i < blocks_x; ++i )
+		{
+			gather_ETC2_block( job, i*4, j*4, rgba );
+			switch( job->format )
+			{
+			case ETC2_COMPRESSED_R11_EAC:
+			case ETC2_COMPRESSED_RG11_EAC:
+				/*	R, then G from the second channel (or R again)	*/
+				for( k = 0; k < 16; ++k )
+				{
+					values[k] = (rgba[k*4] * 2047 + 127) / 255;
+				}
+				compress_EAC_block( values, 1, job->quality, out );
+				if( job->format == ETC2_COMPRESSED_RG11_EAC )
+				{
+					for( k = 0; k < 16; ++k )
+					{
+						int g = (job->channels >= 2) ? rgba[k*4 + ((job->channels == 2) ? 3 : 1)] : rgba[k*4];
+						values[k] = (g * 2047 + 127) / 255;
+					}
+					compress_EAC_block( values, 1, job->quality, out + 8 );
+				}
+				break;
+			case ETC2_COMPRESSED_RGBA8_ETC2_EAC:
+			case ETC2_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+				for( k = 0; k < 16; ++k )
+				{
+					values[k] = rgba[k*4+3];
+				}
+				compress_EAC_block( values, 0, job->quality, out );
+				/*	and the color after the alpha	*/
+				for( k = 0; k < 16; ++k )
+				{
+					rgb[k*3+0] = rgba[k*4+0];
+					rgb[k*3+1] = rgba[k*4+1];
+					rgb[k*3+2] = rgba[k*4+2];
+				}
+				compress_ETC2_RGB_block( rgb, job->quality, out + 8 );
+				break;
+			default:
+				for( k = 0; k < 16; ++k )
+				{
+					rgb[k*3+0] = rgba[k*4+0];
+					rgb[k*3+1] = rgba[k*4+1];
+					rgb[k*3+2] = rgba[k*4+2];
+				}
+				compress_ETC2_RGB_block( rgb, job->quality, out );
+				break;
+			}
+			out += block_size;
+		}
+	}
+}
+
+static void ETC2_decode_rows( void *context, int row_begin, int row_end )
+{
+	const ETC2_job *job = (const ETC2_job*)context;
+	const int blocks_x = (job->width+3) >> 2;
+	const int block_size = etc2_block_size( job->format );
+	const int channels = etc2_decoded_channels( job->format );
+	const int is_signed = (job->format == ETC2_COMPRESSED_SIGNED_R11_EAC) ||
+			(job->format == ETC2_COMPRESSED_SIGNED_RG11_EAC);
+	unsigned char pixels[16*4], rgb[16*3];
+	int values[16];
+	int i, j, k, x, y;
+	for( j = row_begin; j < row_end; ++j )
+	{
+		const unsigned char *in = job->uncompressed + (size_t)j * blocks_x * block_size;
+		for( i = 0; i < blocks_x; ++i )
+		{
+			switch( job->format )
+			{
+			case ETC2_COMPRESSED_R11_EAC:
+			case ETC2_COMPRESSED_SIGNED_R11_EAC:
+			case ETC2_COMPRESSED_RG11_EAC:
+			case ETC2_COMPRESSED_SIGNED_RG11_EAC:
+				for( k = 0; k < channels; ++k )
+				{
+					int n;
+					decode_EAC_block( in + 8*k, 11, is_signed, values );
+					for( n = 0; n < 16; ++n )
+					{
+						pixels[n*channels + k] = (is_signed && job->keep_sign) ?
+								EAC_to_signed_8_bits( values[n] ) : EAC_to_8_bits( values[n], is_signed );
+					}
+				}
+				break;
+			case ETC2_COMPRESSED_RGBA8_ETC2_EAC:
+			case ETC2_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+				decode_EAC_block( in, 8, 0, values );
+				decode_ETC2_RGB_block( in + 8, rgb );
+				for( k = 0; k < 16; ++k )
+				{
+					pixels[k*4+0] = rgb[k*3+0];
+					pixels[k*4+1] = rgb[k*3+1];
+					pixels[k*4+2] = rgb[k*3+2];
+					pixels[k*4+3] = (unsigned char)values[k];
+				}
+				break;
+			default:
+				decode_ETC2_RGB_block( in, pixels );
+				break;
+			}
+			/*	copy out the part of the block inside the image	*/
+			for( y = 0; (y < 4) && (j*4 + y < job->height); ++y )
+			{
+				for( x = 0; (x < 4) && (i*4 + x < job->width); ++x )
+				{
+					memcpy( job->compressed + ((size_t)(j*4 + y) * job->width + i*4 + x) * channels,
+							pixels + (y*4 + x) * channels, channels );
+				}
+			}
+			in += block_size;
+		}
+	}
+}
+
+/********* Actual Exposed Functions *********/
+int
+	etc2_block_size
+	(
+		unsigned int format
+	)
+{
+	switch( format )
+	{
+	case ETC2_COMPRESSED_R11_EAC:
+	case ETC2_COMPRESSED_SIGNED_R11_EAC:
+	case ETC2_COMPRESSED_RGB8_ETC2:
+	case ETC2_COMPRESSED_SRGB8_ETC2:
+	case ETC1_RGB8_OES:
+		return 8;
+	case ETC2_COMPRESSED_RG11_EAC:
+	case ETC2_COMPRESSED_SIGNED_RG11_EAC:
+	case ETC2_COMPRESSED_RGBA8_ETC2_EAC:
+	case ETC2_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+		return 16;
+	}
+	return 0;
+}
+
+int
+	etc2_decoded_channels
+	(
+		unsigned int format
+	)
+{
+	switch( format )
+	{
+	case ETC2_COMPRESSED_R11_EAC:
+	case ETC2_COMPRESSED_SIGNED_R11_EAC:
+		return 1;
+	case ETC2_COMPRESSED_RG11_EAC:
+	case ETC2_COMPRESSED_SIGNED_RG11_EAC:
+		return 2;
+	case ETC2_COMPRESSED_RGBA8_ETC2_EAC:
+	case ETC2_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+		return 4;
+	}
+	return 3;
+}
+
+int
+	etc2_get_encoded_data_size
+	(
+		unsigned int format,
+		int width, int height
+	)
+{
+	return ((width+3) >> 2) * ((height+3) >> 2) * etc2_block_size( format );
+}
+
+unsigned char*
+	convert_image_to_ETC2
+	(
+		const unsigned char *const uncompressed,
+		int width, int height, int channels,
+		unsigned int format,
+		int quality,
+		int *out_size
+	)
+{
+	ETC2_job job;
+	/*	error check	*/
+	*out_size = 0;
+	if( (width < 1) || (height < 1) ||
+		(NULL == uncompressed) ||
+		(channels < 1) || (channels > 4) ||
+		(format == ETC1_RGB8_OES) ||
+		(format == ETC2_COMPRESSED_SIGNED_R11_EAC) ||
+		(format == ETC2_COMPRESSED_SIGNED_RG11_EAC) ||
+		(0 == etc2_block_size( format )) )
+	{
+		return NULL;
+	}
+	soil_zone_begin( "SOIL2::ETC2" );
+	*out_size = etc2_get_encoded_data_size( format, width, height );
+	job.uncompressed = uncompressed;
+	job.width = width;
+	job.height = height;
+	job.channels = channels;
+	job.format = format;
+	job.quality = quality;
+	job.keep_sign = 0;
+	job.compressed = (unsigned char*)malloc( *out_size );
+	/*	compress the rows of blocks straight into place	*/
+	if( NULL != job.compressed )
+	{
+		soil_parallel_for( ETC2_block_rows, &job, (height+3) >> 2, ETC2_GRAIN );
+	}
+	soil_zone_end();
+	return job.compressed;
+}
+
+static int ETC2_decode( const unsigned char *const compressed, unsigned int format,
+		int width, int height, unsigned char *decompressed, int keep_sign )
+{
+	ETC2_job job;
+	/*	error check	*/
+	if( (width < 1) || (height < 1) ||
+		(NULL == compressed) || (NULL == decompressed) ||
+		(0 == etc2_block_size( format )) )
+	{
+		return 0;
+	}
+	soil_zone_begin( "SOIL2::ETC2Decode" );
+	job.uncompressed = compressed;
+	job.compressed = decompressed;
+	job.width = width;
+	job.height = height;
+	job.channels = etc2_decoded_channels( format );
+	job.format = format;
+	job.quality = 0;
+	job.keep_sign = keep_sign;
+	soil_parallel_for( ETC2_decode_rows, &job, (height+3) >> 2, ETC2_GRAIN );
+	soil_zone_end();
+	return 1;
+}
+
+int
+	etc2_decode_image
+	(
+		const unsigned char *const compressed,
+		unsigned int format,
+		int width, int height,
+		unsigned char *decompressed
+	)
+{
+	return ETC2_decode( compressed, format, width, height, decompressed, 0 );
+}
+
+int
+	etc2_decode_image_signed
+	(
+		const unsigned char *const compressed,
+		unsigned int format,
+		int width, int height,
+		unsigned char *decompressed
+	)
+{
+	return ETC2_decode( compressed, format, width, height, decompressed, 1 );
+}
+
+unsigned int
+	etc2_pkm_get_format
+	(
+		const unsigned char *const header
+	)
+{
+	if( NULL == header )
+	{
+		return 0;
+	}
+	if( 0 == memcmp( header, "PKM 10", 6 ) )
+	{
+		return ETC1_RGB8_OES;
+	}
+	if( 0 != memcmp( header, "PKM 20", 6 ) )
+	{
+		return 0;
+	}
+	switch( (header[6] << 8) | header[7] )
+	{
+	case PKM_FORMAT_ETC1_RGB:
+		return ETC1_RGB8_OES;
+	case PKM_FORMAT_ETC2_RGB:
+		return ETC2_COMPRESSED_RGB8_ETC2;
+	case PKM_FORMAT_ETC2_RGBA_OLD:
+	case PKM_FORMAT_ETC2_RGBA:
+		return ETC2_COMPRESSED_RGBA8_ETC2_EAC;
+	case PKM_FORMAT_EAC_R:
+		return ETC2_COMPRESSED_R11_EAC;
+	case PKM_FORMAT_EAC_RG:
+		return ETC2_COMPRESSED_RG11_EAC;
+	case PKM_FORMAT_EAC_R_SIGNED:
+		return ETC2_COMPRESSED_SIGNED_R11_EAC;
+	case PKM_FORMAT_EAC_RG_SIGNED:
+		return ETC2_COMPRESSED_SIGNED_RG11_EAC;
+	case PKM_FORMAT_ETC2_SRGB:
+		return ETC2_COMPRESSED_SRGB8_ETC2;
+	case PKM_FORMAT_ETC2_SRGBA:
+		return ETC2_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC;
+	}
+	/*	the punch-through alpha formats aren't supported	*/
+	return 0;
+}
+
+void
+	etc2_pkm_format_header
+	(
+		unsigned char *header,
+		unsigned int format,
+		int width, int height
+	)
+{
+	int pkm_format;
+	switch( format )
+	{
+	case ETC2_COMPRESSED_RGB8_ETC2:			pkm_format = PKM_FORMAT_ETC2_RGB; break;
+	case ETC2_COMPRESSED_SRGB8_ETC2:		pkm_format = PKM_FORMAT_ETC2_SRGB; break;
+	case ETC2_COMPRESSED_RGBA8_ETC2_EAC:	pkm_format = PKM_FORMAT_ETC2_RGBA; break;
+	case ETC2_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:	pkm_format = PKM_FORMAT_ETC2_SRGBA; break;
+	case ETC2_COMPRESSED_R11_EAC:			pkm_format = PKM_FORMAT_EAC_R; break;
+	case ETC2_COMPRESSED_RG11_EAC:			pkm_format = PKM_FORMAT_EAC_RG; break;
+	case ETC2_COMPRESSED_SIGNED_R11_EAC:	pkm_format = PKM_FORMAT_EAC_R_SIGNED; break;
+	case ETC2_COMPRESSED_SIGNED_RG11_EAC:	pkm_format = PKM_FORMAT_EAC_RG_SIGNED; break;
+	default:
+		/*	plain ETC1	*/
+		etc1_pkm_format_header( header, width, height );
+		return;
+	}
+	memcpy( header, "PKM 20", 6 );
+	header[6] = (unsigned char)(pkm_format >> 8);
+	header[7] = (unsigned char)pkm_format;
+	header[8] = (unsigned char)(((width+3) & ~3) >> 8);
+	header[9] = (unsigned char)((width+3) & ~3);
+	header[10] = (unsigned char)(((height+3) & ~3) >> 8);
+	header[11] = (unsigned char)((height+3) & ~3);
+	header[12] = (unsigned char)(width >> 8);
+	header[13] = (unsigned char)width;
+	header[14] = (unsigned char)(height >> 8);
+	header[15] = (unsigned char)height;
+}
+
+int
+	save_image_as_PKM
+	(
+		const char *filename,
+		int width, int height, int channels,
+		const unsigned char *const data,
+		unsigned int format,
+		int quality
+	)
+{
+	unsigned char header[PKM_HEADER_SIZE];
+	unsigned char *PKM_data;
+	int PKM_size;
+	FILE *fout;
+	/*	error check, the header holds 16 bit sizes	*/
+	if( (NULL == filename) ||
+		(width < 1) || (height < 1) ||
+		(width > 65535) || (height > 65535) ||
+		(channels < 1) || (channels > 4) ||
+		(data == NULL ) )
+	{
+		return 0;
+	}
+	if( format == ETC1_RGB8_OES )
+	{
+		/*	the ETC1 encoder wants tightly packed RGB	*/
+		unsigned char *rgb = (unsigned char*)malloc( (size_t)width * height * 3 );
+		int i;
+		if( NULL == rgb )
+		{
+			return 0;
+		}
+		for( i = 0; i < width*height; ++i )
+		{
+			const unsigned char *p = data + (size_t)i * channels;
+			rgb[i*3+0] = p[0];
+			rgb[i*3+1] = (channels >= 3) ? p[1] : p[0];
+			rgb[i*3+2] = (channels >= 3) ? p[2] : p[0];
+		}
+		PKM_size = (int)etc1_get_encoded_data_size( width, height );
+		PKM_data = (unsigned char*)malloc( PKM_size );
+		if( NULL != PKM_data )
+		{
+			etc1_encode_image_quality( rgb, width, height, 3, width*3, PKM_data, quality );
+		}
+		free( rgb );
+	} else
+	{
+		PKM_data = convert_image_to_ETC2( data, width, height, channels, format, quality, &PKM_size );
+	}
+	if( NULL == PKM_data )
+	{
+		return 0;
+	}
+	etc2_pkm_format_header( header, format, width, height );
+	fout = fopen( filename, "wb" );
+	if( NULL == fout )
+	{
+		free( PKM_data );
+		return 0;
+	}
+	fwrite( header, 1, PKM_HEADER_SIZE, fout );
+	fwrite( PKM_data, 1, PKM_size, fout );
+	fclose( fout );
+	free( PKM_data );
+	return 1;
+}
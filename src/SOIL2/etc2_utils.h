@@ -0,0 +1,150 @@
+/*
+	ETC2 and EAC compression / decompression code
+
+	ETC2 RGB8, ETC2 RGBA8 (EAC alpha) and EAC R11 / RG11,
+	as the OpenGL ES 3.0 formats of the same names.
+
+	Public Domain
+*/
+
+#ifndef HEADER_ETC2_UTILS
+#define HEADER_ETC2_UTILS
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+	The formats, named by their OpenGL internal formats.
+	The sRGB and signed ones are only decoded; the encoder
+	writes sRGB blocks the same as the linear ones.
+**/
+#define ETC2_COMPRESSED_R11_EAC					0x9270
+#define ETC2_COMPRESSED_SIGNED_R11_EAC			0x9271
+#define ETC2_COMPRESSED_RG11_EAC				0x9272
+#define ETC2_COMPRESSED_SIGNED_RG11_EAC			0x9273
+#define ETC2_COMPRESSED_RGB8_ETC2				0x9274
+#define ETC2_COMPRESSED_SRGB8_ETC2				0x9275
+#define ETC2_COMPRESSED_RGBA8_ETC2_EAC			0x9278
+#define ETC2_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC	0x9279
+
+/**
+	Bytes per 4x4 block of the format (8 or 16), 0 if it is
+	not one of the formats above.
+**/
+int
+	etc2_block_size
+	(
+		unsigned int format
+	);
+
+/**
+	Channels of the image etc2_decode_image writes for the
+	format: 1 for R11, 2 for RG11, 3 for RGB8, 4 for RGBA8.
+**/
+int
+	etc2_decoded_channels
+	(
+		unsigned int format
+	);
+
+/**
+	Size of the compressed image, without any file header.
+**/
+int
+	etc2_get_encoded_data_size
+	(
+		unsigned int format,
+		int width, int height
+	);
+
+/**
+	take an image and convert it to one of the formats above.
+	RGB8 uses the color channels (gray for 1 or 2 channels),
+	RGBA8 adds the alpha channel (opaque for 1 or 3 channels),
+	R11 takes the first channel and RG11 the first two.
+	\param quality ETC1_QUALITY_FAST or ETC1_QUALITY_THOROUGH
+**/
+unsigned char*
+	convert_image_to_ETC2
+	(
+		const unsigned char *const uncompressed,
+		int width, int height, int channels,
+		unsigned int format,
+		int quality,
+		int *out_size
+	);
+
+/**
+	Decodes a compressed image into etc2_decoded_channels( format )
+	unsigned chars per pixel.  The 11 bit channels are rounded to 8.
+	\return 0 if failed, otherwise returns 1
+**/
+int
+	etc2_decode_image
+	(
+		const unsigned char *const compressed,
+		unsigned int format,
+		int width, int height,
+		unsigned char *decompressed
+	);
+
+/**
+	As etc2_decode_image, but the signed EAC formats decode to
+	signed chars, -127 to 127 as GL_R8_SNORM and GL_RG8_SNORM
+	read them, instead of being offset to 0 to 255.
+	\return 0 if failed, otherwise returns 1
+**/
+int
+	etc2_decode_image_signed
+	(
+		const unsigned char *const compressed,
+		unsigned int format,
+		int width, int height,
+		unsigned char *decompressed
+	);
+
+/**
+	The format of the image after a PKM 10 or PKM 20 header,
+	ETC1_RGB8_OES for ETC1 data, 0 if the header isn't valid
+	or holds a format this code can't read.
+**/
+unsigned int
+	etc2_pkm_get_format
+	(
+		const unsigned char *const header
+	);
+
+/**
+	Writes a PKM header for the format: PKM 10 for ETC1_RGB8_OES,
+	PKM 20 for the formats above.
+**/
+void
+	etc2_pkm_format_header
+	(
+		unsigned char *header,
+		unsigned int format,
+		int width, int height
+	);
+
+/**
+	Converts an image from an array of unsigned chars to
+	the format, ETC1_RGB8_OES included, then saves it to
+	disk as a PKM file.
+	\return 0 if failed, otherwise returns 1
+**/
+int
+	save_image_as_PKM
+	(
+		const char *filename,
+		int width, int height, int channels,
+		const unsigned char *const data,
+		unsigned int format,
+		int quality
+	);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEADER_ETC2_UTILS	*/
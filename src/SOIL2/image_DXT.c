@@ -8,10 +8,14 @@
 */
 
 #include "image_DXT.h"
+#include "parallel_helper.h"
+#include "profile_helper.h"
+#include "simd_helper.h"
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <float.h>
 
 /*	set this =1 if you want to use the covarince matrix method...
 	which is better than my method of using standard deviations
@@ -37,6 +41,120 @@ void compress_DDS_color_block(
 void compress_DDS_alpha_block(
 				const unsigned char *const uncompressed,
 				unsigned char compressed[8] );
+/*
+	The same for DXT_MODE_RANGE_FIT: end points from the corners
+	of the block's bounding box, for speed over everything else.
+*/
+void compress_DDS_color_block_range_fit(
+				int channels,
+				const unsigned char *const uncompressed,
+				unsigned char compressed[8] );
+/*
+	And for DXT_MODE_CLUSTER_FIT: the best of the least squares
+	end points over all ways of splitting the pixels, ordered
+	along the principal axis, into the 4 colors of the block.
+	Never worse than compress_DDS_color_block or the range fit,
+	and much slower.
+*/
+void compress_DDS_color_block_cluster_fit(
+				int channels,
+				const unsigned char *const uncompressed,
+				unsigned char compressed[8] );
+/*
+	Alpha with each value rounded to the nearest of the 8 levels,
+	where compress_DDS_alpha_block rounds down.
+*/
+void compress_DDS_alpha_block_nearest(
+				const unsigned char *const uncompressed,
+				unsigned char compressed[8] );
+/*
+	Takes a 4x4 block of RGBA pixels and compresses it into 16 bytes
+	of BC7, as mode 6 (RGBA end points, 16 levels) or, for blocks
+	with an alpha of their own, mode 5 (separate RGB and alpha).
+*/
+void compress_BC7_block(
+				int mode,
+				const unsigned char *const uncompressed,
+				unsigned char compressed[16] );
+/*
+	Takes a 4x4 block of RGB floats and compresses it into 16 bytes
+	of BC6H, unsigned or signed, using mode 11: one pair of 10 bit
+	end points and 16 levels between them.
+*/
+void compress_BC6H_block(
+				int mode, int is_signed,
+				const float *const uncompressed,
+				unsigned char compressed[16] );
+
+/*	the vector encoder gives the same blocks as the C code, which
+	needs the C code to round every float operation to float.
+	There is only an AVX2 version: a 4 wide SSE4.1 copy would double
+	the code for CPUs old enough to do without, so anything below
+	SOIL_SIMD_AVX2 uses the C encoder.	*/
+#if defined( SOIL_SIMD_X86 ) && defined( FLT_EVAL_METHOD ) && ( FLT_EVAL_METHOD == 0 )
+	#define SOIL_DXT_SIMD
+/*
+	Compress the color or the alpha of 8 blocks at once with AVX2,
+	for DXT_MODE_DEFAULT and DXT_MODE_RANGE_FIT.
+*/
+SOIL_TARGET_AVX2
+static void compress_DDS_color_blocks_avx2(
+				const unsigned char pixels[16*3][8],
+				unsigned char *compressed, int stride );
+SOIL_TARGET_AVX2
+static void compress_DDS_alpha_blocks_avx2(
+				const unsigned char alpha[16][8],
+				unsigned char *compressed, int stride );
+SOIL_TARGET_AVX2
+static void compress_DDS_color_blocks_range_fit_avx2(
+				const unsigned char pixels[16*3][8],
+				unsigned char *compressed, int stride );
+#endif
+
+/*	writes the DDS header (with the DX10 one when dxgi_format is set, in
+	which case fourCC is ignored) followed by the compressed data	*/
+static int write_DDS_file( const char *filename, int width, int height,
+		unsigned int fourCC, unsigned int dxgi_format,
+		const unsigned char *DDS_data, int DDS_size )
+{
+	FILE *fout;
+	DDS_header header;
+	DDS_header_DXT10 header10;
+	memset( &header, 0, sizeof( DDS_header ) );
+	header.dwMagic = ('D' << 0) | ('D' << 8) | ('S' << 16) | (' ' << 24);
+	header.dwSize = 124;
+	header.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE;
+	header.dwWidth = width;
+	header.dwHeight = height;
+	header.dwPitchOrLinearSize = DDS_size;
+	header.sPixelFormat.dwSize = 32;
+	header.sPixelFormat.dwFlags = DDPF_FOURCC;
+	header.sPixelFormat.dwFourCC = fourCC;
+	if( 0 != dxgi_format )
+	{
+		/*	the BC4/5/6H/7 formats only have a DXGI name	*/
+		header.sPixelFormat.dwFourCC = ('D' << 0) | ('X' << 8) | ('1' << 16) | ('0' << 24);
+		memset( &header10, 0, sizeof( DDS_header_DXT10 ) );
+		header10.dxgiFormat = dxgi_format;
+		header10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+		header10.arraySize = 1;
+	}
+	header.sCaps.dwCaps1 = DDSCAPS_TEXTURE;
+	/*	write it out	*/
+	fout = fopen( filename, "wb");
+	if( NULL == fout )
+	{
+		return 0;
+	}
+	fwrite( &header, sizeof( DDS_header ), 1, fout );
+	if( 0 != dxgi_format )
+	{
+		fwrite( &header10, sizeof( DDS_header_DXT10 ), 1, fout );
+	}
+	fwrite( DDS_data, 1, DDS_size, fout );
+	fclose( fout );
+	return 1;
+}
 
 /********* Actual Exposed Functions *********/
 int
@@ -44,14 +162,15 @@ int
 	(
 		const char *filename,
 		int width, int height, int channels,
-		const unsigned char *const data
+		const unsigned char *const data,
+		int format,
+		int mode
 	)
 {
 	/*	variables	*/
-	FILE *fout;
 	unsigned char *DDS_data;
-	DDS_header header;
-	int DDS_size;
+	DDS_header_DXT10 header10;
+	int DDS_size, ret;
 	/*	error check	*/
 	if( (NULL == filename) ||
 		(width < 1) || (height < 1) ||
@@ -61,254 +180,676 @@ int
 		return 0;
 	}
 	/*	Convert the image	*/
-	if( (channels & 1) == 1 )
+	memset( &header10, 0, sizeof( DDS_header_DXT10 ) );
+	switch( format )
 	{
-		/*	no alpha, just use DXT1	*/
-		DDS_data = convert_image_to_DXT1( data, width, height, channels, &DDS_size );
-	} else
+	case DDS_FORMAT_BC4:
+		DDS_data = convert_image_to_BC4( data, width, height, channels, mode, &DDS_size );
+		header10.dxgiFormat = DXGI_FORMAT_BC4_UNORM;
+		break;
+	case DDS_FORMAT_BC5:
+		DDS_data = convert_image_to_BC5( data, width, height, channels, mode, &DDS_size );
+		header10.dxgiFormat = DXGI_FORMAT_BC5_UNORM;
+		break;
+	case DDS_FORMAT_BC7:
+		DDS_data = convert_image_to_BC7( data, width, height, channels, mode, &DDS_size );
+		header10.dxgiFormat = DXGI_FORMAT_BC7_UNORM;
+		break;
+	default:
+		if( (channels & 1) == 1 )
+		{
+			/*	no alpha, just use DXT1	*/
+			DDS_data = convert_image_to_DXT1( data, width, height, channels, mode, &DDS_size );
+		} else
+		{
+			/*	has alpha, so use DXT5	*/
+			DDS_data = convert_image_to_DXT5( data, width, height, channels, mode, &DDS_size );
+		}
+		break;
+	}
+	if( NULL == DDS_data )
 	{
-		/*	has alpha, so use DXT5	*/
-		DDS_data = convert_image_to_DXT5( data, width, height, channels, &DDS_size );
+		return 0;
 	}
 	/*	save it	*/
-	memset( &header, 0, sizeof( DDS_header ) );
-	header.dwMagic = ('D' << 0) | ('D' << 8) | ('S' << 16) | (' ' << 24);
-	header.dwSize = 124;
-	header.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE;
-	header.dwWidth = width;
-	header.dwHeight = height;
-	header.dwPitchOrLinearSize = DDS_size;
-	header.sPixelFormat.dwSize = 32;
-	header.sPixelFormat.dwFlags = DDPF_FOURCC;
+	if( 0 != header10.dxgiFormat )
+	{
+		ret = write_DDS_file( filename, width, height, 0, header10.dxgiFormat, DDS_data, DDS_size );
+	} else
 	if( (channels & 1) == 1 )
 	{
-		header.sPixelFormat.dwFourCC = ('D' << 0) | ('X' << 8) | ('T' << 16) | ('1' << 24);
+		ret = write_DDS_file( filename, width, height,
+				('D' << 0) | ('X' << 8) | ('T' << 16) | ('1' << 24), 0, DDS_data, DDS_size );
 	} else
 	{
-		header.sPixelFormat.dwFourCC = ('D' << 0) | ('X' << 8) | ('T' << 16) | ('5' << 24);
+		ret = write_DDS_file( filename, width, height,
+				('D' << 0) | ('X' << 8) | ('T' << 16) | ('5' << 24), 0, DDS_data, DDS_size );
 	}
-	header.sCaps.dwCaps1 = DDSCAPS_TEXTURE;
-	/*	write it out	*/
-	fout = fopen( filename, "wb");
-	fwrite( &header, sizeof( DDS_header ), 1, fout );
-	fwrite( DDS_data, 1, DDS_size, fout );
-	fclose( fout );
 	/*	done	*/
 	free( DDS_data );
-	return 1;
+	return ret;
 }
 
-unsigned char* convert_image_to_DXT1(
-		const unsigned char *const uncompressed,
+int
+	save_image_as_DDS_BC6H
+	(
+		const char *filename,
 		int width, int height, int channels,
-		int *out_size )
+		const float *const data,
+		int mode
+	)
 {
-	unsigned char *compressed;
-	int i, j, x, y;
-	unsigned char ublock[16*3];
-	unsigned char cblock[8];
-	int index = 0, chan_step = 1;
-	int block_count = 0;
+	unsigned char *DDS_data;
+	int DDS_size, is_signed = 0, ret, i;
 	/*	error check	*/
-	*out_size = 0;
-	if( (width < 1) || (height < 1) ||
-		(NULL == uncompressed) ||
-		(channels < 1) || (channels > 4) )
+	if( (NULL == filename) ||
+		(width < 1) || (height < 1) ||
+		(channels < 1) || (channels > 4) ||
+		(data == NULL ) )
 	{
-		return NULL;
+		return 0;
+	}
+	/*	only pay for the signed format if there is something negative	*/
+	for( i = 0; i < width*height*channels; ++i )
+	{
+		if( data[i] < 0.0f )
+		{
+			is_signed = 1;
+			break;
+		}
+	}
+	DDS_data = convert_image_to_BC6H( data, width, height, channels, is_signed, mode, &DDS_size );
+	if( NULL == DDS_data )
+	{
+		return 0;
 	}
+	ret = write_DDS_file( filename, width, height, 0,
+			is_signed ? DXGI_FORMAT_BC6H_SF16 : DXGI_FORMAT_BC6H_UF16,
+			DDS_data, DDS_size );
+	free( DDS_data );
+	return ret;
+}
+
+/*	rows of 4x4 blocks per parallel job	*/
+#define SOIL_DXT_GRAIN 4
+
+typedef struct
+{
+	const unsigned char *uncompressed;
+	/*	BC6H compresses floats instead	*/
+	const float *uncompressed_float;
+	int width, height, channels;
+	unsigned char *compressed;
+	int mode;
+	int simd;
+	int is_signed;
+} DXT_job;
+
+/*
+	Copies the 4x4 block at (i,j) into ublock as RGB (or RGBA,
+	with alpha 255 for images without), repeating the first pixel
+	where the block hangs over the edge of the image.
+*/
+static void gather_DXT_block(
+		const DXT_job *job,
+		int i, int j, int out_channels,
+		unsigned char *ublock )
+{
+	const int width = job->width;
+	const int channels = job->channels;
 	/*	for channels == 1 or 2, I do not step forward for R,G,B values	*/
-	if( channels < 3 )
+	const int chan_step = (channels < 3) ? 0 : 1;
+	/*	# channels = 1 or 3 have no alpha, 2 & 4 do have alpha	*/
+	const int has_alpha = 1 - (channels & 1);
+	int x, y, c;
+	int idx = 0;
+	int mx = 4, my = 4;
+	if( j+4 >= job->height )
 	{
-		chan_step = 0;
+		my = job->height - j;
 	}
-	/*	get the RAM for the compressed image
-		(8 bytes per 4x4 pixel block)	*/
-	*out_size = ((width+3) >> 2) * ((height+3) >> 2) * 8;
-	compressed = (unsigned char*)malloc( *out_size );
-	/*	go through each block	*/
-	for( j = 0; j < height; j += 4 )
+	if( i+4 >= width )
 	{
-		for( i = 0; i < width; i += 4 )
+		mx = width - i;
+	}
+	for( y = 0; y < my; ++y )
+	{
+		const unsigned char *row = job->uncompressed + ((j+y)*width + i)*channels;
+		for( x = 0; x < mx; ++x )
 		{
-			/*	copy this block into a new one	*/
-			int idx = 0;
-			int mx = 4, my = 4;
-			if( j+4 >= height )
+			ublock[idx++] = row[x*channels];
+			ublock[idx++] = row[x*channels+chan_step];
+			ublock[idx++] = row[x*channels+chan_step+chan_step];
+			if( 4 == out_channels )
 			{
-				my = height - j;
+				ublock[idx++] =
+					has_alpha * row[x*channels+channels-1]
+					+ (1-has_alpha)*255;
 			}
-			if( i+4 >= width )
+		}
+		for( x = mx; x < 4; ++x )
+		{
+			for( c = 0; c < out_channels; ++c )
 			{
-				mx = width - i;
+				ublock[idx++] = ublock[c];
 			}
-			for( y = 0; y < my; ++y )
+		}
+	}
+	for( y = my; y < 4; ++y )
+	{
+		for( x = 0; x < 4; ++x )
+		{
+			for( c = 0; c < out_channels; ++c )
 			{
-				for( x = 0; x < mx; ++x )
-				{
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels];
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels+chan_step];
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels+chan_step+chan_step];
-				}
-				for( x = mx; x < 4; ++x )
-				{
-					ublock[idx++] = ublock[0];
-					ublock[idx++] = ublock[1];
-					ublock[idx++] = ublock[2];
-				}
+				ublock[idx++] = ublock[c];
+			}
+		}
+	}
+}
+
+#if defined( SOIL_DXT_SIMD )
+/*
+	The inside of an RGB or RGBA image, 4 bytes per pixel gathered
+	for 8 blocks at once, split into channels with a byte shuffle.
+	Returns 0 for what it can't do.
+*/
+SOIL_TARGET_AVX2
+static int gather_DXT_lanes_avx2( const DXT_job *job, int i, int j,
+		unsigned char pixels[16*3][8], unsigned char alpha[16][8] )
+{
+	const int channels = job->channels;
+	/*	in each 128 bit lane, the 4 reds, then greens, blues and alphas	*/
+	const __m256i split = _mm256_setr_epi8(
+			0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+			0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15 );
+	const __m256i lanes = _mm256_setr_epi32( 0, 4, 1, 5, 2, 6, 3, 7 );
+	const __m256i offsets = _mm256_mullo_epi32( _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ),
+			_mm256_set1_epi32( 4*channels ) );
+	__m256i opaque = _mm256_setzero_si256();
+	int x, y;
+	if( (channels < 3) ||
+		/*	the 4th byte of the last RGB pixel would be past the end	*/
+		((3 == channels) && ((i+8)*4 == job->width) && ((j+1)*4 == job->height)) )
+	{
+		return 0;
+	}
+	if( 3 == channels )
+	{
+		opaque = _mm256_set1_epi32( 0xFF000000 );
+	}
+	for( y = 0; y < 4; ++y )
+	{
+		const unsigned char *row = job->uncompressed + ((j*4+y)*job->width + i*4)*channels;
+		for( x = 0; x < 4; ++x )
+		{
+			const int p = y*4 + x;
+			__m256i v = _mm256_i32gather_epi32( (const int*)(row + x*channels), offsets, 1 );
+			/*	RGB reads one byte of the next pixel, make it alpha 255	*/
+			v = _mm256_or_si256( opaque, v );
+			v = _mm256_permutevar8x32_epi32( _mm256_shuffle_epi8( v, split ), lanes );
+			/*	8 reds, 8 greens, 8 blues, 8 alphas	*/
+			_mm_storeu_si128( (__m128i*)pixels[p*3], _mm256_castsi256_si128( v ) );
+			_mm_storel_epi64( (__m128i*)pixels[p*3+2], _mm256_extracti128_si256( v, 1 ) );
+			if( NULL != alpha )
+			{
+				_mm_storel_epi64( (__m128i*)alpha[p], _mm_srli_si128( _mm256_extracti128_si256( v, 1 ), 8 ) );
 			}
-			for( y = my; y < 4; ++y )
+		}
+	}
+	return 1;
+}
+
+/*
+	Gathers the 8 blocks from (i,j) on transposed, so channel c of
+	pixel p of block k is at pixels[p*3+c][k] (and its alpha, when
+	wanted, at alpha[p][k]).  Blocks inside the image are read
+	straight from it, the ones on an edge go through gather_DXT_block.
+*/
+static void gather_DXT_lanes( const DXT_job *job, int i, int j,
+		unsigned char pixels[16*3][8], unsigned char alpha[16][8] )
+{
+	const int channels = job->channels;
+	const int out_channels = (NULL != alpha) ? 4 : 3;
+	int k, p, x, y;
+	if( ((i+8)*4 <= job->width) && ((j+1)*4 <= job->height) &&
+		gather_DXT_lanes_avx2( job, i, j, pixels, alpha ) )
+	{
+		return;
+	}
+	if( ((i+8)*4 <= job->width) && ((j+1)*4 <= job->height) )
+	{
+		const int chan_step = (channels < 3) ? 0 : 1;
+		for( y = 0; y < 4; ++y )
+		{
+			const unsigned char *row = job->uncompressed + ((j*4+y)*job->width + i*4)*channels;
+			for( k = 0; k < 8; ++k )
 			{
 				for( x = 0; x < 4; ++x )
 				{
-					ublock[idx++] = ublock[0];
-					ublock[idx++] = ublock[1];
-					ublock[idx++] = ublock[2];
+					const unsigned char *px = row + (k*4+x)*channels;
+					p = y*4 + x;
+					pixels[p*3+0][k] = px[0];
+					pixels[p*3+1][k] = px[chan_step];
+					pixels[p*3+2][k] = px[chan_step+chan_step];
+					if( NULL != alpha )
+					{
+						alpha[p][k] = (channels & 1) ? 255 : px[channels-1];
+					}
 				}
 			}
-			/*	compress the block	*/
-			++block_count;
-			compress_DDS_color_block( 3, ublock, cblock );
-			/*	copy the data from the block into the main block	*/
-			for( x = 0; x < 8; ++x )
+		}
+	} else
+	{
+		unsigned char ublock[16*4];
+		for( k = 0; k < 8; ++k )
+		{
+			gather_DXT_block( job, (i+k)*4, j*4, out_channels, ublock );
+			for( p = 0; p < 16; ++p )
 			{
-				compressed[index++] = cblock[x];
+				pixels[p*3+0][k] = ublock[p*out_channels+0];
+				pixels[p*3+1][k] = ublock[p*out_channels+1];
+				pixels[p*3+2][k] = ublock[p*out_channels+2];
+				if( NULL != alpha )
+				{
+					alpha[p][k] = ublock[p*4+3];
+				}
 			}
 		}
 	}
-	return compressed;
 }
+#endif
 
-unsigned char* convert_image_to_DXT5(
-		const unsigned char *const uncompressed,
-		int width, int height, int channels,
-		int *out_size )
+static void compress_DXT_color( const DXT_job *job, int channels,
+		const unsigned char *ublock, unsigned char *out )
 {
-	unsigned char *compressed;
-	int i, j, x, y;
-	unsigned char ublock[16*4];
-	unsigned char cblock[8];
-	int index = 0, chan_step = 1;
-	int block_count = 0, has_alpha;
-	/*	error check	*/
-	*out_size = 0;
-	if( (width < 1) || (height < 1) ||
-		(NULL == uncompressed) ||
-		(channels < 1) || ( channels > 4) )
+	switch( job->mode )
 	{
-		return NULL;
+	case DXT_MODE_RANGE_FIT:
+		compress_DDS_color_block_range_fit( channels, ublock, out );
+		break;
+	case DXT_MODE_CLUSTER_FIT:
+		compress_DDS_color_block_cluster_fit( channels, ublock, out );
+		break;
+	default:
+		compress_DDS_color_block( channels, ublock, out );
+		break;
 	}
-	/*	for channels == 1 or 2, I do not step forward for R,G,B vales	*/
-	if( channels < 3 )
+}
+
+static void compress_DXT_alpha( const DXT_job *job,
+		const unsigned char *ublock, unsigned char *out )
+{
+	if( DXT_MODE_CLUSTER_FIT == job->mode )
+	{
+		compress_DDS_alpha_block_nearest( ublock, out );
+	} else
 	{
-		chan_step = 0;
+		compress_DDS_alpha_block( ublock, out );
 	}
-	/*	# channels = 1 or 3 have no alpha, 2 & 4 do have alpha	*/
-	has_alpha = 1 - (channels & 1);
-	/*	get the RAM for the compressed image
-		(16 bytes per 4x4 pixel block)	*/
-	*out_size = ((width+3) >> 2) * ((height+3) >> 2) * 16;
-	compressed = (unsigned char*)malloc( *out_size );
-	/*	go through each block	*/
-	for( j = 0; j < height; j += 4 )
-	{
-		for( i = 0; i < width; i += 4 )
-		{
-			/*	local variables, and my block counter	*/
-			int idx = 0;
-			int mx = 4, my = 4;
-			if( j+4 >= height )
-			{
-				my = height - j;
-			}
-			if( i+4 >= width )
-			{
-				mx = width - i;
-			}
-			for( y = 0; y < my; ++y )
+}
+
+/*	every block is independent, and has its own place in the output	*/
+static void DXT1_block_rows( void *context, int row_begin, int row_end )
+{
+	const DXT_job *job = (const DXT_job*)context;
+	const int blocks_x = (job->width+3) >> 2;
+	unsigned char ublock[16*3];
+	int i, j;
+	for( j = row_begin; j < row_end; ++j )
+	{
+		unsigned char *out = job->compressed + j*blocks_x*8;
+		i = 0;
+#if defined( SOIL_DXT_SIMD )
+		if( (SOIL_SIMD_AVX2 == job->simd) && (DXT_MODE_CLUSTER_FIT != job->mode) )
+		{
+			/*	8 blocks at a time, each in its own lane	*/
+			unsigned char pixels[16*3][8];
+			for( ; i + 8 <= blocks_x; i += 8 )
 			{
-				for( x = 0; x < mx; ++x )
+				gather_DXT_lanes( job, i, j, pixels, NULL );
+				if( DXT_MODE_RANGE_FIT == job->mode )
 				{
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels];
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels+chan_step];
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels+chan_step+chan_step];
-					ublock[idx++] =
-						has_alpha * uncompressed[(j+y)*width*channels+(i+x)*channels+channels-1]
-						+ (1-has_alpha)*255;
-				}
-				for( x = mx; x < 4; ++x )
+					compress_DDS_color_blocks_range_fit_avx2( pixels, out, 8 );
+				} else
 				{
-					ublock[idx++] = ublock[0];
-					ublock[idx++] = ublock[1];
-					ublock[idx++] = ublock[2];
-					ublock[idx++] = ublock[3];
+					compress_DDS_color_blocks_avx2( pixels, out, 8 );
 				}
+				out += 8*8;
 			}
-			for( y = my; y < 4; ++y )
+		}
+#endif
+		for( ; i < blocks_x; ++i )
+		{
+			gather_DXT_block( job, i*4, j*4, 3, ublock );
+			compress_DXT_color( job, 3, ublock, out );
+			out += 8;
+		}
+	}
+}
+
+static void DXT5_block_rows( void *context, int row_begin, int row_end )
+{
+	const DXT_job *job = (const DXT_job*)context;
+	const int blocks_x = (job->width+3) >> 2;
+	unsigned char ublock[16*4];
+	int i, j;
+	for( j = row_begin; j < row_end; ++j )
+	{
+		unsigned char *out = job->compressed + j*blocks_x*16;
+		i = 0;
+#if defined( SOIL_DXT_SIMD )
+		if( (SOIL_SIMD_AVX2 == job->simd) && (DXT_MODE_CLUSTER_FIT != job->mode) )
+		{
+			unsigned char pixels[16*3][8];
+			unsigned char alpha[16][8];
+			for( ; i + 8 <= blocks_x; i += 8 )
 			{
-				for( x = 0; x < 4; ++x )
+				gather_DXT_lanes( job, i, j, pixels, alpha );
+				compress_DDS_alpha_blocks_avx2( alpha, out, 16 );
+				if( DXT_MODE_RANGE_FIT == job->mode )
 				{
-					ublock[idx++] = ublock[0];
-					ublock[idx++] = ublock[1];
-					ublock[idx++] = ublock[2];
-					ublock[idx++] = ublock[3];
+					compress_DDS_color_blocks_range_fit_avx2( pixels, out + 8, 16 );
+				} else
+				{
+					compress_DDS_color_blocks_avx2( pixels, out + 8, 16 );
 				}
+				out += 8*16;
 			}
-			/*	now compress the alpha block	*/
-			compress_DDS_alpha_block( ublock, cblock );
-			/*	copy the data from the compressed alpha block into the main buffer	*/
-			for( x = 0; x < 8; ++x )
-			{
-				compressed[index++] = cblock[x];
-			}
-			/*	then compress the color block	*/
-			++block_count;
-			compress_DDS_color_block( 4, ublock, cblock );
-			/*	copy the data from the compressed color block into the main buffer	*/
-			for( x = 0; x < 8; ++x )
-			{
-				compressed[index++] = cblock[x];
-			}
+		}
+#endif
+		for( ; i < blocks_x; ++i )
+		{
+			gather_DXT_block( job, i*4, j*4, 4, ublock );
+			/*	the alpha block comes first, then the color block	*/
+			compress_DXT_alpha( job, ublock, out );
+			compress_DXT_color( job, 4, ublock, out + 8 );
+			out += 16;
 		}
 	}
-	return compressed;
 }
 
-/********* Helper Functions *********/
-int convert_bit_range( int c, int from_bits, int to_bits )
+/*
+	Copies one channel of the 4x4 block at (i,j) into the alpha
+	of an RGBA ublock, which is what the alpha block encoder reads.
+*/
+static void gather_BC_channel(
+		const DXT_job *job,
+		int i, int j, int channel,
+		unsigned char *ublock )
 {
-	int b = (1 << (from_bits - 1)) + c * ((1 << to_bits) - 1);
-	return (b + (b >> from_bits)) >> from_bits;
+	const int width = job->width;
+	const int channels = job->channels;
+	int x, y;
+	int mx = 4, my = 4;
+	if( channel >= channels )
+	{
+		channel = channels - 1;
+	}
+	if( j+4 >= job->height )
+	{
+		my = job->height - j;
+	}
+	if( i+4 >= width )
+	{
+		mx = width - i;
+	}
+	for( y = 0; y < 4; ++y )
+	{
+		for( x = 0; x < 4; ++x )
+		{
+			/*	the first pixel again where the block hangs over	*/
+			ublock[(y*4+x)*4+3] = ((x < mx) && (y < my)) ?
+					job->uncompressed[((j+y)*width + i+x)*channels + channel] :
+					ublock[3];
+		}
+	}
 }
 
-int rgb_to_565( int r, int g, int b )
+static void BC4_block_rows( void *context, int row_begin, int row_end )
 {
-	return
-		(convert_bit_range( r, 8, 5 ) << 11) |
-		(convert_bit_range( g, 8, 6 ) << 05) |
-		(convert_bit_range( b, 8, 5 ) << 00);
+	const DXT_job *job = (const DXT_job*)context;
+	const int blocks_x = (job->width+3) >> 2;
+	unsigned char ublock[16*4];
+	int i, j;
+	for( j = row_begin; j < row_end; ++j )
+	{
+		unsigned char *out = job->compressed + j*blocks_x*8;
+		for( i = 0; i < blocks_x; ++i )
+		{
+			gather_BC_channel( job, i*4, j*4, 0, ublock );
+			compress_DDS_alpha_block_nearest( ublock, out );
+			out += 8;
+		}
+	}
 }
 
-void rgb_888_from_565( unsigned int c, int *r, int *g, int *b )
+static void BC5_block_rows( void *context, int row_begin, int row_end )
 {
-	*r = convert_bit_range( (c >> 11) & 31, 5, 8 );
-	*g = convert_bit_range( (c >> 05) & 63, 6, 8 );
-	*b = convert_bit_range( (c >> 00) & 31, 5, 8 );
+	const DXT_job *job = (const DXT_job*)context;
+	const int blocks_x = (job->width+3) >> 2;
+	unsigned char ublock[16*4];
+	int i, j;
+	for( j = row_begin; j < row_end; ++j )
+	{
+		unsigned char *out = job->compressed + j*blocks_x*16;
+		for( i = 0; i < blocks_x; ++i )
+		{
+			/*	red block, then green block	*/
+			gather_BC_channel( job, i*4, j*4, 0, ublock );
+			compress_DDS_alpha_block_nearest( ublock, out );
+			gather_BC_channel( job, i*4, j*4, 1, ublock );
+			compress_DDS_alpha_block_nearest( ublock, out + 8 );
+			out += 16;
+		}
+	}
 }
 
-void compute_color_line_STDEV(
-		const unsigned char *const uncompressed,
-		int channels,
-		float point[3], float direction[3] )
+static void BC7_block_rows( void *context, int row_begin, int row_end )
 {
-	const float inv_16 = 1.0f / 16.0f;
-	int i;
-	float sum_r = 0.0f, sum_g = 0.0f, sum_b = 0.0f;
-	float sum_rr = 0.0f, sum_gg = 0.0f, sum_bb = 0.0f;
-	float sum_rg = 0.0f, sum_rb = 0.0f, sum_gb = 0.0f;
-	/*	calculate all data needed for the covariance matrix
-		( to compare with _rygdxt code)	*/
-	for( i = 0; i < 16*channels; i += channels )
+	const DXT_job *job = (const DXT_job*)context;
+	const int blocks_x = (job->width+3) >> 2;
+	unsigned char ublock[16*4];
+	int i, j;
+	for( j = row_begin; j < row_end; ++j )
+	{
+		unsigned char *out = job->compressed + j*blocks_x*16;
+		for( i = 0; i < blocks_x; ++i )
+		{
+			gather_DXT_block( job, i*4, j*4, 4, ublock );
+			compress_BC7_block( job->mode, ublock, out );
+			out += 16;
+		}
+	}
+}
+
+static void BC6H_block_rows( void *context, int row_begin, int row_end )
+{
+	const DXT_job *job = (const DXT_job*)context;
+	const int blocks_x = (job->width+3) >> 2;
+	/*	for channels == 1 or 2, I do not step forward for R,G,B values	*/
+	const int chan_step = (job->channels < 3) ? 0 : 1;
+	float fblock[16*3];
+	int i, j, x, y, c;
+	for( j = row_begin; j < row_end; ++j )
+	{
+		unsigned char *out = job->compressed + j*blocks_x*16;
+		for( i = 0; i < blocks_x; ++i )
+		{
+			/*	the first pixel again where the block hangs over	*/
+			for( y = 0; y < 4; ++y )
+			{
+				for( x = 0; x < 4; ++x )
+				{
+					float *px = fblock + (y*4+x)*3;
+					if( (i*4+x < job->width) && (j*4+y < job->height) )
+					{
+						const float *in = job->uncompressed_float + ((j*4+y)*job->width + i*4+x)*job->channels;
+						for( c = 0; c < 3; ++c )
+						{
+							px[c] = in[c*chan_step];
+						}
+					} else
+					{
+						for( c = 0; c < 3; ++c )
+						{
+							px[c] = fblock[c];
+						}
+					}
+				}
+			}
+			compress_BC6H_block( job->mode, job->is_signed, fblock, out );
+			out += 16;
+		}
+	}
+}
+
+static void init_DXT_job( DXT_job *job,
+		const unsigned char *uncompressed, const float *uncompressed_float,
+		int width, int height, int channels, int mode )
+{
+	job->uncompressed = uncompressed;
+	job->uncompressed_float = uncompressed_float;
+	job->width = width;
+	job->height = height;
+	job->channels = channels;
+	job->compressed = NULL;
+	job->mode = mode;
+	job->simd = soil_simd_level();
+	job->is_signed = 0;
+}
+
+/*
+	Checks the job, gets the RAM for the compressed image (block_bytes
+	per 4x4 pixel block) and has worker compress the rows of blocks
+	straight into place.  *out_size stays 0 unless there is an image.
+*/
+static unsigned char* DXT_run_job( DXT_job *job, int block_bytes,
+		SOIL_parallel_task worker, const char *zone, int *out_size )
+{
+	int size;
+	/*	error check	*/
+	*out_size = 0;
+	if( (job->width < 1) || (job->height < 1) ||
+		((NULL == job->uncompressed) && (NULL == job->uncompressed_float)) ||
+		(job->channels < 1) || (job->channels > 4) )
+	{
+		return NULL;
+	}
+	size = ((job->width+3) >> 2) * ((job->height+3) >> 2) * block_bytes;
+	soil_zone_begin( zone );
+	job->compressed = (unsigned char*)malloc( size );
+	if( NULL != job->compressed )
+	{
+		soil_parallel_for( worker, job, (job->height+3) >> 2, SOIL_DXT_GRAIN );
+		*out_size = size;
+	}
+	soil_zone_end();
+	return job->compressed;
+}
+
+unsigned char* convert_image_to_DXT1(
+		const unsigned char *const uncompressed,
+		int width, int height, int channels,
+		int mode,
+		int *out_size )
+{
+	DXT_job job;
+	init_DXT_job( &job, uncompressed, NULL, width, height, channels, mode );
+	return DXT_run_job( &job, 8, DXT1_block_rows, "SOIL2::DXT1", out_size );
+}
+
+unsigned char* convert_image_to_DXT5(
+		const unsigned char *const uncompressed,
+		int width, int height, int channels,
+		int mode,
+		int *out_size )
+{
+	DXT_job job;
+	init_DXT_job( &job, uncompressed, NULL, width, height, channels, mode );
+	return DXT_run_job( &job, 16, DXT5_block_rows, "SOIL2::DXT5", out_size );
+}
+
+unsigned char* convert_image_to_BC4(
+		const unsigned char *const uncompressed,
+		int width, int height, int channels,
+		int mode,
+		int *out_size )
+{
+	DXT_job job;
+	init_DXT_job( &job, uncompressed, NULL, width, height, channels, mode );
+	return DXT_run_job( &job, 8, BC4_block_rows, "SOIL2::BC4", out_size );
+}
+
+unsigned char* convert_image_to_BC5(
+		const unsigned char *const uncompressed,
+		int width, int height, int channels,
+		int mode,
+		int *out_size )
+{
+	DXT_job job;
+	init_DXT_job( &job, uncompressed, NULL, width, height, channels, mode );
+	return DXT_run_job( &job, 16, BC5_block_rows, "SOIL2::BC5", out_size );
+}
+
+unsigned char* convert_image_to_BC7(
+		const unsigned char *const uncompressed,
+		int width, int height, int channels,
+		int mode,
+		int *out_size )
+{
+	DXT_job job;
+	init_DXT_job( &job, uncompressed, NULL, width, height, channels, mode );
+	return DXT_run_job( &job, 16, BC7_block_rows, "SOIL2::BC7", out_size );
+}
+
+unsigned char* convert_image_to_BC6H(
+		const float *const uncompressed,
+		int width, int height, int channels,
+		int is_signed,
+		int mode,
+		int *out_size )
+{
+	DXT_job job;
+	init_DXT_job( &job, NULL, uncompressed, width, height, channels, mode );
+	job.is_signed = is_signed;
+	return DXT_run_job( &job, 16, BC6H_block_rows, "SOIL2::BC6H", out_size );
+}
+
+/********* Helper Functions *********/
+int convert_bit_range( int c, int from_bits, int to_bits )
+{
+	int b = (1 << (from_bits - 1)) + c * ((1 << to_bits) - 1);
+	return (b + (b >> from_bits)) >> from_bits;
+}
+
+int rgb_to_565( int r, int g, int b )
+{
+	return
+		(convert_bit_range( r, 8, 5 ) << 11) |
+		(convert_bit_range( g, 8, 6 ) << 05) |
+		(convert_bit_range( b, 8, 5 ) << 00);
+}
+
+void rgb_888_from_565( unsigned int c, int *r, int *g, int *b )
+{
+	*r = convert_bit_range( (c >> 11) & 31, 5, 8 );
+	*g = convert_bit_range( (c >> 05) & 63, 6, 8 );
+	*b = convert_bit_range( (c >> 00) & 31, 5, 8 );
+}
+
+void compute_color_line_STDEV(
+		const unsigned char *const uncompressed,
+		int channels,
+		float point[3], float direction[3] )
+{
+	const float inv_16 = 1.0f / 16.0f;
+	int i;
+	float sum_r = 0.0f, sum_g = 0.0f, sum_b = 0.0f;
+	float sum_rr = 0.0f, sum_gg = 0.0f, sum_bb = 0.0f;
+	float sum_rg = 0.0f, sum_rb = 0.0f, sum_gb = 0.0f;
+	/*	calculate all data needed for the covariance matrix
+		( to compare with _rygdxt code)	*/
+	for( i = 0; i < 16*channels; i += channels )
 	{
 		sum_r += uncompressed[i+0];
 		sum_rr += uncompressed[i+0] * uncompressed[i+0];
@@ -630,3 +1171,1391 @@ void
 	}
 	/*	done compressing to DXT1	*/
 }
+
+/*
+	Picks the nearest of the 4 colors between two 565 end points
+	for each pixel, stores the block and returns its squared error.
+	The end points are put in the order that gives 4 colors, or
+	stay as one color when they are the same.
+*/
+static int encode_DDS_color_indices(
+		int channels,
+		const unsigned char *const uncompressed,
+		int enc_c0, int enc_c1,
+		unsigned char compressed[8] )
+{
+	/*	stupid order	*/
+	const int swizzle4[] = { 0, 2, 3, 1 };
+	int palette[4][3];
+	int i, k, error = 0;
+	unsigned int bits = 0;
+	if( enc_c0 < enc_c1 )
+	{
+		k = enc_c0;
+		enc_c0 = enc_c1;
+		enc_c1 = k;
+	}
+	rgb_888_from_565( enc_c0, &palette[0][0], &palette[0][1], &palette[0][2] );
+	rgb_888_from_565( enc_c1, &palette[3][0], &palette[3][1], &palette[3][2] );
+	for( k = 0; k < 3; ++k )
+	{
+		palette[1][k] = (2*palette[0][k] + palette[3][k] + 1) / 3;
+		palette[2][k] = (palette[0][k] + 2*palette[3][k] + 1) / 3;
+	}
+	for( i = 0; i < 16; ++i )
+	{
+		const unsigned char *px = uncompressed + i*channels;
+		int best = 0, best_error = 0x7FFFFFFF;
+		/*	equal end points make a 3 color block, stick to the first	*/
+		const int count = (enc_c0 == enc_c1) ? 1 : 4;
+		for( k = 0; k < count; ++k )
+		{
+			const int dr = px[0] - palette[k][0];
+			const int dg = px[1] - palette[k][1];
+			const int db = px[2] - palette[k][2];
+			const int e = dr*dr + dg*dg + db*db;
+			if( e < best_error )
+			{
+				best_error = e;
+				best = k;
+			}
+		}
+		error += best_error;
+		bits |= (unsigned int)swizzle4[best] << (2*i);
+	}
+	compressed[0] = (enc_c0 >> 0) & 255;
+	compressed[1] = (enc_c0 >> 8) & 255;
+	compressed[2] = (enc_c1 >> 0) & 255;
+	compressed[3] = (enc_c1 >> 8) & 255;
+	compressed[4] = (bits >> 0) & 255;
+	compressed[5] = (bits >> 8) & 255;
+	compressed[6] = (bits >> 16) & 255;
+	compressed[7] = (bits >> 24) & 255;
+	return error;
+}
+
+void
+	compress_DDS_color_block_range_fit
+	(
+		int channels,
+		const unsigned char *const uncompressed,
+		unsigned char compressed[8]
+	)
+{
+	int lo[3], hi[3], sum[3] = { 0, 0, 0 };
+	int c0[3], c1[3], dir[3];
+	int cov_rg = 0, cov_gb = 0, cov_rb = 0, swap_r, swap_b;
+	int i, k, inset, enc_c0, enc_c1, len2;
+	unsigned int bits = 0;
+	for( k = 0; k < 3; ++k )
+	{
+		lo[k] = hi[k] = uncompressed[k];
+	}
+	for( i = 0; i < 16; ++i )
+	{
+		const unsigned char *px = uncompressed + i*channels;
+		for( k = 0; k < 3; ++k )
+		{
+			lo[k] = (px[k] < lo[k]) ? px[k] : lo[k];
+			hi[k] = (px[k] > hi[k]) ? px[k] : hi[k];
+			sum[k] += px[k];
+		}
+	}
+	/*	the box has two diagonals per channel pair, follow the one
+		the colors lean along (16 times the covariance is enough)	*/
+	for( i = 0; i < 16; ++i )
+	{
+		const unsigned char *px = uncompressed + i*channels;
+		const int r = 16*px[0] - sum[0];
+		const int g = 16*px[1] - sum[1];
+		const int b = 16*px[2] - sum[2];
+		cov_rg += r*g;
+		cov_gb += g*b;
+		cov_rb += r*b;
+	}
+	/*	pull the corners in a little, the end points are used less
+		than the colors between them	*/
+	for( k = 0; k < 3; ++k )
+	{
+		inset = (hi[k] - lo[k]) >> 4;
+		lo[k] += inset;
+		hi[k] -= inset;
+	}
+	/*	green leads, red and blue follow it, or each other when
+		they don't go with green at all	*/
+	swap_r = (0 != cov_rg) ? (cov_rg < 0) : ((0 != cov_gb) ? ((cov_rb < 0) != (cov_gb < 0)) : (cov_rb < 0));
+	swap_b = (0 != cov_gb) ? (cov_gb < 0) : ((cov_rb < 0) != swap_r);
+	if( swap_r )
+	{
+		k = lo[0];
+		lo[0] = hi[0];
+		hi[0] = k;
+	}
+	if( swap_b )
+	{
+		k = lo[2];
+		lo[2] = hi[2];
+		hi[2] = k;
+	}
+	enc_c0 = rgb_to_565( hi[0], hi[1], hi[2] );
+	enc_c1 = rgb_to_565( lo[0], lo[1], lo[2] );
+	if( enc_c0 < enc_c1 )
+	{
+		k = enc_c0;
+		enc_c0 = enc_c1;
+		enc_c1 = k;
+	}
+	/*	project each pixel onto the line between the end points and
+		round to the nearest third, comparing rather than dividing	*/
+	rgb_888_from_565( enc_c0, &c0[0], &c0[1], &c0[2] );
+	rgb_888_from_565( enc_c1, &c1[0], &c1[1], &c1[2] );
+	len2 = 0;
+	for( k = 0; k < 3; ++k )
+	{
+		dir[k] = c0[k] - c1[k];
+		len2 += dir[k]*dir[k];
+	}
+	for( i = 0; i < 16; ++i )
+	{
+		const unsigned char *px = uncompressed + i*channels;
+		/*	stupid order, by thirds of the way from c1 to c0	*/
+		const int swizzle4[] = { 1, 3, 2, 0 };
+		const int t = 6*((px[0] - c1[0])*dir[0] + (px[1] - c1[1])*dir[1] + (px[2] - c1[2])*dir[2]);
+		const int thirds = (t >= len2) + (t >= 3*len2) + (t >= 5*len2);
+		bits |= (unsigned int)swizzle4[thirds] << (2*i);
+	}
+	compressed[0] = (enc_c0 >> 0) & 255;
+	compressed[1] = (enc_c0 >> 8) & 255;
+	compressed[2] = (enc_c1 >> 0) & 255;
+	compressed[3] = (enc_c1 >> 8) & 255;
+	compressed[4] = (bits >> 0) & 255;
+	compressed[5] = (bits >> 8) & 255;
+	compressed[6] = (bits >> 16) & 255;
+	compressed[7] = (bits >> 24) & 255;
+}
+
+static int clamp_DXT_channel( float x )
+{
+	int i = (int)(x + 0.5f);
+	return (i < 0) ? 0 : ((i > 255) ? 255 : i);
+}
+
+void
+	compress_DDS_color_block_cluster_fit
+	(
+		int channels,
+		const unsigned char *const uncompressed,
+		unsigned char compressed[8]
+	)
+{
+	/*	how much of the first end point each of the 4 colors has	*/
+	const float weight[4] = { 1.0f, 2.0f / 3.0f, 1.0f / 3.0f, 0.0f };
+	float point[3], direction[3], dots[16];
+	/*	running sums of the pixels in order along the axis	*/
+	float prefix[17][3];
+	int order[16];
+	int i, j, k, i0, i1, i2;
+	float best = FLT_MAX, best_a[3] = { 0.0f, 0.0f, 0.0f }, best_b[3] = { 0.0f, 0.0f, 0.0f };
+	unsigned char candidate[8];
+	int error, candidate_error, enc_c0, enc_c1;
+	/*	start from the end points of the usual and the range fit
+		encodings, cluster fit has to beat both of them	*/
+	compress_DDS_color_block( channels, uncompressed, compressed );
+	error = encode_DDS_color_indices( channels, uncompressed,
+			compressed[0] | (compressed[1] << 8), compressed[2] | (compressed[3] << 8), compressed );
+	compress_DDS_color_block_range_fit( channels, uncompressed, candidate );
+	candidate_error = encode_DDS_color_indices( channels, uncompressed,
+			candidate[0] | (candidate[1] << 8), candidate[2] | (candidate[3] << 8), candidate );
+	if( candidate_error < error )
+	{
+		error = candidate_error;
+		memcpy( compressed, candidate, 8 );
+	}
+	if( 0 == error )
+	{
+		return;
+	}
+	/*	sort the pixels along the principal axis	*/
+	compute_color_line_STDEV( uncompressed, channels, point, direction );
+	for( i = 0; i < 16; ++i )
+	{
+		const unsigned char *px = uncompressed + i*channels;
+		const float dot = direction[0]*px[0] + direction[1]*px[1] + direction[2]*px[2];
+		for( j = i; (j > 0) && (dots[j-1] > dot); --j )
+		{
+			dots[j] = dots[j-1];
+			order[j] = order[j-1];
+		}
+		dots[j] = dot;
+		order[j] = i;
+	}
+	prefix[0][0] = prefix[0][1] = prefix[0][2] = 0.0f;
+	for( i = 0; i < 16; ++i )
+	{
+		for( k = 0; k < 3; ++k )
+		{
+			prefix[i+1][k] = prefix[i][k] + uncompressed[order[i]*channels + k];
+		}
+	}
+	/*	pixels [0,i0) get color 0, [i0,i1) color 2, [i1,i2) color 3
+		and [i2,16) color 1, solve for the end points of each split	*/
+	for( i0 = 0; i0 <= 16; ++i0 )
+	for( i1 = i0; i1 <= 16; ++i1 )
+	for( i2 = i1; i2 <= 16; ++i2 )
+	{
+		const int n[4] = { i0, i1 - i0, i2 - i1, 16 - i2 };
+		float aa = 0.0f, bb = 0.0f, ab = 0.0f, det, e = 0.0f;
+		float x[3], y[3], a[3], b[3];
+		for( j = 0; j < 4; ++j )
+		{
+			aa += n[j] * weight[j] * weight[j];
+			bb += n[j] * (1.0f - weight[j]) * (1.0f - weight[j]);
+			ab += n[j] * weight[j] * (1.0f - weight[j]);
+		}
+		det = aa*bb - ab*ab;
+		if( det < 0.0001f )
+		{
+			continue;
+		}
+		for( k = 0; k < 3; ++k )
+		{
+			const float s0 = prefix[i0][k];
+			const float s1 = prefix[i1][k] - prefix[i0][k];
+			const float s2 = prefix[i2][k] - prefix[i1][k];
+			const float s3 = prefix[16][k] - prefix[i2][k];
+			x[k] = s0 + weight[1]*s1 + weight[2]*s2;
+			y[k] = weight[2]*s1 + weight[1]*s2 + s3;
+			a[k] = (x[k]*bb - y[k]*ab) / det;
+			b[k] = (y[k]*aa - x[k]*ab) / det;
+			/*	the squared error less the constant sum of squares	*/
+			e += aa*a[k]*a[k] + bb*b[k]*b[k] + 2.0f*ab*a[k]*b[k] - 2.0f*(a[k]*x[k] + b[k]*y[k]);
+		}
+		if( e < best )
+		{
+			best = e;
+			for( k = 0; k < 3; ++k )
+			{
+				best_a[k] = a[k];
+				best_b[k] = b[k];
+			}
+		}
+	}
+	enc_c0 = rgb_to_565( clamp_DXT_channel( best_a[0] ), clamp_DXT_channel( best_a[1] ), clamp_DXT_channel( best_a[2] ) );
+	enc_c1 = rgb_to_565( clamp_DXT_channel( best_b[0] ), clamp_DXT_channel( best_b[1] ), clamp_DXT_channel( best_b[2] ) );
+	if( encode_DDS_color_indices( channels, uncompressed, enc_c0, enc_c1, candidate ) < error )
+	{
+		memcpy( compressed, candidate, 8 );
+	}
+}
+
+void
+	compress_DDS_alpha_block_nearest
+	(
+		const unsigned char *const uncompressed,
+		unsigned char compressed[8]
+	)
+{
+	/*	stupid order	*/
+	const int swizzle8[] = { 1, 7, 6, 5, 4, 3, 2, 0 };
+	int i, a0, a1;
+	int next_bit = 8*2;
+	a0 = a1 = uncompressed[3];
+	for( i = 4+3; i < 16*4; i += 4 )
+	{
+		if( uncompressed[i] > a0 )
+		{
+			a0 = uncompressed[i];
+		} else if( uncompressed[i] < a1 )
+		{
+			a1 = uncompressed[i];
+		}
+	}
+	memset( compressed, 0, 8 );
+	compressed[0] = a0;
+	compressed[1] = a1;
+	for( i = 3; i < 16*4; i += 4 )
+	{
+		/*	the nearest of a1 + v*(a0 - a1)/7, v in [0,7]	*/
+		const int value = (a0 > a1) ? (14*(uncompressed[i] - a1) + (a0 - a1)) / (2*(a0 - a1)) : 7;
+		const int svalue = swizzle8[value];
+		compressed[next_bit >> 3] |= svalue << (next_bit & 7);
+		if( (next_bit & 7) > 5 )
+		{
+			/*	spans 2 bytes, fill in the start of the 2nd byte	*/
+			compressed[1 + (next_bit >> 3)] |= svalue >> (8 - (next_bit & 7) );
+		}
+		next_bit += 3;
+	}
+}
+
+/*	BC7 weights of the levels between the end points, out of 64	*/
+static const int BC7_weights2[4] = { 0, 21, 43, 64 };
+static const int BC7_weights4[16] =
+		{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+/*	appends the low count bits of value to the block, LSB first	*/
+static void put_block_bits( unsigned char compressed[16], int *next_bit,
+		unsigned int value, int count )
+{
+	int i;
+	for( i = 0; i < count; ++i, ++*next_bit )
+	{
+		compressed[*next_bit >> 3] |= ((value >> i) & 1) << (*next_bit & 7);
+	}
+}
+
+/*	the nearest 7 bit end point with the given p-bit,
+	as the 8 bit value it decodes to	*/
+static int quantize_BC7_pbit( float x, int pbit )
+{
+	int q = (int)floor( (x - pbit) * 0.5f + 0.5f );
+	q = (q < 0) ? 0 : ((q > 127) ? 127 : q);
+	return (q << 1) | pbit;
+}
+
+/*	the same for a 7 bit end point with no p-bit	*/
+static int quantize_BC7_7bit( float x )
+{
+	int q = (int)floor( x * (127.0f / 255.0f) + 0.5f );
+	q = (q < 0) ? 0 : ((q > 127) ? 127 : q);
+	return (q << 1) | (q >> 6);
+}
+
+/*
+	Picks the nearest of the levels between e0 and e1 for channels
+	[first, first+count) of each pixel, and returns the squared error.
+	The level is rounded from the projection onto e0->e1, then checked
+	against the two either side, as the weights are not quite evenly
+	spaced and the levels not quite on one line.
+*/
+static int encode_BC7_indices(
+		const unsigned char *const uncompressed,
+		int first, int count,
+		const int *weights, int levels,
+		const int e0[4], const int e1[4],
+		unsigned char indices[16] )
+{
+	int palette[16][4];
+	int d[4], dd = 0;
+	int i, k, c, error = 0;
+	for( k = 0; k < levels; ++k )
+	{
+		for( c = first; c < first + count; ++c )
+		{
+			palette[k][c] = ((64 - weights[k])*e0[c] + weights[k]*e1[c] + 32) >> 6;
+		}
+	}
+	for( c = first; c < first + count; ++c )
+	{
+		d[c] = e1[c] - e0[c];
+		dd += d[c] * d[c];
+	}
+	for( i = 0; i < 16; ++i )
+	{
+		const unsigned char *px = uncompressed + i*4;
+		int guess = 0, best = -1, lo, hi;
+		if( dd > 0 )
+		{
+			int t = 0;
+			for( c = first; c < first + count; ++c )
+			{
+				t += (px[c] - e0[c]) * d[c];
+			}
+			guess = (int)floor( (float)(levels - 1) * t / dd + 0.5f );
+			guess = (guess < 0) ? 0 : ((guess > levels - 1) ? levels - 1 : guess);
+		}
+		lo = (guess > 1) ? guess - 2 : 0;
+		hi = (guess < levels - 2) ? guess + 2 : levels - 1;
+		for( k = lo; k <= hi; ++k )
+		{
+			int e = 0;
+			for( c = first; c < first + count; ++c )
+			{
+				e += (px[c] - palette[k][c]) * (px[c] - palette[k][c]);
+			}
+			if( (best < 0) || (e < best) )
+			{
+				best = e;
+				indices[i] = k;
+			}
+		}
+		error += best;
+	}
+	return error;
+}
+
+/*
+	End points for channels [first, first+count) of the block, from
+	the pixels' spread along their principal axis.  The pixels are
+	4 floats each, as BC6H works on floats and BC7 on bytes.
+*/
+static void fit_block_axis(
+		const float pixels[16*4],
+		int first, int count,
+		float a[4], float b[4] )
+{
+	float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float cov[4][4];
+	float axis[4], v[4];
+	float lo = 0.0f, hi = 0.0f, len;
+	int i, j, k, c;
+	const int last = first + count;
+	for( i = 0; i < 16; ++i )
+	{
+		for( c = first; c < last; ++c )
+		{
+			mean[c] += pixels[i*4+c];
+		}
+	}
+	for( c = first; c < last; ++c )
+	{
+		mean[c] *= 1.0f / 16.0f;
+	}
+	memset( cov, 0, sizeof( cov ) );
+	for( i = 0; i < 16; ++i )
+	{
+		for( c = first; c < last; ++c )
+		{
+			v[c] = pixels[i*4+c] - mean[c];
+		}
+		for( j = first; j < last; ++j )
+		{
+			for( c = first; c < last; ++c )
+			{
+				cov[j][c] += v[j] * v[c];
+			}
+		}
+	}
+	/*	power method, starting from the widest channel	*/
+	k = first;
+	for( c = first + 1; c < last; ++c )
+	{
+		if( cov[c][c] > cov[k][k] )
+		{
+			k = c;
+		}
+	}
+	for( c = first; c < last; ++c )
+	{
+		axis[c] = cov[k][c];
+	}
+	len = 0.0f;
+	for( i = 0; i < 8; ++i )
+	{
+		len = 0.0f;
+		for( j = first; j < last; ++j )
+		{
+			v[j] = 0.0f;
+			for( c = first; c < last; ++c )
+			{
+				v[j] += cov[j][c] * axis[c];
+			}
+			len += v[j] * v[j];
+		}
+		if( len < 1e-12f )
+		{
+			break;
+		}
+		len = 1.0f / (float)sqrt( len );
+		for( j = first; j < last; ++j )
+		{
+			axis[j] = v[j] * len;
+		}
+	}
+	if( len >= 1e-12f )
+	{
+		for( i = 0; i < 16; ++i )
+		{
+			float t = 0.0f;
+			for( c = first; c < last; ++c )
+			{
+				t += (pixels[i*4+c] - mean[c]) * axis[c];
+			}
+			lo = (t < lo) ? t : lo;
+			hi = (t > hi) ? t : hi;
+		}
+	}
+	for( c = first; c < last; ++c )
+	{
+		a[c] = mean[c] + lo * axis[c];
+		b[c] = mean[c] + hi * axis[c];
+	}
+}
+
+/*
+	The least squares end points for channels [first, first+count),
+	given the indices.  Returns 0 when all the pixels use one end.
+*/
+static int refine_block_end_points(
+		const float pixels[16*4],
+		int first, int count,
+		const int *weights, const unsigned char indices[16],
+		float a[4], float b[4] )
+{
+	float aa = 0.0f, bb = 0.0f, ab = 0.0f, det;
+	float x[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float y[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	int i, c;
+	for( i = 0; i < 16; ++i )
+	{
+		const float w = weights[indices[i]] * (1.0f / 64.0f);
+		aa += (1.0f - w) * (1.0f - w);
+		bb += w * w;
+		ab += w * (1.0f - w);
+		for( c = first; c < first + count; ++c )
+		{
+			x[c] += (1.0f - w) * pixels[i*4+c];
+			y[c] += w * pixels[i*4+c];
+		}
+	}
+	det = aa*bb - ab*ab;
+	if( det < 0.0001f )
+	{
+		return 0;
+	}
+	for( c = first; c < first + count; ++c )
+	{
+		a[c] = (x[c]*bb - y[c]*ab) / det;
+		b[c] = (y[c]*aa - x[c]*ab) / det;
+	}
+	return 1;
+}
+
+/*
+	Quantizes RGBA end points for mode 6 with each of the p-bit pairs
+	allowed, and keeps whichever beats the best so far.
+*/
+static void try_BC7_mode6(
+		const unsigned char *const uncompressed,
+		const float a[4], const float b[4], int opaque,
+		int *best_error, int best_e0[4], int best_e1[4],
+		unsigned char best_indices[16] )
+{
+	int e0[4], e1[4], p, c, error;
+	unsigned char indices[16];
+	/*	only odd end points give an alpha of exactly 255	*/
+	for( p = (opaque ? 3 : 0); p < 4; ++p )
+	{
+		for( c = 0; c < 4; ++c )
+		{
+			e0[c] = quantize_BC7_pbit( a[c], p & 1 );
+			e1[c] = quantize_BC7_pbit( b[c], p >> 1 );
+		}
+		error = encode_BC7_indices( uncompressed, 0, 4, BC7_weights4, 16, e0, e1, indices );
+		if( error < *best_error )
+		{
+			*best_error = error;
+			memcpy( best_e0, e0, sizeof( e0 ) );
+			memcpy( best_e1, e1, sizeof( e1 ) );
+			memcpy( best_indices, indices, 16 );
+		}
+	}
+}
+
+/*
+	Mode 6: one pair of RGBA end points, 7 bits each plus a p-bit,
+	and 16 levels between them.  Returns the squared error.
+*/
+static int compress_BC7_mode6(
+		const unsigned char *const uncompressed,
+		const float pixels[16*4],
+		int refinements, int opaque,
+		unsigned char compressed[16] )
+{
+	float a[4], b[4];
+	int e0[4], e1[4];
+	unsigned char indices[16];
+	int error = 0x7FFFFFFF;
+	int i, k, c, next_bit = 0;
+	fit_block_axis( pixels, 0, 4, a, b );
+	try_BC7_mode6( uncompressed, a, b, opaque, &error, e0, e1, indices );
+	for( k = 0; (k < refinements) && (error > 0); ++k )
+	{
+		const int previous = error;
+		if( !refine_block_end_points( pixels, 0, 4, BC7_weights4, indices, a, b ) )
+		{
+			break;
+		}
+		try_BC7_mode6( uncompressed, a, b, opaque, &error, e0, e1, indices );
+		if( error == previous )
+		{
+			break;
+		}
+	}
+	/*	the first index has an implied top bit of 0, so
+		flip the end points around if it would need a 1	*/
+	if( indices[0] & 8 )
+	{
+		for( c = 0; c < 4; ++c )
+		{
+			i = e0[c];
+			e0[c] = e1[c];
+			e1[c] = i;
+		}
+		for( i = 0; i < 16; ++i )
+		{
+			indices[i] = 15 - indices[i];
+		}
+	}
+	/*	mode 6 is 7 bits: 0000001	*/
+	memset( compressed, 0, 16 );
+	put_block_bits( compressed, &next_bit, 1 << 6, 7 );
+	for( c = 0; c < 4; ++c )
+	{
+		put_block_bits( compressed, &next_bit, e0[c] >> 1, 7 );
+		put_block_bits( compressed, &next_bit, e1[c] >> 1, 7 );
+	}
+	put_block_bits( compressed, &next_bit, e0[0] & 1, 1 );
+	put_block_bits( compressed, &next_bit, e1[0] & 1, 1 );
+	put_block_bits( compressed, &next_bit, indices[0], 3 );
+	for( i = 1; i < 16; ++i )
+	{
+		put_block_bits( compressed, &next_bit, indices[i], 4 );
+	}
+	return error;
+}
+
+/*
+	Mode 5: RGB and alpha each get their own pair of end points
+	(7 bits and 8 bits) and 4 levels, for blocks where the alpha
+	does not follow the color.  Returns the squared error.
+*/
+static int compress_BC7_mode5(
+		const unsigned char *const uncompressed,
+		const float pixels[16*4],
+		int refinements,
+		unsigned char compressed[16] )
+{
+	float a[4], b[4];
+	int e0[4], e1[4], t0[4], t1[4];
+	unsigned char indices[16], alpha_indices[16], t_indices[16];
+	int color_error, alpha_error, error;
+	int i, k, c, next_bit = 0;
+	/*	RGB along its principal axis	*/
+	fit_block_axis( pixels, 0, 3, a, b );
+	for( c = 0; c < 3; ++c )
+	{
+		e0[c] = quantize_BC7_7bit( a[c] );
+		e1[c] = quantize_BC7_7bit( b[c] );
+	}
+	color_error = encode_BC7_indices( uncompressed, 0, 3, BC7_weights2, 4, e0, e1, indices );
+	for( k = 0; (k < refinements) && (color_error > 0); ++k )
+	{
+		if( !refine_block_end_points( pixels, 0, 3, BC7_weights2, indices, a, b ) )
+		{
+			break;
+		}
+		for( c = 0; c < 3; ++c )
+		{
+			t0[c] = quantize_BC7_7bit( a[c] );
+			t1[c] = quantize_BC7_7bit( b[c] );
+		}
+		error = encode_BC7_indices( uncompressed, 0, 3, BC7_weights2, 4, t0, t1, t_indices );
+		if( error >= color_error )
+		{
+			break;
+		}
+		color_error = error;
+		memcpy( e0, t0, sizeof( t0 ) );
+		memcpy( e1, t1, sizeof( t1 ) );
+		memcpy( indices, t_indices, 16 );
+	}
+	/*	alpha from its range	*/
+	e0[3] = e1[3] = uncompressed[3];
+	for( i = 1; i < 16; ++i )
+	{
+		e0[3] = (uncompressed[i*4+3] < e0[3]) ? uncompressed[i*4+3] : e0[3];
+		e1[3] = (uncompressed[i*4+3] > e1[3]) ? uncompressed[i*4+3] : e1[3];
+	}
+	alpha_error = encode_BC7_indices( uncompressed, 3, 1, BC7_weights2, 4, e0, e1, alpha_indices );
+	for( k = 0; (k < refinements) && (alpha_error > 0); ++k )
+	{
+		if( !refine_block_end_points( pixels, 3, 1, BC7_weights2, alpha_indices, a, b ) )
+		{
+			break;
+		}
+		t0[3] = clamp_DXT_channel( a[3] );
+		t1[3] = clamp_DXT_channel( b[3] );
+		error = encode_BC7_indices( uncompressed, 3, 1, BC7_weights2, 4, t0, t1, t_indices );
+		if( error >= alpha_error )
+		{
+			break;
+		}
+		alpha_error = error;
+		e0[3] = t0[3];
+		e1[3] = t1[3];
+		memcpy( alpha_indices, t_indices, 16 );
+	}
+	/*	both first indices have an implied top bit of 0	*/
+	if( indices[0] & 2 )
+	{
+		for( c = 0; c < 3; ++c )
+		{
+			i = e0[c];
+			e0[c] = e1[c];
+			e1[c] = i;
+		}
+		for( i = 0; i < 16; ++i )
+		{
+			indices[i] = 3 - indices[i];
+		}
+	}
+	if( alpha_indices[0] & 2 )
+	{
+		i = e0[3];
+		e0[3] = e1[3];
+		e1[3] = i;
+		for( i = 0; i < 16; ++i )
+		{
+			alpha_indices[i] = 3 - alpha_indices[i];
+		}
+	}
+	/*	mode 5 is 6 bits: 000001, then no channel rotation	*/
+	memset( compressed, 0, 16 );
+	put_block_bits( compressed, &next_bit, 1 << 5, 6 );
+	put_block_bits( compressed, &next_bit, 0, 2 );
+	for( c = 0; c < 3; ++c )
+	{
+		put_block_bits( compressed, &next_bit, e0[c] >> 1, 7 );
+		put_block_bits( compressed, &next_bit, e1[c] >> 1, 7 );
+	}
+	put_block_bits( compressed, &next_bit, e0[3], 8 );
+	put_block_bits( compressed, &next_bit, e1[3], 8 );
+	put_block_bits( compressed, &next_bit, indices[0], 1 );
+	for( i = 1; i < 16; ++i )
+	{
+		put_block_bits( compressed, &next_bit, indices[i], 2 );
+	}
+	put_block_bits( compressed, &next_bit, alpha_indices[0], 1 );
+	for( i = 1; i < 16; ++i )
+	{
+		put_block_bits( compressed, &next_bit, alpha_indices[i], 2 );
+	}
+	return color_error + alpha_error;
+}
+
+void
+	compress_BC7_block
+	(
+		int mode,
+		const unsigned char *const uncompressed,
+		unsigned char compressed[16]
+	)
+{
+	/*	DXT_MODE_RANGE_FIT stops at the principal axis,
+		the others refine the end points by least squares	*/
+	const int refinements =
+			(DXT_MODE_RANGE_FIT == mode) ? 0 :
+			((DXT_MODE_CLUSTER_FIT == mode) ? 4 : 1);
+	unsigned char candidate[16];
+	float pixels[16*4];
+	int alpha_min = 255, alpha_max = 0, i, error;
+	for( i = 0; i < 16*4; ++i )
+	{
+		pixels[i] = uncompressed[i];
+	}
+	for( i = 3; i < 16*4; i += 4 )
+	{
+		alpha_min = (uncompressed[i] < alpha_min) ? uncompressed[i] : alpha_min;
+		alpha_max = (uncompressed[i] > alpha_max) ? uncompressed[i] : alpha_max;
+	}
+	error = compress_BC7_mode6( uncompressed, pixels, refinements, 255 == alpha_min, compressed );
+	/*	mode 6 is enough while the alpha is all the same	*/
+	if( (error > 0) && (alpha_min != alpha_max) &&
+		(compress_BC7_mode5( uncompressed, pixels, refinements, candidate ) < error) )
+	{
+		memcpy( compressed, candidate, 16 );
+	}
+}
+
+/*
+	The bits of the nearest half float to f, negated for negative
+	values, clamped to what BC6H can hold (no negatives unless signed,
+	no infinities or NaNs).
+*/
+static int float_to_BC6H_half( float f, int is_signed )
+{
+	const float magnitude = (f < 0.0f) ? -f : f;
+	unsigned int bits;
+	int half;
+	if( (f != f) || ((0 == is_signed) && (f <= 0.0f)) )
+	{
+		return 0;
+	}
+	if( magnitude >= 65504.0f )
+	{
+		half = 0x7BFF;
+	} else
+	if( magnitude < 6.103515625e-05f )
+	{
+		/*	denormal, in steps of 2^-24	*/
+		half = (int)(magnitude * 16777216.0f + 0.5f);
+	} else
+	{
+		/*	rebias the exponent, round the mantissa	*/
+		memcpy( &bits, &magnitude, sizeof( bits ) );
+		half = (int)((bits >> 13) - ((127 - 15) << 10)) + (int)((bits >> 12) & 1);
+		half = (half > 0x7BFF) ? 0x7BFF : half;
+	}
+	return (f < 0.0f) ? -half : half;
+}
+
+/*	a 10 bit BC6H end point, as the 16 bit value the levels are
+	interpolated from	*/
+static int unquantize_BC6H( int q, int is_signed )
+{
+	if( is_signed )
+	{
+		const int magnitude = (q < 0) ? -q : q;
+		int u = magnitude*64 + 32;
+		if( 0 == magnitude )
+		{
+			u = 0;
+		} else
+		if( magnitude >= 511 )
+		{
+			u = 0x7FFF;
+		}
+		return (q < 0) ? -u : u;
+	}
+	if( 0 == q )
+	{
+		return 0;
+	}
+	return (1023 == q) ? 0xFFFF : q*64 + 32;
+}
+
+/*	and the other way, from the 16 bit value	*/
+static int quantize_BC6H( float u, int is_signed )
+{
+	if( is_signed )
+	{
+		int q = (int)floor( ((u < 0.0f) ? -u : u) * (1.0f / 64.0f) );
+		q = (q > 511) ? 511 : q;
+		return (u < 0.0f) ? -q : q;
+	} else
+	{
+		int q = (int)floor( u * (1.0f / 64.0f) );
+		return (q < 0) ? 0 : ((q > 1023) ? 1023 : q);
+	}
+}
+
+/*	an interpolated 16 bit value, as the bits of the half float	*/
+static int finish_BC6H( int u, int is_signed )
+{
+	if( is_signed )
+	{
+		return (u < 0) ? -(((-u) * 31) >> 5) : ((u * 31) >> 5);
+	}
+	return (u * 31) >> 6;
+}
+
+/*
+	Picks the nearest of the 16 levels between the end points for
+	each pixel, as halfs, and returns the squared error.  As for BC7,
+	rounded from the projection and checked either side.
+*/
+static double encode_BC6H_indices(
+		const int halfs[16*3],
+		const int q0[3], const int q1[3],
+		int is_signed,
+		unsigned char indices[16] )
+{
+	int palette[16][3];
+	double d[3], dd = 0.0, error = 0.0;
+	int i, k, c;
+	for( c = 0; c < 3; ++c )
+	{
+		const int u0 = unquantize_BC6H( q0[c], is_signed );
+		const int u1 = unquantize_BC6H( q1[c], is_signed );
+		for( k = 0; k < 16; ++k )
+		{
+			/*	rounded down, for the negative ones too	*/
+			const int u = u0*(64 - BC7_weights4[k]) + u1*BC7_weights4[k] + 32;
+			palette[k][c] = finish_BC6H( (u >= 0) ? (u >> 6) : -((63 - u) >> 6), is_signed );
+		}
+		d[c] = palette[15][c] - palette[0][c];
+		dd += d[c] * d[c];
+	}
+	for( i = 0; i < 16; ++i )
+	{
+		const int *px = halfs + i*3;
+		double best = -1.0;
+		int guess = 0, lo, hi;
+		if( dd > 0.0 )
+		{
+			double t = 0.0;
+			for( c = 0; c < 3; ++c )
+			{
+				t += (px[c] - palette[0][c]) * d[c];
+			}
+			guess = (int)floor( 15.0 * t / dd + 0.5 );
+			guess = (guess < 0) ? 0 : ((guess > 15) ? 15 : guess);
+		}
+		lo = (guess > 1) ? guess - 2 : 0;
+		hi = (guess < 14) ? guess + 2 : 15;
+		for( k = lo; k <= hi; ++k )
+		{
+			double e = 0.0;
+			for( c = 0; c < 3; ++c )
+			{
+				e += (double)(px[c] - palette[k][c]) * (px[c] - palette[k][c]);
+			}
+			if( (best < 0.0) || (e < best) )
+			{
+				best = e;
+				indices[i] = k;
+			}
+		}
+		error += best;
+	}
+	return error;
+}
+
+void
+	compress_BC6H_block
+	(
+		int mode, int is_signed,
+		const float *const uncompressed,
+		unsigned char compressed[16]
+	)
+{
+	const int refinements =
+			(DXT_MODE_RANGE_FIT == mode) ? 0 :
+			((DXT_MODE_CLUSTER_FIT == mode) ? 4 : 1);
+	/*	the finishing step scales by 31/64 (31/32 signed)	*/
+	const float to_16_bit = is_signed ? 32.0f / 31.0f : 64.0f / 31.0f;
+	int halfs[16*3];
+	float pixels[16*4], a[4], b[4];
+	int q0[3], q1[3], t0[3], t1[3];
+	unsigned char indices[16], t_indices[16];
+	double error, candidate;
+	int i, k, c, next_bit = 0;
+	/*	everything happens on the bits of the half floats, as in the
+		decoder, so the error is close to relative, not absolute	*/
+	for( i = 0; i < 16; ++i )
+	{
+		for( c = 0; c < 3; ++c )
+		{
+			halfs[i*3+c] = float_to_BC6H_half( uncompressed[i*3+c], is_signed );
+			pixels[i*4+c] = halfs[i*3+c] * to_16_bit;
+		}
+		pixels[i*4+3] = 0.0f;
+	}
+	fit_block_axis( pixels, 0, 3, a, b );
+	for( c = 0; c < 3; ++c )
+	{
+		q0[c] = quantize_BC6H( a[c], is_signed );
+		q1[c] = quantize_BC6H( b[c], is_signed );
+	}
+	error = encode_BC6H_indices( halfs, q0, q1, is_signed, indices );
+	for( k = 0; (k < refinements) && (error > 0.0); ++k )
+	{
+		if( !refine_block_end_points( pixels, 0, 3, BC7_weights4, indices, a, b ) )
+		{
+			break;
+		}
+		for( c = 0; c < 3; ++c )
+		{
+			t0[c] = quantize_BC6H( a[c], is_signed );
+			t1[c] = quantize_BC6H( b[c], is_signed );
+		}
+		candidate = encode_BC6H_indices( halfs, t0, t1, is_signed, t_indices );
+		if( candidate >= error )
+		{
+			break;
+		}
+		error = candidate;
+		memcpy( q0, t0, sizeof( t0 ) );
+		memcpy( q1, t1, sizeof( t1 ) );
+		memcpy( indices, t_indices, 16 );
+	}
+	/*	the first index has an implied top bit of 0	*/
+	if( indices[0] & 8 )
+	{
+		for( c = 0; c < 3; ++c )
+		{
+			i = q0[c];
+			q0[c] = q1[c];
+			q1[c] = i;
+		}
+		for( i = 0; i < 16; ++i )
+		{
+			indices[i] = 15 - indices[i];
+		}
+	}
+	/*	mode 11 is 5 bits: 00011, then the 10 bit end points
+		(two's complement when signed) and the indices	*/
+	memset( compressed, 0, 16 );
+	put_block_bits( compressed, &next_bit, 0x03, 5 );
+	for( c = 0; c < 3; ++c )
+	{
+		put_block_bits( compressed, &next_bit, q0[c] & 0x3FF, 10 );
+	}
+	for( c = 0; c < 3; ++c )
+	{
+		put_block_bits( compressed, &next_bit, q1[c] & 0x3FF, 10 );
+	}
+	put_block_bits( compressed, &next_bit, indices[0], 3 );
+	for( i = 1; i < 16; ++i )
+	{
+		put_block_bits( compressed, &next_bit, indices[i], 4 );
+	}
+}
+
+#if defined( SOIL_DXT_SIMD )
+
+/*	a vector of 8 pixel values, one from each block	*/
+SOIL_TARGET_AVX2
+static __m256 load_DXT_lanes( const unsigned char lanes[8] )
+{
+	return _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*)lanes ) ) );
+}
+
+/*	convert_bit_range for 8 lanes	*/
+SOIL_TARGET_AVX2
+static __m256i convert_bit_range_avx2( __m256i c, int from_bits, int to_bits )
+{
+	const __m256i b = _mm256_add_epi32( _mm256_set1_epi32( 1 << (from_bits - 1) ),
+			_mm256_mullo_epi32( c, _mm256_set1_epi32( (1 << to_bits) - 1 ) ) );
+	return _mm256_srli_epi32( _mm256_add_epi32( b, _mm256_srli_epi32( b, from_bits ) ), from_bits );
+}
+
+SOIL_TARGET_AVX2
+static __m256i clamp_epi32_avx2( __m256i x, int lo, int hi )
+{
+	return _mm256_min_epi32( _mm256_max_epi32( x, _mm256_set1_epi32( lo ) ), _mm256_set1_epi32( hi ) );
+}
+
+/*
+	compute_color_line_STDEV, LSE_master_colors_max_min and
+	compress_DDS_color_block for 8 blocks at once, one block per
+	float lane.  Every lane does the same float operations in the
+	same order as the C code, so the blocks come out identical.
+	pixels holds channel c of pixel p of block k at [p*3+c][k],
+	block k is written to compressed + k*stride.
+*/
+SOIL_TARGET_AVX2
+static void compress_DDS_color_blocks_avx2(
+		const unsigned char pixels[16*3][8],
+		unsigned char *compressed, int stride )
+{
+	__m256 r[16], g[16], b[16];
+	__m256 sum_r, sum_g, sum_b, sum_rr, sum_gg, sum_bb, sum_rg, sum_rb, sum_gb;
+	__m256 dir_r, dir_g, dir_b, x_r, x_g, x_b;
+	__m256 vec_len2, dot, dot_min, dot_max, sixteen;
+	__m256i c0[3], c1[3], enc_c0, enc_c1, i565, j565, bits;
+	__m256 line_r, line_g, line_b, dot_offset;
+	int i, k;
+	unsigned int ends[8], indices[8];
+	for( i = 0; i < 16; ++i )
+	{
+		r[i] = load_DXT_lanes( pixels[i*3+0] );
+		g[i] = load_DXT_lanes( pixels[i*3+1] );
+		b[i] = load_DXT_lanes( pixels[i*3+2] );
+	}
+	/*	the covariance matrix, as in compute_color_line_STDEV	*/
+	sum_r = sum_g = sum_b = _mm256_setzero_ps();
+	sum_rr = sum_gg = sum_bb = sum_rg = sum_rb = sum_gb = _mm256_setzero_ps();
+	for( i = 0; i < 16; ++i )
+	{
+		sum_r = _mm256_add_ps( sum_r, r[i] );
+		sum_rr = _mm256_add_ps( sum_rr, _mm256_mul_ps( r[i], r[i] ) );
+		sum_g = _mm256_add_ps( sum_g, g[i] );
+		sum_gg = _mm256_add_ps( sum_gg, _mm256_mul_ps( g[i], g[i] ) );
+		sum_b = _mm256_add_ps( sum_b, b[i] );
+		sum_bb = _mm256_add_ps( sum_bb, _mm256_mul_ps( b[i], b[i] ) );
+		sum_rg = _mm256_add_ps( sum_rg, _mm256_mul_ps( r[i], g[i] ) );
+		sum_rb = _mm256_add_ps( sum_rb, _mm256_mul_ps( r[i], b[i] ) );
+		sum_gb = _mm256_add_ps( sum_gb, _mm256_mul_ps( g[i], b[i] ) );
+	}
+	sum_r = _mm256_mul_ps( sum_r, _mm256_set1_ps( 1.0f / 16.0f ) );
+	sum_g = _mm256_mul_ps( sum_g, _mm256_set1_ps( 1.0f / 16.0f ) );
+	sum_b = _mm256_mul_ps( sum_b, _mm256_set1_ps( 1.0f / 16.0f ) );
+	sixteen = _mm256_set1_ps( 16.0f );
+	sum_rr = _mm256_sub_ps( sum_rr, _mm256_mul_ps( _mm256_mul_ps( sixteen, sum_r ), sum_r ) );
+	sum_gg = _mm256_sub_ps( sum_gg, _mm256_mul_ps( _mm256_mul_ps( sixteen, sum_g ), sum_g ) );
+	sum_bb = _mm256_sub_ps( sum_bb, _mm256_mul_ps( _mm256_mul_ps( sixteen, sum_b ), sum_b ) );
+	sum_rg = _mm256_sub_ps( sum_rg, _mm256_mul_ps( _mm256_mul_ps( sixteen, sum_r ), sum_g ) );
+	sum_rb = _mm256_sub_ps( sum_rb, _mm256_mul_ps( _mm256_mul_ps( sixteen, sum_r ), sum_b ) );
+	sum_gb = _mm256_sub_ps( sum_gb, _mm256_mul_ps( _mm256_mul_ps( sixteen, sum_g ), sum_b ) );
+	/*	three steps of the power method from the same start	*/
+	dir_r = _mm256_set1_ps( 1.0f );
+	dir_g = _mm256_set1_ps( 2.718281828f );
+	dir_b = _mm256_set1_ps( 3.141592654f );
+	for( i = 0; i < 3; ++i )
+	{
+		x_r = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( dir_r, sum_rr ), _mm256_mul_ps( dir_g, sum_rg ) ), _mm256_mul_ps( dir_b, sum_rb ) );
+		x_g = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( dir_r, sum_rg ), _mm256_mul_ps( dir_g, sum_gg ) ), _mm256_mul_ps( dir_b, sum_gb ) );
+		x_b = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( dir_r, sum_rb ), _mm256_mul_ps( dir_g, sum_gb ) ), _mm256_mul_ps( dir_b, sum_bb ) );
+		dir_r = x_r;
+		dir_g = x_g;
+		dir_b = x_b;
+	}
+	/*	the extent of the block along that line, as in LSE_master_colors_max_min	*/
+	vec_len2 = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_set1_ps( 0.00001f ),
+			_mm256_mul_ps( dir_r, dir_r ) ), _mm256_mul_ps( dir_g, dir_g ) ), _mm256_mul_ps( dir_b, dir_b ) );
+	vec_len2 = _mm256_div_ps( _mm256_set1_ps( 1.0f ), vec_len2 );
+	dot_min = dot_max = _mm256_setzero_ps();
+	for( i = 0; i < 16; ++i )
+	{
+		dot = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( dir_r, r[i] ), _mm256_mul_ps( dir_g, g[i] ) ), _mm256_mul_ps( dir_b, b[i] ) );
+		if( 0 == i )
+		{
+			dot_min = dot_max = dot;
+		} else
+		{
+			dot_min = _mm256_min_ps( dot_min, dot );
+			dot_max = _mm256_max_ps( dot_max, dot );
+		}
+	}
+	dot = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( dir_r, sum_r ), _mm256_mul_ps( dir_g, sum_g ) ), _mm256_mul_ps( dir_b, sum_b ) );
+	dot_min = _mm256_mul_ps( _mm256_sub_ps( dot_min, dot ), vec_len2 );
+	dot_max = _mm256_mul_ps( _mm256_sub_ps( dot_max, dot ), vec_len2 );
+	{
+		const __m256 half = _mm256_set1_ps( 0.5f );
+		const __m256 point[3] = { sum_r, sum_g, sum_b };
+		const __m256 dir[3] = { dir_r, dir_g, dir_b };
+		for( i = 0; i < 3; ++i )
+		{
+			c0[i] = clamp_epi32_avx2( _mm256_cvttps_epi32( _mm256_add_ps( _mm256_add_ps( half, point[i] ),
+					_mm256_mul_ps( dot_max, dir[i] ) ) ), 0, 255 );
+			c1[i] = clamp_epi32_avx2( _mm256_cvttps_epi32( _mm256_add_ps( _mm256_add_ps( half, point[i] ),
+					_mm256_mul_ps( dot_min, dir[i] ) ) ), 0, 255 );
+		}
+	}
+	i565 = _mm256_or_si256( _mm256_or_si256( _mm256_slli_epi32( convert_bit_range_avx2( c0[0], 8, 5 ), 11 ),
+			_mm256_slli_epi32( convert_bit_range_avx2( c0[1], 8, 6 ), 5 ) ), convert_bit_range_avx2( c0[2], 8, 5 ) );
+	j565 = _mm256_or_si256( _mm256_or_si256( _mm256_slli_epi32( convert_bit_range_avx2( c1[0], 8, 5 ), 11 ),
+			_mm256_slli_epi32( convert_bit_range_avx2( c1[1], 8, 6 ), 5 ) ), convert_bit_range_avx2( c1[2], 8, 5 ) );
+	enc_c0 = _mm256_max_epi32( i565, j565 );
+	enc_c1 = _mm256_min_epi32( i565, j565 );
+	/*	the line between the quantised end points, as in compress_DDS_color_block	*/
+	c0[0] = convert_bit_range_avx2( _mm256_srli_epi32( enc_c0, 11 ), 5, 8 );
+	c0[1] = convert_bit_range_avx2( _mm256_and_si256( _mm256_srli_epi32( enc_c0, 5 ), _mm256_set1_epi32( 63 ) ), 6, 8 );
+	c0[2] = convert_bit_range_avx2( _mm256_and_si256( enc_c0, _mm256_set1_epi32( 31 ) ), 5, 8 );
+	c1[0] = convert_bit_range_avx2( _mm256_srli_epi32( enc_c1, 11 ), 5, 8 );
+	c1[1] = convert_bit_range_avx2( _mm256_and_si256( _mm256_srli_epi32( enc_c1, 5 ), _mm256_set1_epi32( 63 ) ), 6, 8 );
+	c1[2] = convert_bit_range_avx2( _mm256_and_si256( enc_c1, _mm256_set1_epi32( 31 ) ), 5, 8 );
+	line_r = _mm256_cvtepi32_ps( _mm256_sub_epi32( c1[0], c0[0] ) );
+	line_g = _mm256_cvtepi32_ps( _mm256_sub_epi32( c1[1], c0[1] ) );
+	line_b = _mm256_cvtepi32_ps( _mm256_sub_epi32( c1[2], c0[2] ) );
+	vec_len2 = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( line_r, line_r ), _mm256_mul_ps( line_g, line_g ) ), _mm256_mul_ps( line_b, line_b ) );
+	/*	1 / length squared, or 0 when both end points are the same	*/
+	vec_len2 = _mm256_and_ps( _mm256_div_ps( _mm256_set1_ps( 1.0f ), vec_len2 ),
+			_mm256_cmp_ps( vec_len2, _mm256_setzero_ps(), _CMP_GT_OQ ) );
+	line_r = _mm256_mul_ps( line_r, vec_len2 );
+	line_g = _mm256_mul_ps( line_g, vec_len2 );
+	line_b = _mm256_mul_ps( line_b, vec_len2 );
+	dot_offset = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( line_r, _mm256_cvtepi32_ps( c0[0] ) ),
+			_mm256_mul_ps( line_g, _mm256_cvtepi32_ps( c0[1] ) ) ), _mm256_mul_ps( line_b, _mm256_cvtepi32_ps( c0[2] ) ) );
+	bits = _mm256_setzero_si256();
+	for( i = 0; i < 16; ++i )
+	{
+		__m256i value, gray;
+		dot = _mm256_sub_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( line_r, r[i] ), _mm256_mul_ps( line_g, g[i] ) ),
+				_mm256_mul_ps( line_b, b[i] ) ), dot_offset );
+		value = clamp_epi32_avx2( _mm256_cvttps_epi32( _mm256_add_ps( _mm256_mul_ps( dot, _mm256_set1_ps( 3.0f ) ),
+				_mm256_set1_ps( 0.5f ) ) ), 0, 3 );
+		/*	the { 0, 2, 3, 1 } swizzle is the Gray code with its two bits swapped	*/
+		gray = _mm256_xor_si256( value, _mm256_srli_epi32( value, 1 ) );
+		value = _mm256_or_si256( _mm256_slli_epi32( _mm256_and_si256( gray, _mm256_set1_epi32( 1 ) ), 1 ),
+				_mm256_srli_epi32( gray, 1 ) );
+		bits = _mm256_or_si256( bits, _mm256_sllv_epi32( value, _mm256_set1_epi32( 2*i ) ) );
+	}
+	_mm256_storeu_si256( (__m256i*)ends, _mm256_or_si256( enc_c0, _mm256_slli_epi32( enc_c1, 16 ) ) );
+	_mm256_storeu_si256( (__m256i*)indices, bits );
+	for( k = 0; k < 8; ++k )
+	{
+		unsigned char *out = compressed + k*stride;
+		for( i = 0; i < 4; ++i )
+		{
+			out[i] = (unsigned char)(ends[k] >> (8*i));
+			out[4+i] = (unsigned char)(indices[k] >> (8*i));
+		}
+	}
+}
+
+/*
+	compress_DDS_alpha_block for 8 blocks at once, alpha of pixel p
+	of block k at [p][k], block k written to compressed + k*stride.
+*/
+SOIL_TARGET_AVX2
+static void compress_DDS_alpha_blocks_avx2(
+		const unsigned char alpha[16][8],
+		unsigned char *compressed, int stride )
+{
+	/*	stupid order, looked up per byte	*/
+	const __m256i swizzle8 = _mm256_setr_epi8(
+			1, 7, 6, 5, 4, 3, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+			1, 7, 6, 5, 4, 3, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0 );
+	__m256i a[16], a0, a1, lo, hi;
+	__m256 scale_me;
+	int i, k;
+	unsigned int ends[8], lo_bits[8], hi_bits[8];
+	a0 = a1 = a[0] = _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*)alpha[0] ) );
+	for( i = 1; i < 16; ++i )
+	{
+		a[i] = _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*)alpha[i] ) );
+		a0 = _mm256_max_epi32( a0, a[i] );
+		a1 = _mm256_min_epi32( a1, a[i] );
+	}
+	/*	infinite for a flat block, the NaNs that gives become index 0
+		just as they do in the C code	*/
+	scale_me = _mm256_div_ps( _mm256_set1_ps( 7.9999f ), _mm256_cvtepi32_ps( _mm256_sub_epi32( a0, a1 ) ) );
+	lo = hi = _mm256_setzero_si256();
+	for( i = 0; i < 16; ++i )
+	{
+		__m256i value = _mm256_cvttps_epi32( _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_sub_epi32( a[i], a1 ) ), scale_me ) );
+		value = _mm256_and_si256( _mm256_shuffle_epi8( swizzle8, _mm256_and_si256( value, _mm256_set1_epi32( 7 ) ) ),
+				_mm256_set1_epi32( 255 ) );
+		/*	3 bits each, the first 8 in bytes 2-4, the rest in bytes 5-7	*/
+		if( i < 8 )
+		{
+			lo = _mm256_or_si256( lo, _mm256_sllv_epi32( value, _mm256_set1_epi32( 3*i ) ) );
+		} else
+		{
+			hi = _mm256_or_si256( hi, _mm256_sllv_epi32( value, _mm256_set1_epi32( 3*(i-8) ) ) );
+		}
+	}
+	_mm256_storeu_si256( (__m256i*)ends, _mm256_or_si256( a0, _mm256_slli_epi32( a1, 8 ) ) );
+	_mm256_storeu_si256( (__m256i*)lo_bits, lo );
+	_mm256_storeu_si256( (__m256i*)hi_bits, hi );
+	for( k = 0; k < 8; ++k )
+	{
+		unsigned char *out = compressed + k*stride;
+		out[0] = (unsigned char)ends[k];
+		out[1] = (unsigned char)(ends[k] >> 8);
+		for( i = 0; i < 3; ++i )
+		{
+			out[2+i] = (unsigned char)(lo_bits[k] >> (8*i));
+			out[5+i] = (unsigned char)(hi_bits[k] >> (8*i));
+		}
+	}
+}
+
+/*
+	compress_DDS_color_block_range_fit for 8 blocks at once, all
+	in 32 bit integers, laid out as for compress_DDS_color_blocks_avx2.
+	The products are pairs of 16 bit values through madd, which is
+	exact here and much cheaper than a 32 bit multiply.
+*/
+SOIL_TARGET_AVX2
+static void compress_DDS_color_blocks_range_fit_avx2(
+		const unsigned char pixels[16*3][8],
+		unsigned char *compressed, int stride )
+{
+	__m256i px[16][3], rg[16], lo[3], hi[3], sum[3], c0[3], c1[3];
+	__m256i cov_rg, cov_gb, cov_rb, swap_r, swap_b, enc_hi, enc_lo, enc_c0, enc_c1;
+	__m256i dir_rg, dir_b, offset, len2, len2_3, len2_5, bits;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi32( 1 );
+	int i, k;
+	unsigned int ends[8], indices[8];
+	for( i = 0; i < 16; ++i )
+	{
+		for( k = 0; k < 3; ++k )
+		{
+			px[i][k] = _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*)pixels[i*3+k] ) );
+		}
+		/*	red and green as the two 16 bit halves of each lane	*/
+		rg[i] = _mm256_or_si256( px[i][0], _mm256_slli_epi32( px[i][1], 16 ) );
+	}
+	for( k = 0; k < 3; ++k )
+	{
+		lo[k] = hi[k] = sum[k] = px[0][k];
+		for( i = 1; i < 16; ++i )
+		{
+			lo[k] = _mm256_min_epi32( lo[k], px[i][k] );
+			hi[k] = _mm256_max_epi32( hi[k], px[i][k] );
+			sum[k] = _mm256_add_epi32( sum[k], px[i][k] );
+		}
+	}
+	/*	16 sum( r*g ) - sum( r )*sum( g ) has the sign of the covariance	*/
+	cov_rg = cov_gb = cov_rb = zero;
+	for( i = 0; i < 16; ++i )
+	{
+		cov_rg = _mm256_add_epi32( cov_rg, _mm256_madd_epi16( px[i][0], px[i][1] ) );
+		cov_gb = _mm256_add_epi32( cov_gb, _mm256_madd_epi16( px[i][1], px[i][2] ) );
+		cov_rb = _mm256_add_epi32( cov_rb, _mm256_madd_epi16( px[i][0], px[i][2] ) );
+	}
+	cov_rg = _mm256_sub_epi32( _mm256_slli_epi32( cov_rg, 4 ), _mm256_madd_epi16( sum[0], sum[1] ) );
+	cov_gb = _mm256_sub_epi32( _mm256_slli_epi32( cov_gb, 4 ), _mm256_madd_epi16( sum[1], sum[2] ) );
+	cov_rb = _mm256_sub_epi32( _mm256_slli_epi32( cov_rb, 4 ), _mm256_madd_epi16( sum[0], sum[2] ) );
+	for( k = 0; k < 3; ++k )
+	{
+		const __m256i inset = _mm256_srai_epi32( _mm256_sub_epi32( hi[k], lo[k] ), 4 );
+		lo[k] = _mm256_add_epi32( lo[k], inset );
+		hi[k] = _mm256_sub_epi32( hi[k], inset );
+	}
+	/*	the same choice of diagonal, as all-ones masks	*/
+	{
+		const __m256i rg_neg = _mm256_cmpgt_epi32( zero, cov_rg );
+		const __m256i gb_neg = _mm256_cmpgt_epi32( zero, cov_gb );
+		const __m256i rb_neg = _mm256_cmpgt_epi32( zero, cov_rb );
+		const __m256i rg_zero = _mm256_cmpeq_epi32( cov_rg, zero );
+		const __m256i gb_zero = _mm256_cmpeq_epi32( cov_gb, zero );
+		swap_r = _mm256_blendv_epi8( rg_neg,
+				_mm256_blendv_epi8( _mm256_xor_si256( rb_neg, gb_neg ), rb_neg, gb_zero ), rg_zero );
+		swap_b = _mm256_blendv_epi8( gb_neg, _mm256_xor_si256( rb_neg, swap_r ), gb_zero );
+	}
+	{
+		const __m256i r = lo[0], b = lo[2];
+		lo[0] = _mm256_blendv_epi8( lo[0], hi[0], swap_r );
+		hi[0] = _mm256_blendv_epi8( hi[0], r, swap_r );
+		lo[2] = _mm256_blendv_epi8( lo[2], hi[2], swap_b );
+		hi[2] = _mm256_blendv_epi8( hi[2], b, swap_b );
+	}
+	enc_hi = _mm256_or_si256( _mm256_or_si256( _mm256_slli_epi32( convert_bit_range_avx2( hi[0], 8, 5 ), 11 ),
+			_mm256_slli_epi32( convert_bit_range_avx2( hi[1], 8, 6 ), 5 ) ), convert_bit_range_avx2( hi[2], 8, 5 ) );
+	enc_lo = _mm256_or_si256( _mm256_or_si256( _mm256_slli_epi32( convert_bit_range_avx2( lo[0], 8, 5 ), 11 ),
+			_mm256_slli_epi32( convert_bit_range_avx2( lo[1], 8, 6 ), 5 ) ), convert_bit_range_avx2( lo[2], 8, 5 ) );
+	enc_c0 = _mm256_max_epi32( enc_hi, enc_lo );
+	enc_c1 = _mm256_min_epi32( enc_hi, enc_lo );
+	c0[0] = convert_bit_range_avx2( _mm256_srli_epi32( enc_c0, 11 ), 5, 8 );
+	c0[1] = convert_bit_range_avx2( _mm256_and_si256( _mm256_srli_epi32( enc_c0, 5 ), _mm256_set1_epi32( 63 ) ), 6, 8 );
+	c0[2] = convert_bit_range_avx2( _mm256_and_si256( enc_c0, _mm256_set1_epi32( 31 ) ), 5, 8 );
+	c1[0] = convert_bit_range_avx2( _mm256_srli_epi32( enc_c1, 11 ), 5, 8 );
+	c1[1] = convert_bit_range_avx2( _mm256_and_si256( _mm256_srli_epi32( enc_c1, 5 ), _mm256_set1_epi32( 63 ) ), 6, 8 );
+	c1[2] = convert_bit_range_avx2( _mm256_and_si256( enc_c1, _mm256_set1_epi32( 31 ) ), 5, 8 );
+	/*	dot( px - c1, dir ) as dot( px, dir ) - dot( c1, dir )	*/
+	dir_rg = _mm256_or_si256( _mm256_and_si256( _mm256_sub_epi32( c0[0], c1[0] ), _mm256_set1_epi32( 0xFFFF ) ),
+			_mm256_slli_epi32( _mm256_sub_epi32( c0[1], c1[1] ), 16 ) );
+	dir_b = _mm256_sub_epi32( c0[2], c1[2] );
+	offset = _mm256_add_epi32( _mm256_madd_epi16( _mm256_or_si256( c1[0], _mm256_slli_epi32( c1[1], 16 ) ), dir_rg ),
+			_mm256_madd_epi16( c1[2], dir_b ) );
+	len2 = _mm256_add_epi32( _mm256_madd_epi16( dir_rg, dir_rg ), _mm256_mullo_epi32( dir_b, dir_b ) );
+	len2_3 = _mm256_add_epi32( len2, _mm256_slli_epi32( len2, 1 ) );
+	len2_5 = _mm256_add_epi32( len2, _mm256_slli_epi32( len2, 2 ) );
+	bits = zero;
+	for( i = 0; i < 16; ++i )
+	{
+		__m256i t, thirds, gray;
+		t = _mm256_sub_epi32( _mm256_add_epi32( _mm256_madd_epi16( rg[i], dir_rg ),
+				_mm256_madd_epi16( px[i][2], dir_b ) ), offset );
+		t = _mm256_add_epi32( _mm256_slli_epi32( t, 2 ), _mm256_slli_epi32( t, 1 ) );
+		/*	t >= x is !(x > t), each comparison that holds adds one	*/
+		thirds = _mm256_set1_epi32( 3 );
+		thirds = _mm256_add_epi32( thirds, _mm256_cmpgt_epi32( len2, t ) );
+		thirds = _mm256_add_epi32( thirds, _mm256_cmpgt_epi32( len2_3, t ) );
+		thirds = _mm256_add_epi32( thirds, _mm256_cmpgt_epi32( len2_5, t ) );
+		/*	palette index 3 - thirds, then the Gray code swizzle	*/
+		thirds = _mm256_sub_epi32( _mm256_set1_epi32( 3 ), thirds );
+		gray = _mm256_xor_si256( thirds, _mm256_srli_epi32( thirds, 1 ) );
+		gray = _mm256_or_si256( _mm256_slli_epi32( _mm256_and_si256( gray, one ), 1 ), _mm256_srli_epi32( gray, 1 ) );
+		bits = _mm256_or_si256( bits, _mm256_sllv_epi32( gray, _mm256_set1_epi32( 2*i ) ) );
+	}
+	_mm256_storeu_si256( (__m256i*)ends, _mm256_or_si256( enc_c0, _mm256_slli_epi32( enc_c1, 16 ) ) );
+	_mm256_storeu_si256( (__m256i*)indices, bits );
+	for( k = 0; k < 8; ++k )
+	{
+		unsigned char *out = compressed + k*stride;
+		for( i = 0; i < 4; ++i )
+		{
+			out[i] = (unsigned char)(ends[k] >> (8*i));
+			out[4+i] = (unsigned char)(indices[k] >> (8*i));
+		}
+	}
+}
+
+#endif /* SOIL_DXT_SIMD	*/
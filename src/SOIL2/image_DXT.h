@@ -10,9 +10,40 @@
 #ifndef HEADER_IMAGE_DXT
 #define HEADER_IMAGE_DXT
 
+/**
+	How hard the DXT encoder tries, for the mode parameters below.
+	DXT_MODE_RANGE_FIT: end points from the bounding box of each block,
+		for compressing at load time
+	DXT_MODE_DEFAULT: end points along the principal axis of each block
+	DXT_MODE_CLUSTER_FIT: least squares end points for every ordering of
+		the pixels along that axis, for cooking assets offline; each
+		block keeps whichever of those, the default and the range fit
+		end points has the least error
+**/
+enum
+{
+	DXT_MODE_DEFAULT = 0,
+	DXT_MODE_RANGE_FIT = 1,
+	DXT_MODE_CLUSTER_FIT = 2
+};
+
+/**
+	The block format for save_image_as_DDS.
+	DDS_FORMAT_DXT: DXT1 for 1 or 3 channels, DXT5 for 2 or 4
+	DDS_FORMAT_BC4, DDS_FORMAT_BC5, DDS_FORMAT_BC7: as converted below,
+		written with the DX10 header
+**/
+enum
+{
+	DDS_FORMAT_DXT = 0,
+	DDS_FORMAT_BC4 = 1,
+	DDS_FORMAT_BC5 = 2,
+	DDS_FORMAT_BC7 = 3
+};
+
 /**
 	Converts an image from an array of unsigned chars (RGB or RGBA) to
-	DXT1 or DXT5, then saves the converted image to disk.
+	one of the DDS formats above, then saves the converted image to disk.
 	\return 0 if failed, otherwise returns 1
 **/
 int
@@ -20,7 +51,23 @@ save_image_as_DDS
 (
     const char *filename,
     int width, int height, int channels,
-    const unsigned char *const data
+    const unsigned char *const data,
+    int format,
+    int mode
+);
+
+/**
+	Converts an HDR image of floats (RGB or RGBA, alpha is dropped) to
+	BC6H, signed if any value is negative, then saves it to disk.
+	\return 0 if failed, otherwise returns 1
+**/
+int
+save_image_as_DDS_BC6H
+(
+    const char *filename,
+    int width, int height, int channels,
+    const float *const data,
+    int mode
 );
 
 /**
@@ -31,6 +78,7 @@ convert_image_to_DXT1
 (
     const unsigned char *const uncompressed,
     int width, int height, int channels,
+    int mode,
     int *out_size
 );
 
@@ -42,6 +90,58 @@ convert_image_to_DXT5
 (
     const unsigned char *const uncompressed,
     int width, int height, int channels,
+    int mode,
+    int *out_size
+);
+
+/**
+	take an image and convert it to BC4 (one channel, the first one)
+**/
+unsigned char*
+convert_image_to_BC4
+(
+    const unsigned char *const uncompressed,
+    int width, int height, int channels,
+    int mode,
+    int *out_size
+);
+
+/**
+	take an image and convert it to BC5 (two channels, the first two,
+	e.g. the X and Y of a normal map)
+**/
+unsigned char*
+convert_image_to_BC5
+(
+    const unsigned char *const uncompressed,
+    int width, int height, int channels,
+    int mode,
+    int *out_size
+);
+
+/**
+	take an image and convert it to BC7 (RGBA, high quality)
+**/
+unsigned char*
+convert_image_to_BC7
+(
+    const unsigned char *const uncompressed,
+    int width, int height, int channels,
+    int mode,
+    int *out_size
+);
+
+/**
+	take an HDR image of floats and convert it to BC6H (RGB), signed
+	or unsigned (where negative values become 0)
+**/
+unsigned char*
+convert_image_to_BC6H
+(
+    const float *const uncompressed,
+    int width, int height, int channels,
+    int is_signed,
+    int mode,
     int *out_size
 );
 
@@ -85,6 +185,17 @@ typedef struct
 }
 DDS_header ;
 
+/*	follows DDS_header when the FourCC is 'DX10'	*/
+typedef struct
+{
+    unsigned int    dxgiFormat;
+    unsigned int    resourceDimension;
+    unsigned int    miscFlag;
+    unsigned int    arraySize;
+    unsigned int    miscFlags2;
+}
+DDS_header_DXT10 ;
+
 /*	the following constants were copied directly off the MSDN website	*/
 
 /*	The dwFlags member of the original DDSURFACEDESC2 structure
@@ -120,4 +231,24 @@ DDS_header ;
 #define DDSCAPS2_CUBEMAP_NEGATIVEZ	0x00008000
 #define DDSCAPS2_VOLUME	0x00200000
 
+/*	The block compressed formats of the DXGI_FORMAT enumeration	*/
+#define DXGI_FORMAT_BC1_UNORM	71
+#define DXGI_FORMAT_BC1_UNORM_SRGB	72
+#define DXGI_FORMAT_BC2_UNORM	74
+#define DXGI_FORMAT_BC2_UNORM_SRGB	75
+#define DXGI_FORMAT_BC3_UNORM	77
+#define DXGI_FORMAT_BC3_UNORM_SRGB	78
+#define DXGI_FORMAT_BC4_UNORM	80
+#define DXGI_FORMAT_BC4_SNORM	81
+#define DXGI_FORMAT_BC5_UNORM	83
+#define DXGI_FORMAT_BC5_SNORM	84
+#define DXGI_FORMAT_BC6H_UF16	95
+#define DXGI_FORMAT_BC6H_SF16	96
+#define DXGI_FORMAT_BC7_UNORM	98
+#define DXGI_FORMAT_BC7_UNORM_SRGB	99
+
+/*	DDS_header_DXT10 resourceDimension and miscFlag	*/
+#define DDS_DIMENSION_TEXTURE2D	3
+#define DDS_RESOURCE_MISC_TEXTURECUBE	0x00000004
+
 #endif /* HEADER_IMAGE_DXT	*/
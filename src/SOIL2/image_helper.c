@@ -7,48 +7,407 @@
 */
 
 #include "image_helper.h"
+#include "parallel_helper.h"
+#include "profile_helper.h"
+#include "simd_helper.h"
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <float.h>
 
-/*	Upscaling the image uses simple bilinear interpolation	*/
-int
-	up_scale_image
-	(
-		const unsigned char* const orig,
-		int width, int height, int channels,
-		unsigned char* resampled,
-		int resampled_width, int resampled_height
-	)
+/*	rows of output per parallel job	*/
+#define SOIL_RESAMPLE_GRAIN 16
+
+typedef struct
 {
+	const unsigned char *orig;
+	int width, height, channels;
+	unsigned char *resampled;
+	int resampled_width, resampled_height;
 	float dx, dy;
+	int simd;
+} up_scale_job;
+
+/*
+	SIMD kernels.  Each one does exactly what the plain C code
+	next to it does, only several channels or pixels at a time,
+	and is picked at runtime through soil_simd_level.
+*/
+
+/*	the bilinear weights are only bit exact if the C code rounds
+	every float operation to float, not to x87 long double	*/
+#if defined( FLT_EVAL_METHOD ) && ( FLT_EVAL_METHOD == 0 ) && defined( SOIL_SIMD_X86 )
+	#define SOIL_SIMD_UP_SCALE
+#endif
+
+#if defined( SOIL_SIMD_X86 )
+
+/*	sums of the horizontally neighbouring pixels in two vectors
+	of 8 u16, packed into one vector of 8 u16	*/
+static __m128i box_pair_sums_sse2( __m128i a, __m128i b, int channels )
+{
+	switch( channels )
+	{
+	case 1:
+		a = _mm_madd_epi16( a, _mm_set1_epi16( 1 ) );
+		b = _mm_madd_epi16( b, _mm_set1_epi16( 1 ) );
+		return _mm_packs_epi32( a, b );
+	case 2:
+		a = _mm_add_epi16( a, _mm_srli_epi64( a, 32 ) );
+		b = _mm_add_epi16( b, _mm_srli_epi64( b, 32 ) );
+		a = _mm_shuffle_epi32( a, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+		b = _mm_shuffle_epi32( b, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+		return _mm_unpacklo_epi64( a, b );
+	default:
+		a = _mm_add_epi16( a, _mm_srli_si128( a, 8 ) );
+		b = _mm_add_epi16( b, _mm_srli_si128( b, 8 ) );
+		return _mm_unpacklo_epi64( a, b );
+	}
+}
+
+/*	1, 2 and 4 channels, 16 output bytes at a time	*/
+static int box_2x2_row_sse2( const unsigned char *row0, const unsigned char *row1,
+		unsigned char *out, int count, int channels )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i two = _mm_set1_epi16( 2 );
+	const int bytes = count*channels;
+	int done;
+	if( 3 == channels )
+	{
+		return 0;
+	}
+	for( done = 0; done + 16 <= bytes; done += 16 )
+	{
+		const __m128i a0 = _mm_loadu_si128( (const __m128i*)(row0 + 2*done) );
+		const __m128i a1 = _mm_loadu_si128( (const __m128i*)(row0 + 2*done + 16) );
+		const __m128i b0 = _mm_loadu_si128( (const __m128i*)(row1 + 2*done) );
+		const __m128i b1 = _mm_loadu_si128( (const __m128i*)(row1 + 2*done + 16) );
+		/*	the two rows added up, then each pixel with its neighbour	*/
+		__m128i s0 = box_pair_sums_sse2(
+				_mm_add_epi16( _mm_unpacklo_epi8( a0, zero ), _mm_unpacklo_epi8( b0, zero ) ),
+				_mm_add_epi16( _mm_unpackhi_epi8( a0, zero ), _mm_unpackhi_epi8( b0, zero ) ),
+				channels );
+		__m128i s1 = box_pair_sums_sse2(
+				_mm_add_epi16( _mm_unpacklo_epi8( a1, zero ), _mm_unpacklo_epi8( b1, zero ) ),
+				_mm_add_epi16( _mm_unpackhi_epi8( a1, zero ), _mm_unpackhi_epi8( b1, zero ) ),
+				channels );
+		s0 = _mm_srli_epi16( _mm_add_epi16( s0, two ), 2 );
+		s1 = _mm_srli_epi16( _mm_add_epi16( s1, two ), 2 );
+		_mm_storeu_si128( (__m128i*)(out + done), _mm_packus_epi16( s0, s1 ) );
+	}
+	return done / channels;
+}
+
+SOIL_TARGET_AVX2
+static __m256i box_pair_sums_avx2( __m256i a, __m256i b, int channels )
+{
+	switch( channels )
+	{
+	case 1:
+		a = _mm256_madd_epi16( a, _mm256_set1_epi16( 1 ) );
+		b = _mm256_madd_epi16( b, _mm256_set1_epi16( 1 ) );
+		return _mm256_packs_epi32( a, b );
+	case 2:
+		a = _mm256_add_epi16( a, _mm256_srli_epi64( a, 32 ) );
+		b = _mm256_add_epi16( b, _mm256_srli_epi64( b, 32 ) );
+		a = _mm256_shuffle_epi32( a, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+		b = _mm256_shuffle_epi32( b, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+		return _mm256_unpacklo_epi64( a, b );
+	default:
+		a = _mm256_add_epi16( a, _mm256_srli_si256( a, 8 ) );
+		b = _mm256_add_epi16( b, _mm256_srli_si256( b, 8 ) );
+		return _mm256_unpacklo_epi64( a, b );
+	}
+}
+
+/*	3 channels, 4 output pixels at a time, gathering the first
+	and the second pixel of each pair with byte shuffles.  Only
+	SSSE3, but reached through the AVX2 dispatch, which has it	*/
+SOIL_TARGET_AVX2
+static int box_2x2_row_rgb_ssse3( const unsigned char *row0, const unsigned char *row1,
+		unsigned char *out, int count )
+{
+	/*	x holds input bytes 0-15 and y bytes 8-23, -1 leaves a zero	*/
+	const __m128i first_lo_x = _mm_setr_epi8( 0, -1, 1, -1, 2, -1, 6, -1, 7, -1, 8, -1, 12, -1, 13, -1 );
+	const __m128i second_lo_x = _mm_setr_epi8( 3, -1, 4, -1, 5, -1, 9, -1, 10, -1, 11, -1, -1, -1, -1, -1 );
+	const __m128i second_lo_y = _mm_setr_epi8( -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 7, -1, 8, -1 );
+	const __m128i first_hi_x = _mm_setr_epi8( 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 );
+	const __m128i first_hi_y = _mm_setr_epi8( -1, -1, 10, -1, 11, -1, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1 );
+	const __m128i second_hi_y = _mm_setr_epi8( 9, -1, 13, -1, 14, -1, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1 );
+	const __m128i two = _mm_set1_epi16( 2 );
+	int done, row;
+	for( done = 0; done + 4 <= count; done += 4 )
+	{
+		__m128i lo = two, hi = two, packed;
+		for( row = 0; row < 2; ++row )
+		{
+			const unsigned char *in = (0 == row ? row0 : row1) + done*6;
+			const __m128i x = _mm_loadu_si128( (const __m128i*)in );
+			const __m128i y = _mm_loadu_si128( (const __m128i*)(in + 8) );
+			lo = _mm_add_epi16( lo, _mm_shuffle_epi8( x, first_lo_x ) );
+			lo = _mm_add_epi16( lo, _mm_or_si128( _mm_shuffle_epi8( x, second_lo_x ), _mm_shuffle_epi8( y, second_lo_y ) ) );
+			hi = _mm_add_epi16( hi, _mm_or_si128( _mm_shuffle_epi8( x, first_hi_x ), _mm_shuffle_epi8( y, first_hi_y ) ) );
+			hi = _mm_add_epi16( hi, _mm_shuffle_epi8( y, second_hi_y ) );
+		}
+		packed = _mm_packus_epi16( _mm_srli_epi16( lo, 2 ), _mm_srli_epi16( hi, 2 ) );
+		/*	12 bytes, anything more would belong to the next pixels	*/
+		_mm_storel_epi64( (__m128i*)(out + done*3), packed );
+		{
+			int last = _mm_cvtsi128_si32( _mm_srli_si128( packed, 8 ) );
+			memcpy( out + done*3 + 8, &last, 4 );
+		}
+	}
+	return done;
+}
+
+/*	32 output bytes at a time.  Each 128 bit lane does what the
+	SSE2 code does for 16 of them, so nothing crosses lanes	*/
+SOIL_TARGET_AVX2
+static int box_2x2_row_avx2( const unsigned char *row0, const unsigned char *row1,
+		unsigned char *out, int count, int channels )
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i two = _mm256_set1_epi16( 2 );
+	const int bytes = count*channels;
+	int done;
+	if( 3 == channels )
+	{
+		return box_2x2_row_rgb_ssse3( row0, row1, out, count );
+	}
+	for( done = 0; done + 32 <= bytes; done += 32 )
+	{
+		const unsigned char *in0 = row0 + 2*done;
+		const unsigned char *in1 = row1 + 2*done;
+		/*	lane 0 gets input bytes 0-31, lane 1 bytes 32-63	*/
+		const __m256i a0 = _mm256_inserti128_si256( _mm256_castsi128_si256(
+				_mm_loadu_si128( (const __m128i*)in0 ) ), _mm_loadu_si128( (const __m128i*)(in0 + 32) ), 1 );
+		const __m256i a1 = _mm256_inserti128_si256( _mm256_castsi128_si256(
+				_mm_loadu_si128( (const __m128i*)(in0 + 16) ) ), _mm_loadu_si128( (const __m128i*)(in0 + 48) ), 1 );
+		const __m256i b0 = _mm256_inserti128_si256( _mm256_castsi128_si256(
+				_mm_loadu_si128( (const __m128i*)in1 ) ), _mm_loadu_si128( (const __m128i*)(in1 + 32) ), 1 );
+		const __m256i b1 = _mm256_inserti128_si256( _mm256_castsi128_si256(
+				_mm_loadu_si128( (const __m128i*)(in1 + 16) ) ), _mm_loadu_si128( (const __m128i*)(in1 + 48) ), 1 );
+		__m256i s0 = box_pair_sums_avx2(
+				_mm256_add_epi16( _mm256_unpacklo_epi8( a0, zero ), _mm256_unpacklo_epi8( b0, zero ) ),
+				_mm256_add_epi16( _mm256_unpackhi_epi8( a0, zero ), _mm256_unpackhi_epi8( b0, zero ) ),
+				channels );
+		__m256i s1 = box_pair_sums_avx2(
+				_mm256_add_epi16( _mm256_unpacklo_epi8( a1, zero ), _mm256_unpacklo_epi8( b1, zero ) ),
+				_mm256_add_epi16( _mm256_unpackhi_epi8( a1, zero ), _mm256_unpackhi_epi8( b1, zero ) ),
+				channels );
+		s0 = _mm256_srli_epi16( _mm256_add_epi16( s0, two ), 2 );
+		s1 = _mm256_srli_epi16( _mm256_add_epi16( s1, two ), 2 );
+		_mm256_storeu_si256( (__m256i*)(out + done), _mm256_packus_epi16( s0, s1 ) );
+	}
+	/*	what's left may still fill a 16 byte step	*/
+	done /= channels;
+	return done + box_2x2_row_sse2( row0 + done*2*channels, row1 + done*2*channels,
+			out + done*channels, count - done, channels );
+}
+
+#endif /* SOIL_SIMD_X86	*/
+
+#if defined( SOIL_SIMD_NEON_AVAILABLE )
+
+/*	8 output pixels at a time, any number of channels: the
+	structure loads split the channels, and a pairwise add
+	sums each pixel with its neighbour	*/
+static int box_2x2_row_neon( const unsigned char *row0, const unsigned char *row1,
+		unsigned char *out, int count, int channels )
+{
+	int done;
+	for( done = 0; done + 8 <= count; done += 8 )
+	{
+		const unsigned char *in0 = row0 + done*2*channels;
+		const unsigned char *in1 = row1 + done*2*channels;
+		unsigned char *dst = out + done*channels;
+		switch( channels )
+		{
+		case 1:
+			vst1_u8( dst, vrshrn_n_u16( vaddq_u16( vpaddlq_u8( vld1q_u8( in0 ) ), vpaddlq_u8( vld1q_u8( in1 ) ) ), 2 ) );
+			break;
+		case 2:
+			{
+				uint8x16x2_t a = vld2q_u8( in0 ), b = vld2q_u8( in1 );
+				uint8x8x2_t r;
+				r.val[0] = vrshrn_n_u16( vaddq_u16( vpaddlq_u8( a.val[0] ), vpaddlq_u8( b.val[0] ) ), 2 );
+				r.val[1] = vrshrn_n_u16( vaddq_u16( vpaddlq_u8( a.val[1] ), vpaddlq_u8( b.val[1] ) ), 2 );
+				vst2_u8( dst, r );
+			}
+			break;
+		case 3:
+			{
+				uint8x16x3_t a = vld3q_u8( in0 ), b = vld3q_u8( in1 );
+				uint8x8x3_t r;
+				r.val[0] = vrshrn_n_u16( vaddq_u16( vpaddlq_u8( a.val[0] ), vpaddlq_u8( b.val[0] ) ), 2 );
+				r.val[1] = vrshrn_n_u16( vaddq_u16( vpaddlq_u8( a.val[1] ), vpaddlq_u8( b.val[1] ) ), 2 );
+				r.val[2] = vrshrn_n_u16( vaddq_u16( vpaddlq_u8( a.val[2] ), vpaddlq_u8( b.val[2] ) ), 2 );
+				vst3_u8( dst, r );
+			}
+			break;
+		default:
+			{
+				uint8x16x4_t a = vld4q_u8( in0 ), b = vld4q_u8( in1 );
+				uint8x8x4_t r;
+				r.val[0] = vrshrn_n_u16( vaddq_u16( vpaddlq_u8( a.val[0] ), vpaddlq_u8( b.val[0] ) ), 2 );
+				r.val[1] = vrshrn_n_u16( vaddq_u16( vpaddlq_u8( a.val[1] ), vpaddlq_u8( b.val[1] ) ), 2 );
+				r.val[2] = vrshrn_n_u16( vaddq_u16( vpaddlq_u8( a.val[2] ), vpaddlq_u8( b.val[2] ) ), 2 );
+				r.val[3] = vrshrn_n_u16( vaddq_u16( vpaddlq_u8( a.val[3] ), vpaddlq_u8( b.val[3] ) ), 2 );
+				vst4_u8( dst, r );
+			}
+			break;
+		}
+	}
+	return done;
+}
+
+#endif /* SOIL_SIMD_NEON_AVAILABLE	*/
+
+/*	averages the 2x2 blocks under count output pixels of two rows,
+	rounding to nearest.  Returns how many pixels it did, the
+	caller does the rest in plain C.	*/
+static int box_2x2_row( int simd, const unsigned char *row0, const unsigned char *row1,
+		unsigned char *out, int count, int channels )
+{
+	if( (channels < 1) || (channels > 4) )
+	{
+		return 0;
+	}
+	switch( simd )
+	{
+#if defined( SOIL_SIMD_X86 )
+	case SOIL_SIMD_AVX2:
+		return box_2x2_row_avx2( row0, row1, out, count, channels );
+	case SOIL_SIMD_SSE2:
+		return box_2x2_row_sse2( row0, row1, out, count, channels );
+#endif
+#if defined( SOIL_SIMD_NEON_AVAILABLE )
+	case SOIL_SIMD_NEON:
+		return box_2x2_row_neon( row0, row1, out, count, channels );
+#endif
+	default:
+		return 0;
+	}
+}
+
+#if defined( SOIL_SIMD_UP_SCALE )
+
+/*	a pixel's channels as floats, reading 4 bytes unless that
+	would go past the end of the image	*/
+static __m128i load_pixel_epi32( const unsigned char *p, const unsigned char *end, int channels )
+{
+	int v = 0;
+	if( p + 4 <= end )
+	{
+		memcpy( &v, p, 4 );
+	} else
+	{
+		memcpy( &v, p, channels );
+	}
+	return _mm_cvtsi32_si128( v );
+}
+
+static void store_pixel( unsigned char *out, int packed, int channels )
+{
+	if( 4 == channels )
+	{
+		memcpy( out, &packed, 4 );
+	} else
+	{
+		int c;
+		for( c = 0; c < channels; ++c )
+		{
+			out[c] = (unsigned char)(packed >> (8*c));
+		}
+	}
+}
+
+/*	one output row, the channels of a pixel side by side.  With
+	only one or two channels most lanes would idle and the plain
+	C code is as fast, so this is for 3 and 4 (and sizes of at
+	least 2x2, below that the C code is used too)	*/
+static void up_scale_row_sse2( const up_scale_job *job, int y )
+{
+	const unsigned char* const orig = job->orig;
+	const int width = job->width;
+	const int height = job->height;
+	const int channels = job->channels;
+	const int stride = width*channels;
+	const unsigned char *end = orig + stride*height;
+	unsigned char *out = job->resampled + y*job->resampled_width*channels;
+	const __m128i zero = _mm_setzero_si128();
+	__m128 wy0, wy1;
+	float sampley = y * job->dy;
+	int inty = (int)sampley;
+	int x;
+	if( inty > height - 2 ) { inty = height - 2; }
+	sampley -= inty;
+	wy0 = _mm_set1_ps( 1.0f - sampley );
+	wy1 = _mm_set1_ps( sampley );
+	for( x = 0; x < job->resampled_width; ++x )
+	{
+		float samplex = x * job->dx;
+		int intx = (int)samplex;
+		const unsigned char *p;
+		__m128 wx0, wx1, value;
+		__m128i packed;
+		if( intx > width - 2 ) { intx = width - 2; }
+		samplex -= intx;
+		wx0 = _mm_set1_ps( 1.0f - samplex );
+		wx1 = _mm_set1_ps( samplex );
+		p = orig + inty*stride + intx*channels;
+		/*	same operations in the same order as the C code	*/
+		value = _mm_set1_ps( 0.5f );
+		value = _mm_add_ps( value, _mm_mul_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( _mm_unpacklo_epi8(
+				load_pixel_epi32( p, end, channels ), zero ), zero ) ), wx0 ), wy0 ) );
+		value = _mm_add_ps( value, _mm_mul_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( _mm_unpacklo_epi8(
+				load_pixel_epi32( p + channels, end, channels ), zero ), zero ) ), wx1 ), wy0 ) );
+		value = _mm_add_ps( value, _mm_mul_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( _mm_unpacklo_epi8(
+				load_pixel_epi32( p + stride, end, channels ), zero ), zero ) ), wx0 ), wy1 ) );
+		value = _mm_add_ps( value, _mm_mul_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( _mm_unpacklo_epi8(
+				load_pixel_epi32( p + stride + channels, end, channels ), zero ), zero ) ), wx1 ), wy1 ) );
+		packed = _mm_cvttps_epi32( value );
+		packed = _mm_packus_epi16( _mm_packs_epi32( packed, packed ), zero );
+		store_pixel( out + x*channels, _mm_cvtsi128_si32( packed ), channels );
+	}
+}
+
+#endif /* SOIL_SIMD_UP_SCALE	*/
+
+static void up_scale_rows( void *context, int y_begin, int y_end )
+{
+	const up_scale_job *job = (const up_scale_job*)context;
+	const unsigned char* const orig = job->orig;
+	const int width = job->width;
+	const int height = job->height;
+	const int channels = job->channels;
+	unsigned char* resampled = job->resampled;
+	const int resampled_width = job->resampled_width;
 	int x, y, c;
 
-    /* error(s) check	*/
-    if ( 	(width < 1) || (height < 1) ||
-            (resampled_width < 2) || (resampled_height < 2) ||
-            (channels < 1) ||
-            (NULL == orig) || (NULL == resampled) )
-    {
-        /*	signify badness	*/
-        return 0;
-    }
-    /*
-		for each given pixel in the new map, find the exact location
-		from the original map which would contribute to this guy
-	*/
-    dx = (width - 1.0f) / (resampled_width - 1.0f);
-    dy = (height - 1.0f) / (resampled_height - 1.0f);
-    for ( y = 0; y < resampled_height; ++y )
+#if defined( SOIL_SIMD_UP_SCALE )
+	if( (job->simd != SOIL_SIMD_NONE) && (channels >= 3) && (channels <= 4) &&
+		(width >= 2) && (height >= 2) )
+	{
+		for( y = y_begin; y < y_end; ++y )
+		{
+			up_scale_row_sse2( job, y );
+		}
+		return;
+	}
+#endif
+    for ( y = y_begin; y < y_end; ++y )
     {
     	/* find the base y index and fractional offset from that	*/
-    	float sampley = y * dy;
+    	float sampley = y * job->dy;
     	int inty = (int)sampley;
     	/*	if( inty < 0 ) { inty = 0; } else	*/
 		if( inty > height - 2 ) { inty = height - 2; }
 		sampley -= inty;
         for ( x = 0; x < resampled_width; ++x )
         {
-			float samplex = x * dx;
+			float samplex = x * job->dx;
 			int intx = (int)samplex;
 			int base_index;
 			/* find the base x index and fractional offset from that	*/
@@ -77,10 +436,119 @@ int
             }
         }
     }
+}
+
+/*	Upscaling the image uses simple bilinear interpolation	*/
+int
+	up_scale_image
+	(
+		const unsigned char* const orig,
+		int width, int height, int channels,
+		unsigned char* resampled,
+		int resampled_width, int resampled_height
+	)
+{
+	up_scale_job job;
+
+    /* error(s) check	*/
+    if ( 	(width < 1) || (height < 1) ||
+            (resampled_width < 2) || (resampled_height < 2) ||
+            (channels < 1) ||
+            (NULL == orig) || (NULL == resampled) )
+    {
+        /*	signify badness	*/
+        return 0;
+    }
+    /*
+		for each given pixel in the new map, find the exact location
+		from the original map which would contribute to this guy
+	*/
+	job.orig = orig;
+	job.width = width;
+	job.height = height;
+	job.channels = channels;
+	job.resampled = resampled;
+	job.resampled_width = resampled_width;
+	job.resampled_height = resampled_height;
+    job.dx = (width - 1.0f) / (resampled_width - 1.0f);
+    job.dy = (height - 1.0f) / (resampled_height - 1.0f);
+	job.simd = soil_simd_level();
+	/*	every output row is independent	*/
+	soil_zone_begin( "SOIL2::up_scale_image" );
+	soil_parallel_for( up_scale_rows, &job, resampled_height, SOIL_RESAMPLE_GRAIN );
+	soil_zone_end();
     /*	done	*/
     return 1;
 }
 
+typedef struct
+{
+	const unsigned char *orig;
+	int width, height, channels;
+	unsigned char *resampled;
+	int block_size_x, block_size_y;
+	int mip_width;
+	int simd;
+} mipmap_job;
+
+static void mipmap_rows( void *context, int j_begin, int j_end )
+{
+	const mipmap_job *job = (const mipmap_job*)context;
+	const unsigned char* const orig = job->orig;
+	const int width = job->width;
+	const int height = job->height;
+	const int channels = job->channels;
+	const int block_size_x = job->block_size_x;
+	const int block_size_y = job->block_size_y;
+	const int mip_width = job->mip_width;
+	int i, j, c;
+
+	for( j = j_begin; j < j_end; ++j )
+	{
+		i = 0;
+		/*	whole 2x2 blocks, the only kind that halving an image has	*/
+		if( (2 == block_size_x) && (2 == block_size_y) && (2*(j+1) <= height) )
+		{
+			const unsigned char *row0 = orig + 2*j*width*channels;
+			i = box_2x2_row( job->simd, row0, row0 + width*channels,
+					job->resampled + j*mip_width*channels, width / 2, channels );
+		}
+		for( ; i < mip_width; ++i )
+		{
+			for( c = 0; c < channels; ++c )
+			{
+				const int index = (j*block_size_y)*width*channels + (i*block_size_x)*channels + c;
+				int sum_value;
+				int u,v;
+				int u_block = block_size_x;
+				int v_block = block_size_y;
+				int block_area;
+				/*	do a bit of checking so we don't over-run the boundaries
+					(necessary for non-square textures!)	*/
+				if( block_size_x * (i+1) > width )
+				{
+					u_block = width - i*block_size_y;
+				}
+				if( block_size_y * (j+1) > height )
+				{
+					v_block = height - j*block_size_y;
+				}
+				block_area = u_block*v_block;
+				/*	for this pixel, see what the average
+					of all the values in the block are.
+					note: start the sum at the rounding value, not at 0	*/
+				sum_value = block_area >> 1;
+				for( v = 0; v < v_block; ++v )
+				for( u = 0; u < u_block; ++u )
+				{
+					sum_value += orig[index + v*width*channels + u*channels];
+				}
+				job->resampled[j*mip_width*channels + i*channels + c] = sum_value / block_area;
+			}
+		}
+	}
+}
+
 int
 	mipmap_image
 	(
@@ -91,7 +559,7 @@ int
 	)
 {
 	int mip_width, mip_height;
-	int i, j, c;
+	mipmap_job job;
 
 	/*	error check	*/
 	if( (width < 1) || (height < 1) ||
@@ -112,43 +580,234 @@ int
 	{
 		mip_height = 1;
 	}
-	for( j = 0; j < mip_height; ++j )
+	job.orig = orig;
+	job.width = width;
+	job.height = height;
+	job.channels = channels;
+	job.resampled = resampled;
+	job.block_size_x = block_size_x;
+	job.block_size_y = block_size_y;
+	job.mip_width = mip_width;
+	job.simd = soil_simd_level();
+	/*	every output row is independent	*/
+	soil_zone_begin( "SOIL2::mipmap_image" );
+	soil_parallel_for( mipmap_rows, &job, mip_height, SOIL_RESAMPLE_GRAIN );
+	soil_zone_end();
+	return 1;
+}
+
+typedef struct
+{
+	const unsigned char *orig;
+	int width, height, channels;
+	unsigned char *resampled;
+	int mip_width, mip_height;
+	int simd;
+} mipmap_level_job;
+
+/*	the rows of level n+1 covered by rows [j_begin,j_end) of level n	*/
+static void mipmap_level_rows( void *context, int j_begin, int j_end )
+{
+	const mipmap_level_job *job = (const mipmap_level_job*)context;
+	const unsigned char* const orig = job->orig;
+	const int width = job->width;
+	const int height = job->height;
+	const int channels = job->channels;
+	const int mip_width = job->mip_width;
+	const int mip_height = job->mip_height;
+	const int stride = width*channels;
+	int i, j, c;
+
+	for( j = j_begin; j < j_end; ++j )
 	{
-		for( i = 0; i < mip_width; ++i )
+		/*	the last row of an odd level takes in the row left over	*/
+		const int y0 = j*2;
+		const int y1 = (j == mip_height-1) ? height : y0+2;
+		unsigned char *out = job->resampled + j*mip_width*channels;
+		i = 0;
+		if( y1-y0 == 2 )
 		{
-			for( c = 0; c < channels; ++c )
+			/*	all but an odd last column are plain 2x2 blocks	*/
+			const unsigned char *row0 = orig + y0*stride;
+			i = box_2x2_row( job->simd, row0, row0 + stride, out,
+					mip_width - (width & 1), channels );
+			out += i*channels;
+		}
+		for( ; i < mip_width; ++i )
+		{
+			const int x0 = i*2;
+			const int x1 = (i == mip_width-1) ? width : x0+2;
+			const unsigned char *in = orig + y0*stride + x0*channels;
+			if( (y1-y0 == 2) && (x1-x0 == 2) )
 			{
-				const int index = (j*block_size_y)*width*channels + (i*block_size_x)*channels + c;
-				int sum_value;
-				int u,v;
-				int u_block = block_size_x;
-				int v_block = block_size_y;
-				int block_area;
-				/*	do a bit of checking so we don't over-run the boundaries
-					(necessary for non-square textures!)	*/
-				if( block_size_x * (i+1) > width )
+				/*	the usual case, round to nearest	*/
+				for( c = 0; c < channels; ++c )
 				{
-					u_block = width - i*block_size_y;
+					out[c] = (unsigned char)((in[c] + in[c+channels]
+						+ in[c+stride] + in[c+stride+channels] + 2) >> 2);
 				}
-				if( block_size_y * (j+1) > height )
+			} else
+			{
+				const int area = (y1-y0)*(x1-x0);
+				int u, v;
+				for( c = 0; c < channels; ++c )
 				{
-					v_block = height - j*block_size_y;
+					int sum_value = area >> 1;
+					for( v = 0; v < y1-y0; ++v )
+					for( u = 0; u < x1-x0; ++u )
+					{
+						sum_value += in[v*stride + u*channels + c];
+					}
+					out[c] = (unsigned char)(sum_value / area);
 				}
-				block_area = u_block*v_block;
-				/*	for this pixel, see what the average
-					of all the values in the block are.
-					note: start the sum at the rounding value, not at 0	*/
-				sum_value = block_area >> 1;
-				for( v = 0; v < v_block; ++v )
-				for( u = 0; u < u_block; ++u )
+			}
+			out += channels;
+		}
+	}
+}
+
+int
+	mipmap_chain_size
+	(
+		int width, int height, int channels
+	)
+{
+	int size = 0;
+	if( (width < 1) || (height < 1) || (channels < 1) )
+	{
+		return 0;
+	}
+	while( (width > 1) || (height > 1) )
+	{
+		width = (width > 1) ? width / 2 : 1;
+		height = (height > 1) ? height / 2 : 1;
+		size += width*height*channels;
+	}
+	return size;
+}
+
+int
+	mipmap_chain
+	(
+		const unsigned char* const orig,
+		int width, int height, int channels,
+		unsigned char* chain
+	)
+{
+	mipmap_level_job job;
+	int levels = 0;
+
+	/*	error check	*/
+	if( (width < 1) || (height < 1) ||
+		(channels < 1) || (orig == NULL) ||
+		(chain == NULL) )
+	{
+		return 0;
+	}
+	soil_zone_begin( "SOIL2::mipmap_chain" );
+	job.orig = orig;
+	job.width = width;
+	job.height = height;
+	job.channels = channels;
+	job.resampled = chain;
+	job.simd = soil_simd_level();
+	while( (job.width > 1) || (job.height > 1) )
+	{
+		job.mip_width = (job.width > 1) ? job.width / 2 : 1;
+		job.mip_height = (job.height > 1) ? job.height / 2 : 1;
+		/*	rows of a level are independent, levels are not	*/
+		soil_parallel_for( mipmap_level_rows, &job, job.mip_height, SOIL_RESAMPLE_GRAIN );
+		++levels;
+		/*	this level is the source of the next	*/
+		job.orig = job.resampled;
+		job.resampled += job.mip_width*job.mip_height*channels;
+		job.width = job.mip_width;
+		job.height = job.mip_height;
+	}
+	soil_zone_end();
+	return levels;
+}
+
+/*	the float version of mipmap_level_job, for HDR images	*/
+typedef struct
+{
+	const float *orig;
+	int width, height, channels;
+	float *resampled;
+	int mip_width, mip_height;
+} mipmap_float_job;
+
+static void mipmap_float_rows( void *context, int j_begin, int j_end )
+{
+	const mipmap_float_job *job = (const mipmap_float_job*)context;
+	const int width = job->width;
+	const int channels = job->channels;
+	const int stride = width*channels;
+	int i, j, c, u, v;
+
+	for( j = j_begin; j < j_end; ++j )
+	{
+		const int y0 = j*2;
+		const int y1 = (j == job->mip_height-1) ? job->height : y0+2;
+		float *out = job->resampled + j*job->mip_width*channels;
+		for( i = 0; i < job->mip_width; ++i )
+		{
+			const int x0 = i*2;
+			const int x1 = (i == job->mip_width-1) ? width : x0+2;
+			const float *in = job->orig + y0*stride + x0*channels;
+			const float scale = 1.0f / ((y1-y0)*(x1-x0));
+			for( c = 0; c < channels; ++c )
+			{
+				float sum_value = 0.0f;
+				for( v = 0; v < y1-y0; ++v )
+				for( u = 0; u < x1-x0; ++u )
 				{
-					sum_value += orig[index + v*width*channels + u*channels];
+					sum_value += in[v*stride + u*channels + c];
 				}
-				resampled[j*mip_width*channels + i*channels + c] = sum_value / block_area;
+				out[c] = sum_value * scale;
 			}
+			out += channels;
 		}
 	}
-	return 1;
+}
+
+int
+	mipmap_chain_float
+	(
+		const float* const orig,
+		int width, int height, int channels,
+		float* chain
+	)
+{
+	mipmap_float_job job;
+	int levels = 0;
+
+	/*	error check	*/
+	if( (width < 1) || (height < 1) ||
+		(channels < 1) || (orig == NULL) ||
+		(chain == NULL) )
+	{
+		return 0;
+	}
+	soil_zone_begin( "SOIL2::mipmap_chain_float" );
+	job.orig = orig;
+	job.width = width;
+	job.height = height;
+	job.channels = channels;
+	job.resampled = chain;
+	while( (job.width > 1) || (job.height > 1) )
+	{
+		job.mip_width = (job.width > 1) ? job.width / 2 : 1;
+		job.mip_height = (job.height > 1) ? job.height / 2 : 1;
+		soil_parallel_for( mipmap_float_rows, &job, job.mip_height, SOIL_RESAMPLE_GRAIN );
+		++levels;
+		job.orig = job.resampled;
+		job.resampled += job.mip_width*job.mip_height*channels;
+		job.width = job.mip_width;
+		job.height = job.mip_height;
+	}
+	soil_zone_end();
+	return levels;
 }
 
 int
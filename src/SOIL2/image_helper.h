@@ -43,6 +43,49 @@ int
 		int block_size_x, int block_size_y
 	);
 
+/**
+	Bytes needed to hold every MIPmap level below a
+	width x height image, 0 if there are none.
+**/
+int
+	mipmap_chain_size
+	(
+		int width, int height, int channels
+	);
+
+/**
+	This function builds the whole MIPmap chain below an
+	image, each level from the one above it, so the work
+	is linear in the size of the image.  Levels follow the
+	OpenGL sizes (half, rounded down, at least 1) and are
+	packed one after another into chain, which must hold
+	mipmap_chain_size bytes.  A pixel is the box average
+	of the 2x2 pixels above it, or 3 wide / 3 tall on the
+	last column / row of an odd sized level.
+	Returns the number of levels written.
+**/
+int
+	mipmap_chain
+	(
+		const unsigned char* const orig,
+		int width, int height, int channels,
+		unsigned char* chain
+	);
+
+/**
+	mipmap_chain for an HDR image of floats, chain must
+	hold mipmap_chain_size floats.  Pixels are plain box
+	averages, without rounding.
+	Returns the number of levels written.
+**/
+int
+	mipmap_chain_float
+	(
+		const float* const orig,
+		int width, int height, int channels,
+		float* chain
+	);
+
 /**
 	This function takes the RGB components of the image
 	and scales each channel from [0,255] to [16,235].
@@ -0,0 +1,120 @@
+#ifndef KTX_HELPER_H
+#define KTX_HELPER_H
+
+/*	the Khronos texture containers, KTX 1.1 and KTX 2.0	*/
+
+#define KTX_IDENTIFIER_SIZE 12
+
+/*	«KTX 11» and «KTX 20»	*/
+static const unsigned char KTX1_identifier[KTX_IDENTIFIER_SIZE] =
+	{ 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+static const unsigned char KTX2_identifier[KTX_IDENTIFIER_SIZE] =
+	{ 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+/*	KTX 1.1: the header, then the key/value data, then for each
+	mip level a 4 byte image size followed by every array element
+	and face of the level, each face and level padded to 4 bytes	*/
+typedef struct
+{
+	unsigned char identifier[KTX_IDENTIFIER_SIZE];
+	unsigned int endianness;
+	unsigned int glType;
+	unsigned int glTypeSize;
+	unsigned int glFormat;
+	unsigned int glInternalFormat;
+	unsigned int glBaseInternalFormat;
+	unsigned int pixelWidth;
+	unsigned int pixelHeight;
+	unsigned int pixelDepth;
+	unsigned int numberOfArrayElements;
+	unsigned int numberOfFaces;
+	unsigned int numberOfMipmapLevels;
+	unsigned int bytesOfKeyValueData;
+} KTX_Header;
+
+/*	the endianness field as written, and read from the other kind of machine	*/
+#define KTX_ENDIAN_REF		0x04030201
+#define KTX_ENDIAN_REF_REV	0x01020304
+
+/*	KTX 2.0: the header, the level index, then the data format
+	descriptor, key/value and supercompression data, and the mip
+	levels, each with every layer and face tightly packed.
+	The 64 bit fields are split in low and high halves.	*/
+typedef struct
+{
+	unsigned char identifier[KTX_IDENTIFIER_SIZE];
+	unsigned int vkFormat;
+	unsigned int typeSize;
+	unsigned int pixelWidth;
+	unsigned int pixelHeight;
+	unsigned int pixelDepth;
+	unsigned int layerCount;
+	unsigned int faceCount;
+	unsigned int levelCount;
+	unsigned int supercompressionScheme;
+	unsigned int dfdByteOffset;
+	unsigned int dfdByteLength;
+	unsigned int kvdByteOffset;
+	unsigned int kvdByteLength;
+	unsigned int sgdByteOffset[2];
+	unsigned int sgdByteLength[2];
+} KTX2_Header;
+
+typedef struct
+{
+	unsigned int byteOffset[2];
+	unsigned int byteLength[2];
+	unsigned int uncompressedByteLength[2];
+} KTX2_Level_Index;
+
+/*	KTX2_Header supercompressionScheme	*/
+#define KTX2_SUPERCOMPRESSION_NONE		0
+#define KTX2_SUPERCOMPRESSION_BASIS_LZ	1
+#define KTX2_SUPERCOMPRESSION_ZSTD		2
+#define KTX2_SUPERCOMPRESSION_ZLIB		3
+
+/*	the VkFormat values KTX2_Header vkFormat can hold that map to
+	OpenGL formats SOIL knows how to upload	*/
+#define KTX2_VK_FORMAT_R8_UNORM					9
+#define KTX2_VK_FORMAT_R8G8_UNORM				16
+#define KTX2_VK_FORMAT_R8G8B8_UNORM				23
+#define KTX2_VK_FORMAT_R8G8B8_SRGB				29
+#define KTX2_VK_FORMAT_R8G8B8A8_UNORM			37
+#define KTX2_VK_FORMAT_R8G8B8A8_SRGB			43
+#define KTX2_VK_FORMAT_R16_SFLOAT				76
+#define KTX2_VK_FORMAT_R16G16_SFLOAT			83
+#define KTX2_VK_FORMAT_R16G16B16_SFLOAT			90
+#define KTX2_VK_FORMAT_R16G16B16A16_SFLOAT		97
+#define KTX2_VK_FORMAT_R32_SFLOAT				100
+#define KTX2_VK_FORMAT_R32G32_SFLOAT			103
+#define KTX2_VK_FORMAT_R32G32B32_SFLOAT			106
+#define KTX2_VK_FORMAT_R32G32B32A32_SFLOAT		109
+#define KTX2_VK_FORMAT_BC1_RGB_UNORM_BLOCK		131
+#define KTX2_VK_FORMAT_BC1_RGB_SRGB_BLOCK		132
+#define KTX2_VK_FORMAT_BC1_RGBA_UNORM_BLOCK		133
+#define KTX2_VK_FORMAT_BC1_RGBA_SRGB_BLOCK		134
+#define KTX2_VK_FORMAT_BC2_UNORM_BLOCK			135
+#define KTX2_VK_FORMAT_BC2_SRGB_BLOCK			136
+#define KTX2_VK_FORMAT_BC3_UNORM_BLOCK			137
+#define KTX2_VK_FORMAT_BC3_SRGB_BLOCK			138
+#define KTX2_VK_FORMAT_BC4_UNORM_BLOCK			139
+#define KTX2_VK_FORMAT_BC4_SNORM_BLOCK			140
+#define KTX2_VK_FORMAT_BC5_UNORM_BLOCK			141
+#define KTX2_VK_FORMAT_BC5_SNORM_BLOCK			142
+#define KTX2_VK_FORMAT_BC6H_UFLOAT_BLOCK		143
+#define KTX2_VK_FORMAT_BC6H_SFLOAT_BLOCK		144
+#define KTX2_VK_FORMAT_BC7_UNORM_BLOCK			145
+#define KTX2_VK_FORMAT_BC7_SRGB_BLOCK			146
+#define KTX2_VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK	147
+#define KTX2_VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK	148
+#define KTX2_VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK	151
+#define KTX2_VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK	152
+#define KTX2_VK_FORMAT_EAC_R11_UNORM_BLOCK		153
+#define KTX2_VK_FORMAT_EAC_R11_SNORM_BLOCK		154
+#define KTX2_VK_FORMAT_EAC_R11G11_UNORM_BLOCK	155
+#define KTX2_VK_FORMAT_EAC_R11G11_SNORM_BLOCK	156
+/*	the 14 ASTC block sizes from 4x4 to 12x12, UNORM then SRGB	*/
+#define KTX2_VK_FORMAT_ASTC_4x4_UNORM_BLOCK		157
+#define KTX2_VK_FORMAT_ASTC_12x12_SRGB_BLOCK	184
+
+#endif
@@ -0,0 +1,47 @@
+/*
+	Parallel helper functions
+
+	Public Domain
+*/
+
+#include "parallel_helper.h"
+#include <stddef.h>
+
+static SOIL_parallel_for_func soil_parallel_func = NULL;
+static void *soil_parallel_user_data = NULL;
+
+void
+	SOIL_set_parallel_for
+	(
+		SOIL_parallel_for_func func,
+		void *user_data
+	)
+{
+	soil_parallel_func = func;
+	soil_parallel_user_data = user_data;
+}
+
+void
+	soil_parallel_for
+	(
+		SOIL_parallel_task task,
+		void *context,
+		int count, int grain
+	)
+{
+	if( count < 1 )
+	{
+		return;
+	}
+	if( grain < 1 )
+	{
+		grain = 1;
+	}
+	if( (NULL == soil_parallel_func) || (count <= grain) )
+	{
+		/*	no pool, or not worth splitting	*/
+		task( context, 0, count );
+		return;
+	}
+	soil_parallel_func( task, context, count, grain, soil_parallel_user_data );
+}
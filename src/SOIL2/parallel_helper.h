@@ -0,0 +1,36 @@
+/*
+	Parallel helper functions
+
+	Lets SOIL spread independent rows or blocks of work over
+	the thread pool registered with SOIL_set_parallel_for,
+	or just run them in place when there is none.
+
+	Public Domain
+*/
+
+#ifndef HEADER_PARALLEL_HELPER
+#define HEADER_PARALLEL_HELPER
+
+#include "SOIL2.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+	Runs task( context, begin, end ) over [0,count) in ranges
+	of at most grain items, and returns once all of them are done.
+**/
+void
+	soil_parallel_for
+	(
+		SOIL_parallel_task task,
+		void *context,
+		int count, int grain
+	);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEADER_PARALLEL_HELPER	*/
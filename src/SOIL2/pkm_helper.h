@@ -16,4 +16,18 @@ typedef struct {
 
 #define PKM_HEADER_SIZE 16
 
+/*	the format field of a PKM 20 header (big endian, in iBlank)	*/
+#define PKM_FORMAT_ETC1_RGB			0
+#define PKM_FORMAT_ETC2_RGB			1
+#define PKM_FORMAT_ETC2_RGBA_OLD	2
+#define PKM_FORMAT_ETC2_RGBA		3
+#define PKM_FORMAT_ETC2_RGBA1		4
+#define PKM_FORMAT_EAC_R			5
+#define PKM_FORMAT_EAC_RG			6
+#define PKM_FORMAT_EAC_R_SIGNED		7
+#define PKM_FORMAT_EAC_RG_SIGNED	8
+#define PKM_FORMAT_ETC2_SRGB		9
+#define PKM_FORMAT_ETC2_SRGBA		10
+#define PKM_FORMAT_ETC2_SRGBA1		11
+
 #endif
@@ -0,0 +1,49 @@
+/*
+	Profile helper functions
+
+	Public Domain
+*/
+
+#include "profile_helper.h"
+#include <stddef.h>
+
+static SOIL_zone_begin_func soil_zone_begin_func = NULL;
+static SOIL_zone_end_func soil_zone_end_func = NULL;
+static void *soil_profiler_user_data = NULL;
+
+void
+	SOIL_set_profiler
+	(
+		SOIL_zone_begin_func begin,
+		SOIL_zone_end_func end,
+		void *user_data
+	)
+{
+	soil_zone_begin_func = begin;
+	soil_zone_end_func = end;
+	soil_profiler_user_data = user_data;
+}
+
+void
+	soil_zone_begin
+	(
+		const char *name
+	)
+{
+	if( NULL != soil_zone_begin_func )
+	{
+		soil_zone_begin_func( name, soil_profiler_user_data );
+	}
+}
+
+void
+	soil_zone_end
+	(
+		void
+	)
+{
+	if( NULL != soil_zone_end_func )
+	{
+		soil_zone_end_func( soil_profiler_user_data );
+	}
+}
@@ -0,0 +1,43 @@
+/*
+	Profile helper functions
+
+	Marks the stages of loading and processing an image as
+	zones for the profiler registered with SOIL_set_profiler,
+	or does nothing when there is none.
+
+	Public Domain
+*/
+
+#ifndef HEADER_PROFILE_HELPER
+#define HEADER_PROFILE_HELPER
+
+#include "SOIL2.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+	Opens a zone on the calling thread.  name must be a string
+	literal, the profiler may keep the pointer.
+**/
+void
+	soil_zone_begin
+	(
+		const char *name
+	);
+
+/**
+	Closes the zone most recently opened on the calling thread.
+**/
+void
+	soil_zone_end
+	(
+		void
+	);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEADER_PROFILE_HELPER	*/
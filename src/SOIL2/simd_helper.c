@@ -0,0 +1,103 @@
+/*
+	SIMD helper functions
+
+	Public Domain
+*/
+
+#include "simd_helper.h"
+
+#if defined( SOIL_SIMD_X86 ) && defined( _MSC_VER )
+	#include <intrin.h>
+#elif defined( SOIL_SIMD_X86 )
+	#include <cpuid.h>
+#endif
+
+/*	-1 until the CPU has been asked	*/
+static int soil_simd_detected = -1;
+static int soil_simd_enabled = 1;
+
+void
+	SOIL_set_SIMD_enabled
+	(
+		int enabled
+	)
+{
+	soil_simd_enabled = enabled;
+}
+
+#if defined( SOIL_SIMD_X86 )
+static void soil_cpuid( int leaf, int subleaf, unsigned int regs[4] )
+{
+#if defined( _MSC_VER )
+	int info[4];
+	__cpuidex( info, leaf, subleaf );
+	regs[0] = info[0];
+	regs[1] = info[1];
+	regs[2] = info[2];
+	regs[3] = info[3];
+#else
+	__cpuid_count( leaf, subleaf, regs[0], regs[1], regs[2], regs[3] );
+#endif
+}
+
+static int soil_detect_simd( void )
+{
+	unsigned int regs[4];
+	int level = SOIL_SIMD_NONE;
+	soil_cpuid( 0, 0, regs );
+	if( regs[0] >= 1 )
+	{
+		unsigned int max_leaf = regs[0];
+		soil_cpuid( 1, 0, regs );
+		/*	EDX bit 26	*/
+		if( regs[3] & (1u << 26) )
+		{
+			level = SOIL_SIMD_SSE2;
+		}
+		/*	AVX2 also needs the OS to save the YMM registers (OSXSAVE, then XCR0 bits 1 and 2)	*/
+		if( (max_leaf >= 7) && (regs[2] & (1u << 27)) && (regs[2] & (1u << 28)) )
+		{
+			unsigned int xcr0;
+#if defined( _MSC_VER )
+			xcr0 = (unsigned int)_xgetbv( 0 );
+#else
+			unsigned int xcr0_high;
+			__asm__ __volatile__( "xgetbv" : "=a"( xcr0 ), "=d"( xcr0_high ) : "c"( 0 ) );
+			(void)xcr0_high;
+#endif
+			soil_cpuid( 7, 0, regs );
+			/*	EBX bit 5	*/
+			if( ((xcr0 & 6) == 6) && (regs[1] & (1u << 5)) )
+			{
+				level = SOIL_SIMD_AVX2;
+			}
+		}
+	}
+	return level;
+}
+#elif defined( SOIL_SIMD_NEON_AVAILABLE )
+static int soil_detect_simd( void )
+{
+	/*	compiled for NEON, so the CPU has it	*/
+	return SOIL_SIMD_NEON;
+}
+#else
+static int soil_detect_simd( void )
+{
+	return SOIL_SIMD_NONE;
+}
+#endif
+
+int
+	soil_simd_level
+	(
+		void
+	)
+{
+	/*	racing threads would all find the same answer	*/
+	if( soil_simd_detected < 0 )
+	{
+		soil_simd_detected = soil_detect_simd();
+	}
+	return soil_simd_enabled ? soil_simd_detected : SOIL_SIMD_NONE;
+}
@@ -0,0 +1,61 @@
+/*
+	SIMD helper functions
+
+	Finds out once which vector instructions the CPU has,
+	so the image processing can pick its SSE2, AVX2 or NEON
+	code at runtime and fall back to the plain C code,
+	which stays the reference every vector path must match
+	bit for bit.  The DXT encoder has an AVX2 path only,
+	SSE2 and NEON levels take its C code.
+
+	Public Domain
+*/
+
+#ifndef HEADER_SIMD_HELPER
+#define HEADER_SIMD_HELPER
+
+#include "SOIL2.h"
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __SSE2__ )
+	#define SOIL_SIMD_X86
+	#include <emmintrin.h>
+	#include <immintrin.h>
+	#if defined( __GNUC__ ) || defined( __clang__ )
+		/*	lets one function use AVX2 without building everything for it	*/
+		#define SOIL_TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+	#else
+		#define SOIL_TARGET_AVX2
+	#endif
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+	#define SOIL_SIMD_NEON_AVAILABLE
+	#include <arm_neon.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum
+{
+	SOIL_SIMD_NONE = 0,
+	SOIL_SIMD_SSE2 = 1,
+	SOIL_SIMD_AVX2 = 2,
+	SOIL_SIMD_NEON = 3
+};
+
+/**
+	The best instruction set this CPU has and SOIL has code
+	for, or SOIL_SIMD_NONE when SIMD was switched off with
+	SOIL_set_SIMD_enabled.
+**/
+int
+	soil_simd_level
+	(
+		void
+	);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEADER_SIMD_HELPER	*/
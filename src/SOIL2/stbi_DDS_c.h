@@ -201,6 +201,21 @@ void stbi_decode_DXT45_alpha_block(
 	}
 	//	done
 }
+//	BC4 is a DXT5 alpha block, and BC5 two of them,
+//	each decoded into one channel of the RGBA block
+void stbi_decode_BC45_channel_block(
+			unsigned char uncompressed[16*4],
+			unsigned char compressed[8],
+			int channel )
+{
+	unsigned char decoded[16*4];
+	int i;
+	stbi_decode_DXT45_alpha_block( decoded, compressed );
+	for( i = 0; i < 16; ++i )
+	{
+		uncompressed[i*4+channel] = decoded[i*4+3];
+	}
+}
 void stbi_decode_DXT_color_block(
 			unsigned char uncompressed[16*4],
 			unsigned char compressed[8] )
@@ -343,10 +358,12 @@ static void * stbi__dds_load(stbi__context *s, int *x, int *y, int *comp, int re
 	stbi_uc block[16*4];
 	stbi_uc compressed[8];
 	int flags, DXT_family;
+	unsigned int fourCC, dxgi_format = 0;
 	int has_alpha, has_mipmap;
 	int is_compressed, cubemap_faces;
 	int block_pitch, num_blocks;
 	DDS_header header={0};
+	DDS_header_DXT10 header10={0};
 	int i, sz, cf;
 	//	load the header
 	if( sizeof( DDS_header ) != 128 )
@@ -367,6 +384,14 @@ static void * stbi__dds_load(stbi__context *s, int *x, int *y, int *comp, int re
 	flags = DDPF_FOURCC | DDPF_RGB;
 	if( (header.sPixelFormat.dwFlags & flags) == 0 ) return NULL;
 	if( (header.sCaps.dwCaps1 & DDSCAPS_TEXTURE) == 0 ) return NULL;
+	//	the DXGI format is in the extended header
+	fourCC = header.sPixelFormat.dwFourCC;
+	if( fourCC == (('D' << 0) | ('X' << 8) | ('1' << 16) | ('0' << 24)) )
+	{
+		stbi__getn( s, (stbi_uc*)(&header10), sizeof( DDS_header_DXT10 ) );
+		if( header10.arraySize > 1 ) return NULL;
+		dxgi_format = header10.dxgiFormat;
+	}
 	//	get the image data
 	s->img_x = header.dwWidth;
 	s->img_y = header.dwHeight;
@@ -389,9 +414,32 @@ static void * stbi__dds_load(stbi__context *s, int *x, int *y, int *comp, int re
 	if( is_compressed )
 	{
 		/*	compressed	*/
+		//	DXT1 to DXT5 are families 1 to 5, BC4 is 6 and BC5 is 7
 		//	note: header.sPixelFormat.dwFourCC is something like (('D'<<0)|('X'<<8)|('T'<<16)|('1'<<24))
-		DXT_family = 1 + (header.sPixelFormat.dwFourCC >> 24) - '1';
-		if( (DXT_family < 1) || (DXT_family > 5) ) return NULL;
+		DXT_family = 0;
+		if( (fourCC & 0x00FFFFFF) == (('D' << 0) | ('X' << 8) | ('T' << 16)) )
+		{
+			DXT_family = 1 + (fourCC >> 24) - '1';
+		} else
+		if( (fourCC == (('A' << 0) | ('T' << 8) | ('I' << 16) | ('1' << 24))) ||
+			(fourCC == (('B' << 0) | ('C' << 8) | ('4' << 16) | ('U' << 24))) )
+		{
+			DXT_family = 6;
+		} else
+		if( (fourCC == (('A' << 0) | ('T' << 8) | ('I' << 16) | ('2' << 24))) ||
+			(fourCC == (('B' << 0) | ('C' << 8) | ('5' << 16) | ('U' << 24))) )
+		{
+			DXT_family = 7;
+		}
+		switch( dxgi_format )
+		{
+		case DXGI_FORMAT_BC1_UNORM: case DXGI_FORMAT_BC1_UNORM_SRGB: DXT_family = 1; break;
+		case DXGI_FORMAT_BC2_UNORM: case DXGI_FORMAT_BC2_UNORM_SRGB: DXT_family = 3; break;
+		case DXGI_FORMAT_BC3_UNORM: case DXGI_FORMAT_BC3_UNORM_SRGB: DXT_family = 5; break;
+		case DXGI_FORMAT_BC4_UNORM: DXT_family = 6; break;
+		case DXGI_FORMAT_BC5_UNORM: DXT_family = 7; break;
+		}
+		if( (DXT_family < 1) || (DXT_family > 7) ) return NULL;
 		/*	check the expected size...oops, nevermind...
 			those non-compliant writers leave
 			dwPitchOrLinearSize == 0	*/
@@ -421,13 +469,28 @@ static void * stbi__dds_load(stbi__context *s, int *x, int *y, int *comp, int re
 					stbi_decode_DXT23_alpha_block ( block, compressed );
 					stbi__getn( s, compressed, 8 );
 					stbi_decode_DXT_color_block ( block, compressed );
-				} else
+				} else if( DXT_family < 6 )
 				{
 					//	DXT4/5
 					stbi__getn( s, compressed, 8 );
 					stbi_decode_DXT45_alpha_block ( block, compressed );
 					stbi__getn( s, compressed, 8 );
 					stbi_decode_DXT_color_block ( block, compressed );
+				} else
+				{
+					//	BC4/5, red (and green), like OpenGL shows them
+					memset( block, 0, sizeof( block ) );
+					stbi__getn( s, compressed, 8 );
+					stbi_decode_BC45_channel_block( block, compressed, 0 );
+					if( DXT_family == 7 )
+					{
+						stbi__getn( s, compressed, 8 );
+						stbi_decode_BC45_channel_block( block, compressed, 1 );
+					}
+					for( bx = 3; bx < 16*4; bx += 4 )
+					{
+						block[bx] = 255;
+					}
 				}
 				//	is this a partial block?
 				if( ref_x + 4 > (int)s->img_x )
@@ -454,7 +517,7 @@ static void * stbi__dds_load(stbi__context *s, int *x, int *y, int *comp, int re
 			if( has_mipmap )
 			{
 				int block_size = 16;
-				if( DXT_family == 1 )
+				if( (DXT_family == 1) || (DXT_family == 6) )
 				{
 					block_size = 8;
 				}
@@ -1,5 +1,6 @@
 #include "pkm_helper.h"
 #include "etc1_utils.h"
+#include "etc2_utils.h"
 
 static int stbi__pkm_test(stbi__context *s)
 {
@@ -24,9 +25,14 @@ static int stbi__pkm_test(stbi__context *s)
 		return 0;
 	}
 
-	if (stbi__get8(s) != '1') {
-		stbi__rewind(s);
-		return 0;
+	//	PKM 10 is ETC1, PKM 20 is ETC2 and EAC
+	switch (stbi__get8(s)) {
+		case '1':
+		case '2':
+			break;
+		default:
+			stbi__rewind(s);
+			return 0;
 	}
 
 	if (stbi__get8(s) != '0') {
@@ -78,11 +84,13 @@ int      stbi__pkm_test_callbacks      (stbi_io_callbacks const *clbk, void *use
 static int stbi__pkm_info(stbi__context *s, int *x, int *y, int *comp )
 {
 	PKMHeader header;
-	unsigned int width, height;
+	unsigned int width, height, format;
 
 	stbi__getn( s, (stbi_uc*)(&header), sizeof(PKMHeader) );
 
-	if ( 0 != strcmp( header.aName, "PKM 10" ) ) {
+	format = etc2_pkm_get_format( (const unsigned char*)&header );
+
+	if ( 0 == format ) {
 		stbi__rewind(s);
 		return 0;
 	}
@@ -92,7 +100,7 @@ static int stbi__pkm_info(stbi__context *s, int *x, int *y, int *comp )
 
 	*x = s->img_x = width;
 	*y = s->img_y = height;
-	*comp = s->img_n = 3;
+	*comp = s->img_n = etc2_decoded_channels( format );
 
 	stbi__rewind(s);
 
@@ -147,12 +155,15 @@ static void * stbi__pkm_load(stbi__context *s, int *x, int *y, int *comp, int re
 	unsigned int bpr;
 	unsigned int size;
 	unsigned int compressedSize;
+	unsigned int format;
 
 	int res;
 
 	stbi__getn( s, (stbi_uc*)(&header), sizeof(PKMHeader) );
 
-	if ( 0 != strcmp( header.aName, "PKM 10" ) ) {
+	format = etc2_pkm_get_format( (const unsigned char*)&header );
+
+	if ( 0 == format ) {
 		return NULL;
 	}
 
@@ -161,18 +172,28 @@ static void * stbi__pkm_load(stbi__context *s, int *x, int *y, int *comp, int re
 
 	*x = s->img_x = width;
 	*y = s->img_y = height;
-	*comp = s->img_n = 3;
+	*comp = s->img_n = etc2_decoded_channels( format );
 
-	compressedSize = etc1_get_encoded_data_size(width, height);
+	compressedSize = etc2_get_encoded_data_size(format, width, height);
 
 	pkm_data = (stbi_uc *)malloc(compressedSize);
-	stbi__getn( s, pkm_data, compressedSize );
+	if ( NULL == pkm_data || !stbi__getn( s, pkm_data, compressedSize ) ) {
+		free( pkm_data );
+		return NULL;
+	}
 
-	bpr = ((width * 3) + align) & ~align;
+	bpr = ((width * s->img_n) + align) & ~align;
 	size = bpr * height;
 	pkm_res_data = (stbi_uc *)malloc(size);
 
-	res = etc1_decode_image((const etc1_byte*)pkm_data, (etc1_byte*)pkm_res_data, width, height, 3, bpr);
+	if ( NULL == pkm_res_data ) {
+		res = -1;
+	} else if ( format == ETC1_RGB8_OES ) {
+		res = etc1_decode_image((const etc1_byte*)pkm_data, (etc1_byte*)pkm_res_data, width, height, 3, bpr);
+	} else {
+		//	the ETC2 decoder returns 1 on success, the ETC1 one 0
+		res = etc2_decode_image(pkm_data, format, width, height, pkm_res_data) ? 0 : -1;
+	}
 
 	free( pkm_data );
 
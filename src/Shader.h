@@ -2,107 +2,267 @@
 #define SHADER_H
 
 #include <string>
-#include <fstream>
-#include <sstream>
-#include <iostream>
+#include <vector>
 
 #include <GL/glew.h>
 
+#include "Log.h"
+#include "Profiler.h"
+#include "ProgramCache.h"
+#include "ShaderSource.h"
+
+// Same value for the ARB and KHR extensions, defined here for GLEW releases that predate both
+#ifndef GL_COMPLETION_STATUS_ARB
+    #define GL_COMPLETION_STATUS_ARB 0x91B1
+#endif
+
+enum Shader_Status
+{
+    SHADER_COMPILING,
+    SHADER_READY,
+    SHADER_FAILED
+};
+
 class Shader
 {
 public:
     GLuint Program;
 
-    // Constructor generates the shader on the fly
-    Shader( const GLchar *vertexPath, const GLchar *fragmentPath )
+    // Constructor generates the shader on the fly. With wait set to false the compile and link
+    // are only submitted and the program can't be used until Finish (or a ShaderBatch) says so.
+    // defines ("#define NAME VALUE" lines) are injected into both stages to build a variant.
+    Shader( const GLchar *vertexPath, const GLchar *fragmentPath, bool wait = true, const std::string &defines = "" )
+    : Program( 0 ), vertexPath( vertexPath ), fragmentPath( fragmentPath ), defines( defines ), vertex( 0 ), fragment( 0 ),
+      cacheable( false ), cacheKey( 0 ), status( SHADER_COMPILING )
     {
-        // Retrieve the vertex/fragment source from filePath
+        // Retrieve the vertex/fragment source from filePath, with includes expanded
         std::string vertexCode;
         std::string fragmentCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
+        std::vector<std::string> fragmentFiles;
+
+        ShaderSource::Load( this->vertexPath, vertexCode, this->files );
+        ShaderSource::Load( this->fragmentPath, fragmentCode, fragmentFiles );
+        this->files.insert( this->files.end( ), fragmentFiles.begin( ), fragmentFiles.end( ) );
 
-        // ensures ifstream objects can throw exceptions
-        vShaderFile.exceptions ( std::ifstream::badbit );
-        fShaderFile.exceptions ( std::ifstream::badbit );
+        vertexCode = ShaderSource::InjectDefines( vertexCode, this->defines );
+        fragmentCode = ShaderSource::InjectDefines( fragmentCode, this->defines );
 
-        try
+        this->Submit( vertexCode, fragmentCode );
+
+        if ( wait )
         {
-            // Open files
-            vShaderFile.open( vertexPath );
-            fShaderFile.open( fragmentPath );
-            std::stringstream vShaderStream, fShaderStream;
-
-            // Read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf( );
-            fShaderStream << fShaderFile.rdbuf( );
-
-            // Close file handlers
-            vShaderFile.close( );
-            fShaderFile.close( );
-
-            // Convert stream into string
-            vertexCode = vShaderStream.str( );
-            fragmentCode = fShaderStream.str( );
+            this->Finish( );
         }
-        catch ( std::ifstream::failure e )
+    }
+
+    void Use( )
+    {
+        glUseProgram( this->Program );
+    }
+
+    const std::string &GetVertexPath( ) const
+    {
+        return this->vertexPath;
+    }
+
+    const std::string &GetFragmentPath( ) const
+    {
+        return this->fragmentPath;
+    }
+
+    const std::string &GetDefines( ) const
+    {
+        return this->defines;
+    }
+
+    // Every file either stage was built from, includes too
+    const std::vector<std::string> &GetFiles( ) const
+    {
+        return this->files;
+    }
+
+    Shader_Status GetStatus( ) const
+    {
+        return this->status;
+    }
+
+    // Never blocks. Without parallel compile support there is no way to ask, so this reports
+    // ready and the cost is paid in Finish instead.
+    bool IsReady( ) const
+    {
+        if ( SHADER_COMPILING != this->status || !HasParallelCompile( ) )
         {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+            return true;
         }
 
-        const GLchar *vShaderCode = vertexCode.c_str( );
-        const GLchar *fShaderCode = fragmentCode.c_str( );
+        GLint done = GL_FALSE;
+        glGetProgramiv( this->Program, GL_COMPLETION_STATUS_ARB, &done );
+
+        return GL_TRUE == done;
+    }
+
+    // Collects the compile and link results, blocking if the driver isn't done yet. Returns true
+    // if the program linked.
+    bool Finish( )
+    {
+        if ( SHADER_COMPILING != this->status )
+        {
+            return SHADER_READY == this->status;
+        }
+
+        PROFILE_ZONE( "Shader::Finish" );
 
-        // Compile Shaders
-        GLuint vertex, fragment;
         GLint success;
         GLchar infoLog[512];
 
-        // Vertex Shader
-        vertex = glCreateShader( GL_VERTEX_SHADER );
-        glShaderSource( vertex, 1, &vShaderCode, NULL );
-        glCompileShader( vertex );
         // Print compile errors if any
-        glGetShaderiv( vertex, GL_COMPILE_STATUS, &success );
+        glGetShaderiv( this->vertex, GL_COMPILE_STATUS, &success );
         if ( !success )
         {
-            glGetShaderInfoLog( vertex, 512, NULL, infoLog );
-            std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+            glGetShaderInfoLog( this->vertex, 512, NULL, infoLog );
+            LOG_ERROR( "ERROR::SHADER::VERTEX::COMPILATION_FAILED {}\n{}", this->vertexPath, infoLog );
         }
 
-        // Fragment Shader
-        fragment = glCreateShader( GL_FRAGMENT_SHADER );
-        glShaderSource( fragment, 1, &fShaderCode, NULL );
-        glCompileShader( fragment );
-        // Print compile errors if any
-        glGetShaderiv( fragment, GL_COMPILE_STATUS, &success );
+        glGetShaderiv( this->fragment, GL_COMPILE_STATUS, &success );
         if ( !success )
         {
-            glGetShaderInfoLog( fragment, 512, NULL, infoLog );
-            std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+            glGetShaderInfoLog( this->fragment, 512, NULL, infoLog );
+            LOG_ERROR( "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED {}\n{}", this->fragmentPath, infoLog );
         }
 
-        // Shader Program
-        this->Program = glCreateProgram( );
-        glAttachShader( this->Program, vertex );
-        glAttachShader( this->Program, fragment );
-        glLinkProgram( this->Program );
         // Print linking errors if any
         glGetProgramiv( this->Program, GL_LINK_STATUS, &success );
         if ( !success )
         {
             glGetProgramInfoLog( this->Program, 512, NULL, infoLog );
-            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+            LOG_ERROR( "ERROR::SHADER::PROGRAM::LINKING_FAILED {} {}\n{}", this->vertexPath, this->fragmentPath, infoLog );
+            this->status = SHADER_FAILED;
+        }
+        else
+        {
+            if ( this->cacheable )
+            {
+                ProgramCache::Store( this->cacheKey, this->Program );
+            }
+
+            this->status = SHADER_READY;
         }
 
         // Delete the shaders as they're linked into our program now, they're no longer necessary
-        glDeleteShader( vertex );
-        glDeleteShader( fragment );
+        glDeleteShader( this->vertex );
+        glDeleteShader( this->fragment );
+        this->vertex = 0;
+        this->fragment = 0;
+
+        return SHADER_READY == this->status;
     }
 
-    void Use( )
+    // Takes over other's program once it has linked, deleting the current one. Used to swap in a
+    // rebuilt program while everything keeps referring to this Shader.
+    void Replace( Shader &other )
     {
-        glUseProgram( this->Program );
+        if ( SHADER_READY != other.status )
+        {
+            return;
+        }
+
+        this->Delete( );
+        this->Program = other.Program;
+        this->files = other.files;
+        this->status = SHADER_READY;
+        other.Program = 0;
+    }
+
+    // There is no destructor since Shaders usually outlive the context, call this while it's current
+    void Delete( )
+    {
+        glDeleteShader( this->vertex );
+        glDeleteShader( this->fragment );
+        glDeleteProgram( this->Program );
+        this->vertex = 0;
+        this->fragment = 0;
+        this->Program = 0;
+    }
+
+    // GL_ARB_parallel_shader_compile and its KHR twin let the driver compile on its own threads
+    // and answer GL_COMPLETION_STATUS without waiting
+    static bool HasParallelCompile( )
+    {
+#ifdef GL_KHR_parallel_shader_compile
+        if ( GLEW_KHR_parallel_shader_compile )
+        {
+            return true;
+        }
+#endif
+
+#ifdef GL_ARB_parallel_shader_compile
+        if ( GLEW_ARB_parallel_shader_compile )
+        {
+            return true;
+        }
+#endif
+
+        return false;
+    }
+
+private:
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::string defines;
+    std::vector<std::string> files;
+    GLuint vertex;
+    GLuint fragment;
+    bool cacheable;
+    ProgramCache::Key cacheKey;
+    Shader_Status status;
+
+    // Hands the sources to the driver without asking for any status in between, since every
+    // query would make it finish that step before the next one could start
+    void Submit( const std::string &vertexCode, const std::string &fragmentCode )
+    {
+        PROFILE_ZONE( "Shader::Submit" );
+
+        // Reuse the driver's binary from an earlier run when nothing that went into it has changed
+        this->cacheable = ProgramCache::IsSupported( );
+        this->Program = glCreateProgram( );
+
+        if ( this->cacheable )
+        {
+            std::vector<std::string> sources;
+            sources.push_back( vertexCode );
+            sources.push_back( fragmentCode );
+            this->cacheKey = ProgramCache::MakeKey( sources, this->defines );
+
+            if ( ProgramCache::Load( this->cacheKey, this->Program ) )
+            {
+                this->status = SHADER_READY;
+                return;
+            }
+        }
+
+        const GLchar *vShaderCode = vertexCode.c_str( );
+        const GLchar *fShaderCode = fragmentCode.c_str( );
+
+        // Vertex Shader
+        this->vertex = glCreateShader( GL_VERTEX_SHADER );
+        glShaderSource( this->vertex, 1, &vShaderCode, NULL );
+        glCompileShader( this->vertex );
+
+        // Fragment Shader
+        this->fragment = glCreateShader( GL_FRAGMENT_SHADER );
+        glShaderSource( this->fragment, 1, &fShaderCode, NULL );
+        glCompileShader( this->fragment );
+
+        // Shader Program
+        glAttachShader( this->Program, this->vertex );
+        glAttachShader( this->Program, this->fragment );
+
+        if ( this->cacheable )
+        {
+            glProgramParameteri( this->Program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+        }
+
+        glLinkProgram( this->Program );
     }
 };
 
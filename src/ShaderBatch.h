@@ -0,0 +1,103 @@
+////////////////////////////////////////////////////////////////
+/// ShaderBatch.h
+////////////////////////////////////////////////////////////////
+
+#ifndef SHADER_BATCH_H
+#define SHADER_BATCH_H
+
+#include <vector>
+
+#include "Shader.h"
+
+// Tracks programs that were submitted with wait set to false. Submitting everything first and
+// collecting results afterwards lets the driver overlap the compiles (on its own threads when
+// parallel shader compile is available) instead of finishing each one before starting the next.
+class ShaderBatch
+{
+public:
+    ShaderBatch( ) : failedCount( 0 )
+    {
+        // Let the driver use as many compiler threads as it likes, through whichever of the two
+        // extensions it has since only that one's entry point is loaded
+#ifdef GL_KHR_parallel_shader_compile
+        if ( GLEW_KHR_parallel_shader_compile )
+        {
+            glMaxShaderCompilerThreadsKHR( 0xFFFFFFFF );
+            return;
+        }
+#endif
+
+#ifdef GL_ARB_parallel_shader_compile
+        if ( GLEW_ARB_parallel_shader_compile )
+        {
+            glMaxShaderCompilerThreadsARB( 0xFFFFFFFF );
+        }
+#endif
+    }
+
+    void Add( Shader &shader )
+    {
+        this->pending.push_back( &shader );
+    }
+
+    // Finishes whatever the driver is done with, returns how many are left. Only non-blocking with
+    // parallel compile support, without it every program counts as done and gets collected here.
+    size_t Poll( )
+    {
+        size_t kept = 0;
+
+        for ( size_t i = 0; i < this->pending.size( ); ++i )
+        {
+            Shader *shader = this->pending[i];
+
+            if ( !shader->IsReady( ) )
+            {
+                this->pending[kept++] = shader;
+                continue;
+            }
+
+            this->Collect( *shader );
+        }
+
+        this->pending.resize( kept );
+
+        return kept;
+    }
+
+    // Blocks until every program is done, returns true if all of them linked
+    bool FinishAll( )
+    {
+        for ( size_t i = 0; i < this->pending.size( ); ++i )
+        {
+            this->Collect( *this->pending[i] );
+        }
+
+        this->pending.clear( );
+
+        return 0 == this->failedCount;
+    }
+
+    size_t GetPendingCount( ) const
+    {
+        return this->pending.size( );
+    }
+
+    size_t GetFailedCount( ) const
+    {
+        return this->failedCount;
+    }
+
+private:
+    std::vector<Shader *> pending;
+    size_t failedCount;
+
+    void Collect( Shader &shader )
+    {
+        if ( !shader.Finish( ) )
+        {
+            ++this->failedCount;
+        }
+    }
+};
+
+#endif // SHADER_BATCH_H
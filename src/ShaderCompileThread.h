@@ -0,0 +1,211 @@
+////////////////////////////////////////////////////////////////
+/// ShaderCompileThread.h
+////////////////////////////////////////////////////////////////
+
+#ifndef SHADER_COMPILE_THREAD_H
+#define SHADER_COMPILE_THREAD_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+// GLFW
+#include <GLFW/glfw3.h>
+
+#include "Log.h"
+#include "Profiler.h"
+#include "Shader.h"
+
+// A program built on the compile thread, tag is whatever the submitter used to tell them apart
+struct CompiledShader
+{
+    const void *owner;
+    GLuint tag;
+    std::unique_ptr<Shader> shader;
+};
+
+// Builds programs on a thread of its own with a hidden context shared with the render context, so
+// compiling and linking (including whatever the driver does synchronously at link time) never
+// stalls a frame. A fence after each build tells the render thread when the program is complete
+// and safe to use from its own context.
+class ShaderCompileThread
+{
+public:
+    // Call on the main thread after GLEW is initialised, GLFW only creates windows there
+    ShaderCompileThread( GLFWwindow *shareWith ) : context( nullptr ), stopping( false )
+    {
+        // The other hints (version, profile) are still the ones the main window was made with
+        glfwWindowHint( GLFW_VISIBLE, GL_FALSE );
+        this->context = glfwCreateWindow( 1, 1, "Shader compiler", nullptr, shareWith );
+        glfwWindowHint( GLFW_VISIBLE, GL_TRUE );
+
+        if ( nullptr == this->context )
+        {
+            LOG_WARNING( "WARNING::SHADER_COMPILE_THREAD::NO_SHARED_CONTEXT" );
+            return;
+        }
+
+        this->thread = std::thread( &ShaderCompileThread::Run, this );
+    }
+
+    ~ShaderCompileThread( )
+    {
+        this->Stop( );
+    }
+
+    // Has to happen before glfwTerminate, on the main thread. Queued requests are dropped.
+    void Stop( )
+    {
+        if ( nullptr == this->context )
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard( this->lock );
+            this->stopping = true;
+        }
+
+        this->wake.notify_one( );
+        this->thread.join( );
+
+        for ( size_t i = 0; i < this->done.size( ); ++i )
+        {
+            glDeleteSync( this->done[i].fence );
+            this->done[i].result.shader->Delete( );
+        }
+
+        this->done.clear( );
+        glfwDestroyWindow( this->context );
+        this->context = nullptr;
+    }
+
+    bool IsRunning( ) const
+    {
+        return nullptr != this->context;
+    }
+
+    void Submit( const void *owner, GLuint tag, const std::string &vertexPath, const std::string &fragmentPath,
+        const std::string &defines )
+    {
+        Request request = { owner, tag, vertexPath, fragmentPath, defines };
+
+        {
+            std::lock_guard<std::mutex> guard( this->lock );
+            this->requests.push_back( request );
+        }
+
+        this->wake.notify_one( );
+    }
+
+    // Moves owner's finished programs into results, never blocks. Programs the GPU side hasn't
+    // completed yet stay for a later call.
+    void Collect( const void *owner, std::vector<CompiledShader> &results )
+    {
+        std::lock_guard<std::mutex> guard( this->lock );
+        size_t kept = 0;
+
+        for ( size_t i = 0; i < this->done.size( ); ++i )
+        {
+            Finished &finished = this->done[i];
+
+            if ( owner == finished.result.owner )
+            {
+                GLenum state = glClientWaitSync( finished.fence, 0, 0 );
+
+                if ( GL_ALREADY_SIGNALED == state || GL_CONDITION_SATISFIED == state )
+                {
+                    glDeleteSync( finished.fence );
+                    results.push_back( std::move( finished.result ) );
+                    continue;
+                }
+            }
+
+            if ( kept != i )
+            {
+                this->done[kept] = std::move( finished );
+            }
+
+            ++kept;
+        }
+
+        this->done.resize( kept );
+    }
+
+private:
+    struct Request
+    {
+        const void *owner;
+        GLuint tag;
+        std::string vertexPath;
+        std::string fragmentPath;
+        std::string defines;
+    };
+
+    struct Finished
+    {
+        CompiledShader result;
+        GLsync fence;
+    };
+
+    GLFWwindow *context;
+    std::thread thread;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::deque<Request> requests;
+    std::vector<Finished> done;
+    bool stopping;
+
+    void Run( )
+    {
+        glfwMakeContextCurrent( this->context );
+        Profiler::Get( ).SetThreadName( "Shader compiler" );
+
+        for ( ;; )
+        {
+            Request request;
+
+            {
+                std::unique_lock<std::mutex> guard( this->lock );
+                this->wake.wait( guard, [this]( ) { return this->stopping || !this->requests.empty( ); } );
+
+                if ( this->stopping )
+                {
+                    break;
+                }
+
+                request = this->requests.front( );
+                this->requests.pop_front( );
+            }
+
+            PROFILE_ZONE( "ShaderCompileThread::Build" );
+
+            // Blocking is fine here, this thread has nothing else to do
+            Finished finished;
+            finished.result.owner = request.owner;
+            finished.result.tag = request.tag;
+            finished.result.shader.reset( new Shader( request.vertexPath.c_str( ), request.fragmentPath.c_str( ), true,
+                request.defines ) );
+            finished.fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+            glFlush( );
+
+            std::lock_guard<std::mutex> guard( this->lock );
+            this->done.push_back( std::move( finished ) );
+        }
+
+        glfwMakeContextCurrent( nullptr );
+    }
+
+    ShaderCompileThread( const ShaderCompileThread & ) = delete;
+    ShaderCompileThread &operator=( const ShaderCompileThread & ) = delete;
+};
+
+#endif // SHADER_COMPILE_THREAD_H
@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////
+/// ShaderSource.h
+////////////////////////////////////////////////////////////////
+
+#ifndef SHADER_SOURCE_H
+#define SHADER_SOURCE_H
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "Log.h"
+
+// The small front end GLSL is missing: #include "file" (resolved relative to the including file,
+// each file pulled in at most once per stage) and defines injected behind the #version line.
+// Every file that went into a stage is reported back so hot reload knows what to watch.
+// Included files get their own source string number in #line, so the n in an "n:line" error
+// message is the index into the file list.
+class ShaderSource
+{
+public:
+    // Returns false if any of the files couldn't be read
+    static bool Load( const std::string &path, std::string &source, std::vector<std::string> &files )
+    {
+        source.clear( );
+        files.clear( );
+
+        return Expand( path, source, files );
+    }
+
+    // defines is a block of "#define NAME VALUE" lines. GLSL wants #version before anything else,
+    // so they go right behind it and a #line puts the numbering back to match the file.
+    static std::string InjectDefines( const std::string &source, const std::string &defines )
+    {
+        if ( defines.empty( ) )
+        {
+            return source;
+        }
+
+        size_t insertAt = 0;
+        size_t version = source.find( "#version" );
+
+        if ( std::string::npos != version )
+        {
+            size_t end = source.find( '\n', version );
+            insertAt = ( std::string::npos == end ) ? source.size( ) : end + 1;
+        }
+
+        size_t nextLine = std::count( source.begin( ), source.begin( ) + insertAt, '\n' ) + 1;
+        std::stringstream injected;
+        injected << source.substr( 0, insertAt );
+
+        if ( insertAt > 0 && '\n' != source[insertAt - 1] )
+        {
+            injected << '\n';
+        }
+
+        injected << defines << "#line " << nextLine << " 0\n" << source.substr( insertAt );
+
+        return injected.str( );
+    }
+
+private:
+    static const int MAX_INCLUDE_DEPTH = 16;
+
+    static std::string DirectoryOf( const std::string &path )
+    {
+        size_t slash = path.find_last_of( '/' );
+
+        return ( std::string::npos == slash ) ? std::string( ) : path.substr( 0, slash + 1 );
+    }
+
+    // Pulls the file name out of a line like #include "name", false if the line isn't an include
+    static bool ParseInclude( const std::string &line, std::string &name )
+    {
+        size_t start = line.find_first_not_of( " \t" );
+
+        if ( std::string::npos == start || 0 != line.compare( start, 8, "#include" ) )
+        {
+            return false;
+        }
+
+        size_t open = line.find( '"', start + 8 );
+        size_t close = ( std::string::npos == open ) ? std::string::npos : line.find( '"', open + 1 );
+
+        if ( std::string::npos == close )
+        {
+            return false;
+        }
+
+        name = line.substr( open + 1, close - open - 1 );
+
+        return true;
+    }
+
+    static bool Expand( const std::string &path, std::string &source, std::vector<std::string> &files, int depth = 0 )
+    {
+        // Included before (or a cycle), behave like #pragma once
+        if ( files.end( ) != std::find( files.begin( ), files.end( ), path ) )
+        {
+            return true;
+        }
+
+        if ( depth > MAX_INCLUDE_DEPTH )
+        {
+            LOG_ERROR( "ERROR::SHADER::INCLUDE_TOO_DEEP {}", path );
+            return false;
+        }
+
+        std::ifstream file( path.c_str( ) );
+
+        if ( !file.is_open( ) )
+        {
+            LOG_ERROR( "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ {}", path );
+            return false;
+        }
+
+        size_t fileIndex = files.size( );
+        files.push_back( path );
+
+        bool success = true;
+        std::string line;
+        std::string name;
+        size_t lineNumber = 0;
+
+        while ( std::getline( file, line ) )
+        {
+            ++lineNumber;
+
+            if ( !ParseInclude( line, name ) )
+            {
+                source += line;
+                source += '\n';
+                continue;
+            }
+
+            std::stringstream marker;
+            marker << "#line 1 " << files.size( ) << '\n';
+            source += marker.str( );
+
+            success = Expand( DirectoryOf( path ) + name, source, files, depth + 1 ) && success;
+
+            marker.str( "" );
+            marker << "#line " << lineNumber + 1 << ' ' << fileIndex << '\n';
+            source += marker.str( );
+        }
+
+        return success;
+    }
+};
+
+#endif // SHADER_SOURCE_H
@@ -0,0 +1,341 @@
+////////////////////////////////////////////////////////////////
+/// ShaderVariants.h
+////////////////////////////////////////////////////////////////
+
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include <fstream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Log.h"
+#include "Shader.h"
+#include "ShaderBatch.h"
+#include "ShaderCompileThread.h"
+#include "ShaderWatcher.h"
+
+// One vertex/fragment pair specialised by feature defines. Feature i maps to bit i of a
+// permutation, and every permutation that has been asked for is compiled once (with that
+// feature's name defined as 1) and kept, so shaders can #ifdef a feature instead of branching
+// on a uniform at runtime. Variants are built on demand or prewarmed from a manifest listing one
+// variant per line by its features, with "-" standing for the variant with none of them.
+//
+// With an uber shader enabled, Select never makes the renderer wait: a permutation that isn't
+// built yet is queued (on the compile thread if there is one) and the uber shader, which has every
+// feature and picks them per draw from its features uniform, is drawn with until Update reports
+// the specialised variant ready.
+class ShaderVariants
+{
+public:
+    static const size_t MAX_FEATURES = 32;
+
+    ShaderVariants( const GLchar *vertexPath, const GLchar *fragmentPath, const std::vector<std::string> &features )
+    : vertexPath( vertexPath ), fragmentPath( fragmentPath ), features( features ), watcher( nullptr ), compileThread( nullptr )
+    {
+        if ( this->features.size( ) > MAX_FEATURES )
+        {
+            LOG_ERROR( "ERROR::SHADER_VARIANTS::TOO_MANY_FEATURES {}", vertexPath );
+            this->features.resize( MAX_FEATURES );
+        }
+    }
+
+    // Variants built from here on are hot reloaded through watcher
+    void SetWatcher( ShaderWatcher *watcher )
+    {
+        this->watcher = watcher;
+    }
+
+    // Permutations built from here on are compiled on thread instead of the render context
+    void SetCompileThread( ShaderCompileThread *thread )
+    {
+        this->compileThread = ( nullptr != thread && thread->IsRunning( ) ) ? thread : nullptr;
+    }
+
+    // Builds (and waits for) the uber shader. It's compiled with UBER defined plus NAME_BIT for each
+    // feature, so the source can test "features & NAME_BIT" at runtime.
+    Shader &EnableUberShader( )
+    {
+        if ( !this->uber )
+        {
+            std::stringstream defines;
+            defines << "#define UBER 1\n";
+
+            for ( size_t i = 0; i < this->features.size( ); ++i )
+            {
+                defines << "#define " << this->features[i] << "_BIT " << ( 1u << i ) << "\n";
+            }
+
+            this->uber.reset( new Shader( this->vertexPath.c_str( ), this->fragmentPath.c_str( ), true, defines.str( ) ) );
+
+            if ( nullptr != this->watcher )
+            {
+                this->watcher->Watch( *this->uber );
+            }
+        }
+
+        return *this->uber;
+    }
+
+    Shader *GetUberShader( )
+    {
+        return this->uber.get( );
+    }
+
+    // What to draw permutation with right now. Without an uber shader this is Get and may block.
+    Shader &Select( GLuint permutation )
+    {
+        if ( !this->uber )
+        {
+            return this->Get( permutation );
+        }
+
+        std::unordered_map<GLuint, std::unique_ptr<Shader>>::iterator it = this->variants.find( permutation );
+
+        if ( it != this->variants.end( ) )
+        {
+            return ( SHADER_READY == it->second->GetStatus( ) ) ? *it->second : *this->uber;
+        }
+
+        this->Start( permutation );
+
+        return *this->uber;
+    }
+
+    // Call once per frame. Picks up variants that finished building and returns their permutations,
+    // anything drawing one of them with the uber shader can switch over now.
+    const std::vector<GLuint> &Update( )
+    {
+        this->ready.clear( );
+
+        if ( nullptr != this->compileThread )
+        {
+            this->compiled.clear( );
+            this->compileThread->Collect( this, this->compiled );
+
+            for ( size_t i = 0; i < this->compiled.size( ); ++i )
+            {
+                GLuint permutation = this->compiled[i].tag;
+                this->inFlight.erase( permutation );
+
+                std::unique_ptr<Shader> &slot = this->variants[permutation];
+
+                // Someone needed it sooner and built it with Get in the meantime
+                if ( slot )
+                {
+                    this->compiled[i].shader->Delete( );
+                    continue;
+                }
+
+                slot = std::move( this->compiled[i].shader );
+
+                if ( nullptr != this->watcher )
+                {
+                    this->watcher->Watch( *slot );
+                }
+
+                if ( SHADER_READY == slot->GetStatus( ) )
+                {
+                    this->ready.push_back( permutation );
+                }
+            }
+        }
+
+        // Variants requested on the render context, done once the driver says so
+        for ( std::unordered_map<GLuint, std::unique_ptr<Shader>>::iterator it = this->variants.begin( ); it != this->variants.end( ); ++it )
+        {
+            Shader &shader = *it->second;
+
+            if ( SHADER_COMPILING == shader.GetStatus( ) && shader.IsReady( ) && shader.Finish( ) )
+            {
+                this->ready.push_back( it->first );
+            }
+        }
+
+        return this->ready;
+    }
+
+    // The permutation a variant was built for, false if shader isn't one of them
+    bool FindPermutation( const Shader *shader, GLuint &permutation ) const
+    {
+        for ( std::unordered_map<GLuint, std::unique_ptr<Shader>>::const_iterator it = this->variants.begin( ); it != this->variants.end( ); ++it )
+        {
+            if ( shader == it->second.get( ) )
+            {
+                permutation = it->first;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // 0 for a name that isn't one of the features
+    GLuint GetFeatureBit( const std::string &name ) const
+    {
+        for ( size_t i = 0; i < this->features.size( ); ++i )
+        {
+            if ( name == this->features[i] )
+            {
+                return 1u << i;
+            }
+        }
+
+        return 0;
+    }
+
+    std::string GetDefines( GLuint permutation ) const
+    {
+        std::string defines;
+
+        for ( size_t i = 0; i < this->features.size( ); ++i )
+        {
+            if ( permutation & ( 1u << i ) )
+            {
+                defines += "#define " + this->features[i] + " 1\n";
+            }
+        }
+
+        return defines;
+    }
+
+    // The variant ready to draw with, compiling it first (and blocking) if it isn't yet
+    Shader &Get( GLuint permutation )
+    {
+        Shader &shader = this->Request( permutation );
+        shader.Finish( );
+
+        return shader;
+    }
+
+    // Starts building the variant if it doesn't exist yet and returns it without waiting, check
+    // IsReady/Finish before drawing with it
+    Shader &Request( GLuint permutation )
+    {
+        std::unique_ptr<Shader> &slot = this->variants[permutation];
+
+        if ( !slot )
+        {
+            slot.reset( new Shader( this->vertexPath.c_str( ), this->fragmentPath.c_str( ), false, this->GetDefines( permutation ) ) );
+
+            if ( nullptr != this->watcher )
+            {
+                this->watcher->Watch( *slot );
+            }
+        }
+
+        return *slot;
+    }
+
+    // Submits every variant the manifest lists. They go to the compile thread if there is one,
+    // otherwise they're submitted here and the ones still compiling are handed to batch if given. Returns how many variants were listed, unknown feature names are reported and skipped.
+    size_t Prewarm( const GLchar *manifestPath, ShaderBatch *batch = nullptr )
+    {
+        std::ifstream manifest( manifestPath );
+
+        if ( !manifest.is_open( ) )
+        {
+            LOG_ERROR( "ERROR::SHADER_VARIANTS::MANIFEST_NOT_SUCCESSFULLY_READ {}", manifestPath );
+            return 0;
+        }
+
+        size_t listed = 0;
+        std::string line;
+
+        while ( std::getline( manifest, line ) )
+        {
+            std::stringstream words( line.substr( 0, line.find( '#' ) ) );
+            std::string word;
+            GLuint permutation = 0;
+            bool any = false;
+
+            while ( words >> word )
+            {
+                any = true;
+
+                if ( "-" == word )
+                {
+                    continue;
+                }
+
+                GLuint bit = this->GetFeatureBit( word );
+
+                if ( 0 == bit )
+                {
+                    LOG_WARNING( "WARNING::SHADER_VARIANTS::UNKNOWN_FEATURE {} in {}", word, manifestPath );
+                }
+
+                permutation |= bit;
+            }
+
+            if ( !any )
+            {
+                continue;
+            }
+
+            if ( nullptr != this->compileThread )
+            {
+                this->Start( permutation );
+            }
+            else
+            {
+                bool existed = 0 != this->variants.count( permutation );
+                Shader &shader = this->Request( permutation );
+
+                if ( !existed && nullptr != batch )
+                {
+                    batch->Add( shader );
+                }
+            }
+
+            ++listed;
+        }
+
+        return listed;
+    }
+
+    size_t GetCount( ) const
+    {
+        return this->variants.size( );
+    }
+
+private:
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::vector<std::string> features;
+    std::unordered_map<GLuint, std::unique_ptr<Shader>> variants;
+    std::unique_ptr<Shader> uber;
+    std::set<GLuint> inFlight;
+    std::vector<CompiledShader> compiled;
+    std::vector<GLuint> ready;
+    ShaderWatcher *watcher;
+    ShaderCompileThread *compileThread;
+
+    // Starts building a permutation without waiting, unless it exists or is already on its way
+    void Start( GLuint permutation )
+    {
+        if ( this->variants.count( permutation ) || this->inFlight.count( permutation ) )
+        {
+            return;
+        }
+
+        if ( nullptr != this->compileThread )
+        {
+            this->inFlight.insert( permutation );
+            this->compileThread->Submit( this, permutation, this->vertexPath, this->fragmentPath, this->GetDefines( permutation ) );
+        }
+        else
+        {
+            this->Request( permutation );
+        }
+    }
+
+    ShaderVariants( const ShaderVariants & ) = delete;
+    ShaderVariants &operator=( const ShaderVariants & ) = delete;
+};
+
+#endif // SHADER_VARIANTS_H
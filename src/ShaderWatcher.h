@@ -0,0 +1,348 @@
+////////////////////////////////////////////////////////////////
+/// ShaderWatcher.h
+////////////////////////////////////////////////////////////////
+
+#ifndef SHADER_WATCHER_H
+#define SHADER_WATCHER_H
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+#include "Log.h"
+#include "Shader.h"
+#include "ShaderCompileThread.h"
+
+// A program that was rebuilt and swapped in, oldProgram is already deleted and only useful for
+// finding the places that still refer to it
+struct ShaderSwap
+{
+    Shader *shader;
+    GLuint oldProgram;
+};
+
+// Hot reload for shader sources. The directories holding the watched shaders' files get an
+// inotify watch (directories rather than files, since most editors save by renaming a new file
+// over the old one). Update runs at a frame boundary: it drains the pending file events, submits
+// a rebuild for each affected program only, and swaps in the rebuilds that have finished linking.
+// A rebuild that fails to compile is dropped and the old program stays in use.
+// Rebuilds go to the compile thread when there is one, so the frame never waits on the compiler.
+// Without it they are submitted on the render context, where only a driver with parallel shader
+// compile keeps them off the frame, otherwise Finish pays for the compile at the next Update.
+// On platforms without inotify this compiles to a watcher that never sees a change.
+class ShaderWatcher
+{
+public:
+    ShaderWatcher( ) : descriptor( -1 ), compileThread( nullptr ), nextTag( 0 )
+    {
+#ifdef __linux__
+        this->descriptor = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+
+        if ( this->descriptor < 0 )
+        {
+            LOG_WARNING( "WARNING::SHADER_WATCHER::INOTIFY_UNAVAILABLE" );
+        }
+#endif
+    }
+
+    ~ShaderWatcher( )
+    {
+#ifdef __linux__
+        if ( this->descriptor >= 0 )
+        {
+            close( this->descriptor );
+        }
+#endif
+    }
+
+    // Rebuilds submitted from here on are built on that thread
+    void SetCompileThread( ShaderCompileThread *thread )
+    {
+        this->compileThread = ( nullptr != thread && thread->IsRunning( ) ) ? thread : nullptr;
+    }
+
+    void Watch( Shader &shader )
+    {
+        this->shaders.push_back( &shader );
+        this->WatchFilesOf( shader );
+    }
+
+    // Call once per frame with the context current and nothing from the previous frame still
+    // needing the old programs. Returns the programs that were swapped in this call.
+    const std::vector<ShaderSwap> &Update( )
+    {
+        this->swapped.clear( );
+
+        std::set<std::string> changed;
+        this->ReadEvents( changed );
+
+        for ( size_t i = 0; i < this->shaders.size( ) && !changed.empty( ); ++i )
+        {
+            Shader *shader = this->shaders[i];
+
+            if ( UsesAny( *shader, changed ) )
+            {
+                this->Rebuild( *shader );
+            }
+        }
+
+        this->CollectRebuilds( );
+
+        return this->swapped;
+    }
+
+    size_t GetPendingCount( ) const
+    {
+        return this->rebuilds.size( );
+    }
+
+private:
+    // replacement is empty while the rebuild is on the compile thread, tag names it there
+    struct PendingRebuild
+    {
+        Shader *target;
+        GLuint tag;
+        std::unique_ptr<Shader> replacement;
+    };
+
+    int descriptor;
+    ShaderCompileThread *compileThread;
+    GLuint nextTag;
+    std::vector<CompiledShader> compiled;
+    std::map<int, std::string> directories;
+    std::vector<Shader *> shaders;
+    std::vector<PendingRebuild> rebuilds;
+    std::vector<ShaderSwap> swapped;
+
+    static std::string DirectoryOf( const std::string &path )
+    {
+        size_t slash = path.find_last_of( '/' );
+
+        return ( std::string::npos == slash ) ? std::string( "." ) : path.substr( 0, slash );
+    }
+
+    // Includes count too, so editing a shared file rebuilds every program that pulls it in
+    static bool UsesAny( const Shader &shader, const std::set<std::string> &changed )
+    {
+        if ( changed.count( shader.GetVertexPath( ) ) || changed.count( shader.GetFragmentPath( ) ) )
+        {
+            return true;
+        }
+
+        const std::vector<std::string> &files = shader.GetFiles( );
+
+        for ( size_t i = 0; i < files.size( ); ++i )
+        {
+            if ( changed.count( files[i] ) )
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void WatchFilesOf( const Shader &shader )
+    {
+        this->WatchDirectoryOf( shader.GetVertexPath( ) );
+        this->WatchDirectoryOf( shader.GetFragmentPath( ) );
+
+        for ( size_t i = 0; i < shader.GetFiles( ).size( ); ++i )
+        {
+            this->WatchDirectoryOf( shader.GetFiles( )[i] );
+        }
+    }
+
+    void WatchDirectoryOf( const std::string &path )
+    {
+#ifdef __linux__
+        if ( this->descriptor < 0 )
+        {
+            return;
+        }
+
+        std::string directory = DirectoryOf( path );
+
+        for ( std::map<int, std::string>::const_iterator it = this->directories.begin( ); it != this->directories.end( ); ++it )
+        {
+            if ( directory == it->second )
+            {
+                return;
+            }
+        }
+
+        int watch = inotify_add_watch( this->descriptor, directory.c_str( ), IN_CLOSE_WRITE | IN_MOVED_TO );
+
+        if ( watch >= 0 )
+        {
+            this->directories[watch] = directory;
+        }
+#else
+        ( void )path;
+#endif
+    }
+
+    // Non-blocking, an editor's save usually shows up as a burst of events that all land in the same set
+    void ReadEvents( std::set<std::string> &changed )
+    {
+#ifdef __linux__
+        if ( this->descriptor < 0 )
+        {
+            return;
+        }
+
+        alignas( struct inotify_event ) char buffer[4096];
+
+        for ( ;; )
+        {
+            ssize_t length = read( this->descriptor, buffer, sizeof( buffer ) );
+
+            if ( length <= 0 )
+            {
+                break;
+            }
+
+            for ( ssize_t offset = 0; offset < length; )
+            {
+                const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>( buffer + offset );
+                std::map<int, std::string>::const_iterator directory = this->directories.find( event->wd );
+
+                if ( event->len > 0 && directory != this->directories.end( ) )
+                {
+                    std::string path = ( "." == directory->second ) ? std::string( event->name ) : directory->second + "/" + event->name;
+                    changed.insert( path );
+                }
+
+                offset += sizeof( struct inotify_event ) + event->len;
+            }
+        }
+#else
+        ( void )changed;
+#endif
+    }
+
+    void Rebuild( Shader &target )
+    {
+        // A newer save supersedes a rebuild that is still compiling
+        for ( size_t i = 0; i < this->rebuilds.size( ); ++i )
+        {
+            if ( &target == this->rebuilds[i].target )
+            {
+                // One already on the compile thread is dropped when it comes back untracked
+                if ( this->rebuilds[i].replacement )
+                {
+                    this->rebuilds[i].replacement->Delete( );
+                }
+
+                this->rebuilds.erase( this->rebuilds.begin( ) + i );
+                break;
+            }
+        }
+
+        PendingRebuild rebuild;
+        rebuild.target = &target;
+        rebuild.tag = this->nextTag++;
+
+        if ( nullptr != this->compileThread && this->compileThread->IsRunning( ) )
+        {
+            this->compileThread->Submit( this, rebuild.tag, target.GetVertexPath( ), target.GetFragmentPath( ), target.GetDefines( ) );
+        }
+        else
+        {
+            rebuild.replacement.reset( new Shader( target.GetVertexPath( ).c_str( ), target.GetFragmentPath( ).c_str( ), false,
+                target.GetDefines( ) ) );
+        }
+
+        this->rebuilds.push_back( std::move( rebuild ) );
+    }
+
+    // Hands the compile thread's finished programs to the rebuilds that are still waiting for them
+    void CollectCompiled( )
+    {
+        if ( nullptr == this->compileThread )
+        {
+            return;
+        }
+
+        this->compiled.clear( );
+        this->compileThread->Collect( this, this->compiled );
+
+        for ( size_t i = 0; i < this->compiled.size( ); ++i )
+        {
+            PendingRebuild *rebuild = nullptr;
+
+            for ( size_t n = 0; n < this->rebuilds.size( ) && nullptr == rebuild; ++n )
+            {
+                if ( this->compiled[i].tag == this->rebuilds[n].tag )
+                {
+                    rebuild = &this->rebuilds[n];
+                }
+            }
+
+            if ( nullptr == rebuild )
+            {
+                // Superseded by a newer save while it was being built
+                this->compiled[i].shader->Delete( );
+                continue;
+            }
+
+            rebuild->replacement = std::move( this->compiled[i].shader );
+        }
+    }
+
+    void CollectRebuilds( )
+    {
+        size_t kept = 0;
+
+        this->CollectCompiled( );
+
+        for ( size_t i = 0; i < this->rebuilds.size( ); ++i )
+        {
+            PendingRebuild &rebuild = this->rebuilds[i];
+
+            // Still on the compile thread, or still compiling on the render context
+            if ( !rebuild.replacement || !rebuild.replacement->IsReady( ) )
+            {
+                if ( kept != i )
+                {
+                    this->rebuilds[kept] = std::move( rebuild );
+                }
+
+                ++kept;
+                continue;
+            }
+
+            // Built on the compile thread it is already finished, and Finish only reads the status
+            if ( rebuild.replacement->Finish( ) )
+            {
+                ShaderSwap swap = { rebuild.target, rebuild.target->Program };
+                rebuild.target->Replace( *rebuild.replacement );
+                this->swapped.push_back( swap );
+
+                // The edit may have added an include from somewhere new
+                this->WatchFilesOf( *rebuild.target );
+
+                LOG_INFO( "SHADER::RELOADED {} {}", rebuild.target->GetVertexPath( ), rebuild.target->GetFragmentPath( ) );
+            }
+            else
+            {
+                // The errors were printed by Finish, keep drawing with the old program
+                rebuild.replacement->Delete( );
+            }
+        }
+
+        this->rebuilds.erase( this->rebuilds.begin( ) + kept, this->rebuilds.end( ) );
+    }
+
+    ShaderWatcher( const ShaderWatcher & ) = delete;
+    ShaderWatcher &operator=( const ShaderWatcher & ) = delete;
+};
+
+#endif // SHADER_WATCHER_H
@@ -0,0 +1,642 @@
+/*
+	The DXT and BC encoders and the DDS loaders.
+
+	- DXT1, DXT5, BC4, BC5 and BC7 give the same bytes with
+	  SOIL_set_SIMD_enabled( 0 ) and with it on, over random sizes
+	  and channel counts (only DXT1 and DXT5 have vector code today).
+	- Decoded again, each format keeps a PSNR floor on a smooth noisy
+	  gradient: DXT1, DXT5, BC4 and BC5 through the DX10 DDS reader of
+	  SOIL_load_image_from_memory, BC7 and BC6H through the small
+	  decoders below, which know the modes the encoders write.
+	- DX10 DDS files of BC7, BC6H, BC4 and sRGB BC1 load directly,
+	  with every MIPmap, into the GL stub, and every truncation and a
+	  few broken headers are turned down without reading past the
+	  buffer (run under valgrind or -fsanitize=address to see that).
+	Exits non-zero on any failure.  Run with "make test".
+*/
+
+#include "../src/SOIL2/SOIL2.h"
+#include "../src/SOIL2/image_DXT.h"
+#include "../src/SOIL2/simd_helper.h"
+#include "gl_stub.h"
+#include <GL/gl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ITERATIONS 200
+
+static int tests = 0, failures = 0;
+
+static void check( int ok, const char *what )
+{
+	++tests;
+	if( !ok )
+	{
+		++failures;
+		printf( "FAIL %s\n", what );
+	}
+}
+
+/*	a smooth RGBA gradient with a little noise, as in the DXT benchmark	*/
+static unsigned char *gradient_image( int width, int height )
+{
+	unsigned char *img = (unsigned char*)malloc( width * height * 4 );
+	int x, y;
+	srand( 1 );
+	for( y = 0; y < height; ++y )
+	{
+		for( x = 0; x < width; ++x )
+		{
+			unsigned char *pixel = img + (y * width + x) * 4;
+			pixel[0] = (unsigned char)(x * 255 / width);
+			pixel[1] = (unsigned char)(y * 255 / height);
+			pixel[2] = (unsigned char)(((x + y) * 255 / (width + height) + (rand() & 7)) & 255);
+			pixel[3] = (unsigned char)(128 + 127 * sin( x * 0.05 ) * cos( y * 0.03 ));
+		}
+	}
+	return img;
+}
+
+static double PSNR( double squared_error, double samples, double peak )
+{
+	if( squared_error <= 0.0 )
+	{
+		return 99.0;
+	}
+	return 10.0 * log10( peak * peak * samples / squared_error );
+}
+
+/********* SIMD against C *********/
+
+enum
+{
+	FORMAT_DXT1,
+	FORMAT_DXT5,
+	FORMAT_BC4,
+	FORMAT_BC5,
+	FORMAT_BC7,
+	FORMATS
+};
+
+static const char *const format_names[FORMATS] = { "DXT1", "DXT5", "BC4", "BC5", "BC7" };
+
+static unsigned char *encode( int format, const unsigned char *img, int width, int height, int channels,
+		int mode, int *size )
+{
+	switch( format )
+	{
+	case FORMAT_DXT1:
+		return convert_image_to_DXT1( img, width, height, channels, mode, size );
+	case FORMAT_DXT5:
+		return convert_image_to_DXT5( img, width, height, channels, mode, size );
+	case FORMAT_BC4:
+		return convert_image_to_BC4( img, width, height, channels, mode, size );
+	case FORMAT_BC5:
+		return convert_image_to_BC5( img, width, height, channels, mode, size );
+	default:
+		return convert_image_to_BC7( img, width, height, channels, mode, size );
+	}
+}
+
+static void test_SIMD_matches_C( void )
+{
+	const int modes[] = { DXT_MODE_RANGE_FIT, DXT_MODE_DEFAULT, DXT_MODE_CLUSTER_FIT };
+	int it, format, m, i;
+	srand( 2 );
+	for( it = 0; it < ITERATIONS; ++it )
+	{
+		const int width = 1 + rand() % 70;
+		const int height = 1 + rand() % 30;
+		const int channels = 1 + rand() % 4;
+		unsigned char *img = (unsigned char*)malloc( width * height * channels );
+		/*	odd iterations get noise, even ones a few flat colors	*/
+		for( i = 0; i < width * height * channels; ++i )
+		{
+			img[i] = (it & 1) ? (unsigned char)rand() : (unsigned char)((rand() & 3) * 85);
+		}
+		for( format = 0; format < FORMATS; ++format )
+		{
+			for( m = 0; m < 3; ++m )
+			{
+				int plain_size, simd_size;
+				unsigned char *plain, *simd;
+				char what[96];
+				SOIL_set_SIMD_enabled( 0 );
+				plain = encode( format, img, width, height, channels, modes[m], &plain_size );
+				SOIL_set_SIMD_enabled( 1 );
+				simd = encode( format, img, width, height, channels, modes[m], &simd_size );
+				snprintf( what, sizeof( what ), "%s mode %d %dx%dx%d SIMD blocks differ from C",
+					format_names[format], modes[m], width, height, channels );
+				check( (NULL != plain) && (NULL != simd) && (plain_size == simd_size) &&
+					(0 == memcmp( plain, simd, plain_size )), what );
+				free( simd );
+				free( plain );
+			}
+		}
+		free( img );
+	}
+}
+
+/********* DDS files in memory *********/
+
+/*	a DDS with the DX10 header around levels of blocks, the caller frees it	*/
+static unsigned char *make_DX10_DDS( int width, int height, int levels, unsigned int dxgi_format,
+		const unsigned char *blocks, int blocks_size, int *size )
+{
+	DDS_header header;
+	DDS_header_DXT10 header10;
+	unsigned char *dds;
+	memset( &header, 0, sizeof( header ) );
+	memset( &header10, 0, sizeof( header10 ) );
+	header.dwMagic = ('D' << 0) | ('D' << 8) | ('S' << 16) | (' ' << 24);
+	header.dwSize = 124;
+	header.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE;
+	header.dwWidth = width;
+	header.dwHeight = height;
+	header.sPixelFormat.dwSize = 32;
+	header.sPixelFormat.dwFlags = DDPF_FOURCC;
+	header.sPixelFormat.dwFourCC = ('D' << 0) | ('X' << 8) | ('1' << 16) | ('0' << 24);
+	header.sCaps.dwCaps1 = DDSCAPS_TEXTURE;
+	if( levels > 1 )
+	{
+		header.dwFlags |= DDSD_MIPMAPCOUNT;
+		header.dwMipMapCount = levels;
+		header.sCaps.dwCaps1 |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+	}
+	header10.dxgiFormat = dxgi_format;
+	header10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+	header10.arraySize = 1;
+	*size = sizeof( header ) + sizeof( header10 ) + blocks_size;
+	dds = (unsigned char*)malloc( *size );
+	memcpy( dds, &header, sizeof( header ) );
+	memcpy( dds + sizeof( header ), &header10, sizeof( header10 ) );
+	memcpy( dds + sizeof( header ) + sizeof( header10 ), blocks, blocks_size );
+	return dds;
+}
+
+/********* decoders for the BC7 and BC6H modes the encoders use *********/
+
+static unsigned int get_bits( const unsigned char block[16], int *pos, int count )
+{
+	unsigned int value = 0;
+	int i;
+	for( i = 0; i < count; ++i, ++*pos )
+	{
+		value |= (unsigned int)((block[*pos >> 3] >> (*pos & 7)) & 1) << i;
+	}
+	return value;
+}
+
+static const int weights2[4] = { 0, 21, 43, 64 };
+static const int weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static int interpolate( int e0, int e1, int weight )
+{
+	return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+/*	BC7 modes 5 and 6 into 16 RGBA pixels, 0 for any other mode	*/
+static int decode_BC7_block( const unsigned char block[16], unsigned char rgba[64] )
+{
+	int pos = 0, e[2][4], i, c;
+	if( 0x40 == (block[0] & 0x7F) )
+	{
+		int p[2];
+		pos = 7;
+		for( c = 0; c < 4; ++c )
+		{
+			e[0][c] = get_bits( block, &pos, 7 );
+			e[1][c] = get_bits( block, &pos, 7 );
+		}
+		p[0] = get_bits( block, &pos, 1 );
+		p[1] = get_bits( block, &pos, 1 );
+		for( c = 0; c < 4; ++c )
+		{
+			e[0][c] = (e[0][c] << 1) | p[0];
+			e[1][c] = (e[1][c] << 1) | p[1];
+		}
+		for( i = 0; i < 16; ++i )
+		{
+			const int index = get_bits( block, &pos, (0 == i) ? 3 : 4 );
+			for( c = 0; c < 4; ++c )
+			{
+				rgba[i*4 + c] = (unsigned char)interpolate( e[0][c], e[1][c], weights4[index] );
+			}
+		}
+		return 1;
+	}
+	if( 0x20 == (block[0] & 0x3F) )
+	{
+		int rotation, color[16];
+		pos = 6;
+		rotation = get_bits( block, &pos, 2 );
+		for( c = 0; c < 3; ++c )
+		{
+			e[0][c] = get_bits( block, &pos, 7 );
+			e[1][c] = get_bits( block, &pos, 7 );
+			e[0][c] = (e[0][c] << 1) | (e[0][c] >> 6);
+			e[1][c] = (e[1][c] << 1) | (e[1][c] >> 6);
+		}
+		e[0][3] = get_bits( block, &pos, 8 );
+		e[1][3] = get_bits( block, &pos, 8 );
+		for( i = 0; i < 16; ++i )
+		{
+			color[i] = get_bits( block, &pos, (0 == i) ? 1 : 2 );
+		}
+		for( i = 0; i < 16; ++i )
+		{
+			const int alpha = get_bits( block, &pos, (0 == i) ? 1 : 2 );
+			unsigned char *px = rgba + i*4;
+			for( c = 0; c < 3; ++c )
+			{
+				px[c] = (unsigned char)interpolate( e[0][c], e[1][c], weights2[color[i]] );
+			}
+			px[3] = (unsigned char)interpolate( e[0][3], e[1][3], weights2[alpha] );
+			if( rotation > 0 )
+			{
+				const unsigned char swap = px[3];
+				px[3] = px[rotation - 1];
+				px[rotation - 1] = swap;
+			}
+		}
+		return 1;
+	}
+	return 0;
+}
+
+static float half_to_float( int h )
+{
+	const int exponent = (h >> 10) & 31;
+	const float mantissa = (float)(h & 1023);
+	const float value = (0 == exponent) ? mantissa * (1.0f / 16777216.0f) :
+		(float)ldexp( 1.0 + mantissa / 1024.0, exponent - 15 );
+	return (h & 0x8000) ? -value : value;
+}
+
+/*	BC6H mode 11 into 16 RGB floats, 0 for any other mode	*/
+static int decode_BC6H_block( const unsigned char block[16], int is_signed, float rgb[48] )
+{
+	int pos = 0, e[2][3], i, c;
+	if( 0x03 != get_bits( block, &pos, 5 ) )
+	{
+		return 0;
+	}
+	for( i = 0; i < 2; ++i )
+	{
+		for( c = 0; c < 3; ++c )
+		{
+			int q = get_bits( block, &pos, 10 );
+			/*	unquantize to 16 bits, as the spec does	*/
+			if( is_signed )
+			{
+				const int negative = (q & 512) ? 1 : 0;
+				q = negative ? 1024 - q : q;
+				q = (0 == q) ? 0 : ((q >= 511) ? 0x7FFF : ((q << 15) + 0x4000) >> 9);
+				q = negative ? -q : q;
+			} else
+			{
+				q = (0 == q) ? 0 : ((1023 == q) ? 0xFFFF : ((q << 16) + 0x8000) >> 10);
+			}
+			e[i][c] = q;
+		}
+	}
+	for( i = 0; i < 16; ++i )
+	{
+		const int index = get_bits( block, &pos, (0 == i) ? 3 : 4 );
+		for( c = 0; c < 3; ++c )
+		{
+			const int x = interpolate( e[0][c], e[1][c], weights4[index] );
+			int h;
+			if( is_signed )
+			{
+				h = (x < 0) ? (0x8000 | ((-x * 31) >> 5)) : ((x * 31) >> 5);
+			} else
+			{
+				h = (x * 31) >> 6;
+			}
+			rgb[i*3 + c] = half_to_float( h );
+		}
+	}
+	return 1;
+}
+
+/********* PSNR floors *********/
+
+#define QUALITY_SIZE 64
+
+/*	decodes a DX10 DDS of the blocks with the SOIL image loader	*/
+static unsigned char *decode_with_SOIL( const unsigned char *blocks, int blocks_size, unsigned int dxgi_format )
+{
+	int dds_size, width, height, channels;
+	unsigned char *dds = make_DX10_DDS( QUALITY_SIZE, QUALITY_SIZE, 1, dxgi_format, blocks, blocks_size, &dds_size );
+	unsigned char *rgba = SOIL_load_image_from_memory( dds, dds_size, &width, &height, &channels, SOIL_LOAD_RGBA );
+	free( dds );
+	if( (NULL != rgba) && ((QUALITY_SIZE != width) || (QUALITY_SIZE != height)) )
+	{
+		SOIL_free_image_data( rgba );
+		return NULL;
+	}
+	return rgba;
+}
+
+/*	the error of the first count channels of the decoded RGBA pixels	*/
+static double channel_error( const unsigned char *img, int channels, const unsigned char *rgba,
+		int first, int count )
+{
+	double error = 0.0;
+	int i, c;
+	for( i = 0; i < QUALITY_SIZE * QUALITY_SIZE; ++i )
+	{
+		for( c = first; c < first + count; ++c )
+		{
+			const double e = (double)img[i * channels + c] - rgba[i * 4 + c];
+			error += e * e;
+		}
+	}
+	return error;
+}
+
+static void check_floor( const char *name, double psnr, double floor_dB )
+{
+	char what[96];
+	printf( "%-16s PSNR %6.2f dB (floor %.1f)\n", name, psnr, floor_dB );
+	snprintf( what, sizeof( what ), "%s PSNR %.2f dB is below %.1f dB", name, psnr, floor_dB );
+	check( psnr >= floor_dB, what );
+}
+
+static void test_quality( void )
+{
+	const double pixels = QUALITY_SIZE * QUALITY_SIZE;
+	unsigned char *img = gradient_image( QUALITY_SIZE, QUALITY_SIZE );
+	unsigned char *rgb = (unsigned char*)malloc( QUALITY_SIZE * QUALITY_SIZE * 3 );
+	unsigned char *blocks, *rgba, *decoded;
+	float *hdr, *hdr_decoded;
+	double error;
+	int size, i, c, is_signed, ok;
+	for( i = 0; i < QUALITY_SIZE * QUALITY_SIZE; ++i )
+	{
+		memcpy( rgb + i*3, img + i*4, 3 );
+	}
+
+	blocks = convert_image_to_DXT1( rgb, QUALITY_SIZE, QUALITY_SIZE, 3, DXT_MODE_DEFAULT, &size );
+	rgba = decode_with_SOIL( blocks, size, DXGI_FORMAT_BC1_UNORM );
+	check( NULL != rgba, "DX10 BC1 DDS did not load" );
+	if( NULL != rgba )
+	{
+		check_floor( "DXT1 RGB", PSNR( channel_error( rgb, 3, rgba, 0, 3 ), 3 * pixels, 255.0 ), 36.0 );
+		SOIL_free_image_data( rgba );
+	}
+	free( blocks );
+
+	blocks = convert_image_to_DXT5( img, QUALITY_SIZE, QUALITY_SIZE, 4, DXT_MODE_DEFAULT, &size );
+	rgba = decode_with_SOIL( blocks, size, DXGI_FORMAT_BC3_UNORM );
+	check( NULL != rgba, "DX10 BC3 DDS did not load" );
+	if( NULL != rgba )
+	{
+		check_floor( "DXT5 RGB", PSNR( channel_error( img, 4, rgba, 0, 3 ), 3 * pixels, 255.0 ), 36.0 );
+		check_floor( "DXT5 alpha", PSNR( channel_error( img, 4, rgba, 3, 1 ), pixels, 255.0 ), 48.0 );
+		SOIL_free_image_data( rgba );
+	}
+	free( blocks );
+
+	blocks = convert_image_to_BC4( img, QUALITY_SIZE, QUALITY_SIZE, 4, DXT_MODE_DEFAULT, &size );
+	rgba = decode_with_SOIL( blocks, size, DXGI_FORMAT_BC4_UNORM );
+	check( NULL != rgba, "DX10 BC4 DDS did not load" );
+	if( NULL != rgba )
+	{
+		check_floor( "BC4 R", PSNR( channel_error( img, 4, rgba, 0, 1 ), pixels, 255.0 ), 52.0 );
+		SOIL_free_image_data( rgba );
+	}
+	free( blocks );
+
+	blocks = convert_image_to_BC5( img, QUALITY_SIZE, QUALITY_SIZE, 4, DXT_MODE_DEFAULT, &size );
+	rgba = decode_with_SOIL( blocks, size, DXGI_FORMAT_BC5_UNORM );
+	check( NULL != rgba, "DX10 BC5 DDS did not load" );
+	if( NULL != rgba )
+	{
+		check_floor( "BC5 RG", PSNR( channel_error( img, 4, rgba, 0, 2 ), 2 * pixels, 255.0 ), 52.0 );
+		SOIL_free_image_data( rgba );
+	}
+	free( blocks );
+
+	/*	BC7, block by block	*/
+	blocks = convert_image_to_BC7( img, QUALITY_SIZE, QUALITY_SIZE, 4, DXT_MODE_DEFAULT, &size );
+	decoded = (unsigned char*)malloc( QUALITY_SIZE * QUALITY_SIZE * 4 );
+	ok = 1;
+	for( i = 0; i < size / 16; ++i )
+	{
+		const int bx = (i % (QUALITY_SIZE / 4)) * 4, by = (i / (QUALITY_SIZE / 4)) * 4;
+		unsigned char block[64];
+		int y;
+		ok &= decode_BC7_block( blocks + i * 16, block );
+		for( y = 0; y < 4; ++y )
+		{
+			memcpy( decoded + ((by + y) * QUALITY_SIZE + bx) * 4, block + y * 16, 16 );
+		}
+	}
+	check( ok, "BC7 encoder wrote a mode other than 5 or 6" );
+	check_floor( "BC7 RGB", PSNR( channel_error( img, 4, decoded, 0, 3 ), 3 * pixels, 255.0 ), 37.5 );
+	check_floor( "BC7 alpha", PSNR( channel_error( img, 4, decoded, 3, 1 ), pixels, 255.0 ), 45.0 );
+	free( decoded );
+	free( blocks );
+
+	/*	BC6H of the gradient scaled to [0,8), and to [-4,4) for signed	*/
+	hdr = (float*)malloc( QUALITY_SIZE * QUALITY_SIZE * 3 * sizeof( float ) );
+	hdr_decoded = (float*)malloc( QUALITY_SIZE * QUALITY_SIZE * 3 * sizeof( float ) );
+	for( is_signed = 0; is_signed < 2; ++is_signed )
+	{
+		for( i = 0; i < QUALITY_SIZE * QUALITY_SIZE * 3; ++i )
+		{
+			hdr[i] = rgb[i] * (8.0f / 256.0f) - (is_signed ? 4.0f : 0.0f);
+		}
+		blocks = convert_image_to_BC6H( hdr, QUALITY_SIZE, QUALITY_SIZE, 3, is_signed, DXT_MODE_DEFAULT, &size );
+		ok = 1;
+		for( i = 0; i < size / 16; ++i )
+		{
+			const int bx = (i % (QUALITY_SIZE / 4)) * 4, by = (i / (QUALITY_SIZE / 4)) * 4;
+			float block[48];
+			int y;
+			ok &= decode_BC6H_block( blocks + i * 16, is_signed, block );
+			for( y = 0; y < 4; ++y )
+			{
+				memcpy( hdr_decoded + ((by + y) * QUALITY_SIZE + bx) * 3, block + y * 12, 12 * sizeof( float ) );
+			}
+		}
+		check( ok, "BC6H encoder wrote a mode other than 11" );
+		error = 0.0;
+		for( i = 0; i < QUALITY_SIZE * QUALITY_SIZE; ++i )
+		{
+			for( c = 0; c < 3; ++c )
+			{
+				const double e = hdr[i*3 + c] - hdr_decoded[i*3 + c];
+				error += e * e;
+			}
+		}
+		check_floor( is_signed ? "BC6H signed" : "BC6H unsigned", PSNR( error, 3 * pixels, 8.0 ), 36.0 );
+		free( blocks );
+	}
+	free( hdr_decoded );
+	free( hdr );
+	free( rgb );
+	free( img );
+}
+
+/********* direct DX10 loading *********/
+
+/*	the bytes of a full MIPmap chain of 4x4 blocks	*/
+static int chain_size( int width, int height, int levels, int block_bytes )
+{
+	int size = 0, level;
+	for( level = 0; level < levels; ++level )
+	{
+		const int w = (width >> level) > 0 ? width >> level : 1;
+		const int h = (height >> level) > 0 ? height >> level : 1;
+		size += ((w + 3) / 4) * ((h + 3) / 4) * block_bytes;
+	}
+	return size;
+}
+
+static void test_direct_load( void )
+{
+	const struct
+	{
+		unsigned int dxgi_format;
+		unsigned int gl_format;
+		int block_bytes;
+	}
+	formats[] =
+	{
+		{ DXGI_FORMAT_BC7_UNORM, 0x8E8C, 16 },
+		{ DXGI_FORMAT_BC6H_UF16, 0x8E8F, 16 },
+		{ DXGI_FORMAT_BC6H_SF16, 0x8E8E, 16 },
+		{ DXGI_FORMAT_BC4_UNORM, 0x8DBB, 8 },
+		{ DXGI_FORMAT_BC1_UNORM_SRGB, 0x8C4D, 8 }
+	};
+	/*	20x12 has 5 levels, down to 1x1	*/
+	const int width = 20, height = 12, levels = 5;
+	int f, i, level;
+	char what[96];
+	for( f = 0; f < (int)(sizeof( formats ) / sizeof( formats[0] )); ++f )
+	{
+		const int size = chain_size( width, height, levels, formats[f].block_bytes );
+		unsigned char *blocks = (unsigned char*)malloc( size );
+		unsigned char *dds;
+		unsigned int tex_ID;
+		int dds_size, offset = 0, ok;
+		for( i = 0; i < size; ++i )
+		{
+			blocks[i] = (unsigned char)(i * 7 + f);
+		}
+		dds = make_DX10_DDS( width, height, levels, formats[f].dxgi_format, blocks, size, &dds_size );
+		gl_stub_reset();
+		tex_ID = SOIL_direct_load_DDS_from_memory( dds, dds_size, 0, 0, 0 );
+		snprintf( what, sizeof( what ), "DX10 DXGI format %u did not load: %s", formats[f].dxgi_format, SOIL_last_result() );
+		check( 0 != tex_ID, what );
+		ok = (levels == gl_stub_upload_count);
+		for( level = 0; ok && (level < levels); ++level )
+		{
+			const gl_stub_upload *upload = &gl_stub_uploads[level];
+			const int w = (width >> level) > 0 ? width >> level : 1;
+			const int h = (height >> level) > 0 ? height >> level : 1;
+			const int level_size = ((w + 3) / 4) * ((h + 3) / 4) * formats[f].block_bytes;
+			ok = upload->compressed && (upload->format == formats[f].gl_format) && (upload->level == level) &&
+				(upload->width == w) && (upload->height == h) && (upload->size == level_size) &&
+				(upload->checksum == gl_stub_checksum( blocks + offset, level_size ));
+			offset += level_size;
+		}
+		snprintf( what, sizeof( what ), "DX10 DXGI format %u uploaded the wrong levels", formats[f].dxgi_format );
+		check( ok, what );
+		check( GL_LINEAR_MIPMAP_LINEAR == gl_stub_min_filter, "DX10 MIPmaps not used for minification" );
+
+		/*	every truncation is turned down	*/
+		ok = 1;
+		for( i = 0; i < dds_size; ++i )
+		{
+			unsigned char *cut = (unsigned char*)malloc( i > 0 ? i : 1 );
+			memcpy( cut, dds, i );
+			ok &= (0 == SOIL_direct_load_DDS_from_memory( cut, i, 0, 0, 0 ));
+			free( cut );
+		}
+		snprintf( what, sizeof( what ), "truncated DX10 DXGI format %u loaded", formats[f].dxgi_format );
+		check( ok, what );
+		free( dds );
+		free( blocks );
+	}
+}
+
+/*	headers the direct loader has to turn down, or at least not read past	*/
+static void test_broken_headers( void )
+{
+	const int width = 16, height = 16;
+	const int size = chain_size( width, height, 1, 16 );
+	unsigned char *blocks = (unsigned char*)calloc( size, 1 );
+	unsigned char *dds;
+	DDS_header header;
+	DDS_header_DXT10 header10;
+	int dds_size, i;
+	const int header_size = sizeof( DDS_header );
+
+	/*	an array, a volume and a DXGI format with no blocks	*/
+	for( i = 0; i < 3; ++i )
+	{
+		dds = make_DX10_DDS( width, height, 1, DXGI_FORMAT_BC7_UNORM, blocks, size, &dds_size );
+		memcpy( &header10, dds + header_size, sizeof( header10 ) );
+		switch( i )
+		{
+		case 0:
+			header10.arraySize = 2;
+			break;
+		case 1:
+			header10.resourceDimension = 4;
+			break;
+		default:
+			header10.dxgiFormat = 2;
+			break;
+		}
+		memcpy( dds + header_size, &header10, sizeof( header10 ) );
+		gl_stub_reset();
+		check( 0 == SOIL_direct_load_DDS_from_memory( dds, dds_size, 0, 0, 0 ) && (0 == gl_stub_upload_count),
+			(0 == i) ? "DX10 texture array loaded" : ((1 == i) ? "DX10 volume loaded" : "DX10 unknown format loaded") );
+		free( dds );
+	}
+
+	/*	more MIPmaps than the size has, and far more	*/
+	for( i = 0; i < 2; ++i )
+	{
+		dds = make_DX10_DDS( width, height, 1, DXGI_FORMAT_BC7_UNORM, blocks, size, &dds_size );
+		memcpy( &header, dds, sizeof( header ) );
+		header.dwFlags |= DDSD_MIPMAPCOUNT;
+		header.sCaps.dwCaps1 |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+		header.dwMipMapCount = (0 == i) ? 40 : 0x7FFFFFFF;
+		memcpy( dds, &header, sizeof( header ) );
+		gl_stub_reset();
+		check( 0 == SOIL_direct_load_DDS_from_memory( dds, dds_size, 0, 0, 0 ),
+			"DX10 file without room for its MIPmaps loaded" );
+		free( dds );
+	}
+
+	/*	a cubemap asked for as a 2D texture, and a 2D one as a cubemap	*/
+	dds = make_DX10_DDS( width, height, 1, DXGI_FORMAT_BC7_UNORM, blocks, size, &dds_size );
+	check( 0 == SOIL_direct_load_DDS_from_memory( dds, dds_size, 0, 0, 1 ), "DX10 2D texture loaded as a cubemap" );
+	memcpy( &header10, dds + header_size, sizeof( header10 ) );
+	header10.miscFlag = DDS_RESOURCE_MISC_TEXTURECUBE;
+	memcpy( dds + header_size, &header10, sizeof( header10 ) );
+	check( 0 == SOIL_direct_load_DDS_from_memory( dds, dds_size, 0, 0, 0 ), "DX10 cubemap loaded as a 2D texture" );
+	/*	and with one face where six are due	*/
+	check( 0 == SOIL_direct_load_DDS_from_memory( dds, dds_size, 0, 0, 1 ), "DX10 cubemap with one face loaded" );
+	free( dds );
+	free( blocks );
+}
+
+int main( void )
+{
+	printf( "SIMD level %d\n", soil_simd_level() );
+	test_SIMD_matches_C();
+	test_quality();
+	test_direct_load();
+	test_broken_headers();
+	printf( "%d of %d DXT and DDS tests passed\n", tests - failures, tests );
+	return (0 == failures) ? 0 : 1;
+}
@@ -0,0 +1,245 @@
+/*
+	The ETC1 encoder gives the same blocks whichever way it runs.
+	etc1_encode_image_quality goes over random sizes, RGB and 565
+	pixels, both qualities, noise and flat colors, once with
+	SOIL_set_SIMD_enabled( 0 ) and once with the SSE2 encoder, and
+	compares the whole output including a guard byte past it.
+	Then a large image is encoded on one thread and again over a
+	pool of threads given to SOIL_set_parallel_for, which hands out
+	the rows of blocks last first, and the two have to match.
+	Last, thorough mode has to give the very blocks etc1_encode_image
+	gave before it had a fast mode, SSE2 or threads: the checksums
+	below come from the scalar encoder SOIL2 shipped with.
+	Exits non-zero on any mismatch.  Run with "make test".
+*/
+
+#include "../src/SOIL2/SOIL2.h"
+#include "../src/SOIL2/etc1_utils.h"
+#include "../src/SOIL2/simd_helper.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ITERATIONS 400
+#define THREADS 4
+
+static int tests = 0, failures = 0;
+
+/*	encodes into a fresh buffer with a guard byte after the blocks	*/
+static unsigned char *encode( const unsigned char *img, int width, int height, int pixel_size,
+		int quality, int *size )
+{
+	unsigned char *out;
+	*size = etc1_get_encoded_data_size( width, height ) + 1;
+	out = (unsigned char*)malloc( *size );
+	memset( out, 7, *size );
+	etc1_encode_image_quality( img, width, height, pixel_size, width * pixel_size, out, quality );
+	return out;
+}
+
+static void test_SIMD_matches_C( void )
+{
+	int it, quality, i;
+	srand( 1 );
+	for( it = 0; it < ITERATIONS; ++it )
+	{
+		const int width = 1 + rand() % 60;
+		const int height = 1 + rand() % 40;
+		const int pixel_size = (0 == it % 3) ? 2 : 3;
+		unsigned char *img = (unsigned char*)malloc( width * height * pixel_size );
+		/*	odd iterations get noise, even ones a few flat colors	*/
+		for( i = 0; i < width * height * pixel_size; ++i )
+		{
+			img[i] = (it & 1) ? (unsigned char)rand() : (unsigned char)((rand() & 3) * 85);
+		}
+		for( quality = ETC1_QUALITY_THOROUGH; quality <= ETC1_QUALITY_FAST; ++quality )
+		{
+			int plain_size, simd_size;
+			unsigned char *plain, *simd;
+			SOIL_set_SIMD_enabled( 0 );
+			plain = encode( img, width, height, pixel_size, quality, &plain_size );
+			SOIL_set_SIMD_enabled( 1 );
+			simd = encode( img, width, height, pixel_size, quality, &simd_size );
+			++tests;
+			if( 0 != memcmp( plain, simd, plain_size ) )
+			{
+				++failures;
+				printf( "FAIL ETC1 %s %dx%d %s, SIMD blocks differ from C\n",
+					(ETC1_QUALITY_FAST == quality) ? "fast" : "thorough", width, height,
+					(2 == pixel_size) ? "565" : "RGB" );
+			}
+			free( simd );
+			free( plain );
+		}
+		free( img );
+	}
+}
+
+/*	a small pool: each thread takes the next range, counting down from the last	*/
+typedef struct
+{
+	SOIL_parallel_task task;
+	void *context;
+	int grain;
+	int next_end;
+	pthread_mutex_t lock;
+} pool_job;
+
+static void *pool_worker( void *argument )
+{
+	pool_job *job = (pool_job*)argument;
+	for( ;; )
+	{
+		int begin, end;
+		pthread_mutex_lock( &job->lock );
+		end = job->next_end;
+		begin = (end > job->grain) ? end - job->grain : 0;
+		job->next_end = begin;
+		pthread_mutex_unlock( &job->lock );
+		if( end <= 0 )
+		{
+			return NULL;
+		}
+		job->task( job->context, begin, end );
+	}
+}
+
+static void pool_parallel_for( SOIL_parallel_task task, void *context, int count, int grain, void *user_data )
+{
+	pthread_t threads[THREADS];
+	pool_job job;
+	int i;
+	(void)user_data;
+	job.task = task;
+	job.context = context;
+	job.grain = grain;
+	job.next_end = count;
+	pthread_mutex_init( &job.lock, NULL );
+	for( i = 0; i < THREADS; ++i )
+	{
+		pthread_create( &threads[i], NULL, pool_worker, &job );
+	}
+	for( i = 0; i < THREADS; ++i )
+	{
+		pthread_join( threads[i], NULL );
+	}
+	pthread_mutex_destroy( &job.lock );
+}
+
+static void test_parallel_matches_serial( void )
+{
+	/*	an odd size, so the last row and column of blocks are partial	*/
+	const int width = 301, height = 203;
+	unsigned char *img = (unsigned char*)malloc( width * height * 3 );
+	int quality, simd, i;
+	srand( 2 );
+	for( i = 0; i < width * height * 3; ++i )
+	{
+		img[i] = (unsigned char)(((i / 3) % width + rand() % 32) & 255);
+	}
+	for( simd = 0; simd <= 1; ++simd )
+	{
+		SOIL_set_SIMD_enabled( simd );
+		for( quality = ETC1_QUALITY_THOROUGH; quality <= ETC1_QUALITY_FAST; ++quality )
+		{
+			int serial_size, parallel_size;
+			unsigned char *serial, *parallel;
+			SOIL_set_parallel_for( NULL, NULL );
+			serial = encode( img, width, height, 3, quality, &serial_size );
+			SOIL_set_parallel_for( pool_parallel_for, NULL );
+			parallel = encode( img, width, height, 3, quality, &parallel_size );
+			SOIL_set_parallel_for( NULL, NULL );
+			++tests;
+			if( 0 != memcmp( serial, parallel, serial_size ) )
+			{
+				++failures;
+				printf( "FAIL ETC1 %s %s, %d threads differ from one\n",
+					(ETC1_QUALITY_FAST == quality) ? "fast" : "thorough", simd ? "SIMD" : "C", THREADS );
+			}
+			free( parallel );
+			free( serial );
+		}
+	}
+	SOIL_set_SIMD_enabled( 1 );
+	free( img );
+}
+
+/*	a repeatable generator, so the known checksums don't hang on the C library's rand	*/
+static unsigned int seed;
+
+static int next_random( void )
+{
+	seed = seed * 1103515245u + 12345u;
+	return (int)((seed >> 16) & 0x7FFF);
+}
+
+static unsigned int checksum( const unsigned char *data, int size )
+{
+	unsigned int sum = 0;
+	int i;
+	for( i = 0; i < size; ++i )
+	{
+		sum = sum * 31 + data[i];
+	}
+	return sum;
+}
+
+static void test_thorough_matches_original( void )
+{
+	/*	width, height, pixel size and the checksum of the original encoder's blocks	*/
+	static const struct { int width, height, pixel_size; unsigned int checksum; } known[] =
+	{
+		{ 4, 4, 3, 39850604u },
+		{ 17, 9, 3, 2661956719u },
+		{ 64, 48, 3, 249892020u },
+		{ 33, 31, 2, 1707419933u },
+		{ 301, 203, 3, 1727618287u },
+	};
+	int k, simd, threads, i;
+	for( k = 0; k < (int)(sizeof( known ) / sizeof( known[0] )); ++k )
+	{
+		const int width = known[k].width, height = known[k].height, pixel_size = known[k].pixel_size;
+		unsigned char *img = (unsigned char*)malloc( width * height * pixel_size );
+		/*	a slope in every channel with some noise over it	*/
+		seed = k + 1;
+		for( i = 0; i < width * height * pixel_size; ++i )
+		{
+			const int x = (i / pixel_size) % width, y = (i / pixel_size) / width;
+			img[i] = (unsigned char)((x * 7 + y * 3 + (i % pixel_size) * 60 + next_random() % 24) & 255);
+		}
+		for( simd = 0; simd <= 1; ++simd )
+		{
+			for( threads = 0; threads <= 1; ++threads )
+			{
+				int size;
+				unsigned char *out;
+				SOIL_set_SIMD_enabled( simd );
+				SOIL_set_parallel_for( threads ? pool_parallel_for : NULL, NULL );
+				out = encode( img, width, height, pixel_size, ETC1_QUALITY_THOROUGH, &size );
+				++tests;
+				if( checksum( out, size - 1 ) != known[k].checksum )
+				{
+					++failures;
+					printf( "FAIL ETC1 thorough %dx%d %s %s%s, blocks differ from the original encoder\n",
+						width, height, (2 == pixel_size) ? "565" : "RGB", simd ? "SIMD" : "C",
+						threads ? " threaded" : "" );
+				}
+				free( out );
+			}
+		}
+		free( img );
+	}
+	SOIL_set_parallel_for( NULL, NULL );
+	SOIL_set_SIMD_enabled( 1 );
+}
+
+int main( void )
+{
+	printf( "SIMD level %d\n", soil_simd_level() );
+	test_SIMD_matches_C();
+	test_parallel_matches_serial();
+	test_thorough_matches_original();
+	printf( "%d of %d ETC1 tests matched\n", tests - failures, tests );
+	return (0 == failures) ? 0 : 1;
+}
@@ -0,0 +1,683 @@
+/*
+	The ETC2 and EAC encoders and decoders.
+
+	- etc2_decode_image gives the same pixels as the small decoder
+	  below, written from the Khronos format spec, for random blocks
+	  of every format, which take in every ETC2 mode: individual,
+	  differential, T, H and planar.
+	- Blocks made to need the T, H and planar modes come out of the
+	  thorough encoder in those modes, and close to the source; fast
+	  mode only tries planar.
+	- Decoded again, each format keeps a PSNR floor on a smooth noisy
+	  gradient, in both qualities, and thorough is never worse.
+	- Without ES3 in the GL stub, KTX files of every ETC2 and EAC
+	  format are decoded on the CPU and uploaded as 8 bit pixels,
+	  sRGB and signed kept, and truncated ones are turned down.
+	Exits non-zero on any failure.  Run with "make test".
+*/
+
+#include "../src/SOIL2/SOIL2.h"
+#include "../src/SOIL2/etc1_utils.h"
+#include "../src/SOIL2/etc2_utils.h"
+#include "gl_stub.h"
+#include <GL/gl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ITERATIONS 200
+
+static int tests = 0, failures = 0;
+
+static void check( int ok, const char *what )
+{
+	++tests;
+	if( !ok )
+	{
+		++failures;
+		printf( "FAIL %s\n", what );
+	}
+}
+
+/*	a smooth RGBA gradient with a little noise, as in the DXT test	*/
+static unsigned char *gradient_image( int width, int height )
+{
+	unsigned char *img = (unsigned char*)malloc( width * height * 4 );
+	int x, y;
+	srand( 1 );
+	for( y = 0; y < height; ++y )
+	{
+		for( x = 0; x < width; ++x )
+		{
+			unsigned char *pixel = img + (y * width + x) * 4;
+			pixel[0] = (unsigned char)(x * 255 / width);
+			pixel[1] = (unsigned char)(y * 255 / height);
+			pixel[2] = (unsigned char)(((x + y) * 255 / (width + height) + (rand() & 7)) & 255);
+			pixel[3] = (unsigned char)(128 + 127 * sin( x * 0.05 ) * cos( y * 0.03 ));
+		}
+	}
+	return img;
+}
+
+static double PSNR( double squared_error, double samples, double peak )
+{
+	if( squared_error <= 0.0 )
+	{
+		return 99.0;
+	}
+	return 10.0 * log10( peak * peak * samples / squared_error );
+}
+
+/********* a decoder from the spec *********/
+
+enum
+{
+	MODE_INDIVIDUAL,
+	MODE_DIFFERENTIAL,
+	MODE_T,
+	MODE_H,
+	MODE_PLANAR,
+	MODES
+};
+
+static const char *const mode_names[MODES] = { "individual", "differential", "T", "H", "planar" };
+
+/*	count bits of the big endian 64 bit block, from bit top down	*/
+static int field( const unsigned char block[8], int top, int count )
+{
+	int v = 0, i;
+	for( i = top; i > top - count; --i )
+	{
+		v = (v << 1) | ((block[7 - i / 8] >> (i % 8)) & 1);
+	}
+	return v;
+}
+
+static int extend( int v, int bits )
+{
+	return (v << (8 - bits)) | (v >> (2 * bits - 8));
+}
+
+static int clamp255( int v )
+{
+	return (v < 0) ? 0 : ((v > 255) ? 255 : v);
+}
+
+/*	the 2 bit index of pixel (x,y), the indices run down the columns	*/
+static int pixel_index( const unsigned char block[8], int x, int y )
+{
+	const int k = x * 4 + y;
+	return field( block, 16 + k, 1 ) * 2 + field( block, k, 1 );
+}
+
+/*	decodes an ETC2 RGB block to 16 RGB pixels in rows, returns its mode	*/
+static int decode_RGB_block( const unsigned char block[8], unsigned char rgb[48] )
+{
+	static const int ETC1_modifiers[8][2] =
+	{
+		{ 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+	};
+	static const int distances[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+	int base[2][3], paint[4][3], delta[3];
+	int mode, x, y, c, i;
+	if( 0 == field( block, 33, 1 ) )
+	{
+		mode = MODE_INDIVIDUAL;
+		for( c = 0; c < 3; ++c )
+		{
+			base[0][c] = extend( field( block, 63 - c * 8, 4 ), 4 );
+			base[1][c] = extend( field( block, 59 - c * 8, 4 ), 4 );
+		}
+	} else
+	{
+		mode = MODE_DIFFERENTIAL;
+		for( c = 0; c < 3; ++c )
+		{
+			delta[c] = ((field( block, 58 - c * 8, 3 ) ^ 4) - 4);
+			base[0][c] = field( block, 63 - c * 8, 5 );
+			base[1][c] = base[0][c] + delta[c];
+			if( (MODE_DIFFERENTIAL == mode) && ((base[1][c] < 0) || (base[1][c] > 31)) )
+			{
+				/*	the first channel to overflow picks the mode	*/
+				mode = MODE_T + c;
+			}
+			base[0][c] = extend( base[0][c], 5 );
+			base[1][c] = extend( base[1][c] & 31, 5 );
+		}
+	}
+	if( mode <= MODE_DIFFERENTIAL )
+	{
+		const int flip = field( block, 32, 1 );
+		for( y = 0; y < 4; ++y )
+		{
+			for( x = 0; x < 4; ++x )
+			{
+				const int sub = flip ? (y >= 2) : (x >= 2);
+				const int *pair = ETC1_modifiers[field( block, sub ? 36 : 39, 3 )];
+				const int index = pixel_index( block, x, y );
+				const int modifier = (index & 2) ? -pair[index & 1] : pair[index & 1];
+				for( c = 0; c < 3; ++c )
+				{
+					rgb[(y * 4 + x) * 3 + c] = (unsigned char)clamp255( base[sub][c] + modifier );
+				}
+			}
+		}
+		return mode;
+	}
+	if( MODE_PLANAR == mode )
+	{
+		int o[3], h[3], v[3];
+		o[0] = extend( field( block, 62, 6 ), 6 );
+		o[1] = extend( (field( block, 56, 1 ) << 6) | field( block, 54, 6 ), 7 );
+		o[2] = extend( (field( block, 48, 1 ) << 5) | (field( block, 44, 2 ) << 3) | field( block, 41, 3 ), 6 );
+		h[0] = extend( (field( block, 38, 5 ) << 1) | field( block, 32, 1 ), 6 );
+		h[1] = extend( field( block, 31, 7 ), 7 );
+		h[2] = extend( field( block, 24, 6 ), 6 );
+		v[0] = extend( field( block, 18, 6 ), 6 );
+		v[1] = extend( field( block, 12, 7 ), 7 );
+		v[2] = extend( field( block, 5, 6 ), 6 );
+		for( y = 0; y < 4; ++y )
+		{
+			for( x = 0; x < 4; ++x )
+			{
+				for( c = 0; c < 3; ++c )
+				{
+					const int value = x * (h[c] - o[c]) + y * (v[c] - o[c]) + 4 * o[c] + 2;
+					rgb[(y * 4 + x) * 3 + c] = (unsigned char)clamp255( (value < 0) ? 0 : value >> 2 );
+				}
+			}
+		}
+		return mode;
+	}
+	if( MODE_T == mode )
+	{
+		const int d = distances[(field( block, 35, 2 ) << 1) | field( block, 32, 1 )];
+		base[0][0] = (field( block, 60, 2 ) << 2) | field( block, 57, 2 );
+		base[0][1] = field( block, 55, 4 );
+		base[0][2] = field( block, 51, 4 );
+		base[1][0] = field( block, 47, 4 );
+		base[1][1] = field( block, 43, 4 );
+		base[1][2] = field( block, 39, 4 );
+		for( c = 0; c < 3; ++c )
+		{
+			paint[0][c] = extend( base[0][c], 4 );
+			paint[2][c] = extend( base[1][c], 4 );
+			paint[1][c] = clamp255( paint[2][c] + d );
+			paint[3][c] = clamp255( paint[2][c] - d );
+		}
+	} else
+	{
+		int d;
+		base[0][0] = field( block, 62, 4 );
+		base[0][1] = (field( block, 58, 3 ) << 1) | field( block, 52, 1 );
+		base[0][2] = (field( block, 51, 1 ) << 3) | field( block, 49, 3 );
+		base[1][0] = field( block, 46, 4 );
+		base[1][1] = field( block, 42, 4 );
+		base[1][2] = field( block, 38, 4 );
+		d = distances[(field( block, 34, 1 ) << 2) | (field( block, 32, 1 ) << 1) |
+			(((base[0][0] << 8) | (base[0][1] << 4) | base[0][2]) >=
+			 ((base[1][0] << 8) | (base[1][1] << 4) | base[1][2]))];
+		for( i = 0; i < 2; ++i )
+		{
+			for( c = 0; c < 3; ++c )
+			{
+				paint[i * 2][c] = clamp255( extend( base[i][c], 4 ) + d );
+				paint[i * 2 + 1][c] = clamp255( extend( base[i][c], 4 ) - d );
+			}
+		}
+	}
+	for( y = 0; y < 4; ++y )
+	{
+		for( x = 0; x < 4; ++x )
+		{
+			const int *color = paint[pixel_index( block, x, y )];
+			for( c = 0; c < 3; ++c )
+			{
+				rgb[(y * 4 + x) * 3 + c] = (unsigned char)color[c];
+			}
+		}
+	}
+	return mode;
+}
+
+/*	decodes an EAC block to 16 values in rows: 8 bit for the alpha of
+	RGBA8, else 11 bit, 0..2047 or signed -1023..1023	*/
+static void decode_EAC_block( const unsigned char block[8], int is_11_bit, int is_signed, int values[16] )
+{
+	static const int modifiers[16][8] =
+	{
+		{ -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 },
+		{ -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+		{ -3, -6, -8, -12, 2, 5, 7, 11 }, { -3, -7, -9, -11, 2, 6, 8, 10 },
+		{ -4, -7, -8, -11, 3, 6, 7, 10 }, { -3, -5, -8, -11, 2, 4, 7, 10 },
+		{ -2, -6, -8, -10, 1, 5, 7, 9 }, { -2, -5, -8, -10, 1, 4, 7, 9 },
+		{ -2, -4, -8, -10, 1, 3, 7, 9 }, { -2, -5, -7, -10, 1, 4, 6, 9 },
+		{ -3, -4, -7, -10, 2, 3, 6, 9 }, { -1, -2, -3, -10, 0, 1, 2, 9 },
+		{ -4, -6, -8, -9, 3, 5, 7, 8 }, { -3, -5, -7, -9, 2, 4, 6, 8 }
+	};
+	const int multiplier = block[1] >> 4;
+	int i;
+	for( i = 0; i < 16; ++i )
+	{
+		const int modifier = modifiers[block[1] & 15][field( block, 47 - 3 * i, 3 )];
+		int value;
+		if( !is_11_bit )
+		{
+			value = clamp255( block[0] + modifier * multiplier );
+		} else if( is_signed )
+		{
+			const int base = ((signed char)block[0] == -128) ? -127 : (signed char)block[0];
+			value = base * 8 + ((multiplier > 0) ? modifier * multiplier * 8 : modifier);
+			value = (value < -1023) ? -1023 : ((value > 1023) ? 1023 : value);
+		} else
+		{
+			value = block[0] * 8 + 4 + ((multiplier > 0) ? modifier * multiplier * 8 : modifier);
+			value = (value < 0) ? 0 : ((value > 2047) ? 2047 : value);
+		}
+		/*	the indices run down the columns	*/
+		values[(i & 3) * 4 + (i >> 2)] = value;
+	}
+}
+
+/*	an 11 bit value rounded to 8 bits, as etc2_decode_image writes them	*/
+static int EAC_8_bits( int value, int is_signed, int keep_sign )
+{
+	if( !is_signed )
+	{
+		return (value * 255 + 1023) / 2047;
+	}
+	if( !keep_sign )
+	{
+		return ((value + 1023) * 255 + 1023) / 2046;
+	}
+	return (unsigned char)(signed char)((value * 127 + ((value < 0) ? -511 : 511)) / 1023);
+}
+
+/*	decodes a whole image of any of the formats the way etc2_decode_image lays it out	*/
+static void decode_image( const unsigned char *blocks, unsigned int format, int width, int height,
+		int keep_sign, unsigned char *out, int mode_counts[MODES] )
+{
+	const int channels = etc2_decoded_channels( format );
+	const int block_size = etc2_block_size( format );
+	const int is_signed = (ETC2_COMPRESSED_SIGNED_R11_EAC == format) || (ETC2_COMPRESSED_SIGNED_RG11_EAC == format);
+	const int blocks_x = (width + 3) / 4;
+	int bx, by, x, y, c;
+	for( by = 0; by < (height + 3) / 4; ++by )
+	{
+		for( bx = 0; bx < blocks_x; ++bx )
+		{
+			const unsigned char *block = blocks + (by * blocks_x + bx) * block_size;
+			unsigned char pixels[16 * 4];
+			int values[16];
+			if( channels >= 3 )
+			{
+				unsigned char rgb[48];
+				const int mode = decode_RGB_block( block + block_size - 8, rgb );
+				if( NULL != mode_counts )
+				{
+					++mode_counts[mode];
+				}
+				for( x = 0; x < 16; ++x )
+				{
+					memcpy( pixels + x * 4, rgb + x * 3, 3 );
+				}
+				if( 4 == channels )
+				{
+					decode_EAC_block( block, 0, 0, values );
+					for( x = 0; x < 16; ++x )
+					{
+						pixels[x * 4 + 3] = (unsigned char)values[x];
+					}
+				}
+			} else
+			{
+				for( c = 0; c < channels; ++c )
+				{
+					decode_EAC_block( block + c * 8, 1, is_signed, values );
+					for( x = 0; x < 16; ++x )
+					{
+						pixels[x * 4 + c] = (unsigned char)EAC_8_bits( values[x], is_signed, keep_sign );
+					}
+				}
+			}
+			for( y = 0; y < 4; ++y )
+			{
+				for( x = 0; x < 4; ++x )
+				{
+					if( (bx * 4 + x < width) && (by * 4 + y < height) )
+					{
+						memcpy( out + ((by * 4 + y) * width + bx * 4 + x) * channels,
+							pixels + (y * 4 + x) * 4, channels );
+					}
+				}
+			}
+		}
+	}
+}
+
+/********* SOIL's decoder against the spec *********/
+
+static const unsigned int all_formats[] =
+{
+	ETC2_COMPRESSED_RGB8_ETC2, ETC2_COMPRESSED_SRGB8_ETC2,
+	ETC2_COMPRESSED_RGBA8_ETC2_EAC, ETC2_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC,
+	ETC2_COMPRESSED_R11_EAC, ETC2_COMPRESSED_SIGNED_R11_EAC,
+	ETC2_COMPRESSED_RG11_EAC, ETC2_COMPRESSED_SIGNED_RG11_EAC
+};
+#define FORMAT_COUNT ((int)(sizeof( all_formats ) / sizeof( all_formats[0] )))
+
+static void test_decoder( void )
+{
+	int mode_counts[MODES];
+	int f, it, keep_sign, i;
+	char what[96];
+	memset( mode_counts, 0, sizeof( mode_counts ) );
+	srand( 2 );
+	for( f = 0; f < FORMAT_COUNT; ++f )
+	{
+		const unsigned int format = all_formats[f];
+		for( it = 0; it < ITERATIONS; ++it )
+		{
+			const int width = 1 + rand() % 13, height = 1 + rand() % 13;
+			const int size = etc2_get_encoded_data_size( format, width, height );
+			const int image_size = width * height * etc2_decoded_channels( format );
+			unsigned char *blocks = (unsigned char*)malloc( size );
+			unsigned char *expected = (unsigned char*)malloc( image_size );
+			unsigned char *decoded = (unsigned char*)malloc( image_size + 1 );
+			for( i = 0; i < size; ++i )
+			{
+				blocks[i] = (unsigned char)rand();
+			}
+			for( keep_sign = 0; keep_sign <= 1; ++keep_sign )
+			{
+				int ok;
+				decode_image( blocks, format, width, height, keep_sign, expected, keep_sign ? NULL : mode_counts );
+				decoded[image_size] = 0x5A;
+				ok = keep_sign ? etc2_decode_image_signed( blocks, format, width, height, decoded ) :
+						etc2_decode_image( blocks, format, width, height, decoded );
+				snprintf( what, sizeof( what ), "format 0x%04X %dx%d%s decodes differently from the spec",
+					format, width, height, keep_sign ? " signed" : "" );
+				check( ok && (0 == memcmp( expected, decoded, image_size )) && (0x5A == decoded[image_size]), what );
+			}
+			free( decoded );
+			free( expected );
+			free( blocks );
+		}
+	}
+	for( i = 0; i < MODES; ++i )
+	{
+		snprintf( what, sizeof( what ), "no random block was in %s mode", mode_names[i] );
+		check( mode_counts[i] > 0, what );
+	}
+}
+
+/********* the encoder's modes *********/
+
+/*	4 bit colors as they decode	*/
+#define C4( v ) ((v) * 17)
+
+/*	the mode a block of pixels is encoded in, and the largest error of any channel	*/
+static int encode_block( const unsigned char rgb[48], int quality, int *max_error )
+{
+	unsigned char *blocks, decoded[48];
+	int size, mode, i;
+	blocks = convert_image_to_ETC2( rgb, 4, 4, 3, ETC2_COMPRESSED_RGB8_ETC2, quality, &size );
+	mode = decode_RGB_block( blocks, decoded );
+	*max_error = 0;
+	for( i = 0; i < 48; ++i )
+	{
+		const int e = abs( (int)rgb[i] - decoded[i] );
+		*max_error = (e > *max_error) ? e : *max_error;
+	}
+	free( blocks );
+	return mode;
+}
+
+static void test_modes( void )
+{
+	/*	T: one color alone, and one with +-distance, spread over both halves
+		each way so ETC1 can't split them; H: two colors with +-distance	*/
+	static const int T_paint[4][3] =
+	{
+		{ C4( 15 ), C4( 1 ), C4( 2 ) }, { C4( 5 ) + 41, C4( 9 ) + 41, C4( 12 ) + 41 },
+		{ C4( 5 ), C4( 9 ), C4( 12 ) }, { C4( 5 ) - 41, C4( 9 ) - 41, C4( 12 ) - 41 }
+	};
+	static const int H_paint[4][3] =
+	{
+		{ C4( 13 ) + 32, C4( 2 ) + 32, C4( 3 ) + 32 }, { C4( 13 ) - 32, C4( 2 ) - 32, C4( 3 ) - 32 },
+		{ C4( 2 ) + 32, C4( 4 ) + 32, C4( 12 ) + 32 }, { C4( 2 ) - 32, C4( 4 ) - 32, C4( 12 ) - 32 }
+	};
+	static const int layout[16] = { 0, 1, 2, 3, 2, 3, 0, 1, 3, 0, 1, 2, 1, 2, 3, 0 };
+	unsigned char T_block[48], H_block[48], planar_block[48];
+	int i, c, mode, fast_mode, error, fast_error;
+	char what[96];
+	for( i = 0; i < 16; ++i )
+	{
+		const int x = i % 4, y = i / 4;
+		for( c = 0; c < 3; ++c )
+		{
+			T_block[i * 3 + c] = (unsigned char)T_paint[layout[i]][c];
+			H_block[i * 3 + c] = (unsigned char)H_paint[layout[i]][c];
+		}
+		/*	three slopes that cross the whole range	*/
+		planar_block[i * 3 + 0] = (unsigned char)(20 + x * 40);
+		planar_block[i * 3 + 1] = (unsigned char)(230 - y * 50);
+		planar_block[i * 3 + 2] = (unsigned char)(40 + x * 20 + y * 25);
+	}
+
+	mode = encode_block( planar_block, ETC1_QUALITY_THOROUGH, &error );
+	fast_mode = encode_block( planar_block, ETC1_QUALITY_FAST, &fast_error );
+	printf( "planar block: thorough %s max error %d, fast %s max error %d\n",
+		mode_names[mode], error, mode_names[fast_mode], fast_error );
+	check( (MODE_PLANAR == mode) && (MODE_PLANAR == fast_mode), "the planar block was not encoded in planar mode" );
+	check( (error <= 4) && (fast_error <= 4), "the planar block was encoded too far off" );
+
+	mode = encode_block( T_block, ETC1_QUALITY_THOROUGH, &error );
+	fast_mode = encode_block( T_block, ETC1_QUALITY_FAST, &fast_error );
+	printf( "T block: thorough %s max error %d, fast %s max error %d\n",
+		mode_names[mode], error, mode_names[fast_mode], fast_error );
+	snprintf( what, sizeof( what ), "the T block was encoded in %s mode", mode_names[mode] );
+	check( MODE_T == mode, what );
+	check( (error <= 8) && (error < fast_error), "the T block was encoded too far off" );
+
+	mode = encode_block( H_block, ETC1_QUALITY_THOROUGH, &error );
+	fast_mode = encode_block( H_block, ETC1_QUALITY_FAST, &fast_error );
+	printf( "H block: thorough %s max error %d, fast %s max error %d\n",
+		mode_names[mode], error, mode_names[fast_mode], fast_error );
+	snprintf( what, sizeof( what ), "the H block was encoded in %s mode", mode_names[mode] );
+	check( MODE_H == mode, what );
+	check( (error <= 8) && (error < fast_error), "the H block was encoded too far off" );
+}
+
+/********* PSNR floors *********/
+
+#define QUALITY_SIZE 64
+
+/*	the squared error of the decoded blocks, over RGB (and alpha) in 8 bits,
+	or for R11 and RG11 in 11 bits against the source as the encoder widens it	*/
+static double image_error( const unsigned char *img, const unsigned char *blocks, unsigned int format,
+		unsigned char *decoded )
+{
+	const int channels = etc2_decoded_channels( format );
+	double error = 0.0;
+	int i, c;
+	if( channels >= 3 )
+	{
+		decode_image( blocks, format, QUALITY_SIZE, QUALITY_SIZE, 0, decoded, NULL );
+		for( i = 0; i < QUALITY_SIZE * QUALITY_SIZE; ++i )
+		{
+			for( c = 0; c < channels; ++c )
+			{
+				const double e = (double)img[i * 4 + c] - decoded[i * channels + c];
+				error += e * e;
+			}
+		}
+		return error;
+	}
+	for( i = 0; i < (QUALITY_SIZE / 4) * (QUALITY_SIZE / 4); ++i )
+	{
+		const int bx = (i % (QUALITY_SIZE / 4)) * 4, by = (i / (QUALITY_SIZE / 4)) * 4;
+		int values[16], k;
+		for( c = 0; c < channels; ++c )
+		{
+			decode_EAC_block( blocks + (i * channels + c) * 8, 1, 0, values );
+			for( k = 0; k < 16; ++k )
+			{
+				const int source = img[((by + k / 4) * QUALITY_SIZE + bx + k % 4) * 4 + c];
+				const double e = (double)((source * 2047 + 127) / 255) - values[k];
+				error += e * e;
+			}
+		}
+	}
+	return error;
+}
+
+static void test_quality( void )
+{
+	/*	dB for thorough and fast	*/
+	static const struct { unsigned int format; const char *name; double floor_dB[2]; } floors[] =
+	{
+		{ ETC2_COMPRESSED_RGB8_ETC2, "RGB8", { 43.0, 38.5 } },
+		{ ETC2_COMPRESSED_RGBA8_ETC2_EAC, "RGBA8", { 44.0, 39.5 } },
+		{ ETC2_COMPRESSED_R11_EAC, "R11", { 51.0, 51.0 } },
+		{ ETC2_COMPRESSED_RG11_EAC, "RG11", { 51.0, 51.0 } }
+	};
+	const int pixels = QUALITY_SIZE * QUALITY_SIZE;
+	unsigned char *img = gradient_image( QUALITY_SIZE, QUALITY_SIZE );
+	unsigned char *decoded = (unsigned char*)malloc( pixels * 4 );
+	int f, quality, size;
+	char what[96];
+	for( f = 0; f < (int)(sizeof( floors ) / sizeof( floors[0] )); ++f )
+	{
+		const int channels = etc2_decoded_channels( floors[f].format );
+		double error[2];
+		for( quality = ETC1_QUALITY_THOROUGH; quality <= ETC1_QUALITY_FAST; ++quality )
+		{
+			const char *quality_name = (ETC1_QUALITY_FAST == quality) ? "fast" : "thorough";
+			unsigned char *blocks = convert_image_to_ETC2( img, QUALITY_SIZE, QUALITY_SIZE, 4,
+					floors[f].format, quality, &size );
+			double psnr;
+			error[quality] = image_error( img, blocks, floors[f].format, decoded );
+			psnr = PSNR( error[quality], (double)channels * pixels, (channels >= 3) ? 255.0 : 2047.0 );
+			printf( "%-6s %-8s PSNR %6.2f dB (floor %.1f)\n", floors[f].name, quality_name,
+				psnr, floors[f].floor_dB[quality] );
+			snprintf( what, sizeof( what ), "%s %s PSNR %.2f dB is below %.1f dB", floors[f].name,
+				quality_name, psnr, floors[f].floor_dB[quality] );
+			check( psnr >= floors[f].floor_dB[quality], what );
+			free( blocks );
+		}
+		snprintf( what, sizeof( what ), "%s thorough has more error than fast", floors[f].name );
+		check( error[ETC1_QUALITY_THOROUGH] <= error[ETC1_QUALITY_FAST], what );
+	}
+	free( decoded );
+	free( img );
+}
+
+/********* KTX files decoded on the CPU *********/
+
+/*	a KTX 1.1 file of the levels, each as convert_image_to_ETC2 makes them	*/
+static unsigned char *make_KTX( unsigned int format, int width, int height, int levels, int *out_size )
+{
+	static const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+	const unsigned int encoded_format = (ETC2_COMPRESSED_SIGNED_R11_EAC == format) ? ETC2_COMPRESSED_R11_EAC :
+			((ETC2_COMPRESSED_SIGNED_RG11_EAC == format) ? ETC2_COMPRESSED_RG11_EAC : format);
+	unsigned int header[13];
+	unsigned char *ktx;
+	int size = 12 + sizeof( header ), level;
+	for( level = 0; level < levels; ++level )
+	{
+		const int w = (width >> level) > 0 ? width >> level : 1, h = (height >> level) > 0 ? height >> level : 1;
+		size += 4 + etc2_get_encoded_data_size( format, w, h );
+	}
+	memset( header, 0, sizeof( header ) );
+	header[0] = 0x04030201;
+	header[4] = format;
+	header[5] = (etc2_decoded_channels( format ) >= 3) ? GL_RGBA : ((1 == etc2_decoded_channels( format )) ? 0x1903 : 0x8227);
+	header[6] = width;
+	header[7] = height;
+	header[10] = 1;
+	header[11] = levels;
+	ktx = (unsigned char*)malloc( size );
+	memcpy( ktx, identifier, 12 );
+	memcpy( ktx + 12, header, sizeof( header ) );
+	*out_size = 12 + sizeof( header );
+	for( level = 0; level < levels; ++level )
+	{
+		const int w = (width >> level) > 0 ? width >> level : 1, h = (height >> level) > 0 ? height >> level : 1;
+		unsigned char *img = gradient_image( w, h );
+		unsigned int image_size;
+		int encoded_size;
+		unsigned char *blocks = convert_image_to_ETC2( img, w, h, 4, encoded_format, ETC1_QUALITY_FAST, &encoded_size );
+		/*	the signed formats get the unsigned blocks, any bytes are valid EAC	*/
+		image_size = encoded_size;
+		memcpy( ktx + *out_size, &image_size, 4 );
+		memcpy( ktx + *out_size + 4, blocks, encoded_size );
+		*out_size += 4 + encoded_size;
+		free( blocks );
+		free( img );
+	}
+	return ktx;
+}
+
+static void test_KTX_fallback( void )
+{
+	/*	the GL internal format each is uploaded as	*/
+	static const unsigned int uploaded_formats[FORMAT_COUNT] =
+	{
+		0x8051, 0x8C41, 0x8058, 0x8C43, 0x8229, 0x8F94, 0x822B, 0x8F95
+	};
+	const int width = 12, height = 8, levels = 4;
+	int f, level, ktx_size, cut, ok;
+	char what[128];
+	for( f = 0; f < FORMAT_COUNT; ++f )
+	{
+		const unsigned int format = all_formats[f];
+		unsigned char *ktx = make_KTX( format, width, height, levels, &ktx_size );
+		unsigned int tex_ID;
+		int offset = 12 + 13 * 4;
+		gl_stub_reset();
+		tex_ID = SOIL_direct_load_KTX_from_memory( ktx, ktx_size, 0, 0, 0 );
+		snprintf( what, sizeof( what ), "KTX of format 0x%04X did not load: %s", format, SOIL_last_result() );
+		check( (0 != tex_ID) && (levels == gl_stub_upload_count), what );
+		for( level = 0; (level < levels) && (level < gl_stub_upload_count); ++level )
+		{
+			const gl_stub_upload *upload = &gl_stub_uploads[level];
+			const int w = (width >> level) > 0 ? width >> level : 1, h = (height >> level) > 0 ? height >> level : 1;
+			const int image_size = w * h * etc2_decoded_channels( format );
+			unsigned char *decoded = (unsigned char*)malloc( image_size );
+			etc2_decode_image_signed( ktx + offset + 4, format, w, h, decoded );
+			snprintf( what, sizeof( what ), "KTX of format 0x%04X level %d was not uploaded as its pixels", format, level );
+			check( !upload->compressed && (uploaded_formats[f] == upload->format) &&
+				(w == upload->width) && (h == upload->height) && (image_size == upload->size) &&
+				(gl_stub_checksum( decoded, image_size ) == upload->checksum), what );
+			offset += 4 + etc2_get_encoded_data_size( format, w, h );
+			free( decoded );
+		}
+		snprintf( what, sizeof( what ), "KTX of format 0x%04X is not MIPmapped", format );
+		check( GL_LINEAR_MIPMAP_LINEAR == gl_stub_min_filter, what );
+
+		/*	every truncation is turned down, on a copy just the size it says	*/
+		ok = 1;
+		for( cut = 0; cut < ktx_size; ++cut )
+		{
+			unsigned char *short_ktx = (unsigned char*)malloc( cut > 0 ? cut : 1 );
+			memcpy( short_ktx, ktx, cut );
+			ok &= (0 == SOIL_direct_load_KTX_from_memory( short_ktx, cut, 0, 0, 0 ));
+			free( short_ktx );
+		}
+		snprintf( what, sizeof( what ), "truncated KTX of format 0x%04X loaded", format );
+		check( ok, what );
+		free( ktx );
+	}
+}
+
+int main( void )
+{
+	test_decoder();
+	test_modes();
+	test_quality();
+	test_KTX_fallback();
+	printf( "%d of %d ETC2 and EAC tests passed\n", tests - failures, tests );
+	return (0 == failures) ? 0 : 1;
+}
@@ -0,0 +1,285 @@
+/*
+	The OpenGL stand-in for the tests, see gl_stub.h
+*/
+
+#include "gl_stub.h"
+#include <GL/gl.h>
+#include <GL/glx.h>
+#include <string.h>
+
+gl_stub_upload gl_stub_uploads[GL_STUB_MAX_UPLOADS];
+int gl_stub_upload_count = 0;
+int gl_stub_min_filter = -1;
+int gl_stub_max_level = -1;
+
+static int unpack_alignment = 4;
+static GLuint next_texture = 1;
+
+void gl_stub_reset( void )
+{
+	gl_stub_upload_count = 0;
+	gl_stub_min_filter = -1;
+	gl_stub_max_level = -1;
+}
+
+unsigned long gl_stub_checksum( const unsigned char *data, int size )
+{
+	unsigned long sum = 0;
+	int i;
+	for( i = 0; i < size; ++i )
+	{
+		sum = sum * 31 + data[i];
+	}
+	return sum;
+}
+
+/*	the bytes per pixel of an uncompressed upload, 0 for ones I don't know	*/
+static int pixel_bytes( GLenum format, GLenum type )
+{
+	int components, bytes;
+	switch( format )
+	{
+	case GL_RED: case GL_ALPHA: case GL_LUMINANCE: case 0x8D94:
+		components = 1;
+		break;
+	case 0x8227: case GL_LUMINANCE_ALPHA: case 0x8228:
+		components = 2;
+		break;
+	case GL_RGB: case 0x80E0: case 0x8D98:
+		components = 3;
+		break;
+	case GL_RGBA: case 0x80E1: case 0x8D99:
+		components = 4;
+		break;
+	default:
+		return 0;
+	}
+	switch( type )
+	{
+	case GL_UNSIGNED_BYTE: case GL_BYTE:
+		bytes = 1;
+		break;
+	case GL_UNSIGNED_SHORT: case GL_SHORT: case 0x140B:
+		bytes = 2;
+		break;
+	case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT:
+		bytes = 4;
+		break;
+	/*	packed into one 16 bit value	*/
+	case 0x8033: case 0x8034: case 0x8363: case 0x8364: case 0x8365: case 0x8366:
+		return 2;
+	/*	packed into one 32 bit value	*/
+	case 0x8035: case 0x8036: case 0x8367: case 0x8368: case 0x8C3B: case 0x8C3E:
+		return 4;
+	default:
+		return 0;
+	}
+	return components * bytes;
+}
+
+static gl_stub_upload *record( GLenum target, GLint level, GLenum format,
+		GLsizei width, GLsizei height, GLsizei depth, int compressed )
+{
+	gl_stub_upload *upload;
+	if( gl_stub_upload_count >= GL_STUB_MAX_UPLOADS )
+	{
+		return NULL;
+	}
+	upload = &gl_stub_uploads[gl_stub_upload_count++];
+	upload->target = target;
+	upload->level = level;
+	upload->format = format;
+	upload->width = width;
+	upload->height = height;
+	upload->depth = depth;
+	upload->compressed = compressed;
+	upload->size = 0;
+	upload->checksum = 0;
+	return upload;
+}
+
+/*	sums the pixel bytes of each row, skipping the padding to the alignment	*/
+static void record_pixels( GLenum target, GLint level, GLint internal_format,
+		GLsizei width, GLsizei height, GLsizei depth,
+		GLenum format, GLenum type, const void *pixels )
+{
+	gl_stub_upload *upload = record( target, level, internal_format, width, height, depth, 0 );
+	const unsigned char *bytes = (const unsigned char*)pixels;
+	const int row = width * pixel_bytes( format, type );
+	const int pitch = (row + unpack_alignment - 1) / unpack_alignment * unpack_alignment;
+	int y;
+	if( (NULL == upload) || (NULL == bytes) )
+	{
+		return;
+	}
+	for( y = 0; y < height * depth; ++y )
+	{
+		int x;
+		for( x = 0; x < row; ++x )
+		{
+			upload->checksum = upload->checksum * 31 + bytes[(size_t)y * pitch + x];
+		}
+		upload->size += row;
+	}
+}
+
+static void APIENTRY stub_CompressedTexImage2D( GLenum target, GLint level, GLenum format,
+		GLsizei width, GLsizei height, GLint border, GLsizei size, const void *data )
+{
+	gl_stub_upload *upload = record( target, level, format, width, height, 1, 1 );
+	(void)border;
+	if( NULL != upload )
+	{
+		upload->size = size;
+		upload->checksum = gl_stub_checksum( (const unsigned char*)data, size );
+	}
+}
+
+static void APIENTRY stub_CompressedTexImage3D( GLenum target, GLint level, GLenum format,
+		GLsizei width, GLsizei height, GLsizei depth, GLint border, GLsizei size, const void *data )
+{
+	gl_stub_upload *upload = record( target, level, format, width, height, depth, 1 );
+	(void)border;
+	if( NULL != upload )
+	{
+		upload->size = size;
+		upload->checksum = gl_stub_checksum( (const unsigned char*)data, size );
+	}
+}
+
+static void APIENTRY stub_TexImage3D( GLenum target, GLint level, GLint internal_format,
+		GLsizei width, GLsizei height, GLsizei depth, GLint border,
+		GLenum format, GLenum type, const void *pixels )
+{
+	(void)border;
+	record_pixels( target, level, internal_format, width, height, depth, format, type, pixels );
+}
+
+static void APIENTRY stub_GenerateMipmap( GLenum target )
+{
+	(void)target;
+}
+
+void glTexImage2D( GLenum target, GLint level, GLint internal_format,
+		GLsizei width, GLsizei height, GLint border,
+		GLenum format, GLenum type, const GLvoid *pixels )
+{
+	(void)border;
+	record_pixels( target, level, internal_format, width, height, 1, format, type, pixels );
+}
+
+void glTexParameteri( GLenum target, GLenum name, GLint value )
+{
+	(void)target;
+	if( GL_TEXTURE_MIN_FILTER == name )
+	{
+		gl_stub_min_filter = value;
+	} else if( 0x813D == name )
+	{
+		gl_stub_max_level = value;
+	}
+}
+
+void glPixelStorei( GLenum name, GLint value )
+{
+	if( GL_UNPACK_ALIGNMENT == name )
+	{
+		unpack_alignment = value;
+	}
+}
+
+void glGetIntegerv( GLenum name, GLint *value )
+{
+	switch( name )
+	{
+	case GL_UNPACK_ALIGNMENT:
+		*value = unpack_alignment;
+		break;
+	case GL_MAX_TEXTURE_SIZE:
+	case 0x851C:
+		*value = 16384;
+		break;
+	default:
+		*value = 1;
+		break;
+	}
+}
+
+const GLubyte *glGetString( GLenum name )
+{
+	switch( name )
+	{
+	case GL_VERSION:
+		return (const GLubyte*)"2.1 stub";
+	case GL_EXTENSIONS:
+		return (const GLubyte*)"GL_EXT_texture_compression_s3tc GL_ARB_texture_compression_rgtc "
+			"GL_ARB_texture_compression_bptc GL_ARB_texture_cube_map GL_ARB_texture_non_power_of_two "
+			"GL_ARB_framebuffer_object";
+	}
+	return (const GLubyte*)"stub";
+}
+
+GLenum glGetError( void )
+{
+	return GL_NO_ERROR;
+}
+
+void glGenTextures( GLsizei n, GLuint *textures )
+{
+	GLsizei i;
+	for( i = 0; i < n; ++i )
+	{
+		textures[i] = next_texture++;
+	}
+}
+
+void glDeleteTextures( GLsizei n, const GLuint *textures )
+{
+	(void)n;
+	(void)textures;
+}
+
+void glBindTexture( GLenum target, GLuint texture )
+{
+	(void)target;
+	(void)texture;
+}
+
+void glReadPixels( GLint x, GLint y, GLsizei width, GLsizei height,
+		GLenum format, GLenum type, GLvoid *pixels )
+{
+	(void)x;
+	(void)y;
+	(void)width;
+	(void)height;
+	(void)format;
+	(void)type;
+	(void)pixels;
+}
+
+void ( *glXGetProcAddress( const GLubyte *name ) )( void )
+{
+	const char *proc = (const char*)name;
+	if( (0 == strcmp( proc, "glCompressedTexImage2D" )) || (0 == strcmp( proc, "glCompressedTexImage2DARB" )) )
+	{
+		return (void (*)( void ))stub_CompressedTexImage2D;
+	}
+	if( 0 == strcmp( proc, "glCompressedTexImage3D" ) )
+	{
+		return (void (*)( void ))stub_CompressedTexImage3D;
+	}
+	if( 0 == strcmp( proc, "glTexImage3D" ) )
+	{
+		return (void (*)( void ))stub_TexImage3D;
+	}
+	if( 0 == strncmp( proc, "glGenerateMipmap", 16 ) )
+	{
+		return (void (*)( void ))stub_GenerateMipmap;
+	}
+	return NULL;
+}
+
+__GLXextFuncPtr glXGetProcAddressARB( const GLubyte *name )
+{
+	return glXGetProcAddress( name );
+}
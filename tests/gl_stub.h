@@ -0,0 +1,41 @@
+/*
+	A stand-in for the OpenGL driver, so the tests can run the SOIL2
+	texture loaders without a context.  It claims OpenGL 2.1 with
+	DXT, RGTC, BPTC and cubemaps, but not ETC2, and keeps a record
+	of every texture upload.  Each upload reads all the bytes GL
+	would read, at the current GL_UNPACK_ALIGNMENT, into a checksum,
+	so a loader that hands over too short a buffer shows up under
+	valgrind or -fsanitize=address.
+*/
+
+#ifndef HEADER_GL_STUB
+#define HEADER_GL_STUB
+
+#define GL_STUB_MAX_UPLOADS 64
+
+typedef struct
+{
+	unsigned int target;
+	int level;
+	/*	the internal format, compressed or not	*/
+	unsigned int format;
+	int width, height, depth;
+	/*	the bytes read, the image size for compressed uploads	*/
+	int size;
+	unsigned long checksum;
+	int compressed;
+} gl_stub_upload;
+
+extern gl_stub_upload gl_stub_uploads[GL_STUB_MAX_UPLOADS];
+extern int gl_stub_upload_count;
+/*	the last GL_TEXTURE_MIN_FILTER and GL_TEXTURE_MAX_LEVEL set, or -1	*/
+extern int gl_stub_min_filter;
+extern int gl_stub_max_level;
+
+/*	forgets the uploads and texture parameters	*/
+void gl_stub_reset( void );
+
+/*	the checksum gl_stub_upload has for these bytes	*/
+unsigned long gl_stub_checksum( const unsigned char *data, int size );
+
+#endif /* HEADER_GL_STUB	*/
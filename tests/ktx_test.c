@@ -0,0 +1,570 @@
+/*
+	The KTX 1.1 and KTX 2.0 loader, SOIL_direct_load_KTX_from_memory.
+
+	- Files built here in memory load with every MIPmap, face and
+	  array layer into the GL stub, and each upload has the right
+	  target, size and bytes: KTX1 with padded rows, byte swapped,
+	  cubemaps and arrays, and MIPmaps left to GL; KTX2 tightly
+	  packed, zlib supercompressed, and ETC2 decoded on the CPU as
+	  the stub has no ES3.
+	- Every truncation of those files, and headers, level sizes and
+	  level indices that don't add up, are turned down without
+	  reading past the buffer (run under valgrind or
+	  -fsanitize=address to see that).
+	Exits non-zero on any failure.  Run with "make test".
+*/
+
+#include "../src/SOIL2/SOIL2.h"
+#include "../src/SOIL2/etc2_utils.h"
+#include "../src/SOIL2/ktx_helper.h"
+#include "gl_stub.h"
+#include <GL/gl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int tests = 0, failures = 0;
+
+static void check( int ok, const char *what )
+{
+	++tests;
+	if( !ok )
+	{
+		++failures;
+		printf( "FAIL %s\n", what );
+	}
+}
+
+/********* KTX files in memory *********/
+
+/*	what a file holds, and how it should reach GL	*/
+typedef struct
+{
+	/*	KTX1 glType, glFormat and glInternalFormat, or KTX2 vkFormat	*/
+	unsigned int type, format, internal_format, vk_format;
+	/*	bytes per pixel, or per 4x4 block when compressed	*/
+	int pixel_size, block_size;
+	int width, height, layers, faces, levels;
+	/*	KTX1 key/value bytes, KTX2 supercompression	*/
+	int key_value_bytes, supercompression;
+	/*	the internal format GL gets, when it isn't the file's	*/
+	unsigned int uploaded_format;
+} KTX_description;
+
+/*	the uploads the loader should make	*/
+static gl_stub_upload expected[GL_STUB_MAX_UPLOADS];
+static int expected_count;
+
+static int level_dimension( int size, int level )
+{
+	return (size >> level) > 0 ? size >> level : 1;
+}
+
+/*	the bytes of one face of a level, rows padded to alignment	*/
+static int face_bytes( const KTX_description *d, int level, int alignment )
+{
+	const int w = level_dimension( d->width, level ), h = level_dimension( d->height, level );
+	if( 0 == d->pixel_size )
+	{
+		return ((w + 3) / 4) * ((h + 3) / 4) * d->block_size;
+	}
+	return (w * d->pixel_size + alignment - 1) / alignment * alignment * h;
+}
+
+/*	the checksum the stub takes of rows of row bytes, pitch apart	*/
+static unsigned long rows_checksum( const unsigned char *data, int row, int pitch, int rows )
+{
+	unsigned long sum = 0;
+	int y, x;
+	for( y = 0; y < rows; ++y )
+	{
+		for( x = 0; x < row; ++x )
+		{
+			sum = sum * 31 + data[y * pitch + x];
+		}
+	}
+	return sum;
+}
+
+/*	adds the uploads of a level whose layer-faces start at data	*/
+static void expect_level( const KTX_description *d, int level, const unsigned char *data, int alignment )
+{
+	const int w = level_dimension( d->width, level ), h = level_dimension( d->height, level );
+	const int face_size = face_bytes( d, level, alignment );
+	const int row = w * d->pixel_size, pitch = face_size / h;
+	const int images = (d->layers > 0) ? d->layers * d->faces : 1;
+	int face;
+	for( face = 0; face < ((d->layers > 0) ? 1 : d->faces); ++face )
+	{
+		gl_stub_upload *upload = &expected[expected_count++];
+		const unsigned char *face_data = data + face * face_size;
+		upload->target = (d->layers > 0) ? ((6 == d->faces) ? 0x9009 : 0x8C1A) :
+				((6 == d->faces) ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D);
+		upload->level = level;
+		upload->format = (0 != d->uploaded_format) ? d->uploaded_format : d->internal_format;
+		upload->width = w;
+		upload->height = h;
+		upload->depth = images;
+		upload->compressed = (0 == d->pixel_size);
+		if( upload->compressed )
+		{
+			upload->size = face_size * images;
+			upload->checksum = gl_stub_checksum( face_data, upload->size );
+		} else
+		{
+			upload->size = row * h * images;
+			upload->checksum = rows_checksum( face_data, row, pitch, h * images );
+		}
+	}
+}
+
+/*	the pixel or block bytes, different in every level	*/
+static void fill( unsigned char *data, int size, int level )
+{
+	int i;
+	for( i = 0; i < size; ++i )
+	{
+		data[i] = (unsigned char)(i * 13 + level * 101 + 7);
+	}
+}
+
+static unsigned char *make_KTX1( const KTX_description *d, int *out_size )
+{
+	KTX_Header header;
+	unsigned char *ktx;
+	int size = sizeof( KTX_Header ) + d->key_value_bytes, level, offset;
+	const int images = ((d->layers > 0) ? d->layers : 1) * d->faces;
+	const int levels = (d->levels > 0) ? d->levels : 1;
+	for( level = 0; level < levels; ++level )
+	{
+		size += 4 + face_bytes( d, level, 4 ) * images;
+	}
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.identifier, KTX1_identifier, KTX_IDENTIFIER_SIZE );
+	header.endianness = KTX_ENDIAN_REF;
+	header.glType = d->type;
+	header.glTypeSize = (0 != d->type) ? 1 : 0;
+	header.glFormat = d->format;
+	header.glInternalFormat = d->internal_format;
+	header.glBaseInternalFormat = (0 != d->format) ? d->format : GL_RGBA;
+	header.pixelWidth = d->width;
+	header.pixelHeight = d->height;
+	header.numberOfArrayElements = d->layers;
+	header.numberOfFaces = d->faces;
+	header.numberOfMipmapLevels = d->levels;
+	header.bytesOfKeyValueData = d->key_value_bytes;
+	ktx = (unsigned char*)calloc( size, 1 );
+	memcpy( ktx, &header, sizeof( header ) );
+	offset = sizeof( KTX_Header ) + d->key_value_bytes;
+	expected_count = 0;
+	for( level = 0; level < levels; ++level )
+	{
+		const int face_size = face_bytes( d, level, 4 );
+		/*	non-array cubemaps give the size of one face	*/
+		const unsigned int image_size = ((0 == d->layers) && (6 == d->faces)) ? face_size : face_size * images;
+		memcpy( ktx + offset, &image_size, 4 );
+		fill( ktx + offset + 4, face_size * images, level );
+		expect_level( d, level, ktx + offset + 4, 4 );
+		offset += 4 + face_size * images;
+	}
+	*out_size = size;
+	return ktx;
+}
+
+/*	a zlib stream of stored deflate blocks	*/
+static int zlib_store( const unsigned char *data, int size, unsigned char *out )
+{
+	unsigned int a = 1, b = 0;
+	int n = 0, i;
+	out[n++] = 0x78;
+	out[n++] = 0x01;
+	for( i = 0; (0 == i) || (i < size); i += 0xFFFF )
+	{
+		const int length = (size - i < 0xFFFF) ? size - i : 0xFFFF;
+		out[n++] = (i + length >= size) ? 1 : 0;
+		out[n++] = (unsigned char)length;
+		out[n++] = (unsigned char)(length >> 8);
+		out[n++] = (unsigned char)~length;
+		out[n++] = (unsigned char)(~length >> 8);
+		memcpy( out + n, data + i, length );
+		n += length;
+	}
+	for( i = 0; i < size; ++i )
+	{
+		a = (a + data[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+	out[n++] = (unsigned char)(b >> 8);
+	out[n++] = (unsigned char)b;
+	out[n++] = (unsigned char)(a >> 8);
+	out[n++] = (unsigned char)a;
+	return n;
+}
+
+static unsigned char *make_KTX2( const KTX_description *d, int *out_size )
+{
+	KTX2_Header header;
+	KTX2_Level_Index index;
+	unsigned char *ktx;
+	const int images = ((d->layers > 0) ? d->layers : 1) * d->faces;
+	const int levels = (d->levels > 0) ? d->levels : 1;
+	const int index_end = sizeof( KTX2_Header ) + levels * sizeof( KTX2_Level_Index );
+	int size = index_end, level, offset;
+	for( level = 0; level < levels; ++level )
+	{
+		/*	room for the zlib framing too	*/
+		size += face_bytes( d, level, 1 ) * images + 16;
+	}
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.identifier, KTX2_identifier, KTX_IDENTIFIER_SIZE );
+	header.vkFormat = d->vk_format;
+	header.typeSize = 1;
+	header.pixelWidth = d->width;
+	header.pixelHeight = d->height;
+	header.layerCount = d->layers;
+	header.faceCount = d->faces;
+	header.levelCount = d->levels;
+	header.supercompressionScheme = d->supercompression;
+	ktx = (unsigned char*)calloc( size, 1 );
+	memcpy( ktx, &header, sizeof( header ) );
+	offset = index_end;
+	expected_count = 0;
+	for( level = 0; level < levels; ++level )
+	{
+		const int level_size = face_bytes( d, level, 1 ) * images;
+		unsigned char *data = (unsigned char*)malloc( level_size );
+		fill( data, level_size, level );
+		memset( &index, 0, sizeof( index ) );
+		index.byteOffset[0] = offset;
+		index.uncompressedByteLength[0] = level_size;
+		if( KTX2_SUPERCOMPRESSION_ZLIB == d->supercompression )
+		{
+			index.byteLength[0] = zlib_store( data, level_size, ktx + offset );
+		} else
+		{
+			memcpy( ktx + offset, data, level_size );
+			index.byteLength[0] = level_size;
+		}
+		memcpy( ktx + sizeof( KTX2_Header ) + level * sizeof( KTX2_Level_Index ), &index, sizeof( index ) );
+		if( 0 != etc2_block_size( d->internal_format ) )
+		{
+			/*	what the CPU decode of an ETC2 level gives GL	*/
+			const int w = level_dimension( d->width, level ), h = level_dimension( d->height, level );
+			const int channels = etc2_decoded_channels( d->internal_format );
+			unsigned char *decoded = (unsigned char*)malloc( w * h * channels );
+			KTX_description pixels = *d;
+			etc2_decode_image_signed( data, d->internal_format, w, h, decoded );
+			pixels.pixel_size = channels;
+			expect_level( &pixels, level, decoded, 1 );
+			free( decoded );
+		} else
+		{
+			expect_level( d, level, data, 1 );
+		}
+		offset += index.byteLength[0];
+		free( data );
+	}
+	*out_size = offset;
+	return ktx;
+}
+
+/*	loads the file and compares the uploads with the expected ones	*/
+static void check_load( const char *name, const unsigned char *ktx, int ktx_size, int flags, int cubemap )
+{
+	char what[160];
+	unsigned int tex_ID;
+	int i;
+	gl_stub_reset();
+	tex_ID = SOIL_direct_load_KTX_from_memory( ktx, ktx_size, 0, flags, cubemap );
+	snprintf( what, sizeof( what ), "%s did not load: %s", name, SOIL_last_result() );
+	check( 0 != tex_ID, what );
+	snprintf( what, sizeof( what ), "%s made %d uploads, not %d", name, gl_stub_upload_count, expected_count );
+	check( expected_count == gl_stub_upload_count, what );
+	for( i = 0; (i < expected_count) && (i < gl_stub_upload_count); ++i )
+	{
+		const gl_stub_upload *e = &expected[i], *u = &gl_stub_uploads[i];
+		snprintf( what, sizeof( what ), "%s upload %d: target 0x%X level %d format 0x%X %dx%dx%d %d bytes%s",
+			name, i, u->target, u->level, u->format, u->width, u->height, u->depth, u->size,
+			(u->checksum != e->checksum) ? ", other bytes" : "" );
+		check( (e->target == u->target) && (e->level == u->level) && (e->format == u->format) &&
+			(e->width == u->width) && (e->height == u->height) && (e->depth == u->depth) &&
+			(e->size == u->size) && (e->compressed == u->compressed) && (e->checksum == u->checksum), what );
+	}
+}
+
+/*	every shorter file fails, each copied to a buffer just its size	*/
+static void check_truncations( const char *name, const unsigned char *ktx, int ktx_size, int cubemap )
+{
+	char what[96];
+	int cut, ok = 1;
+	for( cut = 0; cut < ktx_size; ++cut )
+	{
+		unsigned char *short_ktx = (unsigned char*)malloc( (cut > 0) ? cut : 1 );
+		memcpy( short_ktx, ktx, cut );
+		if( 0 != SOIL_direct_load_KTX_from_memory( short_ktx, cut, 0, 0, cubemap ) )
+		{
+			ok = 0;
+		}
+		free( short_ktx );
+	}
+	snprintf( what, sizeof( what ), "%s loaded when truncated", name );
+	check( ok, what );
+}
+
+/********* files that load *********/
+
+/*	the files of the tests below; GL formats as the stub reports them	*/
+static const KTX_description KTX1_RGB_odd =
+	{ GL_UNSIGNED_BYTE, GL_RGB, 0x8051, 0, 3, 0, 5, 3, 0, 1, 3, 0, 0, 0 };
+static const KTX_description KTX1_BC1 =
+	{ 0, 0, 0x83F0, 0, 0, 8, 16, 8, 0, 1, 5, 8, 0, 0 };
+static const KTX_description KTX1_cubemap =
+	{ GL_UNSIGNED_BYTE, GL_RGBA, 0x8058, 0, 4, 0, 4, 4, 0, 6, 2, 0, 0, 0 };
+static const KTX_description KTX1_array =
+	{ GL_UNSIGNED_BYTE, GL_RGBA, 0x8058, 0, 4, 0, 4, 4, 3, 1, 1, 0, 0, 0 };
+static const KTX_description KTX1_generate =
+	{ GL_UNSIGNED_BYTE, GL_RGBA, 0x8058, 0, 4, 0, 8, 8, 0, 1, 0, 0, 0, 0 };
+static const KTX_description KTX2_RGBA =
+	{ 0, 0, 0x8058, KTX2_VK_FORMAT_R8G8B8A8_UNORM, 4, 0, 8, 8, 0, 1, 4, 0, 0, 0 };
+static const KTX_description KTX2_RGB_odd =
+	{ 0, 0, 0x8051, KTX2_VK_FORMAT_R8G8B8_UNORM, 3, 0, 3, 5, 0, 1, 1, 0, 0, 0 };
+static const KTX_description KTX2_BC7 =
+	{ 0, 0, 0x8E8C, KTX2_VK_FORMAT_BC7_UNORM_BLOCK, 0, 16, 8, 8, 0, 1, 4, 0, 0, 0 };
+static const KTX_description KTX2_zlib_cubemap =
+	{ 0, 0, 0x8058, KTX2_VK_FORMAT_R8G8B8A8_UNORM, 4, 0, 4, 4, 0, 6, 3, 0, KTX2_SUPERCOMPRESSION_ZLIB, 0 };
+static const KTX_description KTX2_zlib_array =
+	{ 0, 0, 0x8229, KTX2_VK_FORMAT_R8_UNORM, 1, 0, 7, 5, 4, 1, 3, 0, KTX2_SUPERCOMPRESSION_ZLIB, 0 };
+static const KTX_description KTX2_ETC2 =
+	{ 0, 0, ETC2_COMPRESSED_RGB8_ETC2, KTX2_VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, 0, 8, 12, 8, 0, 1, 4, 0, 0, 0x8051 };
+static const KTX_description KTX2_EAC_signed =
+	{ 0, 0, ETC2_COMPRESSED_SIGNED_RG11_EAC, KTX2_VK_FORMAT_EAC_R11G11_SNORM_BLOCK, 0, 16, 5, 6, 0, 1, 3, 0, 0, 0x8F95 };
+
+static void test_loads( void )
+{
+	static const struct { const char *name; const KTX_description *d; int is_KTX2; } files[] =
+	{
+		{ "KTX1 RGB 5x3", &KTX1_RGB_odd, 0 },
+		{ "KTX1 BC1 with key/values", &KTX1_BC1, 0 },
+		{ "KTX1 cubemap", &KTX1_cubemap, 0 },
+		{ "KTX1 array", &KTX1_array, 0 },
+		{ "KTX2 RGBA", &KTX2_RGBA, 1 },
+		{ "KTX2 RGB 3x5", &KTX2_RGB_odd, 1 },
+		{ "KTX2 BC7", &KTX2_BC7, 1 },
+		{ "KTX2 zlib cubemap", &KTX2_zlib_cubemap, 1 },
+		{ "KTX2 zlib array", &KTX2_zlib_array, 1 },
+		{ "KTX2 ETC2 RGB8", &KTX2_ETC2, 1 },
+		{ "KTX2 signed RG11", &KTX2_EAC_signed, 1 }
+	};
+	int f, ktx_size;
+	for( f = 0; f < (int)(sizeof( files ) / sizeof( files[0] )); ++f )
+	{
+		const int cubemap = (6 == files[f].d->faces);
+		unsigned char *ktx = files[f].is_KTX2 ? make_KTX2( files[f].d, &ktx_size ) : make_KTX1( files[f].d, &ktx_size );
+		check_load( files[f].name, ktx, ktx_size, 0, cubemap );
+		/*	and not as the other kind of texture	*/
+		check( 0 == SOIL_direct_load_KTX_from_memory( ktx, ktx_size, 0, 0, !cubemap ),
+			cubemap ? "a KTX cubemap loaded as a 2D texture" : "a 2D KTX loaded as a cubemap" );
+		check_truncations( files[f].name, ktx, ktx_size, cubemap );
+		free( ktx );
+	}
+}
+
+/*	a KTX1 file of the other endianness, and MIPmaps left to GL	*/
+static void test_KTX1_variants( void )
+{
+	KTX_Header header;
+	unsigned int *field = &header.endianness;
+	unsigned char *ktx;
+	int ktx_size, offset, level, i;
+	ktx = make_KTX1( &KTX1_BC1, &ktx_size );
+	memcpy( &header, ktx, sizeof( header ) );
+	for( i = 0; i < (int)((sizeof( KTX_Header ) - KTX_IDENTIFIER_SIZE) / 4); ++i )
+	{
+		field[i] = (field[i] >> 24) | ((field[i] >> 8) & 0xFF00) | ((field[i] & 0xFF00) << 8) | (field[i] << 24);
+	}
+	memcpy( ktx, &header, sizeof( header ) );
+	offset = sizeof( KTX_Header ) + KTX1_BC1.key_value_bytes;
+	for( level = 0; level < KTX1_BC1.levels; ++level )
+	{
+		unsigned char *size = ktx + offset, t;
+		offset += 4 + face_bytes( &KTX1_BC1, level, 4 );
+		t = size[0]; size[0] = size[3]; size[3] = t;
+		t = size[1]; size[1] = size[2]; size[2] = t;
+	}
+	check_load( "byte swapped KTX1 BC1", ktx, ktx_size, 0, 0 );
+	check_truncations( "byte swapped KTX1 BC1", ktx, ktx_size, 0 );
+	free( ktx );
+
+	ktx = make_KTX1( &KTX1_generate, &ktx_size );
+	check_load( "KTX1 without MIPmaps", ktx, ktx_size, SOIL_FLAG_MIPMAPS, 0 );
+	check( GL_LINEAR_MIPMAP_LINEAR == gl_stub_min_filter, "a KTX1 file with 0 levels did not get MIPmaps from GL" );
+	free( ktx );
+}
+
+/********* files that don't *********/
+
+static void check_rejected( const char *name, const unsigned char *ktx, int ktx_size, int cubemap )
+{
+	char what[96];
+	snprintf( what, sizeof( what ), "%s loaded", name );
+	gl_stub_reset();
+	check( 0 == SOIL_direct_load_KTX_from_memory( ktx, ktx_size, 0, 0, cubemap ), what );
+}
+
+static void test_broken_KTX1( void )
+{
+	KTX_Header header;
+	unsigned char *ktx, *copy;
+	const int first_level = sizeof( KTX_Header );
+	unsigned int image_size;
+	int ktx_size, i;
+	ktx = make_KTX1( &KTX1_RGB_odd, &ktx_size );
+	copy = (unsigned char*)malloc( ktx_size );
+	for( i = 0; i < 12; ++i )
+	{
+		memcpy( copy, ktx, ktx_size );
+		memcpy( &header, copy, sizeof( header ) );
+		switch( i )
+		{
+		case 0:
+			header.identifier[5] = '2';
+			break;
+		case 1:
+			header.endianness = 0x04030202;
+			break;
+		case 2:
+			header.glType = 0;
+			break;
+		case 3:
+			header.bytesOfKeyValueData = 0xFFFFFFF0u;
+			break;
+		case 4:
+			header.pixelDepth = 1;
+			break;
+		case 5:
+			header.pixelHeight = 0;
+			break;
+		case 6:
+			header.numberOfFaces = 2;
+			break;
+		case 7:
+			header.numberOfMipmapLevels = 33;
+			break;
+		case 8:
+			header.glType = 0x1234;
+			break;
+		case 9:
+			/*	pixels that would need swapping	*/
+			header.glTypeSize = 2;
+			break;
+		case 10:
+			image_size = 0xFFFFFFFCu;
+			memcpy( copy + first_level, &image_size, 4 );
+			break;
+		default:
+			/*	the size of the level is less than its padded rows	*/
+			image_size = 3 * 5 * 3;
+			memcpy( copy + first_level, &image_size, 4 );
+			break;
+		}
+		if( (i < 10) && (9 != i) )
+		{
+			memcpy( copy, &header, sizeof( header ) );
+		} else if( 9 == i )
+		{
+			unsigned int *field = &header.endianness;
+			int k;
+			for( k = 0; k < (int)((sizeof( KTX_Header ) - KTX_IDENTIFIER_SIZE) / 4); ++k )
+			{
+				field[k] = (field[k] >> 24) | ((field[k] >> 8) & 0xFF00) | ((field[k] & 0xFF00) << 8) | (field[k] << 24);
+			}
+			memcpy( copy, &header, sizeof( header ) );
+		}
+		{
+			static const char *const names[12] =
+			{
+				"KTX1 with a KTX2 identifier", "KTX1 of an unknown endianness", "KTX1 with a format but no type",
+				"KTX1 with more key/values than the file", "KTX1 3D texture", "KTX1 1D texture",
+				"KTX1 with 2 faces", "KTX1 with 33 levels", "KTX1 of an unknown type",
+				"byte swapped KTX1 of 16 bit pixels", "KTX1 level larger than the file",
+				"KTX1 level without room for its padded rows"
+			};
+			check_rejected( names[i], copy, ktx_size, 0 );
+		}
+	}
+	free( copy );
+	free( ktx );
+}
+
+static void test_broken_KTX2( void )
+{
+	KTX2_Header header;
+	KTX2_Level_Index index;
+	unsigned char *ktx, *copy;
+	const int first_index = sizeof( KTX2_Header );
+	static const char *const names[] =
+	{
+		"KTX2 without a vkFormat", "KTX2 with BasisLZ supercompression", "KTX2 with 33 levels",
+		"KTX2 level past the end", "KTX2 level whose length wraps around", "KTX2 level over 4 GB",
+		"KTX2 cubemap level not a multiple of 6 faces", "KTX2 array level too small for its layers",
+		"KTX2 zlib level that inflates short", "KTX2 zlib level that is corrupt"
+	};
+	int ktx_size, i;
+	for( i = 0; i < (int)(sizeof( names ) / sizeof( names[0] )); ++i )
+	{
+		const KTX_description *d = (i >= 8) ? &KTX2_zlib_cubemap : &KTX2_RGBA;
+		ktx = make_KTX2( d, &ktx_size );
+		copy = (unsigned char*)malloc( ktx_size );
+		memcpy( copy, ktx, ktx_size );
+		memcpy( &header, copy, sizeof( header ) );
+		memcpy( &index, copy + first_index, sizeof( index ) );
+		switch( i )
+		{
+		case 0:
+			header.vkFormat = 0;
+			break;
+		case 1:
+			header.supercompressionScheme = KTX2_SUPERCOMPRESSION_BASIS_LZ;
+			break;
+		case 2:
+			header.levelCount = 33;
+			break;
+		case 3:
+			index.byteOffset[0] = ktx_size + 1;
+			break;
+		case 4:
+			index.byteLength[0] = 0xFFFFFFFFu;
+			break;
+		case 5:
+			index.byteLength[1] = 1;
+			break;
+		case 6:
+			header.faceCount = 6;
+			break;
+		case 7:
+			header.layerCount = 3;
+			break;
+		case 8:
+			index.uncompressedByteLength[0] += 4;
+			break;
+		default:
+			copy[index.byteOffset[0] + 2] = 0x06;
+			break;
+		}
+		memcpy( copy, &header, sizeof( header ) );
+		memcpy( copy + first_index, &index, sizeof( index ) );
+		check_rejected( names[i], copy, ktx_size, 6 == header.faceCount );
+		free( copy );
+		free( ktx );
+	}
+}
+
+int main( void )
+{
+	test_loads();
+	test_KTX1_variants();
+	test_broken_KTX1();
+	test_broken_KTX2();
+	printf( "%d of %d KTX tests passed\n", tests - failures, tests );
+	return (0 == failures) ? 0 : 1;
+}
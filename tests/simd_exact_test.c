@@ -0,0 +1,122 @@
+/*
+	The SIMD resampling kernels have to give the same bytes as the
+	plain C code.  This runs up_scale_image, the 2x2 mipmap_image and
+	mipmap_chain over random sizes with 1 to 4 channels, once with
+	SOIL_set_SIMD_enabled( 0 ) and once with it on, and compares the
+	whole output buffers, including a guard byte past the chain.
+	Exits non-zero on any mismatch.  Run with "make test".
+*/
+
+#include "../src/SOIL2/SOIL2.h"
+#include "../src/SOIL2/image_helper.h"
+#include "../src/SOIL2/simd_helper.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ITERATIONS 3000
+
+enum
+{
+	TEST_UP_SCALE,
+	TEST_MIPMAP_2X2,
+	TEST_MIPMAP_CHAIN,
+	TEST_KINDS
+};
+
+static const char *const test_names[TEST_KINDS] =
+{
+	"up_scale_image", "mipmap_image 2x2", "mipmap_chain"
+};
+
+static void run( int simd, int kind, const unsigned char *img, int width, int height, int channels,
+		unsigned char *out, int new_width, int new_height )
+{
+	SOIL_set_SIMD_enabled( simd );
+	switch( kind )
+	{
+	case TEST_UP_SCALE:
+		up_scale_image( img, width, height, channels, out, new_width, new_height );
+		break;
+	case TEST_MIPMAP_2X2:
+		mipmap_image( img, width, height, channels, out, 2, 2 );
+		break;
+	default:
+		mipmap_chain( img, width, height, channels, out );
+		break;
+	}
+}
+
+int main( void )
+{
+	int tests = 0, failures = 0;
+	int it, kind, i;
+
+	printf( "SIMD level %d\n", soil_simd_level() );
+	srand( 1 );
+	for( it = 0; it < ITERATIONS; ++it )
+	{
+		int width = 1 + rand() % 90;
+		int height = 1 + rand() % 40;
+		int channels = 1 + rand() % 4;
+		unsigned char *img;
+		/*	now and then a long thin one, to get past the vector widths	*/
+		if( 0 == it % 50 )
+		{
+			width = 1 + rand() % 700;
+			height = 1 + rand() % 9;
+		}
+		img = (unsigned char*)malloc( width * height * channels );
+		/*	odd iterations get noise, even ones only 0 and 255 to push the rounding	*/
+		for( i = 0; i < width * height * channels; ++i )
+		{
+			img[i] = (it & 1) ? (unsigned char)rand() : ((rand() & 1) ? 255 : 0);
+		}
+		for( kind = 0; kind < TEST_KINDS; ++kind )
+		{
+			int new_width = 2 + rand() % 200;
+			int new_height = 2 + rand() % 100;
+			size_t size;
+			unsigned char *plain, *simd;
+			switch( kind )
+			{
+			case TEST_UP_SCALE:
+				if( (width < 2) || (height < 2) )
+				{
+					continue;
+				}
+				size = (size_t)new_width * new_height * channels;
+				break;
+			case TEST_MIPMAP_2X2:
+				size = (size_t)((width > 1) ? width / 2 : 1) * ((height > 1) ? height / 2 : 1) * channels;
+				break;
+			default:
+				size = mipmap_chain_size( width, height, channels ) + 1;
+				break;
+			}
+			plain = (unsigned char*)malloc( size );
+			simd = (unsigned char*)malloc( size );
+			memset( plain, 7, size );
+			memset( simd, 7, size );
+			run( 0, kind, img, width, height, channels, plain, new_width, new_height );
+			run( 1, kind, img, width, height, channels, simd, new_width, new_height );
+			++tests;
+			if( 0 != memcmp( plain, simd, size ) )
+			{
+				++failures;
+				if( TEST_UP_SCALE == kind )
+				{
+					printf( "FAIL %s %dx%dx%d -> %dx%d\n", test_names[kind], width, height, channels, new_width, new_height );
+				} else
+				{
+					printf( "FAIL %s %dx%dx%d\n", test_names[kind], width, height, channels );
+				}
+			}
+			free( simd );
+			free( plain );
+		}
+		free( img );
+	}
+	printf( "%d of %d SIMD resampling tests matched the C code\n", tests - failures, tests );
+	return (0 == failures) ? 0 : 1;
+}